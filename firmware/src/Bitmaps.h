@@ -13,558 +13,1059 @@
 static constexpr const int BMapWidth = 8;
 static constexpr const int BMapHeight = 8;
 
-static constexpr const uint8_t Char_0[] {
-  0b00000000,
-  0b00111100,
-  0b01100110,
-  0b01100110,
-  0b01100110,
-  0b01100110,
-  0b00111100,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_1[] {
-  0b00000000,
-  0b00011000,
-  0b00111000,
-  0b00011000,
-  0b00011000,
-  0b00011000,
-  0b00011000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_2[] {
-  0b00000000,
-  0b00111100,
-  0b01100110,
-  0b00001100,
-  0b00011000,
-  0b00110000,
-  0b01111110,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_3[] {
-  0b00000000,
-  0b00111100,
-  0b01100110,
-  0b00000110,
-  0b00011100,
-  0b01100110,
-  0b00111100,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_4[] {
-  0b00000000,
-  0b00001100,
-  0b00011100,
-  0b00101100,
-  0b00101100,
-  0b01111110,
-  0b00001100,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_5[] {
-  0b00000000,
-  0b01111110,
-  0b01100000,
-  0b01100000,
-  0b01111100,
-  0b00000110,
-  0b01111100,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_6[] {
-  0b00000000,
-  0b00111000,
-  0b01100000,
-  0b01100000,
-  0b01111100,
-  0b01100110,
-  0b00111100,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_7[] {
-  0b00000000,
-  0b01111110,
-  0b01100110,
-  0b00001100,
-  0b00011000,
-  0b00110000,
-  0b00110000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_8[] {
-  0b00000000,
-  0b00111100,
-  0b01100110,
-  0b00111100,
-  0b01100110,
-  0b01100110,
-  0b00111100,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_9[] {
-  0b00000000,
-  0b00111100,
-  0b01100110,
-  0b01100110,
-  0b00111110,
-  0b00001100,
-  0b00011000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_A[] {
-  0b00000000,
-  0b00011000,
-  0b00111100,
-  0b01100110,
-  0b01111110,
-  0b01100110,
-  0b01100110,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_B[] {
-  0b00000000,
-  0b01111100,
-  0b01100110,
-  0b01100100,
-  0b01111110,
-  0b01100110,
-  0b01111100,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_C[] {
-  0b00000000,
-  0b00111100,
-  0b01100110,
-  0b01100000,
-  0b01100000,
-  0b01100110,
-  0b00111100,
-  0b00000000,
-};
+/// The glyphs of the printable ASCII characters from FontFirst to FontLast,
+/// one byte per row with the leftmost pixel in the MSB.
+static constexpr const char FontFirst = ' ';
+static constexpr const char FontLast = '~';
 
-static constexpr const uint8_t Char_D[] {
-  0b00000000,
-  0b01111100,
-  0b01100110,
-  0b01100110,
-  0b01100110,
-  0b01100110,
-  0b01111100,
-  0b00000000,
+static constexpr const uint8_t FontAtlas[FontLast - FontFirst + 1][BMapHeight] {
+  // ' '
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+  },
+  // '!'
+  {
+    0b00000000,
+    0b00110000,
+    0b00110000,
+    0b00110000,
+    0b00110000,
+    0b00000000,
+    0b00110000,
+    0b00000000,
+  },
+  // '"'
+  {
+    0b00000000,
+    0b01100110,
+    0b01100110,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+  },
+  // '#'
+  {
+    0b00000000,
+    0b01101100,
+    0b11111110,
+    0b01101100,
+    0b01101100,
+    0b11111110,
+    0b01101100,
+    0b00000000,
+  },
+  // '$'
+  {
+    0b00000000,
+    0b00010000,
+    0b01111100,
+    0b11010000,
+    0b01111100,
+    0b00010110,
+    0b01111100,
+    0b00010000,
+  },
+  // '%'
+  {
+    0b00000000,
+    0b11000110,
+    0b11001100,
+    0b00011000,
+    0b00110000,
+    0b01100110,
+    0b11000110,
+    0b00000000,
+  },
+  // '&'
+  {
+    0b00000000,
+    0b00111000,
+    0b01101100,
+    0b00111000,
+    0b01110110,
+    0b11011100,
+    0b01110110,
+    0b00000000,
+  },
+  // '\''
+  {
+    0b00000000,
+    0b00011000,
+    0b00011000,
+    0b00110000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+  },
+  // '('
+  {
+    0b00000000,
+    0b00001100,
+    0b00011000,
+    0b00110000,
+    0b00110000,
+    0b00011000,
+    0b00001100,
+    0b00000000,
+  },
+  // ')'
+  {
+    0b00000000,
+    0b00110000,
+    0b00011000,
+    0b00001100,
+    0b00001100,
+    0b00011000,
+    0b00110000,
+    0b00000000,
+  },
+  // '*'
+  {
+    0b00000000,
+    0b00000000,
+    0b01101100,
+    0b00111000,
+    0b11111110,
+    0b00111000,
+    0b01101100,
+    0b00000000,
+  },
+  // '+'
+  {
+    0b00000000,
+    0b00000000,
+    0b00010000,
+    0b00010000,
+    0b01111100,
+    0b00010000,
+    0b00010000,
+    0b00000000,
+  },
+  // ','
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00011000,
+    0b00011000,
+    0b00110000,
+  },
+  // '-'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b01111100,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+  },
+  // '.'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00110000,
+    0b00110000,
+    0b00000000,
+  },
+  // '/'
+  {
+    0b00000000,
+    0b00000110,
+    0b00001100,
+    0b00011000,
+    0b00110000,
+    0b01100000,
+    0b11000000,
+    0b00000000,
+  },
+  // '0'
+  {
+    0b00000000,
+    0b00111100,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b00111100,
+    0b00000000,
+  },
+  // '1'
+  {
+    0b00000000,
+    0b00011000,
+    0b00111000,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+    0b00000000,
+  },
+  // '2'
+  {
+    0b00000000,
+    0b00111100,
+    0b01100110,
+    0b00001100,
+    0b00011000,
+    0b00110000,
+    0b01111110,
+    0b00000000,
+  },
+  // '3'
+  {
+    0b00000000,
+    0b00111100,
+    0b01100110,
+    0b00000110,
+    0b00011100,
+    0b01100110,
+    0b00111100,
+    0b00000000,
+  },
+  // '4'
+  {
+    0b00000000,
+    0b00001100,
+    0b00011100,
+    0b00101100,
+    0b00101100,
+    0b01111110,
+    0b00001100,
+    0b00000000,
+  },
+  // '5'
+  {
+    0b00000000,
+    0b01111110,
+    0b01100000,
+    0b01100000,
+    0b01111100,
+    0b00000110,
+    0b01111100,
+    0b00000000,
+  },
+  // '6'
+  {
+    0b00000000,
+    0b00111000,
+    0b01100000,
+    0b01100000,
+    0b01111100,
+    0b01100110,
+    0b00111100,
+    0b00000000,
+  },
+  // '7'
+  {
+    0b00000000,
+    0b01111110,
+    0b01100110,
+    0b00001100,
+    0b00011000,
+    0b00110000,
+    0b00110000,
+    0b00000000,
+  },
+  // '8'
+  {
+    0b00000000,
+    0b00111100,
+    0b01100110,
+    0b00111100,
+    0b01100110,
+    0b01100110,
+    0b00111100,
+    0b00000000,
+  },
+  // '9'
+  {
+    0b00000000,
+    0b00111100,
+    0b01100110,
+    0b01100110,
+    0b00111110,
+    0b00001100,
+    0b00011000,
+    0b00000000,
+  },
+  // ':'
+  {
+    0b00000000,
+    0b00110000,
+    0b00110000,
+    0b00000000,
+    0b00000000,
+    0b00110000,
+    0b00110000,
+    0b00000000,
+  },
+  // ';'
+  {
+    0b00000000,
+    0b00110000,
+    0b00110000,
+    0b00000000,
+    0b00000000,
+    0b00110000,
+    0b00110000,
+    0b01100000,
+  },
+  // '<'
+  {
+    0b00000000,
+    0b00000100,
+    0b00001000,
+    0b00010000,
+    0b00100000,
+    0b00010000,
+    0b00001000,
+    0b00000100,
+  },
+  // '='
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b01111100,
+    0b00000000,
+    0b01111100,
+    0b00000000,
+    0b00000000,
+  },
+  // '>'
+  {
+    0b00000000,
+    0b00100000,
+    0b00010000,
+    0b00001000,
+    0b00000100,
+    0b00001000,
+    0b00010000,
+    0b00100000,
+  },
+  // '?'
+  {
+    0b00000000,
+    0b00111100,
+    0b01100110,
+    0b00001100,
+    0b00011000,
+    0b00000000,
+    0b00011000,
+    0b00000000,
+  },
+  // '@'
+  {
+    0b00000000,
+    0b00111100,
+    0b01000010,
+    0b01011110,
+    0b01011100,
+    0b01000000,
+    0b00111100,
+    0b00000000,
+  },
+  // 'A'
+  {
+    0b00000000,
+    0b00011000,
+    0b00111100,
+    0b01100110,
+    0b01111110,
+    0b01100110,
+    0b01100110,
+    0b00000000,
+  },
+  // 'B'
+  {
+    0b00000000,
+    0b01111100,
+    0b01100110,
+    0b01100100,
+    0b01111110,
+    0b01100110,
+    0b01111100,
+    0b00000000,
+  },
+  // 'C'
+  {
+    0b00000000,
+    0b00111100,
+    0b01100110,
+    0b01100000,
+    0b01100000,
+    0b01100110,
+    0b00111100,
+    0b00000000,
+  },
+  // 'D'
+  {
+    0b00000000,
+    0b01111100,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b01111100,
+    0b00000000,
+  },
+  // 'E'
+  {
+    0b00000000,
+    0b01111110,
+    0b01100000,
+    0b01111000,
+    0b01100000,
+    0b01100000,
+    0b01111110,
+    0b00000000,
+  },
+  // 'F'
+  {
+    0b00000000,
+    0b01111110,
+    0b01100000,
+    0b01111000,
+    0b01100000,
+    0b01100000,
+    0b01100000,
+    0b00000000,
+  },
+  // 'G'
+  {
+    0b00000000,
+    0b00111100,
+    0b01100110,
+    0b01100000,
+    0b01101110,
+    0b01100110,
+    0b00111100,
+    0b00000000,
+  },
+  // 'H'
+  {
+    0b00000000,
+    0b01100110,
+    0b01100110,
+    0b01111110,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b00000000,
+  },
+  // 'I'
+  {
+    0b00000000,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+    0b00000000,
+  },
+  // 'J'
+  {
+    0b00000000,
+    0b00111110,
+    0b00000110,
+    0b00000110,
+    0b00000110,
+    0b01100110,
+    0b00111000,
+    0b00000000,
+  },
+  // 'K'
+  {
+    0b00000000,
+    0b01100110,
+    0b01101100,
+    0b01111000,
+    0b01111000,
+    0b01101100,
+    0b01100110,
+    0b00000000,
+  },
+  // 'L'
+  {
+    0b00000000,
+    0b01100000,
+    0b01100000,
+    0b01100000,
+    0b01100000,
+    0b01100000,
+    0b01111110,
+    0b00000000,
+  },
+  // 'M'
+  {
+    0b00000000,
+    0b01000010,
+    0b01100110,
+    0b01111110,
+    0b01010110,
+    0b01000110,
+    0b01000110,
+    0b00000000,
+  },
+  // 'N'
+  {
+    0b00000000,
+    0b01000110,
+    0b01100110,
+    0b01110110,
+    0b01101110,
+    0b01100110,
+    0b01100010,
+    0b00000000,
+  },
+  // 'O'
+  {
+    0b00000000,
+    0b00111100,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b00111100,
+    0b00000000,
+  },
+  // 'P'
+  {
+    0b00000000,
+    0b01111100,
+    0b01100110,
+    0b01100110,
+    0b01111100,
+    0b01100000,
+    0b01100000,
+    0b00000000,
+  },
+  // 'Q'
+  {
+    0b00000000,
+    0b00111100,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b01101110,
+    0b00111011,
+    0b00000000,
+  },
+  // 'R'
+  {
+    0b00000000,
+    0b01111100,
+    0b01100110,
+    0b01100110,
+    0b01111100,
+    0b01101100,
+    0b01100110,
+    0b00000000,
+  },
+  // 'S'
+  {
+    0b00000000,
+    0b00111100,
+    0b01100110,
+    0b00110000,
+    0b00011100,
+    0b01000110,
+    0b00111100,
+    0b00000000,
+  },
+  // 'T'
+  {
+    0b00000000,
+    0b01111110,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+    0b00000000,
+  },
+  // 'U'
+  {
+    0b00000000,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b00111100,
+    0b00000000,
+  },
+  // 'V'
+  {
+    0b00000000,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b00111100,
+    0b00011000,
+    0b00000000,
+  },
+  // 'W'
+  {
+    0b00000000,
+    0b01000110,
+    0b01000110,
+    0b01000110,
+    0b01010110,
+    0b01111110,
+    0b01000110,
+    0b00000000,
+  },
+  // 'X'
+  {
+    0b00000000,
+    0b01100110,
+    0b01100110,
+    0b00111100,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b00000000,
+  },
+  // 'Y'
+  {
+    0b00000000,
+    0b01100110,
+    0b01100110,
+    0b00111100,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+    0b00000000,
+  },
+  // 'Z'
+  {
+    0b00000000,
+    0b01111110,
+    0b00000110,
+    0b00001100,
+    0b00011000,
+    0b00110000,
+    0b01111110,
+    0b00000000,
+  },
+  // '['
+  {
+    0b00000000,
+    0b01111110,
+    0b01000000,
+    0b01000000,
+    0b01000000,
+    0b01000000,
+    0b01111110,
+    0b00000000,
+  },
+  // '\\'
+  {
+    0b00000000,
+    0b01100000,
+    0b00110000,
+    0b00011000,
+    0b00001100,
+    0b00000110,
+    0b00000011,
+    0b00000000,
+  },
+  // ']'
+  {
+    0b00000000,
+    0b01111110,
+    0b00000010,
+    0b00000010,
+    0b00000010,
+    0b00000010,
+    0b01111110,
+    0b00000000,
+  },
+  // '^'
+  {
+    0b00000000,
+    0b00010000,
+    0b00101000,
+    0b01000100,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+  },
+  // '_'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b11111111,
+  },
+  // '`'
+  {
+    0b00000000,
+    0b00110000,
+    0b00011000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+  },
+  // 'a'
+  {
+    0b00000000,
+    0b00000000,
+    0b00111100,
+    0b00000110,
+    0b00111110,
+    0b01100110,
+    0b00111110,
+    0b00000000,
+  },
+  // 'b'
+  {
+    0b00000000,
+    0b01100000,
+    0b01100000,
+    0b01111100,
+    0b01100110,
+    0b01100110,
+    0b01111100,
+    0b00000000,
+  },
+  // 'c'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00111100,
+    0b01100000,
+    0b01100000,
+    0b00111100,
+    0b00000000,
+  },
+  // 'd'
+  {
+    0b00000000,
+    0b00000110,
+    0b00000110,
+    0b00111110,
+    0b01100110,
+    0b01100110,
+    0b00111110,
+    0b00000000,
+  },
+  // 'e'
+  {
+    0b00000000,
+    0b00000000,
+    0b00111100,
+    0b01100110,
+    0b01111110,
+    0b01100000,
+    0b00111100,
+    0b00000000,
+  },
+  // 'f'
+  {
+    0b00000000,
+    0b00011100,
+    0b00110000,
+    0b01111100,
+    0b00110000,
+    0b00110000,
+    0b00110000,
+    0b00000000,
+  },
+  // 'g'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00111110,
+    0b01100110,
+    0b00111110,
+    0b00000110,
+    0b01111000,
+  },
+  // 'h'
+  {
+    0b00000000,
+    0b01100000,
+    0b01100000,
+    0b01111100,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b00000000,
+  },
+  // 'i'
+  {
+    0b00000000,
+    0b00011000,
+    0b00000000,
+    0b00111000,
+    0b00011000,
+    0b00011000,
+    0b00111100,
+    0b00000000,
+  },
+  // 'j'
+  {
+    0b00000000,
+    0b00001100,
+    0b00000000,
+    0b00011100,
+    0b00001100,
+    0b00001100,
+    0b01101100,
+    0b00111000,
+  },
+  // 'k'
+  {
+    0b00000000,
+    0b01100000,
+    0b01100110,
+    0b01101100,
+    0b01111000,
+    0b01101100,
+    0b01100110,
+    0b00000000,
+  },
+  // 'l'
+  {
+    0b00000000,
+    0b00111000,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+    0b00111100,
+    0b00000000,
+  },
+  // 'm'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b11001100,
+    0b11111110,
+    0b11010110,
+    0b11000110,
+    0b00000000,
+  },
+  // 'n'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b01111100,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b00000000,
+  },
+  // 'o'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00111100,
+    0b01100110,
+    0b01100110,
+    0b00111100,
+    0b00000000,
+  },
+  // 'p'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b01111100,
+    0b01100110,
+    0b01111100,
+    0b01100000,
+    0b01100000,
+  },
+  // 'q'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00111110,
+    0b01100110,
+    0b00111110,
+    0b00000110,
+    0b00000110,
+  },
+  // 'r'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b01101110,
+    0b01110000,
+    0b01100000,
+    0b01100000,
+    0b00000000,
+  },
+  // 's'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b00111110,
+    0b01110000,
+    0b00001110,
+    0b01111100,
+    0b00000000,
+  },
+  // 't'
+  {
+    0b00000000,
+    0b00110000,
+    0b00110000,
+    0b01111100,
+    0b00110000,
+    0b00110110,
+    0b00011100,
+    0b00000000,
+  },
+  // 'u'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b01100110,
+    0b01100110,
+    0b01100110,
+    0b00111110,
+    0b00000000,
+  },
+  // 'v'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b11000110,
+    0b01101100,
+    0b00111000,
+    0b00010000,
+    0b00000000,
+  },
+  // 'w'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b11000110,
+    0b11010110,
+    0b11111110,
+    0b01101100,
+    0b00000000,
+  },
+  // 'x'
+  {
+    0b00000000,
+    0b00000000,
+    0b01100110,
+    0b00111100,
+    0b00011000,
+    0b00111100,
+    0b01100110,
+    0b00000000,
+  },
+  // 'y'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b01100110,
+    0b01100110,
+    0b00111110,
+    0b00000110,
+    0b01111000,
+  },
+  // 'z'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b01111100,
+    0b00011000,
+    0b00110000,
+    0b01111100,
+    0b00000000,
+  },
+  // '{'
+  {
+    0b00000000,
+    0b00001110,
+    0b00011000,
+    0b00011000,
+    0b01100000,
+    0b00011000,
+    0b00011000,
+    0b00001110,
+  },
+  // '|'
+  {
+    0b00000000,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+    0b00011000,
+  },
+  // '}'
+  {
+    0b00000000,
+    0b01110000,
+    0b00011000,
+    0b00011000,
+    0b00000110,
+    0b00011000,
+    0b00011000,
+    0b01110000,
+  },
+  // '~'
+  {
+    0b00000000,
+    0b00000000,
+    0b00000000,
+    0b01110110,
+    0b11011100,
+    0b00000000,
+    0b00000000,
+    0b00000000,
+  },
 };
 
-static constexpr const uint8_t Char_E[] {
-  0b00000000,
-  0b01111110,
-  0b01100000,
-  0b01111000,
-  0b01100000,
-  0b01100000,
-  0b01111110,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_F[] {
-  0b00000000,
-  0b01111110,
-  0b01100000,
-  0b01111000,
-  0b01100000,
-  0b01100000,
-  0b01100000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_G[] {
-  0b00000000,
-  0b00111100,
-  0b01100110,
-  0b01100000,
-  0b01101110,
-  0b01100110,
-  0b00111100,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_H[] {
-  0b00000000,
-  0b01100110,
-  0b01100110,
-  0b01111110,
-  0b01100110,
-  0b01100110,
-  0b01100110,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_I[] {
-  0b00000000,
-  0b00011000,
-  0b00011000,
-  0b00011000,
-  0b00011000,
-  0b00011000,
-  0b00011000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_J[] {
-  0b00000000,
-  0b00111110,
-  0b00000110,
-  0b00000110,
-  0b00000110,
-  0b01100110,
-  0b00111000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_K[] {
-  0b00000000,
-  0b01100110,
-  0b01101100,
-  0b01111000,
-  0b01111000,
-  0b01101100,
-  0b01100110,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_L[] {
-  0b00000000,
-  0b01100000,
-  0b01100000,
-  0b01100000,
-  0b01100000,
-  0b01100000,
-  0b01111110,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_M[] {
-  0b00000000,
-  0b01000010,
-  0b01100110,
-  0b01111110,
-  0b01010110,
-  0b01000110,
-  0b01000110,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_N[] {
-  0b00000000,
-  0b01000110,
-  0b01100110,
-  0b01110110,
-  0b01101110,
-  0b01100110,
-  0b01100010,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_O[] {
-  0b00000000,
-  0b00111100,
-  0b01100110,
-  0b01100110,
-  0b01100110,
-  0b01100110,
-  0b00111100,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_P[] {
-  0b00000000,
-  0b01111100,
-  0b01100110,
-  0b01100110,
-  0b01111100,
-  0b01100000,
-  0b01100000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_Q[] {
-  0b00000000,
-  0b00111100,
-  0b01100110,
-  0b01100110,
-  0b01100110,
-  0b01101110,
-  0b00111011,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_R[] {
-  0b00000000,
-  0b01111100,
-  0b01100110,
-  0b01100110,
-  0b01111100,
-  0b01101100,
-  0b01100110,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_S[] {
-  0b00000000,
-  0b00111100,
-  0b01100110,
-  0b00110000,
-  0b00011100,
-  0b01000110,
-  0b00111100,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_T[] {
-  0b00000000,
-  0b01111110,
-  0b00011000,
-  0b00011000,
-  0b00011000,
-  0b00011000,
-  0b00011000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_U[] {
-  0b00000000,
-  0b01100110,
-  0b01100110,
-  0b01100110,
-  0b01100110,
-  0b01100110,
-  0b00111100,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_V[] {
-  0b00000000,
-  0b01100110,
-  0b01100110,
-  0b01100110,
-  0b01100110,
-  0b00111100,
-  0b00011000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_W[] {
-  0b00000000,
-  0b01000110,
-  0b01000110,
-  0b01000110,
-  0b01010110,
-  0b01111110,
-  0b01000110,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_X[] {
-  0b00000000,
-  0b01100110,
-  0b01100110,
-  0b00111100,
-  0b01100110,
-  0b01100110,
-  0b01100110,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_Y[] {
-  0b00000000,
-  0b01100110,
-  0b01100110,
-  0b00111100,
-  0b00011000,
-  0b00011000,
-  0b00011000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_Z[] {
-  0b00000000,
-  0b01111110,
-  0b00000110,
-  0b00001100,
-  0b00011000,
-  0b00110000,
-  0b01111110,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_v[] {
-  0b00000000,
-  0b00000000,
-  0b00000000,
-  0b11000110,
-  0b01101100,
-  0b00111000,
-  0b00010000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_x[] {
-  0b00000000,
-  0b00000000,
-  0b01100110,
-  0b00111100,
-  0b00011000,
-  0b00111100,
-  0b01100110,
-  0b00000000,
-};
-
-
-static constexpr const uint8_t Char_z[] {
-  0b00000000,
-  0b00000000,
-  0b00000000,
-  0b01111100,
-  0b00011000,
-  0b00110000,
-  0b01111100,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_PERIOD[] {
-  0b00000000,
-  0b00000000,
-  0b00000000,
-  0b00000000,
-  0b00000000,
-  0b00110000,
-  0b00110000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_COLON[] {
-  0b00000000,
-  0b00110000,
-  0b00110000,
-  0b00000000,
-  0b00000000,
-  0b00110000,
-  0b00110000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_QUESTION[] {
-  0b00000000,
-  0b00111100,
-  0b01100110,
-  0b00001100,
-  0b00011000,
-  0b00000000,
-  0b00011000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_EXCLAMATION[] {
-  0b00000000,
-  0b00110000,
-  0b00110000,
-  0b00110000,
-  0b00110000,
-  0b00000000,
-  0b00110000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_AT[] {
-  0b00000000,
-  0b00111100,
-  0b01000010,
-  0b01011110,
-  0b01011100,
-  0b01000000,
-  0b00111100,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_SPACE[] {
-  0b00000000,
-  0b00000000,
-  0b00000000,
-  0b00000000,
-  0b00000000,
-  0b00000000,
-  0b00000000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_GT[] {
-  0b00000000,
-  0b00100000,
-  0b00010000,
-  0b00001000,
-  0b00000100,
-  0b00001000,
-  0b00010000,
-  0b00100000,
-};
-
-static constexpr const uint8_t Char_PLUS[] {
-  0b00000000,
-  0b00000000,
-  0b00010000,
-  0b00010000,
-  0b01111100,
-  0b00010000,
-  0b00010000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_MINUS[] {
-  0b00000000,
-  0b00000000,
-  0b00000000,
-  0b00000000,
-  0b01111100,
-  0b00000000,
-  0b00000000,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_SQBR_OPEN[] {
-  0b00000000,
-  0b01111110,
-  0b01000000,
-  0b01000000,
-  0b01000000,
-  0b01000000,
-  0b01111110,
-  0b00000000,
-};
-
-static constexpr const uint8_t Char_SQBR_CLOSE[] {
-  0b00000000,
-  0b01111110,
-  0b00000010,
-  0b00000010,
-  0b00000010,
-  0b00000010,
-  0b01111110,
-  0b00000000,
-};
-
-
 // clang-format on
 
 #endif // __BITMAPS_H__
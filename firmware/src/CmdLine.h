@@ -0,0 +1,107 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+
+#ifndef __CMDLINE_H__
+#define __CMDLINE_H__
+
+#include <cstdint>
+
+/// Collects the characters of a USB_COMMANDS request and splits the line into
+/// space-separated words. This has no Pico dependencies, so it can also be
+/// built on the host.
+class CmdLine {
+public:
+  static constexpr const uint32_t MaxLineSz = 64;
+  /// The command and its arguments.
+  static constexpr const uint32_t MaxWords = 4;
+
+private:
+  char Line[MaxLineSz + 1];
+  uint32_t Sz = 0;
+  /// The line was longer than MaxLineSz, so we drop it.
+  bool TooLong = false;
+  const char *Words[MaxWords];
+  uint32_t NumWords = 0;
+
+  static char toUpper(char C) {
+    return C >= 'a' && C <= 'z' ? C - 'a' + 'A' : C;
+  }
+
+  /// Splits Line into Words in place. \Returns false if there are too many.
+  bool split() {
+    NumWords = 0;
+    char *Ptr = Line;
+    while (true) {
+      while (*Ptr == ' ' || *Ptr == '\t')
+        *Ptr++ = '\0';
+      if (*Ptr == '\0')
+        return true;
+      if (NumWords == MaxWords)
+        return false;
+      Words[NumWords++] = Ptr;
+      while (*Ptr != '\0' && *Ptr != ' ' && *Ptr != '\t')
+        ++Ptr;
+    }
+  }
+
+public:
+  enum class Status {
+    /// Waiting for more characters.
+    Incomplete,
+    /// A line is ready, read it with size() and operator[].
+    Ready,
+    /// The line was too long or had too many words.
+    Error,
+  };
+  /// Adds \p C to the line. Lines end with '\n' or '\r', and empty lines are
+  /// skipped. After Ready or Error the next call starts a new line.
+  Status feed(char C) {
+    if (C != '\n' && C != '\r') {
+      if (Sz == MaxLineSz)
+        TooLong = true;
+      else
+        Line[Sz++] = C;
+      return Status::Incomplete;
+    }
+    Line[Sz] = '\0';
+    bool WasTooLong = TooLong;
+    Sz = 0;
+    TooLong = false;
+    if (WasTooLong || !split())
+      return Status::Error;
+    return NumWords == 0 ? Status::Incomplete : Status::Ready;
+  }
+  uint32_t size() const { return NumWords; }
+  const char *operator[](uint32_t Idx) const { return Words[Idx]; }
+  /// \Returns true if word \p Idx is \p Name, ignoring case. \p Name must be
+  /// upper case.
+  bool is(uint32_t Idx, const char *Name) const {
+    if (Idx >= NumWords)
+      return false;
+    const char *Word = Words[Idx];
+    for (; *Word != '\0' && *Name != '\0'; ++Word, ++Name)
+      if (toUpper(*Word) != *Name)
+        return false;
+    return *Word == '\0' && *Name == '\0';
+  }
+  /// Parses word \p Idx as a decimal number into \p Val. \Returns false if it
+  /// is missing, not a number or doesn't fit in 32 bits.
+  bool getUInt(uint32_t Idx, uint32_t &Val) const {
+    if (Idx >= NumWords || *Words[Idx] == '\0')
+      return false;
+    uint64_t Num = 0;
+    for (const char *Ptr = Words[Idx]; *Ptr != '\0'; ++Ptr) {
+      if (*Ptr < '0' || *Ptr > '9')
+        return false;
+      Num = Num * 10 + (*Ptr - '0');
+      if (Num > 0xffffffffu)
+        return false;
+    }
+    Val = (uint32_t)Num;
+    return true;
+  }
+};
+
+#endif // __CMDLINE_H__
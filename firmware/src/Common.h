@@ -12,6 +12,16 @@ static constexpr const int PXL_CLK_STEP = 10000;
 
 // Tolerate this much error in vertical Hz when auto-detecting the video mode.
 static constexpr int AUTO_DETECT_MODE_V_HZ_ERROR = 1;
+// Tolerate this much error in horizontal Hz when auto-detecting the video mode.
+static constexpr int AUTO_DETECT_MODE_H_HZ_ERROR = 1000;
+// Tolerate this much error in the lines per frame when auto-detecting.
+static constexpr int AUTO_DETECT_MODE_LINES_ERROR = 8;
+// Added to the score of a mode for each sync polarity that does not match.
+static constexpr float AUTO_DETECT_MODE_POLARITY_PENALTY = 2.0f;
+// Added to the score of a mode if the pin activity does not match.
+static constexpr float AUTO_DETECT_MODE_PINS_PENALTY = 1.0f;
+// If the two best modes are closer than this, check the pin activity.
+static constexpr float AUTO_DETECT_MODE_AMBIGUOUS_SCORE = 0.5f;
 
 static constexpr const uint32_t VGA_RGB_GPIO = 14; // 14-19, 2 bits per color
 static constexpr const uint32_t VGA_MDA_GPIO = 18;
@@ -26,6 +36,29 @@ static constexpr const uint32_t CGA_ACTUAL_RGB_GPIO = 8; // 8-13:BBGGRR
 
 static constexpr const uint32_t MDA_VI_GPIO = 26; // 26-27:IV (Intensity,Video)
 
+// The TTL input pins as seen by gpio_get_all(), used for telling apart the
+// signal types when the timings are not enough.
+static constexpr const uint32_t TTL_PRIMARY_RGB_MASK =
+    1u << 1 | 1u << 3 | 1u << 5; // PB, PG, PR
+static constexpr const uint32_t TTL_SECONDARY_RED_MASK = 1u << 4; // SR
+static constexpr const uint32_t TTL_MONO_MASK =
+    1u << 0 | 1u << 2; // SB (MDA Video), SG (MDA Intensity)
+/// All the TTL pins checked for activity.
+static constexpr const uint32_t TTL_PIN_ACTIVITY_MASK =
+    TTL_PRIMARY_RGB_MASK | TTL_SECONDARY_RED_MASK | TTL_MONO_MASK;
+/// Collect the pin activity over this many frames.
+static constexpr const uint32_t PIN_ACTIVITY_FRAMES = 4;
+/// If we saw no activity (e.g., black screen) sample again after this many
+/// mode checks.
+static constexpr const uint32_t PIN_ACTIVITY_RETRY_CNT = 16;
+/// Synthesize a mode for an unknown signal only after its lines per frame
+/// have been stable for this many mode checks.
+static constexpr const uint32_t ADAPTIVE_MODE_STABLE_CNT = 4;
+/// Save a learned mode to flash once the content of this many non-black
+/// frames has fit in its visible lines.
+static constexpr const uint32_t ADAPTIVE_MODE_SAVE_FRAMES = 300;
+static constexpr const uint32_t ADAPTIVE_MODE_DISPLAY_MS = 3000;
+
 static constexpr const uint32_t AUTO_ADJUST_GPIO = 28;
 static constexpr const uint32_t PX_CLK_BTN_GPIO = 22;
 
@@ -57,8 +90,38 @@ static constexpr const int MANUAL_TTL_XBORDER_STEP = 4;
 static constexpr const int MANUAL_TTL_YBORDER_STEP = 1;
 static constexpr const int MANUAL_TTL_MAX_XBORDER = 400;
 static constexpr const int MANUAL_TTL_MAX_YBORDER = 200;
+/// Manual TTL AUTO-SIZE: Skip this many frames after widening the capture
+/// area, as this may switch the PIOs.
+static constexpr const uint32_t AUTO_SIZE_SETTLE_FRAMES = 8;
+/// Manual TTL AUTO-SIZE: Measure for this many frames.
+static constexpr const uint32_t AUTO_SIZE_FRAMES = 48;
+/// Manual TTL AUTO-SIZE: Scan this many frame-buffer rows per frame.
+static constexpr const uint32_t AUTO_SIZE_ROWS_PER_FRAME = 32;
 
 static constexpr const uint32_t NO_TTL_SIGNAL_MS = 800;
+/// The lines captured by the logic analyzer, when triggered by VSync and
+/// by HSync. The sample rate drops if they don't fit in RAM at the maximum.
+static constexpr const uint32_t LOGIC_ANALYZER_VSYNC_LINES = 32;
+static constexpr const uint32_t LOGIC_ANALYZER_HSYNC_LINES = 4;
+/// Give up if the trigger doesn't come in time, e.g. with no signal.
+static constexpr const uint32_t LOGIC_ANALYZER_TIMEOUT_MS = 500;
+static constexpr const uint32_t LOGIC_ANALYZER_DISPLAY_MS = 3000;
+/// The most time USB_STREAM spends sending per frame. With an input signal
+/// it also stops at the VSync retrace, so this matters with no signal.
+static constexpr const uint32_t USB_STREAM_MAX_TICK_US = 10000;
+/// USB_COMMANDS reads at most this many characters per frame.
+static constexpr const uint32_t USB_COMMANDS_MAX_CHARS = 64;
+/// The pixel clocks accepted by USB_COMMANDS.
+static constexpr const uint32_t USB_COMMANDS_PXCLK_MIN = 4000000;
+static constexpr const uint32_t USB_COMMANDS_PXCLK_MAX = 30000000;
+/// DBGPRINT: The bytes of messages buffered per core, see DebugLog.
+static constexpr const uint32_t DEBUG_LOG_BYTES = 2048;
+/// DBGPRINT: The most time the capture spends sending messages per frame.
+static constexpr const uint32_t DEBUG_LOG_MAX_TICK_US = 2000;
+/// DBGPRINT: How long DebugLog::flush() waits for USB.
+static constexpr const uint32_t DEBUG_LOG_FLUSH_MS = 500;
+/// The events kept by Trace per core. Each one is 20 bytes.
+static constexpr const uint32_t TRACE_ENTRIES = 64;
 static constexpr const uint32_t PROFILE_DISPLAY_MS = 4000;
 static constexpr const uint32_t UNKNOWN_MODE_MS = 2000;
 /// Limit the number of times we will show the "unknown mode" message.
@@ -66,6 +129,11 @@ static constexpr const uint32_t UNKNOWN_MODE_SHOW_MSG_MAX_COUNT = 3;
 /// Wait for a bit until we print the "unknown mode message"
 static constexpr const uint32_t UNKNOWN_MODE_SHOW_MSG_MIN_COUNT = 2;
 static constexpr const int TTL_MOD = 4;
+/// Lock to a new mode after this many consecutive matching measurements of the
+/// sync counters. We get one VSync measurement per frame.
+static constexpr const uint32_t SYNC_LOCK_STABLE_CNT = 2;
+/// Sync periods within this per-mille of each other are considered the same.
+static constexpr const uint32_t SYNC_LOCK_PERMILLE = 5;
 
 static constexpr const uint32_t LED_FRAME_MOD = 128;
 static constexpr const uint32_t LED_MOD_ON = 0;
@@ -77,6 +145,22 @@ static constexpr const uint32_t AUTO_ADJUST_THROTTLE_CNT = 4;
 static constexpr const uint32_t AUTO_ADJUST_START_AFTER = 2;
 /// Duration in frames.
 static constexpr const uint32_t AUTO_ADJUST_DURATION = 16;
+/// Continuous auto-adjust: the number of non-dark frames accumulated into the
+/// border histograms before we check if we need to re-center.
+static constexpr const uint32_t AUTO_ADJUST_CONT_WINDOW = 64;
+/// Continuous auto-adjust: frames with fewer non-empty lines are dark.
+static constexpr const uint32_t AUTO_ADJUST_CONT_MIN_LINES = 16;
+/// Continuous auto-adjust: the left border is the one that this permille of
+/// the non-empty lines are at or left of. Filters out stray pixels.
+static constexpr const uint32_t AUTO_ADJUST_CONT_X_PERMILLE = 10;
+/// Continuous auto-adjust: re-center only if the borders moved by at least
+/// this many pixels or lines...
+static constexpr const uint32_t AUTO_ADJUST_CONT_X_HYSTERESIS = 8;
+static constexpr const uint32_t AUTO_ADJUST_CONT_Y_HYSTERESIS = 2;
+/// ...for this many consecutive windows.
+static constexpr const uint32_t AUTO_ADJUST_CONT_PERSIST_WINDOWS = 2;
+/// Continuous auto-adjust: minimum time between writes to flash.
+static constexpr const uint32_t AUTO_ADJUST_CONT_SAVE_INTERVAL_MS = 60000;
 
 /// Button LongPress cnt (in frames)
 static constexpr const int BTN_LONG_PRESS_FRAMES = 60;
@@ -97,9 +181,6 @@ static constexpr const uint32_t BrightCyan = 0b011111;
 static constexpr const uint32_t HMask = 0b01000000;
 static constexpr const uint32_t VMask = 0b10000000;
 
-static constexpr const uint32_t VGADarkYellow = 0b101000 | HMask; // VHRRGGBB
-static constexpr const uint32_t VGABrown      = 0b100100 | HMask;
-
 static constexpr const uint32_t HMask_4 =
     HMask | HMask << 8 | HMask << 16 | HMask << 24;
 static constexpr const uint32_t VMask_4 =
@@ -131,6 +212,9 @@ static constexpr const uint32_t BlackMDA_8_HV =
 static constexpr const uint32_t BlackMDA_8_V = BlackMDA_8 | VMaskMDA_8;
 
 static constexpr const uint32_t MDAPixels = 800;
+/// MDA_RESAMPLE_640: This many MDA columns get scaled to MDA_RESAMPLE_DST.
+static constexpr const uint32_t MDA_RESAMPLE_SRC = 720;
+static constexpr const uint32_t MDA_RESAMPLE_DST = 640;
 static constexpr const uint32_t MDALines = 600;
 
 static constexpr const uint32_t TTLVMask = 1u << TTL_VSYNC_GPIO;
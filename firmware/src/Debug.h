@@ -9,6 +9,8 @@
 
 
 #ifdef DBGPRINT
+// Only debug builds link iostream.
+#include <iostream>
 #define DBG_PRINT(...)                                                         \
   { __VA_ARGS__ }
 #else
@@ -0,0 +1,88 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+
+#include "DebugLog.h"
+
+#ifdef DBGPRINT
+
+#include "hardware/sync.h"
+#include "pico/stdio_usb.h"
+#include "tusb.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+DebugLog::Ring DebugLog::Rings[2];
+
+static DebugLog Log;
+
+void DebugLog::install() { std::cout.rdbuf(&Log); }
+
+void DebugLog::push(const char *Data, uint32_t Sz) {
+  Ring &R = Rings[get_core_num()];
+  uint32_t Head = R.Head;
+  if (Sz > DEBUG_LOG_BYTES - (Head - R.Tail)) {
+    R.Dropped = R.Dropped + Sz;
+    return;
+  }
+  uint32_t Idx = Head % DEBUG_LOG_BYTES;
+  uint32_t First = std::min(Sz, DEBUG_LOG_BYTES - Idx);
+  memcpy(&R.Buf[Idx], Data, First);
+  memcpy(&R.Buf[0], Data + First, Sz - First);
+  // The data must be in the ring before the consumer can see it.
+  __dmb();
+  R.Head = Head + Sz;
+}
+
+DebugLog::int_type DebugLog::overflow(int_type C) {
+  if (traits_type::eq_int_type(C, traits_type::eof()))
+    return traits_type::not_eof(C);
+  char Ch = traits_type::to_char_type(C);
+  push(&Ch, 1);
+  return C;
+}
+
+std::streamsize DebugLog::xsputn(const char *Data, std::streamsize Sz) {
+  push(Data, (uint32_t)Sz);
+  return Sz;
+}
+
+void DebugLog::drainRing(Ring &R, absolute_time_t Deadline, bool Wait) {
+  uint32_t Tail = R.Tail;
+  uint32_t Head = R.Head;
+  __dmb();
+  if (!stdio_usb_connected()) {
+    // Nobody is listening, so don't let the messages pile up.
+    R.Tail = Head;
+    R.ReportedDropped = R.Dropped;
+    return;
+  }
+  while (Tail != Head && !time_reached(Deadline)) {
+    uint32_t Avail = tud_cdc_write_available();
+    if (Avail == 0) {
+      if (!Wait)
+        break;
+      continue;
+    }
+    uint32_t Idx = Tail % DEBUG_LOG_BYTES;
+    uint32_t Sz = std::min({Head - Tail, DEBUG_LOG_BYTES - Idx, Avail});
+    stdio_usb.out_chars(&R.Buf[Idx], Sz);
+    Tail += Sz;
+    // Done reading before the producer can reuse the space.
+    __dmb();
+    R.Tail = Tail;
+  }
+  uint32_t Dropped = R.Dropped;
+  if (Tail == Head && Dropped != R.ReportedDropped) {
+    char Msg[48];
+    int Sz = snprintf(Msg, sizeof(Msg), "\n[DebugLog: dropped %lu bytes]\n",
+                      (unsigned long)(Dropped - R.ReportedDropped));
+    stdio_usb.out_chars(Msg, Sz);
+    R.ReportedDropped = Dropped;
+  }
+}
+
+#endif // DBGPRINT
@@ -0,0 +1,68 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+
+#ifndef __DEBUGLOG_H__
+#define __DEBUGLOG_H__
+
+#include <config.h>
+
+#ifdef DBGPRINT
+
+#include "Common.h"
+#include "pico/time.h"
+#include <cstdint>
+#include <streambuf>
+
+/// Replaces the stream buffer of std::cout, so that the DBG_PRINT messages
+/// don't block the video loops on the USB serial. Each core writes into its
+/// own ring, so a ring has a single producer and needs no lock, and drain()
+/// sends them to USB when the capture has time to spare. The messages are
+/// still formatted by iostream on the core that prints them, but that is
+/// quick compared to waiting for USB. If a ring is full the message is
+/// dropped, and drain() reports how many bytes were lost.
+///
+/// std::cerr still writes to USB right away, for the errors.
+class DebugLog : public std::streambuf {
+  struct Ring {
+    char Buf[DEBUG_LOG_BYTES];
+    /// Free-running indexes, the used bytes are Head - Tail.
+    volatile uint32_t Head = 0;
+    volatile uint32_t Tail = 0;
+    /// Written by the producer, reported by the consumer.
+    volatile uint32_t Dropped = 0;
+    uint32_t ReportedDropped = 0;
+  };
+  static_assert((DEBUG_LOG_BYTES & (DEBUG_LOG_BYTES - 1)) == 0,
+                "Must be a power of 2");
+  static Ring Rings[2];
+
+  static void push(const char *Data, uint32_t Sz);
+  static void drainRing(Ring &R, absolute_time_t Deadline, bool Wait);
+
+protected:
+  int_type overflow(int_type C) override;
+  std::streamsize xsputn(const char *Data, std::streamsize Sz) override;
+
+public:
+  /// Redirects std::cout to the rings.
+  static void install();
+  /// Sends the messages of both cores to USB, until the rings are empty, USB
+  /// can't take more without blocking, or \p Deadline is reached. There must
+  /// be a single consumer: core0 until it starts core1, then core1.
+  static void drain(absolute_time_t Deadline) {
+    for (Ring &R : Rings)
+      drainRing(R, Deadline, /*Wait=*/false);
+  }
+  /// Like drain() but waits for USB, for when timing doesn't matter.
+  static void flush() {
+    auto Deadline = make_timeout_time_ms(DEBUG_LOG_FLUSH_MS);
+    for (Ring &R : Rings)
+      drainRing(R, Deadline, /*Wait=*/true);
+  }
+};
+
+#endif // DBGPRINT
+
+#endif // __DEBUGLOG_H__
@@ -10,19 +10,18 @@
 #elif defined(PICO_RP2350)
 #include "xpm/splash.xpm"
 #endif
+#include <algorithm>
 #include <cstring>
 
 DisplayBuffer::DisplayBuffer() : SplashXPM(splash) {
-  // The DMA is used for copying txt to screen.
-  DMAChannel = dma_claim_unused_channel(true);
   DMAChannel2 = dma_claim_unused_channel(true);
 }
 
 void DisplayBuffer::clear() {
   memset(Buffer, 0, BuffX * BuffY);
 }
-void DisplayBuffer::clearTxtBuffer() {
-  memset(TxtBuffer, 0, TxtBuffX * TxtBuffY);
+void DisplayBuffer::clearOverlay() {
+  memset(Overlay, 0, BuffX * OverlayLines);
 }
 
 void DisplayBuffer::noSignal() {
@@ -30,131 +29,147 @@ void DisplayBuffer::noSignal() {
   int Zoom = TTLReader::isHighRes(*TimingsTTL) ? 2 : 1;
   SplashXPM.show(*this, *TimingsTTL, 0, 0, Zoom);
 
-  // Print the version at the bottom of the screen.
+  // Print the version at the bottom right of the screen.
   char Version[8];
   snprintf(Version, 8, "v%d.%d.%d", REVISION_MAJOR, REVISION_MINOR,
            REVISION_PATCH);
-  displayTxt(Version, 0, /*Center=*/false);
-  // Special case for MDA because we print 2 pixels per byte.
-  int DisplayWidth = TimingsTTL->Mode == TTL::MDA ? TimingsTTL->H_Visible / 2
-                                                  : TimingsTTL->H_Visible;
   int VersionLen = strlen(Version);
-  for (int Line = 0; Line != BMapHeight; ++Line) {
-    memcpy(&Buffer[TimingsTTL->V_Visible - 2 * TxtBuffY + Line]
-                  [DisplayWidth - (VersionLen * 2) * BMapWidth],
-           &TxtBuffer[Line][0], VersionLen * BMapWidth);
-  }
+  // The right margin is twice the text width in buffer bytes.
+  int PixelsPerByte = getPixelsPerByte();
+  int X = (int)TimingsTTL->H_Visible -
+          (VersionLen * 2) * BMapWidth * PixelsPerByte;
+  int Y = TimingsTTL->V_Visible - 2 * BMapHeight;
+  uint32_t FgColor = TimingsTTL->Mode == TTL::MDA ? White : BrightCyan;
+  for (int Idx = 0; Idx != VersionLen; ++Idx)
+    displayChar(Version[Idx], X + Idx * BMapWidth, Y, Buffer, FgColor, Black);
 }
 
-void DisplayBuffer::setPixel(uint8_t Pixel, int X, int Y,
-                             uint8_t Buff[][BuffX]) {
-  int MaxBuffX;
-  int MaxBuffY;
-  if (Buff == Buffer) {
-    MaxBuffX = BuffX;
-    MaxBuffY = BuffY;
-  } else if (Buff == TxtBuffer) {
-    MaxBuffX = TxtBuffX;
-    MaxBuffY = TxtBuffY;
-  } else {
-    Utils::unreachable("setPixel() Unimplemented Buff!");
-  }
-  // Avoid out of bounds accesses.
-  if (X >= MaxBuffX || Y >= MaxBuffY || X < 0 || Y < 0) {
-    DBG_PRINT(std::cout << __FUNCTION__ << " Out of bounds X=" << X
-                        << " Y=" << Y << "\n";)
+void DisplayBuffer::updateNibbleLUT(uint32_t FgColor, uint32_t BgColor) {
+  bool IsMDA = TimingsTTL->Mode == TTL::MDA;
+  uint32_t Key = (FgColor & 0xff) | (BgColor & 0xff) << 8 | IsMDA << 16 |
+                 HalfRate << 17;
+  if (Key == NibbleLUTKey)
     return;
-  }
-
-  switch (TimingsTTL->Mode) {
-  case TTL::CGA:
-  case TTL::EGA:
-    Buff[Y][X] = Pixel;
-    break;
-  case TTL::MDA: {
-    bool IsFirst = X % 2 == 0;
-    if (IsFirst) {
-      Buff[Y][X / 2] &= 0xf0;
-      Buff[Y][X / 2] |= Pixel & 0x0f;
-    } else {
-      Buff[Y][X / 2] &= 0x0f;
-      Buff[Y][X / 2] |= Pixel & 0xf0;
+  NibbleLUTKey = Key;
+  int PixelsPerByte = getPixelsPerByte();
+  for (uint32_t Nibble = 0; Nibble != 16; ++Nibble) {
+    uint32_t Word = 0;
+    for (int Px = 0; Px != 4; ++Px) {
+      uint32_t Pixel = (Nibble & (0b1000 >> Px) ? FgColor : BgColor) & 0xff;
+      // MDA has the first pixel in the low nibble. In HalfRate the 2 pixels
+      // get merged so that 1-pixel wide strokes don't disappear.
+      if (IsMDA)
+        Pixel &= Px % 2 == 0 ? 0x0f : 0xf0;
+      Word |= Pixel << (8 * (Px / PixelsPerByte));
     }
-    break;
-  }
+    NibbleLUT[Nibble] = Word;
   }
 }
 
-void DisplayBuffer::showBitmap(const uint8_t *BMap, int X, int Y,
-                               uint8_t Buff[][BuffX], uint32_t FgColor,
-                               uint32_t BgColor, int ZoomXLevel,
-                               int ZoomYLevel) {
+void DisplayBuffer::displayChar(char C, int X, int Y, uint8_t Buff[][BuffX],
+                                uint32_t FgColor, uint32_t BgColor,
+                                int ZoomXLevel, int ZoomYLevel) {
+  const int MaxBuffY = Buff == Overlay ? OverlayLines : BuffY;
+  ZoomXLevel = std::clamp(ZoomXLevel, 1, MaxZoom);
+  const int PixelsPerByte = getPixelsPerByte();
+  // A glyph row is BMapWidth * ZoomXLevel pixels, so it is a whole number of
+  // words in any format.
+  const int NumWords = BMapWidth * ZoomXLevel / PixelsPerByte / 4;
+  const int Byte = X / PixelsPerByte & ~0b11;
+  if (X < 0 || Y < 0 || Byte + NumWords * 4 > (int)BuffX ||
+      Y + BMapHeight * ZoomYLevel > MaxBuffY) {
+    DBG_PRINT(std::cout << __FUNCTION__ << " Out of bounds X=" << X
+                        << " Y=" << Y << "\n";)
+    return;
+  }
+  updateNibbleLUT(FgColor, BgColor);
+  const uint8_t *Glyph = getGlyph(C);
   for (int Line = 0; Line != BMapHeight; ++Line) {
-    for (int Bit = 0; Bit != BMapWidth; ++Bit) {
-      for (int ZoomX = 0; ZoomX != ZoomXLevel; ++ZoomX) {
-        for (int ZoomY = 0; ZoomY != ZoomYLevel; ++ZoomY) {
-          bool IsBitSet = BMap[Line] & (0b1 << Bit);
-          uint8_t Pixel = IsBitSet ? FgColor : BgColor;
-          setPixel(Pixel, X + ZoomXLevel * (BMapWidth - Bit) - ZoomX,
-                   Y + ZoomYLevel * Line + ZoomY, Buff);
-        }
+    // Repeat each bit ZoomXLevel times.
+    uint32_t Bits = Glyph[Line];
+    if (ZoomXLevel != 1) {
+      Bits = 0;
+      for (int Bit = BMapWidth - 1; Bit >= 0; --Bit)
+        Bits = Bits << ZoomXLevel |
+               ((Glyph[Line] >> Bit) & 1) * ((1u << ZoomXLevel) - 1);
+    }
+    // Expand the row, starting from the leftmost nibble.
+    uint32_t Words[MaxZoom * BMapWidth / 4];
+    int Shift = BMapWidth * ZoomXLevel;
+    for (int W = 0; W != NumWords; ++W) {
+      Shift -= 4;
+      uint32_t Word = NibbleLUT[(Bits >> Shift) & 0xf];
+      if (PixelsPerByte == 2) {
+        Shift -= 4;
+        Word |= NibbleLUT[(Bits >> Shift) & 0xf] << 16;
       }
+      Words[W] = Word;
+    }
+    for (int ZoomY = 0; ZoomY != ZoomYLevel; ++ZoomY) {
+      auto *Dst = (uint32_t *)&Buff[Y + Line * ZoomYLevel + ZoomY][Byte];
+      for (int W = 0; W != NumWords; ++W)
+        Dst[W] = Words[W];
     }
   }
 }
 
-void DisplayBuffer::displayChar(char C, int X, int Y, uint8_t Buff[][BuffX],
-                                uint32_t FgColor, uint32_t BgColor,
-                                int ZoomXLevel, int ZoomYLevel) {
-  const uint8_t *CharBMap = getCharSafe(C);
-  showBitmap(CharBMap, X, Y, Buff, FgColor, BgColor, ZoomXLevel, ZoomYLevel);
-}
-
-void DisplayBuffer::displayPage(const Utils::StaticString<640> &PageTxt, bool Center) {
-  clear();
-
+bool DisplayBuffer::displayPage(const Utils::StaticString<640> &PageTxt,
+                                bool Center) {
   DBG_PRINT(std::cout << __FUNCTION__ << " PageTxt:\n" << PageTxt << "\n";)
-  static constexpr const int LineSpacing = 0;
   int LeftBorder = 20;
   int TopBorder = 20;
 
   uint32_t FgColor = TimingsTTL->Mode == TTL::MDA ? White : BrightCyan;
   uint32_t BgColor = Black;
 
-  if (Center) {
-    // Find longest line.
-    int MaxLineSz = 0;
-    int NumLines = 0;
-    for (int Idx = 0, LastNL = 0, E = PageTxt.size(); Idx != E; ++Idx) {
-      if (PageTxt[Idx] == '\n') {
-        MaxLineSz = std::max(MaxLineSz, Idx - LastNL);
-        LastNL = Idx;
-        ++NumLines;
-      }
+  // Find longest line.
+  int MaxLineSz = 0;
+  int NumLines = 0;
+  for (int Idx = 0, LastNL = 0, E = PageTxt.size(); Idx != E; ++Idx) {
+    if (PageTxt[Idx] == '\n') {
+      MaxLineSz = std::max(MaxLineSz, Idx - LastNL);
+      LastNL = Idx;
+      ++NumLines;
     }
+  }
+  if (Center) {
     // Calculate the offset such that the text is centered.
     LeftBorder = TimingsTTL->H_Visible / 2 - MaxLineSz * BMapWidth / 2;
-    TopBorder =
-        TimingsTTL->V_Visible / 2 - NumLines * (BMapHeight + LineSpacing) / 2;
+    TopBorder = TimingsTTL->V_Visible / 2 - NumLines * BMapHeight / 2;
   }
 
-  int X = LeftBorder;
+  // Each line of the page is one overlay row, so the image around the page
+  // stays live.
+  bool OnOverlay = NumLines <= (int)OverlayRows;
+  uint8_t(*Dst)[BuffX] = Buffer;
   int Y = TopBorder;
+  if (OnOverlay) {
+    hideOverlay();
+    clearOverlay();
+    Dst = Overlay;
+    Y = 0;
+  } else {
+    clear();
+  }
+  int X = LeftBorder;
   for (char C : PageTxt) {
     if (C == '\n') {
-      Y += BMapHeight + LineSpacing;
+      Y += BMapHeight;
       X = LeftBorder;
       continue;
     }
-    displayChar(C, X, Y, Buffer, FgColor, BgColor);
+    displayChar(C, X, Y, Dst, FgColor, BgColor);
     X += BMapWidth;
   }
+  if (OnOverlay)
+    showOverlay(std::max(TopBorder, 0), (1u << NumLines) - 1);
   DBG_PRINT(std::cout << __FUNCTION__ << "----END----\n";)
+  return OnOverlay;
 }
 
 void DisplayBuffer::displayTxt(const char *Line, int X, bool Center) {
   DBG_PRINT(std::cout << "displayTxt(" << Line << ")\n";)
-  clearTxtBuffer();
+  clearOverlay();
 
   static constexpr const int ZoomXLevel = 1;
   static constexpr const int ZoomYLevel = 1;
@@ -170,26 +185,12 @@ void DisplayBuffer::displayTxt(const char *Line, int X, bool Center) {
   uint32_t BgColor = Black;
   for (int Idx = 0; Idx != LineSz; ++Idx) {
     char C = Line[Idx];
-    displayChar(C, ActualX, ActualY, TxtBuffer, FgColor, BgColor, ZoomXLevel,
+    displayChar(C, ActualX, ActualY, Overlay, FgColor, BgColor, ZoomXLevel,
                 ZoomYLevel);
     ActualX += BMapWidth * ZoomXLevel;
   }
 }
 
-void DisplayBuffer::copyTxtBufferToScreen() {
-  if (dma_channel_is_busy(DMAChannel))
-    return;                     // Not sure it's needed
-  dma_channel_config DMAConfig = dma_channel_get_default_config(DMAChannel);
-  channel_config_set_transfer_data_size(&DMAConfig, DMA_SIZE_32);
-  channel_config_set_read_increment(&DMAConfig, true);
-  channel_config_set_write_increment(&DMAConfig, true);
-  dma_channel_configure(DMAChannel, &DMAConfig,
-                        /*Dst=*/&Buffer[getTxtLineYTop()][0],
-                        /*Src=*/TxtBuffer,
-                        /*Transfers=*/TxtBuffX * TxtBuffY / /*DMA_SIZE_32*/ 4,
-                        true /*Start immediately*/);
-}
-
 void __not_in_flash_func(DisplayBuffer::fillBottomWithBlackAfter)(uint32_t Line) {
   if (Line >= BuffY)
     return;
@@ -12,72 +12,21 @@
 #include "Timings.h"
 #include "XPM2.h"
 #include "hardware/dma.h"
-#include <iostream>
+#include "hardware/interp.h"
+#include <array>
+#include <cstring>
 #include <pico/stdlib.h>
 
 class DisplayBuffer {
   friend class XPM2;
-  // The DMA used for copying text from TxtBuffer to Buffer.
-  int DMAChannel;
   // The DMA used for filling in the frame buffer border with black.
   int DMAChannel2;
 
-  const uint8_t *getCharSafe(char C) {
-    // clang-format off
-    switch(C) {
-    case '0': return Char_0;
-    case '1': return Char_1;
-    case '2': return Char_2;
-    case '3': return Char_3;
-    case '4': return Char_4;
-    case '5': return Char_5;
-    case '6': return Char_6;
-    case '7': return Char_7;
-    case '8': return Char_8;
-    case '9': return Char_9;
-    case 'A': return Char_A;
-    case 'B': return Char_B;
-    case 'C': return Char_C;
-    case 'D': return Char_D;
-    case 'E': return Char_E;
-    case 'F': return Char_F;
-    case 'G': return Char_G;
-    case 'H': return Char_H;
-    case 'I': return Char_I;
-    case 'J': return Char_J;
-    case 'K': return Char_K;
-    case 'L': return Char_L;
-    case 'M': return Char_M;
-    case 'N': return Char_N;
-    case 'O': return Char_O;
-    case 'P': return Char_P;
-    case 'Q': return Char_Q;
-    case 'R': return Char_R;
-    case 'S': return Char_S;
-    case 'T': return Char_T;
-    case 'U': return Char_U;
-    case 'V': return Char_V;
-    case 'W': return Char_W;
-    case 'X': return Char_X;
-    case 'Y': return Char_Y;
-    case 'Z': return Char_Z;
-    case 'v': return Char_v;
-    case 'x': return Char_x;
-    case 'z': return Char_z;
-    case '.': return Char_PERIOD;
-    case ':': return Char_COLON;
-    case '?': return Char_QUESTION;
-    case '!': return Char_EXCLAMATION;
-    case '@': return Char_AT;
-    case ' ': return Char_SPACE;
-    case '>': return Char_GT;
-    case '+': return Char_PLUS;
-    case '-': return Char_MINUS;
-    case '[': return Char_SQBR_OPEN;
-    case ']': return Char_SQBR_CLOSE;
-    default: return Char_SPACE;
-    }
-    // clang-format on
+  /// \Returns the glyph of \p C, or a blank one if C isn't printable.
+  static const uint8_t *getGlyph(char C) {
+    if (C < FontFirst || C > FontLast)
+      C = ' ';
+    return FontAtlas[C - FontFirst];
   }
 
 public:
@@ -94,35 +43,75 @@ private:
   }
   /// This is linked to TTLReader's TTL mode.
   const TTLDescr *TimingsTTL = nullptr;
+  /// The CGA lines hold 320 pixels that get doubled on output, so like MDA
+  /// each byte covers 2 pixels.
+  bool HalfRate = false;
+
+  /// The on-screen text overlay. These are a few rows of text in the frame
+  /// buffer format, which the scanout shows instead of the frame buffer lines
+  /// under them. So the capture never has to skip the text lines and the
+  /// image under the text is left intact. The RP2040 only has room for the
+  /// single line of displayTxt().
+#if defined(PICO_RP2040)
+  static constexpr const uint32_t OverlayRows = 1;
+#else
+  static constexpr const uint32_t OverlayRows = 16;
+#endif
+  static constexpr const uint32_t OverlayLines = OverlayRows * BMapHeight;
+  uint8_t Overlay[OverlayLines][BuffX] __attribute__((aligned(4)));
+  /// The buffer line where the first overlay row is shown.
+  volatile uint32_t OverlayY = 0;
+  /// Bit N enables overlay row N. Set by core1, read by the scanout on core0.
+  volatile uint32_t OverlayMask = 0;
 
-  static constexpr const int TxtBuffY = 8;
-  static constexpr const int TxtBuffX = BuffX;
-  uint8_t TxtBuffer[TxtBuffY][TxtBuffX] __attribute__((aligned(4)));
+  /// The 4 pixels of each nibble of a glyph row, in the buffer format and in
+  /// the colors of NibbleLUTKey. With 1 pixel per byte each entry is a whole
+  /// word, otherwise it is the low half of one.
+  std::array<uint32_t, 16> NibbleLUT;
+  uint32_t NibbleLUTKey = 0xffffffff;
+  /// Rebuilds NibbleLUT if the colors or the buffer format changed.
+  void updateNibbleLUT(uint32_t FgColor, uint32_t BgColor);
+  /// \Returns 2 for MDA and the 320-pixel capture, 1 otherwise.
+  int getPixelsPerByte() const {
+    return TimingsTTL->Mode == TTL::MDA || HalfRate ? 2 : 1;
+  }
 
 public:
   /// The top of the text, counting from the top of the buffer.
   uint32_t getTxtLineYTop() const { return TimingsTTL->V_Visible / 2; }
-  /// The bottom of the text, counting from the top of the buffer.
-  uint32_t getTxtLineYBot() const { return getTxtLineYTop() + TxtBuffY; }
   DisplayBuffer();
   void clear();
-  void clearTxtBuffer();
+  void clearOverlay();
   void noSignal();
-  /// Writes to TxtBuffer.
-  void setPixel(uint8_t Pixel, int X, int Y, uint8_t Buff[][BuffX]);
-  /// Writes to TxtBuffer.
-  void showBitmap(const uint8_t *BMap, int X, int Y, uint8_t Buff[][BuffX],
-                  uint32_t FgColor, uint32_t BgColor, int ZoomXLevel = 1,
-                  int ZoomYLevel = 1);
+  static constexpr const int MaxZoom = 4;
+  /// Draws \p C at pixel \p X of line \p Y of \p Buff, which is either the
+  /// frame buffer or the overlay. X is rounded down to a whole word, so each
+  /// glyph row is written as whole words. Glyphs that don't fit are skipped.
   void displayChar(char C, int X, int Y, uint8_t Buff[][BuffX],
                    uint32_t FgColor, uint32_t BgColor, int ZoomXLevel = 1,
                    int ZoomYLevel = 1);
-  /// Writes Line to TxtBuffer.
+  /// Writes Line to the first overlay row. Use showOverlay() to show it.
   void displayTxt(const char *Line, int X, bool Center = false);
-  /// Write a text page to the dipslay buffer (not TxtBuffer).
-  void displayPage(const Utils::StaticString<640> &PageTxt, bool Center = true);
-  /// Copy TxtBuffer to Buffer, i.e. show text on screen.
-  void copyTxtBufferToScreen();
+  /// Shows a text page in the overlay. \Returns false if the page has more
+  /// lines than OverlayRows, in which case it is written to the frame buffer
+  /// and the capture must be stopped while it is shown.
+  bool displayPage(const Utils::StaticString<640> &PageTxt, bool Center = true);
+  /// Shows the overlay rows enabled in \p Mask starting at buffer line \p Y.
+  void showOverlay(uint32_t Y, uint32_t Mask) {
+    OverlayMask = 0;
+    OverlayY = Y;
+    OverlayMask = Mask;
+  }
+  void hideOverlay() { OverlayMask = 0; }
+  /// \Returns the line that the scanout shows for buffer line \p Y: either
+  /// the overlay or the frame buffer line, with Y clamped to the buffer.
+  inline const uint8_t *getScanoutRow(uint32_t Y) const {
+    uint32_t OverlayLine = Y - OverlayY;
+    if (OverlayLine < OverlayLines &&
+        (OverlayMask >> (OverlayLine / BMapHeight)) & 1)
+      return Overlay[OverlayLine];
+    return Buffer[std::min(BuffY - 1, Y)];
+  }
 
   inline void setBit(int Y, int X, int BitN, bool Val) {
     setBit(Buffer[Y][X], BitN, (int)Val);
@@ -137,33 +126,117 @@ public:
     uint32_t LimitedY = std::min(TimingsTTL->V_Visible - 1, Y);
     Buffer[LimitedY][LimitedX] = Val;
   }
-  inline void setCGA32(uint32_t Y, uint32_t X, uint32_t Val) {
-    uint32_t LimitedX = std::min(BuffX - 4, X);
-    uint32_t LimitedY = std::min(BuffY - 1, Y);
-    (uint32_t &)Buffer[LimitedY][LimitedX] = Val;
+  /// \Returns the byte offset that centers the MDA image in the 800x600 frame.
+  inline uint32_t getMDAXOffset() const {
+    return (TimingsVGA[VGA_800x600_56Hz].H_Visible - TimingsTTL->H_Visible) / 2;
+  }
+
+  /// Configures this core's interp0 lane 0 as a pointer stream of consecutive
+  /// 32-bit words: each pop of the full result returns BASE2 + ACCUM0 and
+  /// advances ACCUM0 by BASE0. Each core has its own interpolators so this
+  /// needs to run once on each core.
+  /// The clamp mode of interp1 lane 0 is not used for the end of the line: it
+  /// clamps to BASE0 and BASE1 instead of adding BASE0, so the lane can't
+  /// step and clamp at the same time, and BASE1 is not free for lane 1 to
+  /// step instead. interpStartRow() returns a loop bound instead, which costs
+  /// one compare per line rather than a second interpolator access per word.
+  /// This replaced a std::min() per word, but it has not been timed on the
+  /// Pico, and the host can't time it because the interpolators are emulated.
+  static void interpInit() {
+    interp_config Cfg = interp_default_config();
+    interp_set_config(interp0, 0, &Cfg);
+    interp_set_config(interp0, 1, &Cfg);
+    interp0->base[0] = 4;
+    interp0->base[1] = 0;
+    interp0->accum[1] = 0;
+  }
+  /// Points interp0 to byte \p X of line \p Y, with Y clamped to the buffer.
+  /// \Returns how many words fit in the line from \p X. Any writes past these
+  /// should be clamped to getLastWord32().
+  inline uint32_t interpStartRow(uint32_t Y, uint32_t X) {
+    interp0->base[2] = (uintptr_t)Buffer[std::min(BuffY - 1, Y)];
+    interp0->accum[0] = X;
+    return X <= BuffX - 4 ? (BuffX - X) / 4 : 0;
+  }
+  /// Like interpStartRow() but for the scanout, see getScanoutRow().
+  inline void interpStartScanoutRow(uint32_t Y) {
+    interp0->base[2] = (uintptr_t)getScanoutRow(Y);
+    interp0->accum[0] = 0;
   }
-  inline void setMDA32(uint32_t Y, uint32_t X, uint32_t Val) {
-    // XOffset to center image in 800x600 frame.
-    const uint32_t XOffset =
-        (TimingsVGA[VGA_800x600_56Hz].H_Visible - TimingsTTL->H_Visible) / 2;
-    uint32_t LimitedX = std::min(BuffX - 4, X + XOffset);
-    uint32_t LimitedY = std::min(BuffY - 1, Y);
-    (uint32_t &)Buffer[LimitedY][LimitedX] = Val;
+  /// \Returns the next word of the line set with interpStartRow().
+  static inline uint32_t *interpNextWord32() {
+    return (uint32_t *)(uintptr_t)interp_pop_full_result(interp0);
+  }
+  /// \Returns the last word of line \p Y, with Y clamped to the buffer.
+  inline uint32_t *getLastWord32(uint32_t Y) {
+    return (uint32_t *)&Buffer[std::min(BuffY - 1, Y)][BuffX - 4];
+  }
+
+  /// The MDA_RESAMPLE_640 resampler keeps 8 of every 9 MDA pixels, so every
+  /// 16 output pixels come from the next 18 pixels, i.e. 9 bytes, of the MDA
+  /// line. This is the same as nearest-neighbour with output column C showing
+  /// pixel C * 9 / 8.
+  static constexpr const uint32_t ResampleBlockBytes = 9;
+  static_assert(MDA_RESAMPLE_SRC * 8 == MDA_RESAMPLE_DST * 9,
+                "The resampler expects a 9:8 ratio");
+  /// Configures this core's interp1 like interp0 in interpInit(), but as a
+  /// pointer stream of ResampleBlockBytes steps for resampleMDARow().
+  static void resampleInterpInit() {
+    interp_config Cfg = interp_default_config();
+    interp_set_config(interp1, 0, &Cfg);
+    interp_set_config(interp1, 1, &Cfg);
+    interp1->base[0] = ResampleBlockBytes;
+    interp1->base[1] = 0;
+    interp1->accum[1] = 0;
+  }
+  /// \Returns the first MDA pixel that resampleMDARow() shows for a line of
+  /// \p TTLH pixels, which centers the MDA_RESAMPLE_SRC columns. It is even
+  /// so each block starts at the low nibble of a byte.
+  static constexpr uint32_t getResampleStart(uint32_t TTLH) {
+    uint32_t Start =
+        TTLH > MDA_RESAMPLE_SRC ? (TTLH - MDA_RESAMPLE_SRC) / 2 : 0;
+    // Don't read past the end of the line.
+    return std::min(Start, 2 * (BuffX - MDA_RESAMPLE_SRC / 2 - 1)) & ~1u;
+  }
+  /// Resamples the MDA_RESAMPLE_SRC pixels of MDA buffer line \p Y (as shown
+  /// by the scanout) from pixel \p Start to MDA_RESAMPLE_DST pixels. They
+  /// are passed to \p Put as words of 8 pixels, in the MDA buffer format.
+  /// Uses interp1, see resampleInterpInit().
+  template <typename PutFn>
+  inline void resampleMDARow(uint32_t Y, uint32_t Start, PutFn Put) const {
+    interp1->base[2] = (uintptr_t)&getScanoutRow(Y)[Start / 2];
+    interp1->accum[0] = 0;
+    for (uint32_t Block = 0; Block != MDA_RESAMPLE_DST / 16; ++Block) {
+      const uint8_t *Src =
+          (const uint8_t *)(uintptr_t)interp_pop_full_result(interp1);
+      // The blocks are not word-aligned.
+      uint32_t Lo, Hi;
+      memcpy(&Lo, Src, 4);
+      memcpy(&Hi, Src + 4, 4);
+      // Pixels 0-7, then 9-16.
+      Put(Lo);
+      Put(Hi >> 4 | (uint32_t)Src[8] << 28);
+    }
   }
   inline uint8_t getMDA(int Y, int X, int BitN) {
     if (Buffer[Y][X] & (1 << BitN))
       return Green;
     return Black;
   }
-  /// \Returns 8 MDA pixels.
-  inline uint32_t getMDA32(int Y, int X) {
-    return (uint32_t &)Buffer[Y][X / 2];
-  }
   inline uint8_t get(int Y, int X) { return Buffer[Y][X]; }
   inline uint32_t get32(int Y, int X) { return (uint32_t &)Buffer[Y][X]; }
 
+  /// Lends the frame buffer RAM as \p Words 32-bit words, e.g. to the logic
+  /// analyzer. The scanout keeps showing it, so call clear() to give it back.
+  uint32_t *borrowRAM(uint32_t &Words) {
+    Words = BuffX * BuffY / 4;
+    return (uint32_t *)Buffer;
+  }
+
   /// We only need to call this once.
   void setMode(const TTLDescr &NewMode) { TimingsTTL = &NewMode; }
+  /// Called by TTLReader when it switches to/from the 320-pixel capture.
+  void setHalfRate(bool Val) { HalfRate = Val; }
   /// Fi
   void fillBottomWithBlackAfter(uint32_t Line);
 };
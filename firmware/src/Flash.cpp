@@ -6,7 +6,6 @@
 #include "Flash.h"
 #include "Debug.h"
 #include <cstring>
-#include <iostream>
 #include <pico/multicore.h>
 
 FlashStorage::DataTy::DataTy() {
@@ -20,6 +19,7 @@ FlashStorage::DataTy::DataTy() {
   Elements[RevisionMinorIdx] = REVISION_MINOR;
 }
 
+#ifdef DBGPRINT
 void FlashStorage::DataTy::dump() const {
   for (uint32_t Idx = 0, E = ActualDataStartIdx; Idx < E; ++Idx)
     std::cout << Idx << " : " << Elements[Idx] << "\n";
@@ -27,9 +27,11 @@ void FlashStorage::DataTy::dump() const {
   for (uint32_t Idx = ActualDataStartIdx, E = Elements.size(); Idx < E; ++Idx)
     std::cout << Idx << " : " << Elements[Idx] << "\n";
 }
+#endif
 
 FlashStorage::FlashStorage() {
   FlashArray = (const int *)(XIP_BASE + WriteBaseOffset);
+  ExtFlashArray = (const int *)(XIP_BASE + ExtWriteBaseOffset);
 }
 
 void FlashStorage::write(const DataTy &DataVec) {
@@ -45,7 +47,10 @@ void FlashStorage::write(const DataTy &DataVec) {
   uint32_t SvInterrupts = save_and_disable_interrupts();
   flash_range_erase(EraseBaseOffset, BytesToErase);
   flash_range_program(WriteBaseOffset, (const uint8_t *)DataVec.raw_get(),
-                      DataVec.size_in_bytes());
+                      FLASH_PAGE_SIZE);
+  flash_range_program(ExtWriteBaseOffset,
+                      (const uint8_t *)(DataVec.raw_get() + ElmsPerPage),
+                      FLASH_PAGE_SIZE);
   // Restore interrupts.
   restore_interrupts(SvInterrupts);
   // Resume execution on other core.
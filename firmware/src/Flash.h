@@ -11,16 +11,22 @@
 #include <config.h>
 #include <hardware/flash.h>
 #include <hardware/sync.h>
-#include <iostream>
 
 class FlashStorage {
-  // Erase the last sector (4KB) of the 2MB flash, but write the last page (256
-  // bytes).
+  // Erase the last sector (4KB) of the 2MB flash, but write the last two pages
+  // (256 bytes each). The last page holds the magic number and the original
+  // data, while the extension page right before it holds the rest. This keeps
+  // the data written by older firmware (which only wrote the last page)
+  // readable. Note that the extension page of older firmware reads 0xFFFFFFFF.
   static constexpr const int BytesToErase = FLASH_SECTOR_SIZE;
-  static constexpr const int BytesToWrite = FLASH_PAGE_SIZE;
+  static constexpr const int NumPages = 2;
+  static constexpr const int BytesToWrite = NumPages * FLASH_PAGE_SIZE;
+  static constexpr const int ElmsPerPage = FLASH_PAGE_SIZE / sizeof(int);
 
   static constexpr const int EraseBaseOffset = 2 * (1u << 20) - BytesToErase;
-  static constexpr const int WriteBaseOffset = 2 * (1u << 20) - BytesToWrite;
+  static constexpr const int WriteBaseOffset = 2 * (1u << 20) - FLASH_PAGE_SIZE;
+  static constexpr const int ExtWriteBaseOffset =
+      WriteBaseOffset - FLASH_PAGE_SIZE;
 
   using MagicNumberTy = std::array<int, 5>;
   static constexpr MagicNumberTy MagicNumber = {12131111, 45, 0, 667, 13121111};
@@ -33,6 +39,8 @@ class FlashStorage {
 
   /// Points to the beginning of the writeable area.
   const int *FlashArray = nullptr;
+  /// Points to the extension page.
+  const int *ExtFlashArray = nullptr;
 
 public:
   /// Hides the boilerplate elements (version and magic number) written to
@@ -59,18 +67,23 @@ public:
   public:
     /// \Returns the raw data size (including the boilerplate).
     static constexpr size_t size_in_bytes() { return NumElms * sizeof(ValTy); }
+    /// \Returns the number of values that fit (excluding the boilerplate).
+    static constexpr size_t capacity() { return NumElms - ActualDataStartIdx; }
+#ifdef DBGPRINT
     void dump() const;
+#endif
   };
   FlashStorage();
   void write(const DataTy &DataVec);
   /// \Reads a value at \p ValueIdx offset (after the boilerplate).
   int read(int ValueIdx) const {
-    auto Val = FlashArray[ActualDataStartIdx + ValueIdx];
+    int ActualIdx = ActualDataStartIdx + ValueIdx;
+    auto Val = ActualIdx < ElmsPerPage
+                   ? FlashArray[ActualIdx]
+                   : ExtFlashArray[ActualIdx - ElmsPerPage];
     DBG_PRINT(std::cout << "Flash.read(" << ValueIdx << ") : " << Val << "\n";)
     return Val;
   }
-  /// \Returns the memory location of the actual data (not boilerplate) in flash
-  const int *getData() const { return &FlashArray[ActualDataStartIdx]; }
   std::pair<int, int> readRevision() const;
   MagicNumberTy readMagicNumber() const;
   bool valid() const;
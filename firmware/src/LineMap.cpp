@@ -0,0 +1,51 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+
+#include "LineMap.h"
+#include "Debug.h"
+
+void LineMap::build() {
+  DBG_PRINT(std::cout << "LineMap: " << modeToStr(R) << " SrcLines=" << SrcLines
+                      << " Repeat=" << Repeat << " ExtraLines=" << ExtraLines
+                      << " Fill=" << (Scale == Scaling::Fill) << "\n";)
+  Map.fill(Black);
+  const uint32_t VGALines = TimingsVGA[R].V_Visible;
+  if (SrcLines == 0)
+    return;
+  switch (Scale) {
+  case Scaling::Integer: {
+    // Center vertically if there is empty space, e.g. 640x350 in 640x400.
+    uint32_t ScaledLines = Repeat * SrcLines;
+    uint32_t Top = VGALines > ScaledLines ? (VGALines - ScaledLines) / 2 : 0;
+    uint32_t End = std::min(Top + ScaledLines,
+                            std::min(VGALines + ExtraLines, MaxLines));
+    uint32_t Src = 0;
+    uint32_t Cnt = 0;
+    for (uint32_t Line = Top; Line < End; ++Line) {
+      Map[Line] = Src;
+      if (++Cnt == Repeat) {
+        Cnt = 0;
+        ++Src;
+      }
+    }
+    break;
+  }
+  case Scaling::Fill: {
+    // Each VGA line advances the source by SrcLines / VGALines buffer lines,
+    // tracked as an integer part and a remainder.
+    uint32_t Src = 0;
+    uint32_t Rem = 0;
+    for (uint32_t Line = 0; Line != VGALines; ++Line) {
+      Map[Line] = Src;
+      Rem += SrcLines;
+      while (Rem >= VGALines) {
+        Rem -= VGALines;
+        ++Src;
+      }
+    }
+    break;
+  }
+  }
+}
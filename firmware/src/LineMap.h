@@ -0,0 +1,71 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+
+#ifndef __LINEMAP_H__
+#define __LINEMAP_H__
+
+#include "Timings.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+/// Maps each visible VGA line to the frame buffer line that it shows. It gets
+/// rebuilt only when the input or output mode changes, so the scanout costs a
+/// single table read per line.
+class LineMap {
+public:
+  /// The VGA line is black.
+  static constexpr const uint16_t Black = 0xffff;
+  /// The visible lines of the tallest VGA mode, plus its front porch.
+  static constexpr const uint32_t MaxLines = [] {
+    uint32_t Max = 0;
+    for (const auto &VGA : TimingsVGA)
+      Max = std::max(Max, VGA.V_Visible + VGA.V_FrontPorch);
+    return Max;
+  }();
+
+  enum class Scaling {
+    /// Each buffer line is repeated a fixed number of times and the image is
+    /// centered vertically. This is pixel-perfect.
+    Integer,
+    /// Nearest-neighbour scaling to fill all the visible VGA lines.
+    Fill,
+  };
+
+private:
+  std::array<uint16_t, MaxLines> Map;
+  // The parameters the map was built with.
+  VGAResolution R = VGA_MAX;
+  uint32_t SrcLines = 0;
+  uint32_t Repeat = 0;
+  uint32_t ExtraLines = 0;
+  Scaling Scale = Scaling::Integer;
+
+  void build();
+
+public:
+  /// Rebuilds the map if any of the parameters changed.
+  /// \p SrcLines is the number of buffer lines to show.
+  /// \p Repeat is the number of times each line is shown with
+  /// Scaling::Integer, e.g. 2 for line-doubling.
+  /// \p ExtraLines are the lines after V_Visible that may still show content
+  /// with Scaling::Integer, for inputs slightly taller than VGA.
+  void update(VGAResolution NewR, uint32_t NewSrcLines, uint32_t NewRepeat,
+              uint32_t NewExtraLines, Scaling NewScale) {
+    if (NewR == R && NewSrcLines == SrcLines && NewRepeat == Repeat &&
+        NewExtraLines == ExtraLines && NewScale == Scale)
+      return;
+    R = NewR;
+    SrcLines = NewSrcLines;
+    Repeat = NewRepeat;
+    ExtraLines = NewExtraLines;
+    Scale = NewScale;
+    build();
+  }
+  /// \Returns the buffer line for VGA line \p Line, or Black.
+  uint16_t operator[](uint32_t Line) const { return Map[Line]; }
+};
+
+#endif // __LINEMAP_H__
@@ -0,0 +1,117 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+
+#include "LogicAnalyzer.h"
+#include "Common.h"
+#include "Debug.h"
+#include "LogicAnalyzer.pio.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include <algorithm>
+#include <cstdio>
+
+const char *LogicAnalyzer::triggerToStr(Trigger Trig) {
+  switch (Trig) {
+  case Trigger::None:
+    return "NONE";
+  case Trigger::VSync:
+    return "VSYNC";
+  case Trigger::HSync:
+    return "HSYNC";
+  }
+  return "UNKNOWN";
+}
+
+bool LogicAnalyzer::capture(PIO Pio, uint SM, Trigger NewTrig, Polarity Pol,
+                            uint32_t Lines, float HHz, uint32_t *NewRAM,
+                            uint32_t Words, uint32_t TimeoutMs) {
+  Trig = NewTrig;
+  RAM = NewRAM;
+  // Use the highest rate that fits Lines in RAM.
+  float MaxRate = (float)clock_get_hz(clk_sys) / CyclesPerSample;
+  uint32_t MaxSamples = Words * SamplesPerWord;
+  float Secs = HHz > 0 ? Lines / HHz : 0;
+  SampleRate = Secs > 0 ? std::min(MaxRate, MaxSamples / Secs) : MaxRate;
+  float ClkDiv = std::clamp(MaxRate / SampleRate, 1.0f, 65535.0f);
+  SampleRate = MaxRate / ClkDiv;
+  if (Secs > 0)
+    Words =
+        std::min(Words, (uint32_t)(Secs * SampleRate) / SamplesPerWord + 1);
+  NumSamples = Words * SamplesPerWord;
+  DBG_PRINT(std::cout << "LogicAnalyzer: " << triggerToStr(Trig)
+                      << " Rate=" << SampleRate << "Hz Samples=" << NumSamples
+                      << "\n";)
+
+  // Start the DMA first, so that it drains the FIFO from the first sample.
+  int DMAChannel = dma_claim_unused_channel(true);
+  dma_channel_config DMAConfig = dma_channel_get_default_config(DMAChannel);
+  channel_config_set_transfer_data_size(&DMAConfig, DMA_SIZE_32);
+  channel_config_set_read_increment(&DMAConfig, false);
+  channel_config_set_write_increment(&DMAConfig, true);
+  channel_config_set_dreq(&DMAConfig, pio_get_dreq(Pio, SM, /*is_tx=*/false));
+  dma_channel_configure(DMAChannel, &DMAConfig, /*Dst=*/RAM,
+                        /*Src=*/&Pio->rxf[SM], /*Transfers=*/Words,
+                        /*Start=*/true);
+
+  uint StartOffset = LogicAnalyzer_offset_sample;
+  uint TriggerGPIO = 0;
+  if (Trig != Trigger::None) {
+    TriggerGPIO = Trig == Trigger::VSync ? TTL_VSYNC_GPIO : TTL_HSYNC_GPIO;
+    // Start at the beginning of the sync pulse.
+    StartOffset = Pol == Polarity::Pos ? LogicAnalyzer_offset_rising
+                                       : LogicAnalyzer_offset_falling;
+  }
+  PioLoader.loadPIOProgram(
+      Pio, SM, &LogicAnalyzer_program,
+      [StartOffset, TriggerGPIO, ClkDiv](PIO Pio, uint SM, uint Offset) {
+        LogicAnalyzerPioConfig(Pio, SM, Offset, StartOffset, TriggerGPIO,
+                               ClkDiv);
+      });
+
+  auto Timeout = make_timeout_time_ms(TimeoutMs);
+  while (dma_channel_is_busy(DMAChannel) && !time_reached(Timeout))
+    ;
+  bool Done = !dma_channel_is_busy(DMAChannel);
+  if (!Done) {
+    // No trigger, or it stopped in the middle of the capture.
+    NumSamples = (Words - dma_channel_hw_addr(DMAChannel)->transfer_count) *
+                 SamplesPerWord;
+    dma_channel_abort(DMAChannel);
+  }
+  PioLoader.unloadAllPio(Pio, {SM});
+  dma_channel_unclaim(DMAChannel);
+  DBG_PRINT(std::cout << "LogicAnalyzer: Done=" << Done << "\n";)
+  return Done;
+}
+
+void LogicAnalyzer::send() const {
+  printf("LA-BEGIN %lu %lu %lu %s\n", (unsigned long)FormatVersion,
+         (unsigned long)SampleRate, (unsigned long)NumSamples,
+         triggerToStr(Trig));
+  // The signals change rarely compared to the sample rate, so print runs.
+  static constexpr const int RunsPerLine = 8;
+  auto GetSample = [this](uint32_t Idx) -> uint32_t {
+    uint32_t Word = RAM[Idx / SamplesPerWord];
+    return Idx % SamplesPerWord == 0 ? Word >> 16 : Word & 0xffff;
+  };
+  int Runs = 0;
+  for (uint32_t Idx = 0; Idx < NumSamples;) {
+    uint32_t Sample = GetSample(Idx);
+    uint32_t Cnt = 1;
+    while (Idx + Cnt < NumSamples && GetSample(Idx + Cnt) == Sample)
+      ++Cnt;
+    printf("%s%lx:%lx", Runs == 0 ? "LA " : " ", (unsigned long)Sample,
+           (unsigned long)Cnt);
+    if (++Runs == RunsPerLine) {
+      printf("\n");
+      Runs = 0;
+    }
+    Idx += Cnt;
+  }
+  if (Runs != 0)
+    printf("\n");
+  printf("LA-END\n");
+  fflush(stdout);
+}
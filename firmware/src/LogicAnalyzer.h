@@ -0,0 +1,56 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+
+#ifndef __LOGICANALYZER_H__
+#define __LOGICANALYZER_H__
+
+#include "PioProgramLoader.h"
+#include "Timings.h"
+#include "hardware/pio.h"
+#include <cstdint>
+
+/// A diagnostic mode that samples all the TTL input pins (see
+/// LogicAnalyzer.pio) into borrowed RAM, and then prints the samples to the
+/// USB serial port for firmware/tools/la2vcd.py, which converts them to VCD.
+/// The format is one line per group of runs:
+///   LA-BEGIN <Version> <SampleRateHz> <NumSamples> <NONE|VSYNC|HSYNC>
+///   LA <Sample>:<Count> <Sample>:<Count> ...
+///   LA-END
+/// with the samples and counts in hex.
+class LogicAnalyzer {
+public:
+  enum class Trigger {
+    None,
+    VSync,
+    HSync,
+  };
+  static const char *triggerToStr(Trigger Trig);
+  static constexpr const uint32_t FormatVersion = 1;
+  /// Each sample takes this many PIO cycles.
+  static constexpr const uint32_t CyclesPerSample = 4;
+  static constexpr const uint32_t SamplesPerWord = 2;
+
+private:
+  PioProgramLoader &PioLoader;
+  uint32_t *RAM = nullptr;
+  uint32_t NumSamples = 0;
+  float SampleRate = 0;
+  Trigger Trig = Trigger::None;
+
+public:
+  LogicAnalyzer(PioProgramLoader &PioLoader) : PioLoader(PioLoader) {}
+  /// Loads the sampling program on \p Pio \p SM, which must have been stopped
+  /// by the caller, and captures about \p Lines lines of \p HHz (at the
+  /// highest rate that fits in the \p Words of \p RAM), starting at the sync
+  /// pulse of \p Trig with polarity \p Pol. The program is unloaded before
+  /// returning. \Returns false if the trigger didn't come within
+  /// \p TimeoutMs.
+  bool capture(PIO Pio, uint SM, Trigger Trig, Polarity Pol, uint32_t Lines,
+               float HHz, uint32_t *RAM, uint32_t Words, uint32_t TimeoutMs);
+  /// Prints the last capture to the USB serial port.
+  void send() const;
+};
+
+#endif // __LOGICANALYZER_H__
@@ -0,0 +1,71 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+
+#include "Palette.h"
+#include "Common.h"
+#include "Debug.h"
+#include <algorithm>
+
+const char *paletteToStr(Palette P) {
+  switch (P) {
+    // clang-format off
+#define DEF_PALETTE(NAME, STR) \
+    case Palette::NAME: return STR;
+#include "Palettes.def"
+    // clang-format on
+  }
+  return "UNKNOWN";
+}
+
+// The monochrome palettes, from black to the brightest shade.
+static constexpr const uint8_t GreenRamp[] = {
+    0b000000, 0b000100, 0b001000, 0b001100, 0b011101, 0b101110};
+static constexpr const uint8_t AmberRamp[] = {
+    0b000000, 0b010000, 0b100100, 0b110100, 0b111000, 0b111001};
+static constexpr const uint8_t WhiteRamp[] = {
+    0b000000, 0b010101, 0b101010, 0b111111};
+
+/// \Returns the shade of \p Ramp that matches the brightness of \p RGB.
+template <size_t RampSz>
+static uint8_t toMono(uint32_t RGB, const uint8_t (&Ramp)[RampSz]) {
+  uint32_t R = (RGB >> 4) & 0b11;
+  uint32_t G = (RGB >> 2) & 0b11;
+  uint32_t B = RGB & 0b11;
+  // The usual 0.30/0.59/0.11 luma weights, so Y is 0 to 300.
+  uint32_t Y = 30 * R + 59 * G + 11 * B;
+  return Ramp[(Y * (RampSz - 1) + 150) / 300];
+}
+
+static uint8_t getColor(Palette P, uint32_t RGB) {
+  switch (P) {
+  case Palette::Standard:
+    // Like IBM's monitors, show the CGA/EGA dark yellow as brown.
+    return RGB == 0b101000 ? 0b100100 : RGB;
+  case Palette::Raw:
+    return RGB;
+  case Palette::Green:
+    return toMono(RGB, GreenRamp);
+  case Palette::Amber:
+    return toMono(RGB, AmberRamp);
+  case Palette::White:
+    return toMono(RGB, WhiteRamp);
+  case Palette::RedGreen: {
+    // Add blue for as much red as there is on top of the green, so reds turn
+    // into magentas but yellows are left alone.
+    uint32_t R = (RGB >> 4) & 0b11;
+    uint32_t G = (RGB >> 2) & 0b11;
+    uint32_t B = RGB & 0b11;
+    B = std::max(B, R > G ? R - G : 0);
+    return R << 4 | G << 2 | B;
+  }
+  }
+  return RGB;
+}
+
+void buildPaletteLUT(Palette P, PaletteLUT &LUT) {
+  DBG_PRINT(std::cout << "Palette: " << paletteToStr(P) << "\n";)
+  for (uint32_t Idx = 0, E = LUT.size(); Idx != E; ++Idx)
+    LUT[Idx] = getColor(P, Idx & RGBMask);
+}
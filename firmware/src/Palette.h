@@ -0,0 +1,40 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+
+#ifndef __PALETTE_H__
+#define __PALETTE_H__
+
+#include <array>
+#include <cstdint>
+
+enum class Palette : uint32_t {
+// clang-format off
+#define DEF_PALETTE(NAME, ...) \
+  NAME,
+#include "Palettes.def"
+  // clang-format on
+};
+
+static constexpr const uint32_t PaletteMAX = 0
+#define DEF_PALETTE(...) +1
+#include "Palettes.def"
+    ;
+
+const char *paletteToStr(Palette P);
+
+/// A color look-up table indexed by a captured VHRRGGBB byte. The entries are
+/// the RRGGBB colors to show with HV cleared, so the LUT also masks the syncs.
+using PaletteLUT = std::array<uint8_t, 256>;
+
+/// Fills in \p LUT for palette \p P.
+void buildPaletteLUT(Palette P, PaletteLUT &LUT);
+
+/// \Returns the 4 VHRRGGBB pixels of \p VHRGB mapped through \p LUT.
+static inline uint32_t applyPaletteLUT(const uint8_t *LUT, uint32_t VHRGB) {
+  return LUT[VHRGB & 0xff] | LUT[(VHRGB >> 8) & 0xff] << 8 |
+         LUT[(VHRGB >> 16) & 0xff] << 16 | LUT[VHRGB >> 24] << 24;
+}
+
+#endif // __PALETTE_H__
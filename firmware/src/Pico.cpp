@@ -10,6 +10,7 @@
 #include "hardware/pll.h"
 #include "hardware/structs/rosc.h"
 #include "hardware/structs/scb.h"
+#include <cstdio>
 #include <iomanip>
 
 PinRange::PinRange(uint32_t From, uint32_t To) : From(From), To(To) {
@@ -27,7 +28,9 @@ void PinRange::dump(std::ostream &OS) const {
   OS.flags(Flags);
 }
 
+#ifdef DBGPRINT
 void PinRange::dump() const { dump(std::cerr); }
+#endif
 
 Pico::Pico() {
   // Some valid frequencies: 225000, 250000, 270000, 280000, 290400
@@ -51,24 +54,24 @@ Pico::Pico() {
 
   // Wait for a bit otherwise this does not show up during serial debug.
   DBG_PRINT(sleep_ms(1500);)
-  std::cerr << "+---------------------------------+\n";
-  std::cerr << "|          " << PROJECT_NAME << "\n";
-  std::cerr << "+---------------------------------+\n";
-  std::cerr << "clk_sys = " << frequency_count_khz(CLOCKS_FC0_SRC_VALUE_CLK_SYS)
-            << "KHz\n";
-  std::cerr << "clk_usb = " << frequency_count_khz(CLOCKS_FC0_SRC_VALUE_CLK_USB)
-            << "KHz\n";
-  std::cerr << "clk_peri = "
-            << frequency_count_khz(CLOCKS_FC0_SRC_VALUE_CLK_PERI) << "KHz\n";
-  std::cerr << "clk_ref = " << frequency_count_khz(CLOCKS_FC0_SRC_VALUE_CLK_REF)
-            << "KHz\n";
+  printf("+---------------------------------+\n");
+  printf("|          %s\n", PROJECT_NAME);
+  printf("+---------------------------------+\n");
+  printf("clk_sys = %luKHz\n",
+         (unsigned long)frequency_count_khz(CLOCKS_FC0_SRC_VALUE_CLK_SYS));
+  printf("clk_usb = %luKHz\n",
+         (unsigned long)frequency_count_khz(CLOCKS_FC0_SRC_VALUE_CLK_USB));
+  printf("clk_peri = %luKHz\n",
+         (unsigned long)frequency_count_khz(CLOCKS_FC0_SRC_VALUE_CLK_PERI));
+  printf("clk_ref = %luKHz\n",
+         (unsigned long)frequency_count_khz(CLOCKS_FC0_SRC_VALUE_CLK_REF));
 #ifdef PICO1
-  std::cerr << "clk_rtc = " << frequency_count_khz(CLOCKS_FC0_SRC_VALUE_CLK_RTC)
-            << "KHz\n";
+  printf("clk_rtc = %luKHz\n",
+         (unsigned long)frequency_count_khz(CLOCKS_FC0_SRC_VALUE_CLK_RTC));
 #endif
 #ifdef PICO2
-  std::cerr << "clk_adc = " << frequency_count_khz(CLOCKS_FC0_SRC_VALUE_CLK_ADC)
-            << "KHz\n";
+  printf("clk_adc = %luKHz\n",
+         (unsigned long)frequency_count_khz(CLOCKS_FC0_SRC_VALUE_CLK_ADC));
 #endif
 }
 
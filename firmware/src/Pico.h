@@ -10,10 +10,8 @@
 #include "hardware/clocks.h"
 #include "hardware/vreg.h"
 #include "pico/stdlib.h"
-#include <iostream>
-#include <map>
-#include <memory>
 #include <optional>
+#include <ostream>
 
 /// A range of GPIO pins. This is useful because it also creates the
 /// corresponding mask which is used for setting and resetting pins.
@@ -31,7 +29,9 @@ public:
   uint32_t getTo() const { return To; }
   uint32_t getMask() const { return Mask; }
   void dump(std::ostream &OS) const;
+#ifdef DBGPRINT
   DUMP_METHOD void dump() const;
+#endif
 };
 
 class Pico {
@@ -4,6 +4,7 @@
 //
 
 #include "PioProgramLoader.h"
+#include <algorithm>
 
 #ifdef DBGPRINT
 static const char *getPioStr(PIO Pio) {
@@ -11,9 +12,9 @@ static const char *getPioStr(PIO Pio) {
 }
 #endif
 
-uint PioProgramLoader::loadPIOProgram(PIO Pio, uint SM,
-                                      const pio_program_t *Program,
-                                      std::function<void(PIO, uint, uint)> Fn) {
+uint PioProgramLoader::loadPIOProgram(
+    PIO Pio, uint SM, const pio_program_t *Program,
+    Utils::FunctionRef<void(PIO, uint, uint)> Fn) {
   DBG_PRINT(std::cout << "loadPIO: Before critical section " << getPioStr(Pio)
                       << " SM=" << SM << "\n";)
   critical_section_enter_blocking(&LoadPIOProgramLock);
@@ -10,9 +10,7 @@
 #include "Utils.h"
 #include "hardware/pio.h"
 #include "pico/critical_section.h"
-#include <functional>
 #include <initializer_list>
-#include <iostream>
 
 class PioProgramLoader {
   struct KeyValuePair {
@@ -27,7 +25,7 @@ public:
 
   /// \Returns the offset of the loaded program.
   uint loadPIOProgram(PIO Pio, uint SM, const pio_program_t *Program,
-                      std::function<void(PIO, uint, uint)> Fn);
+                      Utils::FunctionRef<void(PIO, uint, uint)> Fn);
   void unloadAllPio(PIO Pio, std::initializer_list<uint> SMs);
 };
 
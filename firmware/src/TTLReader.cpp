@@ -5,15 +5,26 @@
 
 #include "TTLReader.h"
 #include "Common.h"
+#include "DebugLog.h"
 #include "DisplayBuffer.h"
+#include "SyncPeriod.pio.h"
+#include "TemporalFilter.h"
+#include "Trace.h"
 #include "Utils.h"
+#include "hardware/structs/io_bank0.h"
 #include "pico/stdlib.h"
+#include <algorithm>
 #include <cmath>
 
 static constexpr const uint32_t EGABorderCounter = 700;
 static constexpr const uint32_t CGABorderCounter = 700;
 static constexpr const uint32_t MDABorderCounter = 800;
 
+#ifdef TEMPORAL_FILTER
+/// The temporal filter history starts this many words into each row.
+static constexpr const uint32_t HistoryWords = DisplayBuffer::BuffX / 8;
+#endif
+
 static inline void EGA640x350PioConfig(PIO Pio, uint SM, uint Offset,
                                        uint RGB_GPIO, uint32_t HSYNC_GPIO,
                                        uint16_t ClkDivInt, uint8_t ClkDivFrac,
@@ -32,8 +43,8 @@ static inline void EGA640x350PioConfig(PIO Pio, uint SM, uint Offset,
       break;
     }
     }
-    std::cerr << "Bad InstrDelay or SamplingOffset in EGA: GetSmConfig("
-              << InstrDelay << ", " << SamplingOffset << ")\n";
+    printf("Bad InstrDelay or SamplingOffset in EGA: GetSmConfig(%lu, %lu)\n",
+           (unsigned long)InstrDelay, (unsigned long)SamplingOffset);
     exit(1);
   };
   pio_sm_config Conf = GetSmConfig(InstrDelay, SamplingOffset, HSyncPolarity);
@@ -73,8 +84,8 @@ static inline void CGA640x200PioConfig(PIO Pio, uint SM, uint Offset,
 #include "CGASwitchCase_NegHSync_config_cpp"
     }
     }
-    std::cerr << "Bad InstrDelay or SamplingOffset in CGA: GetSmConfig("
-              << InstrDelay << ", " << SamplingOffset << ")\n";
+    printf("Bad InstrDelay or SamplingOffset in CGA: GetSmConfig(%lu, %lu)\n",
+           (unsigned long)InstrDelay, (unsigned long)SamplingOffset);
     exit(1);
   };
   pio_sm_config Conf = GetSmConfig(InstrDelay, SamplingOffset, HSyncPolarity);
@@ -121,8 +132,8 @@ static inline void MDA720x350PioConfig(PIO Pio, uint SM, uint Offset,
       break;
     }
     }
-    std::cerr << "Bad InstrDelay or SamplingOffset in MDA: GetSmConfig("
-              << InstrDelay << ", " << SamplingOffset << ")\n";
+    printf("Bad InstrDelay or SamplingOffset in MDA: GetSmConfig(%lu, %lu)\n",
+           (unsigned long)InstrDelay, (unsigned long)SamplingOffset);
     exit(1);
   };
   pio_sm_config Conf = GetSmConfig(InstrDelay, SamplingOffset, HSyncPolarity);
@@ -160,6 +171,8 @@ void AutoAdjustBorder::applyBorders(const TTLDescr &TimingsTTL) {
   // Update TTLReader's values.
   XBorder = TmpXBorder;
   YBorder = TmpYBorder;
+  Trace::event(TraceEvent::Borders, XBorder, YBorder,
+               (uint32_t)TimingsTTL.Mode);
 
   switch (TimingsTTL.Mode) {
   case TTL::CGA:
@@ -205,9 +218,230 @@ void AutoAdjustBorder::runAutoAdjust() {
   forceStart();
 }
 
+// The DMA stops after MaxLines, so any captured lines past them would be lost.
+static_assert(AutoAdjustBorder::MaxLines >= DisplayBuffer::BuffY,
+              "BorderLines can't hold all captured lines");
+uint32_t AutoAdjustBorder::BorderLines[AutoAdjustBorder::MaxLines];
+AutoAdjustBorder::FrameStats AutoAdjustBorder::Stats;
+std::array<uint32_t, AutoAdjustBorder::HistogramBins>
+    AutoAdjustBorder::WindowXHistogram;
+std::array<uint16_t, AutoAdjustBorder::MaxLines>
+    AutoAdjustBorder::WindowYHistogram;
+
+void AutoAdjustBorder::init(PIO Pio, uint SM) {
+  BorderPio = Pio;
+  BorderSM = SM;
+  DMAChannel = dma_claim_unused_channel(true);
+}
+
+void AutoAdjustBorder::release() {
+  if (DMAChannel < 0)
+    return;
+  dma_channel_abort(DMAChannel);
+  dma_channel_unclaim(DMAChannel);
+  DMAChannel = -1;
+  DMAArmed = false;
+}
+
+void AutoAdjustBorder::dropFrame() {
+  if (!DMAArmed)
+    return;
+  dma_channel_abort(DMAChannel);
+  DMAArmed = false;
+}
+
+void __not_in_flash_func(AutoAdjustBorder::frameStart)() {
+  // Drop the values pushed during VSync. The FIFO is not joined so at most 4.
+  while (!pio_sm_is_rx_fifo_empty(BorderPio, BorderSM))
+    pio_sm_get(BorderPio, BorderSM);
+  dma_channel_config DMAConfig = dma_channel_get_default_config(DMAChannel);
+  channel_config_set_transfer_data_size(&DMAConfig, DMA_SIZE_32);
+  channel_config_set_read_increment(&DMAConfig, false);
+  channel_config_set_write_increment(&DMAConfig, true);
+  channel_config_set_dreq(&DMAConfig,
+                          pio_get_dreq(BorderPio, BorderSM, /*is_tx=*/false));
+  dma_channel_configure(DMAChannel, &DMAConfig,
+                        /*Dst=*/BorderLines,
+                        /*Src=*/&BorderPio->rxf[BorderSM],
+                        /*Transfers=*/MaxLines,
+                        true /*Start immediately*/);
+  DMAArmed = true;
+}
+
+void PinActivitySampler::clearEdges() {
+  for (uint32_t Pin = 0; Pin != 32; ++Pin)
+    if ((TTL_PIN_ACTIVITY_MASK >> Pin) & 1)
+      gpio_acknowledge_irq(Pin, GPIO_IRQ_EDGE_RISE);
+}
+
+uint32_t PinActivitySampler::getEdges() const {
+  uint32_t Edges = 0;
+  for (uint32_t Pin = 0; Pin != 32; ++Pin) {
+    if (((TTL_PIN_ACTIVITY_MASK >> Pin) & 1) == 0)
+      continue;
+    // 4 event bits per GPIO, 8 GPIOs per register.
+    uint32_t Events = io_bank0_hw->intr[Pin / 8] >> (4 * (Pin % 8));
+    if (Events & GPIO_IRQ_EDGE_RISE)
+      Edges |= 1u << Pin;
+  }
+  return Edges;
+}
+
+std::optional<uint32_t> PinActivitySampler::poll() {
+  switch (St) {
+  case State::Idle:
+    clearEdges();
+    Frames = 0;
+    St = State::Sampling;
+    return std::nullopt;
+  case State::Sampling:
+    return std::nullopt;
+  case State::Done:
+    break;
+  }
+  St = State::Idle;
+  // TTL pins are low when black, so look at the pins that ever went high.
+  uint32_t Activity = 0;
+  if ((Ones & TTL_PRIMARY_RGB_MASK) != 0)
+    Activity |= PinActivityRGB;
+  if ((Ones & TTL_SECONDARY_RED_MASK) != 0)
+    Activity |= PinActivitySecondaryRed;
+  if ((Ones & TTL_MONO_MASK) != 0 && (Activity & PinActivityRGB) == 0)
+    Activity |= PinActivityMono;
+  DBG_PRINT(std::cout << "PinActivity=" << Activity << "\n";)
+  return Activity;
+}
+
+void PinActivitySampler::frameEnd(bool Aborted) {
+  if (St != State::Sampling)
+    return;
+  // Start over, the edges may have come from the signal loss.
+  if (Aborted) {
+    clearEdges();
+    Frames = 0;
+    return;
+  }
+  if (++Frames != PIN_ACTIVITY_FRAMES)
+    return;
+  Ones = getEdges();
+  St = State::Done;
+}
+
+bool AutoAdjustBorder::processFrame() {
+  if (!DMAArmed)
+    return false;
+  uint32_t NumLines =
+      MaxLines - dma_channel_hw_addr(DMAChannel)->transfer_count;
+  dma_channel_abort(DMAChannel);
+  DMAArmed = false;
+
+  Stats.MinX = std::numeric_limits<uint32_t>::max();
+  Stats.MaxX = 0;
+  Stats.FirstLine = std::numeric_limits<uint32_t>::max();
+  Stats.LastLine = 0;
+  Stats.NonEmptyLines = 0;
+  Stats.XHistogram.fill(0);
+  for (uint32_t Line = 0; Line != NumLines; ++Line) {
+    uint32_t Raw = BorderLines[Line];
+    // The PIO counter expired without finding a non-black pixel.
+    if (Raw == 0xffffffff || Raw == 0)
+      continue;
+    uint32_t Border = BorderCounter - Raw;
+    Stats.MinX = std::min(Stats.MinX, Border);
+    Stats.MaxX = std::max(Stats.MaxX, Border);
+    Stats.FirstLine = std::min(Stats.FirstLine, Line);
+    Stats.LastLine = Line;
+    ++Stats.NonEmptyLines;
+    ++Stats.XHistogram[std::min(Border / HistogramBinSz, HistogramBins - 1)];
+  }
+  return true;
+}
+
+void AutoAdjustBorder::resetWindow() {
+  WindowXHistogram.fill(0);
+  WindowYHistogram.fill(0);
+  WindowFrames = 0;
+  WindowLines = 0;
+  ProposedCnt = 0;
+}
+
+bool AutoAdjustBorder::continuousTick(const TTLDescr &TimingsTTL) {
+  // Skip dark frames, like a blank screen while switching programs.
+  if (Stats.NonEmptyLines < AUTO_ADJUST_CONT_MIN_LINES)
+    return false;
+  for (uint32_t Bin = 0; Bin != HistogramBins; ++Bin)
+    WindowXHistogram[Bin] += Stats.XHistogram[Bin];
+  ++WindowYHistogram[std::min(Stats.FirstLine, MaxLines - 1)];
+  WindowLines += Stats.NonEmptyLines;
+  if (++WindowFrames != AUTO_ADJUST_CONT_WINDOW)
+    return false;
+
+  // The left border: the first bin that reaches the percentile.
+  uint32_t NewXBorder = 0;
+  uint32_t XThreshold = std::max(
+      1u, (WindowLines * AUTO_ADJUST_CONT_X_PERMILLE + 999) / 1000);
+  for (uint32_t Bin = 0, Sum = 0; Bin != HistogramBins; ++Bin) {
+    Sum += WindowXHistogram[Bin];
+    if (Sum >= XThreshold) {
+      NewXBorder = Bin * HistogramBinSz;
+      break;
+    }
+  }
+  // The top border: the median of the first lines.
+  uint32_t NewYBorder = 0;
+  for (uint32_t Line = 0, Sum = 0; Line != MaxLines; ++Line) {
+    Sum += WindowYHistogram[Line];
+    if (Sum * 2 > WindowFrames) {
+      NewYBorder = Line;
+      break;
+    }
+  }
+  uint32_t KeepProposedCnt = ProposedCnt;
+  resetWindow();
+
+  // MDA always uses an XBorder of 0, see applyBorders().
+  if (!isXBorderAuto() || TimingsTTL.Mode == TTL::MDA)
+    NewXBorder = XBorder;
+  if (!isYBorderAuto())
+    NewYBorder = YBorder;
+  auto Differ = [](uint32_t A, uint32_t B, uint32_t Hysteresis) {
+    return (A > B ? A - B : B - A) >= Hysteresis;
+  };
+  bool XChanged = Differ(NewXBorder, XBorder, AUTO_ADJUST_CONT_X_HYSTERESIS);
+  bool YChanged = Differ(NewYBorder, YBorder, AUTO_ADJUST_CONT_Y_HYSTERESIS);
+  if (!XChanged && !YChanged)
+    return false;
+  // Count the windows in a row that agree on the new borders.
+  bool SameAsProposed =
+      KeepProposedCnt != 0 &&
+      !Differ(NewXBorder, ProposedXBorder, AUTO_ADJUST_CONT_X_HYSTERESIS) &&
+      !Differ(NewYBorder, ProposedYBorder, AUTO_ADJUST_CONT_Y_HYSTERESIS);
+  ProposedCnt = SameAsProposed ? KeepProposedCnt + 1 : 1;
+  ProposedXBorder = NewXBorder;
+  ProposedYBorder = NewYBorder;
+  if (ProposedCnt < AUTO_ADJUST_CONT_PERSIST_WINDOWS)
+    return false;
+
+  ProposedCnt = 0;
+  TmpXBorder = NewXBorder;
+  TmpYBorder = NewYBorder;
+  applyBorders(TimingsTTL);
+  DBG_PRINT(std::cout << "Continuous Auto Adjust: XBorder=" << XBorder
+                      << " YBorder=" << YBorder << "\n";)
+  return true;
+}
+
 bool AutoAdjustBorder::frameTick(const TTLDescr &TimingsTTL) {
-  if (Enabled == State::Off)
+  bool HaveStats = processFrame();
+  if (Enabled == State::Off) {
+    if (Continuous && HaveStats && continuousTick(TimingsTTL))
+      PendingSave = true;
     return false;
+  }
+  if (HaveStats && !Stats.empty()) {
+    TmpXBorder = std::min(TmpXBorder, Stats.MinX & 0xfffffffc); // 4-byte align
+    TmpYBorder = std::min(TmpYBorder, Stats.FirstLine);
+  }
   if (++ThrottleCnt % AUTO_ADJUST_THROTTLE_CNT == 0)
     return false;
   ++FrameCnt;
@@ -229,24 +463,109 @@ bool AutoAdjustBorder::frameTick(const TTLDescr &TimingsTTL) {
   return false;
 }
 
-void AutoAdjustBorder::collect(PIO Pio, uint32_t SM, uint32_t ModeBorderCounter,
-                               uint32_t Line, TTL Mode) {
-  // Get the border value from the dedicated PIO.
-  uint32_t Raw = pio_sm_get_blocking(Pio, SM);
-  if (Raw == 0xffffffff)
-    Raw = 0;
+void AutoSize::start() {
+  Active = true;
+  FrameCnt = 0;
+  NextRow = 0;
+  MinX = std::numeric_limits<uint32_t>::max();
+  MaxX = 0;
+  NonEmptyRows = 0;
+  MinFirstLine = std::numeric_limits<uint32_t>::max();
+  MaxLastLine = 0;
+  NonEmptyFrames = 0;
+}
 
-  if (Enabled != State::Off) {
-    uint32_t Border = ModeBorderCounter - Raw;
-    Border &= 0xfffffffc; // Must be 4-byte aligned!
-    TmpXBorder = std::min(TmpXBorder, Border);
-    // If line is non-empty set YBorder.
-    bool LineNonEmpty = Raw != 0;
-    if (LineNonEmpty)
-      // I think we need Line - 4 because Border.pio fills up the 4-size FIFO
-      // during VSync.
-      TmpYBorder = std::min(TmpYBorder, std::max((uint32_t)0u, Line - 4));
+bool AutoSize::getRowExtent(uint32_t Y, bool IsMDA, bool HalfRate,
+                            uint32_t &Left, uint32_t &Right) const {
+#ifdef TEMPORAL_FILTER
+  // The right half of the row holds the temporal filter's history.
+  const uint32_t BuffX =
+      HalfRate ? DisplayBuffer::BuffX / 2 : DisplayBuffer::BuffX;
+#else
+  constexpr uint32_t BuffX = DisplayBuffer::BuffX;
+#endif
+  // Find the first and last non-black 4-byte words first.
+  uint32_t FirstX = BuffX;
+  for (uint32_t X = 0; X != BuffX; X += 4) {
+    if (Buff.get32(Y, X) != Black_4) {
+      FirstX = X;
+      break;
+    }
+  }
+  if (FirstX == BuffX)
+    return false;
+  uint32_t LastX = FirstX;
+  for (uint32_t X = BuffX - 4; X != FirstX; X -= 4) {
+    if (Buff.get32(Y, X) != Black_4) {
+      LastX = X;
+      break;
+    }
   }
+  // Now find the bytes within them.
+  uint32_t LeftByte = FirstX;
+  while (Buff.get(Y, LeftByte) == Black)
+    ++LeftByte;
+  uint32_t RightByte = LastX + 3;
+  while (Buff.get(Y, RightByte) == Black)
+    --RightByte;
+  if (HalfRate) {
+    // Each byte is a pair of identical pixels.
+    Left = 2 * LeftByte;
+    Right = 2 * RightByte + 1;
+    return true;
+  }
+  if (!IsMDA) {
+    Left = LeftByte;
+    Right = RightByte;
+    return true;
+  }
+  // MDA has 2 pixels per byte, the low nibble being the even pixel.
+  Left = 2 * LeftByte + ((Buff.get(Y, LeftByte) & 0x0f) != 0 ? 0 : 1);
+  Right = 2 * RightByte + ((Buff.get(Y, RightByte) & 0xf0) != 0 ? 1 : 0);
+  return true;
+}
+
+bool AutoSize::frameTick(const TTLDescr &TimingsTTL, bool HalfRate,
+                         const AutoAdjustBorder::FrameStats &Stats) {
+  if (!Active)
+    return false;
+  if (FrameCnt++ < AUTO_SIZE_SETTLE_FRAMES)
+    return false;
+  if (!Stats.empty()) {
+    MinFirstLine = std::min(MinFirstLine, Stats.FirstLine);
+    MaxLastLine = std::max(MaxLastLine, Stats.LastLine);
+    ++NonEmptyFrames;
+  }
+  // Scanning the whole frame buffer takes too long, so scan a few rows per
+  // frame in a round-robin fashion.
+  bool IsMDA = TimingsTTL.Mode == TTL::MDA;
+  uint32_t NumRows = std::min(TimingsTTL.V_Visible, DisplayBuffer::BuffY);
+  for (uint32_t Cnt = 0; Cnt != AUTO_SIZE_ROWS_PER_FRAME; ++Cnt) {
+    uint32_t Y = NextRow;
+    NextRow = (NextRow + 1) % NumRows;
+    uint32_t Left, Right;
+    if (!getRowExtent(Y, IsMDA, HalfRate, Left, Right))
+      continue;
+    MinX = std::min(MinX, Left);
+    MaxX = std::max(MaxX, Right);
+    ++NonEmptyRows;
+  }
+  if (FrameCnt != AUTO_SIZE_SETTLE_FRAMES + AUTO_SIZE_FRAMES)
+    return false;
+  Active = false;
+  DBG_PRINT(std::cout << "AutoSize: MinX=" << MinX << " MaxX=" << MaxX
+                      << " MinFirstLine=" << MinFirstLine
+                      << " MaxLastLine=" << MaxLastLine << "\n";)
+  return true;
+}
+
+std::optional<AutoSize::Result> AutoSize::getResult() const {
+  if (NonEmptyRows == 0 || NonEmptyFrames == 0)
+    return std::nullopt;
+  // XBorder moves in steps of 4 pixels, so round up the width.
+  uint32_t Width = ((MaxX - MinX + 1) + 3) & 0xfffffffc;
+  uint32_t Height = MaxLastLine - MinFirstLine + 1;
+  return Result{Width + XB, Height + YB};
 }
 
 uint32_t &TTLReader::getPxClkFor(const TTLDescr &Descr) {
@@ -257,7 +576,7 @@ uint32_t &TTLReader::getPxClkFor(const TTLDescr &Descr) {
   case TTL::MDA:
     return MDAPxClk;
   default:
-    std::cerr << __FUNCTION__ << " BAD Mode " << modeToStr(Descr.Mode) << "\n";
+    printf("%s BAD Mode %s\n", __FUNCTION__, modeToStr(Descr.Mode));
     exit(1);
   }
 }
@@ -271,7 +590,7 @@ uint32_t &TTLReader::getSamplingOffsetFor(const TTLDescr &Descr) {
   case TTL::MDA:
     return MDASamplingOffset;
   default:
-    std::cerr << __FUNCTION__ << " BAD Mode " << modeToStr(Descr.Mode) << "\n";
+    printf("%s BAD Mode %s\n", __FUNCTION__, modeToStr(Descr.Mode));
     exit(1);
   }
 }
@@ -335,7 +654,20 @@ void TTLReader::changePxClk(bool Increase, bool SmallStep, bool OffsetStep) {
   displayPxClk();
 }
 
+void TTLReader::restartCaptureSMs() {
+  auto Restart = [](PIO Pio, uint SM, uint Offset) {
+    pio_sm_set_enabled(Pio, SM, false);
+    pio_sm_clear_fifos(Pio, SM);
+    pio_sm_restart(Pio, SM);
+    pio_sm_exec(Pio, SM, pio_encode_jmp(Offset));
+    pio_sm_set_enabled(Pio, SM, true);
+  };
+  Restart(TTLPio, TTLSM, TTLOffset);
+  Restart(TTLBorderPio, TTLBorderSM, TTLBorderOffset);
+}
+
 void TTLReader::unclaimUsedSMs() {
+  AutoAdjust.release();
   for (auto [Pio, SM] : UsedSMs) {
     pio_sm_set_enabled(Pio, SM, false);
     // Unclaim it.
@@ -349,43 +681,133 @@ int TTLReader::claimUnusedSMSafe(PIO Pio) {
   return SM;
 }
 
-void TTLReader::updateSyncPolarityVariables() {
-  auto GetPolarity = [this](PIO Pio, uint SM) {
-    uint32_t Samples = pio_sm_get_blocking(Pio, SM);
-    // DBG_PRINT(printf("GetPolarity: 0x%08x\n", Samples);)
-    // Count the number of '1's. If more than 16 then it's negative ~~~~|_|~~~~
-    uint32_t CntOnes = 0;
-    for (int Idx = 0; Idx != 32; ++Idx) {
-      if ((Samples >> Idx) & 0x1)
-        ++CntOnes;
-      if (CntOnes > 16)
-        return Polarity::Neg;
+bool SyncPeriodCounter::Result::matches(const Result &Other) const {
+  uint32_t Diff = Period > Other.Period ? Period - Other.Period
+                                        : Other.Period - Period;
+  return Pol == Other.Pol &&
+         (uint64_t)Diff * 1000 <= (uint64_t)Period * SYNC_LOCK_PERMILLE;
+}
+
+void SyncPeriodCounter::arm() {
+  SyncPeriodArm(Pio, SM, Offset);
+  Pushes = 0;
+}
+
+std::optional<SyncPeriodCounter::Result>
+__not_in_flash_func(SyncPeriodCounter::poll)() {
+  uint32_t Level = pio_sm_get_rx_fifo_level(Pio, SM);
+  // If the FIFO is full the SM may be stalled, so it's no longer counting.
+  bool Full = Level >= 4;
+  std::optional<Result> ResOpt;
+  for (; Level != 0; --Level) {
+    // X counts down, one decrement every 2 cycles.
+    uint32_t X = pio_sm_get(Pio, SM);
+    bool IsRise = (++Pushes % 2) == 0;
+    if (!IsRise) {
+      LastFall = X;
+      continue;
     }
-    return Polarity::Pos;
-  };
+    // The first falling edge is not valid, we need Fall-Rise-Fall-Rise.
+    if (Pushes >= 4) {
+      uint32_t High = 2 * (LastRise - LastFall);
+      uint32_t Low = 2 * (LastFall - X);
+      Result Res;
+      Res.Period = High + Low;
+      Res.Pulse = std::min(High, Low);
+      Res.Pol = High < Low ? Polarity::Pos : Polarity::Neg;
+      ResOpt = Res;
+    }
+    LastRise = X;
+  }
+  if (Full) {
+    Trace::event(TraceEvent::SyncFifoFull, SM);
+    arm();
+  }
+  return ResOpt;
+}
 
-  if (!pio_sm_is_rx_fifo_empty(VSyncPolarityPio, VSyncPolaritySM)) {
-    // VSync
-    Polarity NewVSyncPolarity = GetPolarity(VSyncPolarityPio, VSyncPolaritySM);
-    DBG_PRINT(if (NewVSyncPolarity != VSyncPolarity) {
-      std::cout << "NewVSyncPolarity=" << polarityToChar(NewVSyncPolarity)
-                << "\n";
+bool TTLReader::updateSyncVariables() {
+  if (auto HOpt = HSyncCounter.poll()) {
+    DBG_PRINT(if (HOpt->Pol != HSyncPolarity) {
+      std::cout << "NewHSyncPolarity=" << polarityToChar(HOpt->Pol) << "\n";
     })
-    VSyncPolarity = NewVSyncPolarity;
-  } else {
-    DBG_PRINT(std::cerr << "VSync Polarity Pio FIFO empty!\n";)
+    HSyncMeasOpt = *HOpt;
+    HSyncPolarity = HOpt->Pol;
+  }
+  auto VOpt = VSyncCounter.poll();
+  if (!VOpt || !HSyncMeasOpt)
+    return false;
+  DBG_PRINT(if (VOpt->Pol != VSyncPolarity) {
+    std::cout << "NewVSyncPolarity=" << polarityToChar(VOpt->Pol) << "\n";
+  })
+  VSyncMeasOpt = *VOpt;
+  bool VPolarityChanged = VOpt->Pol != VSyncPolarity;
+  VSyncPolarity = VOpt->Pol;
+  if (VPolarityChanged && !ManualTTLEnabled) {
+    // The capture loops look for VSync with the polarity of the preset, so
+    // don't wait for checkAndUpdateMode() to pick a matching one.
+    TimingsTTL.V_SyncPolarity = VSyncPolarity;
+    updateCapturePreset();
   }
 
-  if (!pio_sm_is_rx_fifo_empty(HSyncPolarityPio, HSyncPolaritySM)) {
-    // HSync
-    Polarity NewHSyncPolarity = GetPolarity(HSyncPolarityPio, HSyncPolaritySM);
-    DBG_PRINT(if (NewHSyncPolarity != HSyncPolarity) {
-      std::cout << "NewHSyncPolarity=" << polarityToChar(NewHSyncPolarity)
-                << "\n";
-    })
-    HSyncPolarity = NewHSyncPolarity;
-  } else {
-    DBG_PRINT(std::cerr << "HSync Polarity Pio FIFO empty!\n";)
+  const auto &V = *VSyncMeasOpt;
+  const auto &H = *HSyncMeasOpt;
+  float SysHz = (float)clock_get_hz(clk_sys);
+  VHz = SysHz / V.Period;
+  HHz = SysHz / H.Period;
+  // The lines between two VSync pulses, like the ones we capture.
+  LinesPerFrame = (V.Period - V.Pulse + H.Period / 2) / H.Period;
+  return true;
+}
+
+void TTLReader::syncLockTick(uint32_t Mod) {
+  bool NewMeas = updateSyncVariables();
+  if (SyncChangeTime)
+    ++SyncChangeFrames;
+  switch (SyncLock) {
+  case SyncLockState::Locked: {
+    if (NewMeas && (!VSyncMeasOpt->matches(LockedV) ||
+                    !HSyncMeasOpt->matches(LockedH))) {
+      // The sync timings changed, look for a new mode.
+      DBG_PRINT(std::cout << "Sync lock lost\n";)
+      PinActivity.reset();
+      SyncLock = SyncLockState::Searching;
+      SyncLockStableCnt = 0;
+      SyncChangeTime = get_absolute_time();
+      SyncChangeFrames = 0;
+      break;
+    }
+    if (Mod == 3)
+      checkAndUpdateMode();
+    break;
+  }
+  case SyncLockState::Searching: {
+    if (!SyncChangeTime) {
+      // Just started or the input just got enabled.
+      SyncChangeTime = get_absolute_time();
+      SyncChangeFrames = 0;
+    }
+    if (!NewMeas)
+      break;
+    bool Same = SyncLockStableCnt != 0 && VSyncMeasOpt->matches(LockedV) &&
+                HSyncMeasOpt->matches(LockedH);
+    SyncLockStableCnt = Same ? SyncLockStableCnt + 1 : 1;
+    LockedV = *VSyncMeasOpt;
+    LockedH = *HSyncMeasOpt;
+    if (SyncLockStableCnt < SYNC_LOCK_STABLE_CNT)
+      break;
+    checkAndUpdateMode();
+    setBorders();
+    SyncLock = SyncLockState::Locked;
+    LastLockUs = absolute_time_diff_us(*SyncChangeTime, get_absolute_time());
+    LastLockFrames = SyncChangeFrames;
+    SyncChangeTime = std::nullopt;
+    DBG_PRINT(std::cout << "Sync locked in " << *LastLockUs << "us "
+                        << LastLockFrames << " frames: VHz=" << VHz
+                        << " HHz=" << HHz << " Lines=" << LinesPerFrame
+                        << "\n";)
+    break;
+  }
   }
 }
 
@@ -427,6 +849,18 @@ void TTLReader::readConfigFromFlash() {
   EGABorderOpt = ReadBorderSafe(Profile::EGABorderIdx);
   MDABorderOpt = ReadBorderSafe(Profile::MDABorderIdx);
 
+  // Erased flash reads as 0xFFFFFFFF, so only 1 turns these on.
+  AutoAdjust.setContinuous(
+      (uint32_t)Flash.read(get(ProfileExt::AutoAdjustContinuousIdx)) == 1);
+  Capture320 = (uint32_t)Flash.read(get(ProfileExt::Capture320Idx)) == 1;
+  uint32_t PalIdx = (uint32_t)Flash.read(get(ProfileExt::PaletteIdx));
+  setPalette(PalIdx < PaletteMAX ? (Palette)PalIdx : Palette::Standard);
+  LearnedOpt =
+      LearnedTTL::unpack((uint32_t)Flash.read(get(ProfileExt::LearnedSyncIdx)),
+                         (uint32_t)Flash.read(get(ProfileExt::LearnedSizeIdx)));
+  LearnedUnsaved = false;
+  DBG_PRINT(std::cout << "LearnedOpt=" << (LearnedOpt ? "Yes" : "No") << "\n";)
+
   DBG_PRINT(std::cout << "CGABorderOpt=" << (CGABorderOpt ? "Yes" : "No")
                       << "\n";)
   DBG_PRINT(std::cout << "EGABorderOpt=" << (EGABorderOpt ? "Yes" : "No")
@@ -451,18 +885,23 @@ void TTLReader::readConfigFromFlash() {
 }
 
 TTLReader::TTLReader(PioProgramLoader &PioLoader, Pico &Pi, FlashStorage &Flash,
-                     DisplayBuffer &Buff, PIO VSyncPolarityPio,
-                     uint VSyncPolaritySM, PIO HSyncPolarityPio,
-                     uint HSyncPolaritySM, bool ResetToDefaults)
+                     DisplayBuffer &Buff, PIO SyncPeriodPio,
+                     uint VSyncPeriodSM, uint HSyncPeriodSM,
+                     uint SyncPeriodOffset, bool ResetToDefaults)
     : Pi(Pi), PioLoader(PioLoader),
       AutoAdjustBtn(AUTO_ADJUST_GPIO, Pi, "AutoAdjust"),
       PxClkBtn(PX_CLK_BTN_GPIO, Pi, "PxClk"),
       AutoAdjust(ManualTTLEnabled, ManualTTL, XBorderAUTO, XBorder, YBorderAUTO,
                  YBorder, CGABorderOpt, EGABorderOpt, MDABorderOpt, Flash,
                  *this),
-      Flash(Flash), VSyncPolarityPio(VSyncPolarityPio),
-      VSyncPolaritySM(VSyncPolaritySM), HSyncPolarityPio(HSyncPolarityPio),
-      HSyncPolaritySM(HSyncPolaritySM), ResetToDefaults(ResetToDefaults),
+      AutoSizer(Buff),
+#ifdef USB_STREAM
+      Stream(Buff),
+#endif
+      LA(PioLoader), Flash(Flash),
+      VSyncCounter(SyncPeriodPio, VSyncPeriodSM, SyncPeriodOffset),
+      HSyncCounter(SyncPeriodPio, HSyncPeriodSM, SyncPeriodOffset),
+      ResetToDefaults(ResetToDefaults),
       Buff(Buff), ManualTTLMenu(*this) {
   DBG_PRINT(std::cout << "\n\n\n\n\nTTLReader constructor start\n";)
 
@@ -475,6 +914,8 @@ TTLReader::TTLReader(PioProgramLoader &PioLoader, Pico &Pi, FlashStorage &Flash,
   ProfileBankOpt = 0;
 
   Buff.setMode(TimingsTTL);
+  // We are running on core1, which stores the captured lines with interp0.
+  DisplayBuffer::interpInit();
   if (ResetToDefaults) {
     DBG_PRINT(std::cout << "\n\n\n*** Reset to defaults ***\n\n\n";)
     saveToFlash(/*OnlyProfileBank=*/false, /*AllProfiles=*/true);
@@ -495,6 +936,8 @@ TTLReader::TTLReader(PioProgramLoader &PioLoader, Pico &Pi, FlashStorage &Flash,
       DBG_PRINT(std::cout << "Flash not valid!\n";);
     }
   }
+  // If we didn't read the config from flash we still need the default LUT.
+  setPalette(Pal);
   if (ManualTTLEnabled)
     TimingsTTL = ManualTTL;
 
@@ -503,85 +946,139 @@ TTLReader::TTLReader(PioProgramLoader &PioLoader, Pico &Pi, FlashStorage &Flash,
 
   TTLBorderPio = pio0;
   TTLBorderSM = claimUnusedSMSafe(TTLBorderPio);
+  AutoAdjust.init(TTLBorderPio, TTLBorderSM);
+
+  VSyncCounter.arm();
+  HSyncCounter.arm();
 
   DBG_PRINT(std::cout << "TTLReader constructor getDividerAutomatically()\n";)
   getDividerAutomatically();
   DBG_PRINT(std::cout << "TTLReader constructor switchPio()\n";)
   switchPio();
+  updateCapturePreset();
   DBG_PRINT(std::cout << "TTLReader constructor end\n";)
 }
 
-template <bool DiscardData>
+template <int Preset>
 bool __not_in_flash_func(TTLReader::readLineCGA)(uint32_t Line) {
-  // Now fill in the line until HSync is high.
-  uint32_t X = 0;
+  // For presets these are compile-time constants, so the loop trip count and
+  // the VSync check below don't need to load TimingsTTL on every line.
+  const TTLDescr &Timings = getCaptureTimings<Preset>();
+  const uint32_t H_Visible = Timings.H_Visible;
+  const bool RetraceVSync = Timings.V_SyncPolarity == Pos;
+  // In 320-pixel mode each FIFO entry holds 4 samples of every other pixel, so
+  // the border and the line are counted in samples.
+  const bool Half = HalfRate;
+  const uint32_t XBorderSamples = Half ? XBorder / 2 : XBorder;
+  const uint32_t H_Samples = Half ? H_Visible / 2 : H_Visible;
+  const uint8_t *LUT = PalLUT.data();
 
   uint32_t XBorderAdj =
-      (XBorder + /*FIFO sz=*/8 * /*Pixels per FIFO Entry=*/4) &
+      (XBorderSamples + /*FIFO sz=*/8 * /*Pixels per FIFO Entry=*/4) &
       0xfffffffc; // Must be 4-byte aligned!
   // Wait here if we are still in HSync retrace
-  while (gpio_get(TTL_HSYNC_GPIO) != 0)
+  while (gpio_get(TTL_HSYNC_GPIO) != 0 && !NoSignal)
     ;
   if (Line < YBorder) {
-    while (gpio_get(TTL_HSYNC_GPIO) == 0)
+    while (gpio_get(TTL_HSYNC_GPIO) == 0 && !NoSignal)
       ;
   } else {
-    uint32_t XMax = TimingsTTL.H_Visible + XBorderAdj;
-    while (true) {
-      // Example:
-      // ISR Values are right-shifted. 0 is the earliest, 3 is the latest
-      //              3         2         1         0
-      //         |---------|---------|---------|---------|
-      // VHRGB0 = VHRR GGBB VHRR GGBB VHRR GGBB VHRR GGBB
-      //
-      // Pico is little endian, so low-order bits of a 32-bit int come in lower
-      // addresses in memory. So when we write into Buff we need to write bytes
-      // in order: 0, 1, 2, 3
-
-      // Skip non-visible parts
-      uint32_t VHRGB = pio_sm_get_blocking(TTLPio, TTLSM);
-      if constexpr (!DiscardData) {
-        if (X >= XBorderAdj) {
-          Buff.setCGA32(Line - YBorder, X - XBorderAdj, VHRGB & RGBMask_4);
-        }
+    // Skip non-visible parts. XBorderAdj is 4-byte aligned so these are whole
+    // FIFO entries and we don't need to check X against the border for each
+    // entry of the visible part below.
+    for (uint32_t X = 0; X != XBorderAdj; X += 4)
+      getTTLData();
+
+    const uint32_t BuffLine = Line - YBorder;
+    // We read one more entry than what fits in H_Visible.
+    const uint32_t NumEntries = H_Samples / 4 + 1;
+    // The store addresses come from interp0, so the loop below only needs to
+    // clamp at the end of the line instead of for every entry.
+    const uint32_t FitEntries =
+        std::min(NumEntries, Buff.interpStartRow(BuffLine, 0));
+#ifdef TEMPORAL_FILTER
+    // In 320-pixel mode the right half of each row is unused, so it keeps the
+    // history of the temporal filter. The entries past the left half get
+    // dropped so that they don't overwrite the history.
+    if (Half) {
+      const uint32_t FilterEntries = std::min(FitEntries, HistoryWords);
+#pragma GCC unroll 4
+      for (uint32_t Cnt = 0; Cnt != FilterEntries; ++Cnt) {
+        uint32_t VHRGB = getTTLData();
+        uint32_t *Out = Buff.interpNextWord32();
+        *Out = TemporalFilter::apply(LUT, VHRGB, Out[HistoryWords]);
       }
-      X += 4;
-      if (X > XMax) {
-        break;
+      for (uint32_t Cnt = FilterEntries; Cnt != NumEntries; ++Cnt)
+        getTTLData();
+    } else
+#endif // TEMPORAL_FILTER
+    {
+#pragma GCC unroll 4
+      for (uint32_t Cnt = 0; Cnt != FitEntries; ++Cnt) {
+        // Example:
+        // ISR Values are right-shifted. 0 is the earliest, 3 is the latest
+        //              3         2         1         0
+        //         |---------|---------|---------|---------|
+        // VHRGB0 = VHRR GGBB VHRR GGBB VHRR GGBB VHRR GGBB
+        //
+        // Pico is little endian, so low-order bits of a 32-bit int come in
+        // lower addresses in memory. So when we write into Buff we need to
+        // write bytes in order: 0, 1, 2, 3
+        //
+        // The palette LUT also clears the HV bits.
+        uint32_t VHRGB = getTTLData();
+        *Buff.interpNextWord32() = applyPaletteLUT(LUT, VHRGB);
       }
+      // Entries that don't fit overwrite the last word of the line.
+      for (uint32_t Cnt = FitEntries; Cnt != NumEntries; ++Cnt)
+        *Buff.getLastWord32(BuffLine) = applyPaletteLUT(LUT, getTTLData());
     }
   }
   // Wait for HSYNC
-  while (gpio_get(TTL_HSYNC_GPIO) == 0)
+  while (gpio_get(TTL_HSYNC_GPIO) == 0 && !NoSignal)
     ;
 
   // // Flush FIFO so that the remaining entries are not used by the next line
   // while(!pio_sm_is_rx_fifo_empty(TTLPio, TTLSM))
   //   pio_sm_get(TTLPio, TTLSM);
-  bool InRetrace =
-      gpio_get(TTL_VSYNC_GPIO) == (TimingsTTL.V_SyncPolarity == Pos);
-  return InRetrace;
+  bool InRetrace = gpio_get(TTL_VSYNC_GPIO) == RetraceVSync;
+  // If we lost the signal end the frame here.
+  return InRetrace || NoSignal;
 }
 
-template <bool DiscardData>
+template <int Preset>
 bool __not_in_flash_func(TTLReader::readLineMDA)(uint32_t Line) {
-  // Now fill in the line until HSync is high.
-  uint32_t PixelX = 0;
-  uint32_t BuffX = 0;
+  // See readLineCGA().
+  const TTLDescr &Timings = getCaptureTimings<Preset>();
+  const uint32_t H_Visible = Timings.H_Visible;
+  const bool RetraceVSync = Timings.V_SyncPolarity == Pos;
+
   uint32_t XBorderAdj =
       (XBorder + /*FIFO sz (not filling up)=*/4 * /*Pixels per FIFO Entry=*/8) &
       0xfffffffc; // Must be 4-byte aligned!
 
   // Wait here if we are still in HSync retrace
-  while (gpio_get(TTL_HSYNC_GPIO) != 0)
+  while (gpio_get(TTL_HSYNC_GPIO) != 0 && !NoSignal)
     ;
   if (Line < YBorder) {
-    while (gpio_get(TTL_HSYNC_GPIO) == 0)
+    while (gpio_get(TTL_HSYNC_GPIO) == 0 && !NoSignal)
       ;
   } else {
-    uint32_t XMax = TimingsTTL.H_Visible;
-    uint32_t XMaxPixelX = XMax + XBorderAdj;
-    while (true) {
+    // Since we are packing 2 monochrome values per byte, each FIFO entry (8
+    // pixels) takes 4 bytes in the buffer. This is also the unit of XBorderAdj.
+    const uint32_t NumEntries = (H_Visible + XBorderAdj) / 8 + 1;
+    const uint32_t SkipEntries = std::min(XBorderAdj / 4, NumEntries);
+    // Skip non-visible parts
+    for (uint32_t Cnt = 0; Cnt != SkipEntries; ++Cnt)
+      getTTLData();
+
+    const uint32_t BuffLine = Line - YBorder;
+    const uint32_t VisibleEntries = NumEntries - SkipEntries;
+    // Same as readLineCGA() but starting at the offset that centers MDA.
+    const uint32_t FitEntries = std::min(
+        VisibleEntries, Buff.interpStartRow(BuffLine, Buff.getMDAXOffset()));
+#pragma GCC unroll 4
+    for (uint32_t Cnt = 0; Cnt != FitEntries; ++Cnt) {
       // Example:
       // ISR Values are right-shifted. 0 is the earliest, 7 is the latest
       //              3         2         1         0
@@ -590,26 +1087,18 @@ bool __not_in_flash_func(TTLReader::readLineMDA)(uint32_t Line) {
       //
       // So the natural way of inserting values to the ISR is with right-shift.
       // We need to come up with the order: 7 6 5 4 3 2 1 0
-      uint32_t MDA8 = pio_sm_get_blocking(TTLPio, TTLSM);
-      if constexpr (!DiscardData) {
-        if (BuffX >= XBorderAdj)
-          Buff.setMDA32(Line - YBorder, BuffX - XBorderAdj, MDA8);
-      }
-      // Since we are packing 2 monochrome values per byte we are increasing
-      // BuffX by 4 instead of 8 to avoid dividing it by 2 again in setMDA32().
-      BuffX += 4;
-      PixelX += 8;
-      if (PixelX > XMaxPixelX) {
-        break;
-      }
+      uint32_t MDA8 = getTTLData();
+      *Buff.interpNextWord32() = MDA8;
     }
+    for (uint32_t Cnt = FitEntries; Cnt != VisibleEntries; ++Cnt)
+      *Buff.getLastWord32(BuffLine) = getTTLData();
   }
   // Wait for HSYNC
-  while (gpio_get(TTL_HSYNC_GPIO) == 0)
+  while (gpio_get(TTL_HSYNC_GPIO) == 0 && !NoSignal)
     ;
-  bool InRetrace =
-      gpio_get(TTL_VSYNC_GPIO) == (TimingsTTL.V_SyncPolarity == Pos);
-  return InRetrace;
+  bool InRetrace = gpio_get(TTL_VSYNC_GPIO) == RetraceVSync;
+  // If we lost the signal end the frame here.
+  return InRetrace || NoSignal;
 }
 
 static auto getEGAProgram(uint32_t InstrDelay, uint32_t SamplingOffset, Polarity HSync) {
@@ -623,8 +1112,8 @@ static auto getEGAProgram(uint32_t InstrDelay, uint32_t SamplingOffset, Polarity
     break;
   }
   }
-  std::cerr << "Bad InstrDelay or SamplingOffset in  getEGAProgram("
-            << InstrDelay << "," << SamplingOffset << ")\n";
+  printf("Bad InstrDelay or SamplingOffset in  getEGAProgram(%lu,%lu)\n",
+         (unsigned long)InstrDelay, (unsigned long)SamplingOffset);
   exit(1);
 }
 
@@ -640,8 +1129,8 @@ static auto getCGAProgram(uint32_t InstrDelay, uint32_t SamplingOffset,
     break;
   }
   }
-  std::cerr << "Bad InstrDelay or SamplingOffset in getCGAProgram("
-            << InstrDelay << ", " << SamplingOffset << ")\n";
+  printf("Bad InstrDelay or SamplingOffset in getCGAProgram(%lu, %lu)\n",
+         (unsigned long)InstrDelay, (unsigned long)SamplingOffset);
   exit(1);
 }
 
@@ -656,8 +1145,8 @@ static auto getMDAProgram(uint32_t InstrDelay, uint32_t SamplingOffset, Polarity
     break;
   }
   }
-  std::cerr << "Bad InstrDelay or SamplingOffset in getMDAProgram("
-            << InstrDelay << ", " << SamplingOffset << ")\n";
+  printf("Bad InstrDelay or SamplingOffset in getMDAProgram(%lu, %lu)\n",
+         (unsigned long)InstrDelay, (unsigned long)SamplingOffset);
   exit(1);
 }
 
@@ -669,7 +1158,7 @@ static std::pair<uint32_t, uint32_t> getIPPRange(TTL M) {
   case TTL::MDA:
     return {5, 16};
   }
-  std::cerr << "Bad Mode in getIPPRange(" << modeToStr(M) << ")\n";
+  printf("Bad Mode in getIPPRange(%s)\n", modeToStr(M));
   exit(1);
 }
 
@@ -685,10 +1174,16 @@ bool TTLReader::haveBorderFromFlash() const {
 }
 
 void TTLReader::switchPio() {
+  // This must match the divider from getDividerAutomatically().
+  HalfRate = isHalfRate();
+  Buff.setHalfRate(HalfRate);
+  DBG_PRINT(std::cout << "HalfRate=" << HalfRate << "\n";)
   DBG_PRINT(std::cout << "unloadAllPio()\n";)
   PioLoader.unloadAllPio(TTLPio, {TTLSM, TTLBorderSM});
   DBG_PRINT(std::cout << "\nTTLReader Switching PIO to "
                       << modeToStr(TimingsTTL.Mode) << "\n\n";)
+  Trace::event(TraceEvent::SwitchPio, (uint32_t)TimingsTTL.Mode, HalfRate,
+               getPxClkFor(TimingsTTL));
 
   auto GetBorderIPP = [](TTL M) { return 10; };
 
@@ -715,6 +1210,7 @@ void TTLReader::switchPio() {
         });
     pio_sm_put_blocking(TTLBorderPio, TTLBorderSM,
                         /*Counter=*/MDABorderCounter);
+    AutoAdjust.setBorderCounter(MDABorderCounter);
     break;
   }
   case TTL::CGA:
@@ -737,6 +1233,7 @@ void TTLReader::switchPio() {
           });
       pio_sm_put_blocking(TTLBorderPio, TTLBorderSM,
                           /*Counter=*/EGABorderCounter);
+      AutoAdjust.setBorderCounter(EGABorderCounter);
 
     } else {
       TTLOffset = PioLoader.loadPIOProgram(
@@ -757,6 +1254,7 @@ void TTLReader::switchPio() {
           });
       pio_sm_put_blocking(TTLBorderPio, TTLBorderSM,
                           /*Counter=*/CGABorderCounter);
+      AutoAdjust.setBorderCounter(CGABorderCounter);
     }
     break;
   }
@@ -800,6 +1298,9 @@ void TTLReader::getDividerAutomatically() {
   ClkDivider BestClkDiv;
   double PicoClk_Hz = frequency_count_khz(CLOCKS_FC0_SRC_VALUE_CLK_SYS) * 1000;
   uint32_t PixelClk_Hz = getPxClkFor(TimingsTTL);
+  // In 320-pixel mode we sample every other pixel.
+  if (isHalfRate())
+    PixelClk_Hz /= 2;
   auto IPPRange = getIPPRange(TimingsTTL.Mode);
   for (uint32_t IPP = IPPRange.first, E = IPPRange.second; IPP <= E; ++IPP) {
     double ClkDiv = (double)PicoClk_Hz / (PixelClk_Hz * IPP);
@@ -869,12 +1370,12 @@ static void legalizeManualTTL(TTLDescrReduced &ManualTTL) {
 
 void TTLReader::saveToFlash(bool OnlyProfileBank, bool AllProfiles) {
   DBG_PRINT(std::cout << "Saving to flash...\n";)
-  const int *FlashVec = Flash.getData();
-
+  Trace::event(TraceEvent::FlashWrite, *ProfileBankOpt, OnlyProfileBank,
+               AllProfiles);
   // Fill in the vector with the current values.
   FlashStorage::DataTy FlashValues;
   for (int Idx = 0, E = getNumFlashEntries(); Idx != E; ++Idx)
-    FlashValues[Idx] = FlashVec[Idx];
+    FlashValues[Idx] = Flash.read(Idx);
 
   // Now override with the ones for the current preset (bank).
   FlashValues[ProfileBankIdx] = *ProfileBankOpt;
@@ -915,12 +1416,57 @@ void TTLReader::saveToFlash(bool OnlyProfileBank, bool AllProfiles) {
           ManualTTLEnabled && YBorderAUTO ? YBorderAUTO : 0;
       FlashValues[get(Profile::ManualTTL_V_BackPorchIdx, Profile)] =
           ManualTTLEnabled ? ManualTTL.V_BackPorch : 0;
+
+      FlashValues[get(ProfileExt::AutoAdjustContinuousIdx, Profile)] =
+          AutoAdjust.getContinuous();
+      auto [LearnedSync, LearnedSize] =
+          LearnedOpt ? LearnedOpt->pack() : std::make_pair(0u, 0u);
+      FlashValues[get(ProfileExt::LearnedSyncIdx, Profile)] = LearnedSync;
+      FlashValues[get(ProfileExt::LearnedSizeIdx, Profile)] = LearnedSize;
+      FlashValues[get(ProfileExt::Capture320Idx, Profile)] = Capture320;
+      FlashValues[get(ProfileExt::PaletteIdx, Profile)] = (uint32_t)Pal;
     }
   }
   Flash.write(FlashValues);
   DBG_PRINT(std::cout << "DONE!\n";)
 }
 
+void TTLReader::startAutoSize() {
+  DBG_PRINT(std::cout << "AutoSize start\n";)
+  AutoSizeOrigTTL = ManualTTL;
+  // Capture as much as fits in the frame buffer.
+  ManualTTL.H_Visible = std::numeric_limits<uint32_t>::max();
+  ManualTTL.V_Visible = std::numeric_limits<uint32_t>::max();
+  legalizeManualTTL(ManualTTL);
+  // MDA is centered in the 800 pixel wide VGA output, see getMDAXOffset().
+  if (ManualTTL.Mode == TTL::MDA)
+    ManualTTL.H_Visible = std::min(ManualTTL.H_Visible,
+                                   TimingsVGA[VGA_800x600_56Hz].H_Visible);
+  // Remove any stale pixels from the right of the previous H_Visible.
+  Buff.clear();
+  AutoSizer.start();
+}
+
+void TTLReader::finishAutoSize() {
+  if (auto ResultOpt = AutoSizer.getResult()) {
+    ManualTTL.H_Visible = ResultOpt->H_Visible;
+    ManualTTL.V_Visible = ResultOpt->V_Visible;
+  } else {
+    ManualTTL.H_Visible = AutoSizeOrigTTL.H_Visible;
+    ManualTTL.V_Visible = AutoSizeOrigTTL.V_Visible;
+  }
+  legalizeManualTTL(ManualTTL);
+  DBG_PRINT(std::cout << "AutoSize done: " << ManualTTL.H_Visible << "x"
+                      << ManualTTL.V_Visible << "\n";)
+  Buff.clear();
+  checkAndUpdateMode();
+  if (AutoSizer.getResult())
+    printManualTTLMenu();
+  else
+    displayTxt("AUTO-SIZE: NO IMAGE FOUND", MANUAL_TTL_DISPLAY_DONE_MS);
+  ManualTTLExitTime = delayed_by_ms(FrameEnd, MANUAL_TTL_TIMEOUT_MS);
+}
+
 void TTLReader::toggleManualTTL() {
   if (ManualTTLEnabled) {
     ManualTTLEnabled = false;
@@ -976,6 +1522,15 @@ void TTLReader::printManualTTLMenu() {
                             ManualTTLEnabled && !YBorderAUTO,
                             /*Prefix=*/"", /*Item=*/V_BackPorchSS.get());
 
+  // Measures the H/V visible area.
+  ManualTTLMenu.addMenuItem(
+      ManualTTLMenu_AutoSize_ItemIdx, ManualTTLEnabled,
+      /*Prefix=*/"", /*Item=*/AutoSizer.isActive() ? "MEASURING" : "AUTO-SIZE");
+
+  // The palette applies to AUTO-TTL too.
+  ManualTTLMenu.addMenuItem(ManualTTLMenu_Palette_ItemIdx, true,
+                            /*Prefix=*/"PAL:", /*Item=*/paletteToStr(Pal));
+
   ManualTTLMenu.display(/*Selection=*/ManualTTLMenuIdx, MANUAL_TTL_DISPLAY_MS);
 }
 
@@ -1024,12 +1579,12 @@ bool TTLReader::manualTTLMode() {
   bool LongLeft = AutoAdjustBtn.get() == ButtonState::LongPress;
   bool LongRight = PxClkBtn.get() == ButtonState::LongPress;
   if (LongLeft || LongRight) {
-    if (ManualTTLEnabled) {
-      if (LongRight) {
-        ManualTTLMenu.incrSelection(ManualTTLMenuIdx);
-      } else if (LongLeft) {
-        ManualTTLMenu.decrSelection(ManualTTLMenuIdx);
-      }
+    // This skips the disabled items, so with AUTO-TTL it only cycles between
+    // AUTO-TTL and the palette.
+    if (LongRight) {
+      ManualTTLMenu.incrSelection(ManualTTLMenuIdx);
+    } else if (LongLeft) {
+      ManualTTLMenu.decrSelection(ManualTTLMenuIdx);
     }
     printManualTTLMenu();
     return true;
@@ -1089,6 +1644,17 @@ bool TTLReader::manualTTLMode() {
         ManualTTL.V_BackPorch = NextYBorder;
         break;
       }
+      case ManualTTLMenu_AutoSize_ItemIdx: {
+        // Measure the H/V visible area
+        if (!AutoSizer.isActive())
+          startAutoSize();
+        break;
+      }
+      case ManualTTLMenu_Palette_ItemIdx: {
+        // Next palette
+        setPalette((Palette)(((uint32_t)Pal + 1) % PaletteMAX));
+        break;
+      }
       }
       legalizeManualTTL(ManualTTL);
       printManualTTLMenu();
@@ -1146,6 +1712,18 @@ bool TTLReader::manualTTLMode() {
         ManualTTL.V_BackPorch = PrevYBorder;
         break;
       }
+      case ManualTTLMenu_AutoSize_ItemIdx: {
+        // Measure the H/V visible area
+        if (!AutoSizer.isActive())
+          startAutoSize();
+        break;
+      }
+      case ManualTTLMenu_Palette_ItemIdx: {
+        // Previous palette
+        uint32_t PalIdx = (uint32_t)Pal;
+        setPalette((Palette)(PalIdx > 0 ? PalIdx - 1 : PaletteMAX - 1));
+        break;
+      }
       }
       legalizeManualTTL(ManualTTL);
       printManualTTLMenu();
@@ -1165,10 +1743,34 @@ void __not_in_flash_func(TTLReader::checkAndUpdateMode)() {
     Tmp = ManualTTL;
     NewModeOpt = Tmp;
   } else {
-    NewModeOpt = getModeForVPolarityAndHz(VSyncPolarity, VHz);
+    TTLFeatures Features = getFeatures();
+    auto MatchOpt = classifyMode(Features);
+    if (MatchOpt && MatchOpt->Ambiguous) {
+      // The timings match more than one preset, so check the pins. The
+      // activity is cached as sampling takes a few frames.
+      bool Retry = CachedPinActivity == 0 &&
+                   ++PinActivityRetryCnt % PIN_ACTIVITY_RETRY_CNT == 0;
+      if (CachedPinActivityPreset != MatchOpt->PresetIdx || Retry ||
+          PinActivity.busy()) {
+        auto ActivityOpt = PinActivity.poll();
+        // Keep the current mode until the pins have been sampled.
+        if (!ActivityOpt)
+          return;
+        CachedPinActivity = *ActivityOpt;
+        CachedPinActivityPreset = MatchOpt->PresetIdx;
+      }
+      Features.PinActivity = CachedPinActivity;
+      MatchOpt = classifyMode(Features);
+    }
+    if (MatchOpt)
+      NewModeOpt = MatchOpt->Descr;
+    else
+      NewModeOpt = getAdaptiveMode(Features);
   }
 
   if (!NewModeOpt) {
+    // The polarity may have changed, so this may no longer match a preset.
+    updateCapturePreset();
     static uint32_t ThrottleMsgCnt;
     // Don't show the "unknown mode" message immediately wait until the
     // UnknownMsgMinCnt counter goes to 0.
@@ -1176,16 +1778,19 @@ void __not_in_flash_func(TTLReader::checkAndUpdateMode)() {
       UnknownMsgMinCnt = UNKNOWN_MODE_SHOW_MSG_MIN_COUNT;
       DBG_PRINT(std::cout << "ManualTTLEnabled=" << ManualTTLEnabled << "\n";)
       DBG_PRINT(ManualTTL.dump(std::cout);)
-      DBG_PRINT(std::cout << "Could not match Polarity="
-                          << polarityToChar(VSyncPolarity) << " and Hz=" << VHz
+      DBG_PRINT(std::cout << "Could not match VPolarity="
+                          << polarityToChar(VSyncPolarity) << " VHz=" << VHz
+                          << " HPolarity=" << polarityToChar(HSyncPolarity)
+                          << " HHz=" << HHz << " Lines=" << LinesPerFrame
                           << "\n";)
       // Display a helper debugging message that this is an unknown mode.
       // But limit the number of times the user will see the message.
       if (UsrAction == UserAction::None && UnknownMsgMaxCnt > 0) {
         --UnknownMsgMaxCnt;
-        char Buff[40];
-        snprintf(Buff, 40, "UNKNOWN MODE: VSYNC %dHz POLARITY:%c", (int)VHz,
-                 polarityToChar(VSyncPolarity));
+        char Buff[48];
+        snprintf(Buff, 48, "UNKNOWN MODE: V:%dHz%c H:%dHz%c LINES:%d", (int)VHz,
+                 polarityToChar(VSyncPolarity), (int)HHz,
+                 polarityToChar(HSyncPolarity), (int)LinesPerFrame);
         displayTxt(Buff, UNKNOWN_MODE_MS);
       }
     }
@@ -1199,6 +1804,8 @@ void __not_in_flash_func(TTLReader::checkAndUpdateMode)() {
       *NewModeOpt != TimingsTTL; // NOTE: This ignore porches/retraces/Hz
   if (ChangeMode) {
     DBG_PRINT(std::cout << "\nChangeMode: " << *NewModeOpt << "\n";)
+    Trace::event(TraceEvent::ModeChange, (uint32_t)NewModeOpt->Mode,
+                 NewModeOpt->H_Visible, NewModeOpt->V_Visible);
     DBG_PRINT(std::cout << "      From: " << TimingsTTL << "\n";)
     DBG_PRINT(std::cout << "OLD:\n";)
     Utils::StaticString<640> SS;
@@ -1210,9 +1817,21 @@ void __not_in_flash_func(TTLReader::checkAndUpdateMode)() {
     DBG_PRINT(std::cout << SS.get() << "\n";);
     Buff.setMode(*NewModeOpt);
     TimingsTTL = *NewModeOpt;
+    ++ModeChanges;
     getDividerAutomatically();
     switchPio();
   }
+  updateCapturePreset();
+}
+
+void TTLReader::updateCapturePreset() {
+  int NewPreset = ManualTTLEnabled || GenericCapture
+                      ? GenericPreset
+                      : getPresetIdx(TimingsTTL);
+  DBG_PRINT(if (NewPreset != CapturePreset) {
+    std::cout << "CapturePreset=" << NewPreset << "\n";
+  })
+  CapturePreset = NewPreset;
 }
 
 void TTLReader::displayTTLInfo() {
@@ -1224,7 +1843,18 @@ void TTLReader::displayTTLInfo() {
   SS << "TTL INFO\n";
   SS << "--------\n";
   TimingsTTL.dumpFull(SS, SamplingOffset);
-  Buff.displayPage(SS);
+  if (LastLockUs)
+    SS << "LOCK TIME: " << (int)(*LastLockUs / 1000) << "ms "
+       << (int)LastLockFrames << " FRAMES\n";
+#ifdef TEMPORAL_FILTER
+  // There is no room for the filter's history in 640-pixel capture.
+  if (TimingsTTL.Mode != TTL::MDA)
+    SS << (HalfRate ? "TEMPORAL FILTER: ON\n"
+                    : "TEMPORAL FILTER: OFF (NEEDS 320 PIXELS)\n");
+#endif
+  // The page replaces any text that is still showing.
+  DisplayTxtEndTime = std::nullopt;
+  TTLInfoOnOverlay = Buff.displayPage(SS);
 }
 
 void TTLReader::showProfile() {
@@ -1247,6 +1877,11 @@ void TTLReader::changeProfile(bool Next) {
     else
       *ProfileBankOpt -= 1;
   }
+  selectProfile(*ProfileBankOpt);
+}
+
+void TTLReader::selectProfile(uint32_t Profile) {
+  ProfileBankOpt = Profile;
   showProfile();
   readConfigFromFlash();
 
@@ -1290,12 +1925,28 @@ void __not_in_flash_func(TTLReader::handleButtons)() {
     return;
   }
 
+  if (UsrAction == UserAction::TTLInfo &&
+      (BtnA == ButtonState::MedRelease || BtnB == ButtonState::MedRelease)) {
+    // Medium press in Info runs the logic analyzer, triggered by VSync with
+    // the AutoAdjust button or HSync with the PxClk button.
+    UsrAction = UserAction::None;
+    if (TTLInfoOnOverlay)
+      Buff.hideOverlay();
+    runLogicAnalyzer(BtnA == ButtonState::MedRelease
+                         ? LogicAnalyzer::Trigger::VSync
+                         : LogicAnalyzer::Trigger::HSync);
+    return;
+  }
+
   if (UsrAction == UserAction::TTLInfo &&
       (BtnA == ButtonState::Release || BtnA == ButtonState::LongPress ||
        BtnB == ButtonState::Release || BtnB == ButtonState::LongPress)) {
     // Quick exit from Info with a simple push.
     UsrAction = UserAction::None;
-    Buff.clear();
+    if (TTLInfoOnOverlay)
+      Buff.hideOverlay();
+    else
+      Buff.clear();
     return;
   }
 
@@ -1322,6 +1973,41 @@ void __not_in_flash_func(TTLReader::handleButtons)() {
   }
 
   if (UsrAction == UserAction::ChangeProfile) {
+    if (BtnA == ButtonState::MedRelease) {
+      // Medium press toggles the continuous auto-adjust for this profile.
+      bool Continuous = !AutoAdjust.getContinuous();
+      AutoAdjust.setContinuous(Continuous);
+      displayTxt(Continuous ? "AUTO ADJUST: CONTINUOUS ON"
+                            : "AUTO ADJUST: CONTINUOUS OFF",
+                 AUTO_ADJUST_ALWAYS_ON_DISPLAY_MS);
+      saveToFlash();
+      ChangeProfileEndTime = delayed_by_ms(FrameEnd, PROFILE_DISPLAY_MS);
+      return;
+    }
+    if (BtnB == ButtonState::MedRelease) {
+      if (NoSignal) {
+        displayTxt("NO TTL SIGNAL", NO_TTL_SIGNAL_MS);
+        return;
+      }
+      // Medium press toggles the 320-pixel capture for this profile.
+      Capture320 = !Capture320;
+#ifdef TEMPORAL_FILTER
+      // The temporal filter only runs in 320-pixel capture.
+      displayTxt(Capture320 ? "320 PIXEL CAPTURE: ON"
+                            : "320 PIXEL CAPTURE: OFF, NO FILTER",
+                 AUTO_ADJUST_ALWAYS_ON_DISPLAY_MS);
+#else
+      displayTxt(Capture320 ? "320 PIXEL CAPTURE: ON"
+                            : "320 PIXEL CAPTURE: OFF",
+                 AUTO_ADJUST_ALWAYS_ON_DISPLAY_MS);
+#endif
+      saveToFlash();
+      getDividerAutomatically();
+      switchPio();
+      checkAndUpdateMode();
+      ChangeProfileEndTime = delayed_by_ms(FrameEnd, PROFILE_DISPLAY_MS);
+      return;
+    }
     if (BtnA == ButtonState::Release) {
       if (NoSignal) {
         displayTxt("NO TTL SIGNAL", NO_TTL_SIGNAL_MS);
@@ -1418,21 +2104,175 @@ void __not_in_flash_func(TTLReader::handleButtons)() {
   }
 }
 
+void TTLReader::runLogicAnalyzer(LogicAnalyzer::Trigger Trig) {
+  displayTxt("LOGIC ANALYZER: CAPTURING");
+  PioLoader.unloadAllPio(TTLPio, {TTLSM, TTLBorderSM});
+  uint32_t Words;
+  uint32_t *RAM = Buff.borrowRAM(Words);
+  bool IsVSync = Trig == LogicAnalyzer::Trigger::VSync;
+  bool Triggered = LA.capture(
+      TTLPio, TTLSM, Trig,
+      IsVSync ? VSyncPolarity : HSyncPolarity,
+      IsVSync ? LOGIC_ANALYZER_VSYNC_LINES : LOGIC_ANALYZER_HSYNC_LINES, HHz,
+      RAM, Words, LOGIC_ANALYZER_TIMEOUT_MS);
+  displayTxt("LOGIC ANALYZER: SENDING");
+  LA.send();
+  Buff.clear();
+  switchPio();
+  displayTxt(Triggered ? "LOGIC ANALYZER: SENT" : "LOGIC ANALYZER: NO TRIGGER",
+             LOGIC_ANALYZER_DISPLAY_MS);
+}
+
+#ifdef USB_COMMANDS
+void TTLReader::serviceCommands() {
+  for (uint32_t Cnt = 0; Cnt != USB_COMMANDS_MAX_CHARS; ++Cnt) {
+    int C = getchar_timeout_us(0);
+    if (C == PICO_ERROR_TIMEOUT)
+      return;
+    switch (Cmd.feed((char)C)) {
+    case CmdLine::Status::Incomplete:
+      break;
+    case CmdLine::Status::Ready:
+      runCommand();
+      break;
+    case CmdLine::Status::Error:
+      printf("=ERR TOO_LONG\n");
+      break;
+    }
+  }
+}
+
+void TTLReader::runCommand() {
+  static constexpr const uint32_t ProtocolVersion = 1;
+  auto Reply = [](const char *Err) {
+    if (Err != nullptr)
+      printf("=ERR %s\n", Err);
+    else
+      printf("=OK\n");
+    fflush(stdout);
+  };
+  const TTL Mode = TimingsTTL.Mode;
+  if (Cmd.is(0, "PING") && Cmd.size() == 1)
+    return Reply(nullptr);
+
+  if (Cmd.is(0, "VERSION") && Cmd.size() == 1) {
+    printf("+PROTOCOL %lu\n", (unsigned long)ProtocolVersion);
+    printf("+FIRMWARE %s\n", PROJECT_NAME);
+    return Reply(nullptr);
+  }
+
+  if (Cmd.is(0, "STATS") && Cmd.size() == 1) {
+    const ClkDivider &ClkDiv = Mode == TTL::MDA   ? MDAClkDiv
+                               : isHighRes(TimingsTTL) ? EGAClkDiv
+                                                       : CGAClkDiv;
+    uint32_t IPP = Mode == TTL::MDA ? MDAIPP
+                   : isHighRes(TimingsTTL) ? EGAIPP
+                                           : CGAIPP;
+    printf("+NO_SIGNAL %d\n", (int)NoSignal);
+    printf("+VHZ %.2f\n", (double)VHz);
+    printf("+HHZ %.0f\n", (double)HHz);
+    printf("+VPOL %c\n", polarityToChar(VSyncPolarity));
+    printf("+HPOL %c\n", polarityToChar(HSyncPolarity));
+    printf("+LINES %lu\n", (unsigned long)LinesPerFrame);
+    printf("+MODE %s\n", modeToStr(Mode));
+    printf("+RES %lux%lu\n", (unsigned long)(TimingsTTL.H_Visible - XB),
+           (unsigned long)(TimingsTTL.V_Visible - YB));
+    printf("+PRESET %d\n", CapturePreset);
+    printf("+MANUAL_TTL %d\n", (int)ManualTTLEnabled);
+    printf("+PROFILE %lu\n", (unsigned long)*ProfileBankOpt);
+    printf("+PXCLK %lu\n", (unsigned long)getPxClkFor(TimingsTTL));
+    printf("+OFFSET %lu\n", (unsigned long)getSamplingOffsetFor(TimingsTTL));
+    printf("+IPP %lu\n", (unsigned long)IPP);
+    printf("+CLKDIV %.4f\n", ClkDiv.get());
+    printf("+HALF_RATE %d\n", (int)HalfRate);
+    printf("+XBORDER %lu\n", (unsigned long)XBorder);
+    printf("+YBORDER %lu\n", (unsigned long)YBorder);
+    printf("+PALETTE %s\n", paletteToStr(Pal));
+    printf("+FRAMES %lu\n", (unsigned long)FrameCnt);
+    printf("+ABORTED_FRAMES %lu\n", (unsigned long)AbortedFrames);
+    printf("+SIGNAL_LOSSES %lu\n", (unsigned long)SignalLosses);
+    printf("+MODE_CHANGES %lu\n", (unsigned long)ModeChanges);
+    return Reply(nullptr);
+  }
+
+  if (Cmd.is(0, "SET") && Cmd.size() == 3) {
+    uint32_t Val;
+    if (!Cmd.getUInt(2, Val))
+      return Reply("BAD_VALUE");
+    // Don't change the settings under the user's feet.
+    if (UsrAction != UserAction::None)
+      return Reply("BUSY");
+    if (Cmd.is(1, "PXCLK") || Cmd.is(1, "OFFSET")) {
+      if (Cmd.is(1, "PXCLK")) {
+        if (Val < USB_COMMANDS_PXCLK_MIN || Val > USB_COMMANDS_PXCLK_MAX)
+          return Reply("OUT_OF_RANGE");
+        getPxClkFor(TimingsTTL) = Val;
+      } else {
+        if (Val >= getSamplingOffsetMod(Mode))
+          return Reply("OUT_OF_RANGE");
+        getSamplingOffsetFor(TimingsTTL) = Val;
+      }
+      getDividerAutomatically();
+      switchPio();
+      checkAndUpdateMode();
+      return Reply(nullptr);
+    }
+    if (Cmd.is(1, "XBORDER") || Cmd.is(1, "YBORDER")) {
+      bool IsX = Cmd.is(1, "XBORDER");
+      if (ManualTTLEnabled && !(IsX ? XBorderAUTO : YBorderAUTO))
+        return Reply("MANUAL_TTL");
+      if (IsX ? Val % 4 != 0 || Val >= AutoAdjustBorder::HistogramBins *
+                                            AutoAdjustBorder::HistogramBinSz
+              : Val >= AutoAdjustBorder::MaxLines)
+        return Reply("OUT_OF_RANGE");
+      (IsX ? XBorder : YBorder) = Val;
+      // Keep them in the per-mode border, like the auto-adjust does.
+      BorderXY XY(XBorder, YBorder);
+      if (Mode == TTL::MDA)
+        MDABorderOpt = XY;
+      else if (isHighRes(TimingsTTL))
+        EGABorderOpt = XY;
+      else
+        CGABorderOpt = XY;
+      Buff.clear();
+      return Reply(nullptr);
+    }
+    if (Cmd.is(1, "PROFILE")) {
+      if (Val >= NumProfiles)
+        return Reply("OUT_OF_RANGE");
+      selectProfile(Val);
+      return Reply(nullptr);
+    }
+    return Reply("UNKNOWN_SETTING");
+  }
+
+  if (Cmd.is(0, "COMMIT") && Cmd.size() == 1) {
+    saveToFlash();
+    return Reply(nullptr);
+  }
+  if (Cmd.is(0, "TRACE") && Cmd.size() == 1) {
+    Trace::dump();
+    return Reply(nullptr);
+  }
+  Reply("UNKNOWN_COMMAND");
+}
+#endif // USB_COMMANDS
+
 void TTLReader::displayTxt(const char *Txt, int Time) {
   DBG_PRINT(std::cout << "TTLReader::" << __FUNCTION__ << " Txt=" << Txt
                       << " Time=" << Time << "\n";)
   Buff.displayTxt(Txt, 0, /*Center=*/true);
+  Buff.showOverlay(Buff.getTxtLineYTop(), /*Mask=*/0b1);
   DisplayTxtEndTime = delayed_by_ms(get_absolute_time(), Time);
 }
 
 void TTLReader::displayTxtTick() {
   if (DisplayTxtEndTime) {
-    if (to_ms_since_boot(get_absolute_time()) <
+    if (to_ms_since_boot(get_absolute_time()) >=
         to_ms_since_boot(*DisplayTxtEndTime)) {
-      Buff.copyTxtBufferToScreen();
-    } else {
       DBG_PRINT(std::cout << "DisplayTxtEnd\n";)
       DisplayTxtEndTime = std::nullopt;
+      Buff.hideOverlay();
       if (NoSignal)
         Buff.noSignal();
     }
@@ -1442,29 +2282,22 @@ void TTLReader::displayTxtTick() {
 /// \Returns true if \p Descr is high resolution. This is to tell apart EGA
 /// 640x350 from 640x200.
 bool TTLReader::isHighRes(const TTLDescr &Descr) {
-  // Ideally the limit should be 240, but:
-  // - Some non-standard inputs are 260 lines instead of 240
-  // - and we currently don't support 800x600 for CGA/EGA (not fast enough)
-  // so we go over the limit and still use 640x480 with line doubling for these
-  // modes in order to preserve the aspect ratio.
+  // Ideally the limit should be 240, but some non-standard inputs are 260
+  // lines instead of 240, so we go over the limit and still line-double these
+  // modes in order to preserve the aspect ratio. By default they use 640x480
+  // and the VGA front porch, or 800x600 with CGA_800x600.
   return Descr.V_Visible - YB > 260;
 }
 
-template <TTL M, bool DiscardLineData>
+template <TTL M, int Preset>
 bool __not_in_flash_func(TTLReader::readLinePerMode)(uint32_t Line) {
   bool InVSync = false;
   if constexpr (M == TTL::CGA) {
-    InVSync = readLineCGA<DiscardLineData>(Line);
-    AutoAdjust.collect(TTLBorderPio, TTLBorderSM, CGABorderCounter, Line,
-                       TimingsTTL.Mode);
+    InVSync = readLineCGA<Preset>(Line);
   } else if constexpr (M == TTL::EGA) {
-    InVSync = readLineCGA<DiscardLineData>(Line);
-    AutoAdjust.collect(TTLBorderPio, TTLBorderSM, EGABorderCounter, Line,
-                       TimingsTTL.Mode);
+    InVSync = readLineCGA<Preset>(Line);
   } else if constexpr (M == TTL::MDA) {
-    InVSync = readLineMDA<DiscardLineData>(Line);
-    AutoAdjust.collect(TTLBorderPio, TTLBorderSM, MDABorderCounter, Line,
-                       TimingsTTL.Mode);
+    InVSync = readLineMDA<Preset>(Line);
   }
   else {
     DBG_PRINT(std::cout << "Bad mode: " << modeToStr(TimingsTTL.Mode) << "\n";)
@@ -1473,15 +2306,86 @@ bool __not_in_flash_func(TTLReader::readLinePerMode)(uint32_t Line) {
   return InVSync;
 }
 
-void TTLReader::calculateVHSyncs(absolute_time_t LastFrameEnd,
-                                 uint32_t VisibleLines) {
-  uint32_t FrameUs = absolute_time_diff_us(LastFrameEnd, FrameEnd);
-  VHz = (float)1000000 / FrameUs;
+TTLFeatures TTLReader::getFeatures() const {
+  TTLFeatures Features;
+  Features.V_Hz = VHz;
+  Features.H_Hz = HHz;
+  Features.Lines = LinesPerFrame;
+  Features.V_SyncPolarity = VSyncPolarity;
+  Features.H_SyncPolarity = HSyncPolarity;
+  return Features;
+}
 
-  uint32_t VisibleUs = absolute_time_diff_us(FrameBegin, FrameEnd);
-  HHz = (float)1000000 * VisibleLines / VisibleUs;
+std::optional<TTLDescr> TTLReader::getAdaptiveMode(TTLFeatures &Features) {
+  if (LearnedOpt && LearnedOpt->matches(Features))
+    return LearnedOpt->getDescr(Features);
+  if (Features.V_Hz == 0 || Features.H_Hz == 0 || Features.Lines == 0)
+    return std::nullopt;
+  // Wait until the measurements are stable before learning a new mode.
+  bool Stable = std::abs((int)Features.Lines - (int)AdaptiveLines) <= 1;
+  AdaptiveLines = Features.Lines;
+  AdaptiveStableCnt = Stable ? AdaptiveStableCnt + 1 : 0;
+  if (AdaptiveStableCnt < ADAPTIVE_MODE_STABLE_CNT)
+    return std::nullopt;
+
+  // The pins tell apart MDA from RGB signals. Try again on the next call
+  // until they have been sampled.
+  if (!Features.PinActivity) {
+    Features.PinActivity = PinActivity.poll();
+    if (!Features.PinActivity)
+      return std::nullopt;
+  }
+  AdaptiveStableCnt = 0;
+  // Start with the visible lines of the family's preset, learnedFrameTick()
+  // then fits them to the content.
+  TTLDescr Descr = synthesizeMode(Features, /*FirstLine=*/1, /*LastLine=*/0);
+  Descr.V_Visible = std::clamp(Descr.V_Visible, MANUAL_TTL_VERT_MIN + YB,
+                               DisplayBuffer::BuffY);
+  LearnedOpt = LearnedTTL(Features, Descr);
+  LearnedUnsaved = true;
+  LearnedFeatures = Features;
+  LearnedFirstLine = std::numeric_limits<uint32_t>::max();
+  LearnedLastLine = 0;
+  LearnedSameFrames = 0;
+  DBG_PRINT(std::cout << "Learned mode: " << Descr << "\n";)
+
+  char Buff[48];
+  snprintf(Buff, 48, "LEARNED MODE: %s %dHz %d LINES", modeToStr(Descr.Mode),
+           (int)Features.V_Hz, (int)(Descr.V_Visible - YB));
+  displayTxt(Buff, ADAPTIVE_MODE_DISPLAY_MS);
+  return Descr;
+}
 
-  FrameBegin = FrameEnd;
+void TTLReader::learnedFrameTick() {
+  // Only refine with frames of the learned signal.
+  if (SyncLock != SyncLockState::Locked || !LearnedOpt->matches(getFeatures()))
+    return;
+  const auto &Stats = AutoAdjust.getFrameStats();
+  // Black frames tell us nothing about the size.
+  if (Stats.empty())
+    return;
+  // The extent only grows, as a mostly black frame doesn't reach the edges.
+  uint32_t FirstLine = std::min(LearnedFirstLine, Stats.FirstLine);
+  uint32_t LastLine = std::max(LearnedLastLine, Stats.LastLine);
+  if (FirstLine == LearnedFirstLine && LastLine == LearnedLastLine) {
+    // Don't write flash under the user's feet, the menus save when done.
+    if (++LearnedSameFrames < ADAPTIVE_MODE_SAVE_FRAMES ||
+        UsrAction != UserAction::None)
+      return;
+    DBG_PRINT(std::cout << "Saving learned mode\n";)
+    LearnedUnsaved = false;
+    saveToFlash();
+    return;
+  }
+  LearnedFirstLine = FirstLine;
+  LearnedLastLine = LastLine;
+  LearnedSameFrames = 0;
+  TTLDescr Descr = synthesizeMode(LearnedFeatures, FirstLine, LastLine);
+  Descr.V_Visible = std::clamp(Descr.V_Visible, MANUAL_TTL_VERT_MIN + YB,
+                               DisplayBuffer::BuffY);
+  LearnedOpt = LearnedTTL(LearnedFeatures, Descr);
+  DBG_PRINT(std::cout << "Learned mode refined: " << FirstLine << "-"
+                      << LastLine << "\n";)
 }
 
 void TTLReader::setBorders() {
@@ -1503,72 +2407,91 @@ void TTLReader::setBorders() {
   }
 }
 
-template <TTL M>
+template <TTL M, int Preset>
 void __not_in_flash_func(TTLReader::readFrame)(uint32_t &Line) {
-  if (DisplayTxtEndTime) {
-    // If we are displaying on-screen text use this code block.
-    bool InVSync = false;
-    do {
-      uint32_t VisibleLine = Line - YBorder;
-      bool DiscardLine = DisplayTxtEndTime &&
-                         VisibleLine >= Buff.getTxtLineYTop() &&
-                         VisibleLine <= Buff.getTxtLineYBot();
-      if (DiscardLine) {
-        InVSync = readLinePerMode<M, /*DiscardLine=*/true>(Line);
-      } else {
-        InVSync = readLinePerMode<M, /*DiscardLine=*/false>(Line);
-      }
-      ++Line;
-    } while (!InVSync);
-  } else {
-    // Not displaying any text, optimized block.
-    bool InVSync = false;
-    do {
-      InVSync = readLinePerMode<M, /*DiscardLine=*/false>(Line);
-      ++Line;
-    } while (!InVSync);
-    // Fill the bottom of the frame buffer with black pixels to remove
-    // out-of-border artifacts that may show up when closing programs.
-    Buff.fillBottomWithBlackAfter(Line);
-  }
+  // The on-screen text lives in the overlay, so we can always capture the
+  // whole frame.
+  bool InVSync = false;
+  do {
+    InVSync = readLinePerMode<M, Preset>(Line);
+    ++Line;
+  } while (!InVSync);
+  // Fill the bottom of the frame buffer with black pixels to remove
+  // out-of-border artifacts that may show up when closing programs.
+  Buff.fillBottomWithBlackAfter(Line);
 }
 
 void TTLReader::runForEver() {
   Pi.ledON();
   while (true) {
     ++FrameCnt;
-    bool InInfoPage = UsrAction == UserAction::TTLInfo;
+    bool InInfoPage = UsrAction == UserAction::TTLInfo && !TTLInfoOnOverlay;
     bool DisableInput = NoSignal || InInfoPage;
     // Wait here if we are in VSync retrace.
     bool RetraceVSync = TimingsTTL.V_SyncPolarity == Pos;
-    while (!DisableInput && gpio_get(TTL_VSYNC_GPIO) == RetraceVSync)
+    while (!DisableInput && gpio_get(TTL_VSYNC_GPIO) == RetraceVSync &&
+           !NoSignal)
       ;
     FrameBegin = get_absolute_time();
+    if (!DisableInput)
+      AutoAdjust.frameStart();
     // A fresh frame, start with Line 0
     uint32_t Line = 0;
     if (ManualTTLEnabled)
       TimingsTTL = ManualTTL;
 
     if (!DisableInput) {
-      switch (TimingsTTL.Mode) {
-      case TTL::EGA:
-        readFrame<TTL::EGA>(Line);
-        break;
-      case TTL::CGA:
-        readFrame<TTL::CGA>(Line);
+      switch (ManualTTLEnabled ? GenericPreset : CapturePreset) {
+        // clang-format off
+#define DEF_TTL(NAME, ...)                                                     \
+      case NAME:                                                               \
+        readFrame<PresetTimingsTTL[NAME].Mode, NAME>(Line);                    \
         break;
-      case TTL::MDA:
-        readFrame<TTL::MDA>(Line);
+#include "TimingsTTL.def"
+        // clang-format on
+      default:
+        switch (TimingsTTL.Mode) {
+        case TTL::EGA:
+          readFrame<TTL::EGA, GenericPreset>(Line);
+          break;
+        case TTL::CGA:
+          readFrame<TTL::CGA, GenericPreset>(Line);
+          break;
+        case TTL::MDA:
+          readFrame<TTL::MDA, GenericPreset>(Line);
+          break;
+        }
         break;
       }
     }
 
+    // We lost the signal in the middle of the frame, so don't use it.
+    bool Aborted = !DisableInput && NoSignal;
+    if (!DisableInput)
+      PinActivity.frameEnd(Aborted);
+    if (Aborted) {
+      DBG_PRINT(std::cout << "Capture aborted at line " << Line << "\n";)
+      AutoAdjust.dropFrame();
+      ++AbortedFrames;
+      Trace::event(TraceEvent::CaptureAborted, Line);
+    }
+
     if (DisableInput) {
       if (NoSignal != LastNoSignal)
         Buff.noSignal();
       // Simulate a frame delay, since we are not actually receiving TTL data.
-      // This helps with button timings.
-      Utils::sleep_ms(20);
+      // This helps with button timings. Stop early if the signal is back.
+      for (uint32_t Ms = 0; Ms != 20 && (InInfoPage || NoSignal); ++Ms)
+        Utils::sleep_ms(1);
+    }
+    if (LastNoSignal && !NoSignal) {
+      DBG_PRINT(std::cout << "TTLReader: Signal is back\n";)
+      Trace::event(TraceEvent::SignalBack);
+      restartCaptureSMs();
+    }
+    if (NoSignal && !LastNoSignal) {
+      ++SignalLosses;
+      Trace::event(TraceEvent::SignalLost);
     }
     LastNoSignal = NoSignal;
 
@@ -1576,20 +2499,40 @@ void TTLReader::runForEver() {
     if (BordersAdjusted) {
       DBG_PRINT(std::cout << "Borders adjusted!\n";)
       saveToFlash();
+      AutoAdjust.clearPendingSave();
     }
+    // Continuous auto-adjust: Rate-limit flash writes and don't write while
+    // the user is in a menu, the menu will save when done.
+    if (AutoAdjust.hasPendingSave() && UsrAction == UserAction::None &&
+        (!LastContinuousSaveTime ||
+         absolute_time_diff_us(*LastContinuousSaveTime, FrameBegin) >=
+             (int64_t)AUTO_ADJUST_CONT_SAVE_INTERVAL_MS * 1000)) {
+      DBG_PRINT(std::cout << "Continuous borders adjusted!\n";)
+      saveToFlash();
+      AutoAdjust.clearPendingSave();
+      LastContinuousSaveTime = FrameBegin;
+    }
+    // Manual TTL AUTO-SIZE measurement.
+    if (!DisableInput && !Aborted && AutoSizer.isActive() &&
+        AutoSizer.frameTick(TimingsTTL, HalfRate, AutoAdjust.getFrameStats()))
+      finishAutoSize();
+    if (!DisableInput && !Aborted && LearnedUnsaved)
+      learnedFrameTick();
 
-    auto LastFrameEnd = FrameEnd;
     FrameEnd = get_absolute_time();
 
     auto Mod = FrameCnt % TTL_MOD;
-    if (!DisableInput && Mod == 1)
-      calculateVHSyncs(LastFrameEnd, Line);
-
     if (!DisableInput) {
-      if (Mod == 2)
-        updateSyncPolarityVariables();
-      else if (Mod == 3)
-        checkAndUpdateMode();
+      syncLockTick(Mod);
+    } else if (SyncLock == SyncLockState::Locked || SyncChangeTime) {
+      // Start over when the input is back.
+      PinActivity.reset();
+      SyncLock = SyncLockState::Searching;
+      SyncLockStableCnt = 0;
+      SyncChangeTime = std::nullopt;
+      // Drop any timestamps from before the signal loss.
+      VSyncCounter.arm();
+      HSyncCounter.arm();
     }
     // Try set the border from flash values.
     if (!DisableInput && Mod == 0)
@@ -1598,5 +2541,13 @@ void TTLReader::runForEver() {
     handleButtons();
     if (Mod == 0)
       displayTxtTick();
+#ifdef USB_STREAM
+    Stream.frameTick(TimingsTTL, HalfRate, !DisableInput,
+                     make_timeout_time_us(USB_STREAM_MAX_TICK_US));
+#endif
+#ifdef USB_COMMANDS
+    serviceCommands();
+#endif
+    DBG_PRINT(DebugLog::drain(make_timeout_time_us(DEBUG_LOG_MAX_TICK_US));)
   }
 }
@@ -10,16 +10,22 @@
 #include "CGA640x200Border.pio.h"
 #include "CGAPio.h"
 #include "ClkDivider.h"
+#include "CmdLine.h"
 #include "Common.h"
 #include "EGA640x350Border.pio.h"
 #include "EGAPio.h"
 #include "Flash.h"
 #include "HorizMenu.h"
+#include "LogicAnalyzer.h"
 #include "MDA720x350Border.pio.h"
 #include "MDAPio.h"
+#include "Palette.h"
 #include "PioProgramLoader.h"
 #include "Timings.h"
+#include "UsbStream.h"
+#include "hardware/dma.h"
 #include "hardware/pio.h"
+#include <array>
 #include <limits>
 
 class DisplayBuffer;
@@ -63,6 +69,74 @@ class AutoAdjustBorder {
   uint32_t TmpXBorder = 0;
   uint32_t TmpYBorder = 0;
 
+public:
+  /// The most lines that the border SM pushes per frame, which are the
+  /// captured lines, so at least DisplayBuffer::BuffY. It is not the total
+  /// number of lines per frame, e.g. EGA 640x350 has 413.
+  static constexpr const uint32_t MaxLines = 400;
+  /// The width of each bin of the left-border histogram in pixels. This
+  /// matches the 4-pixel alignment of XBorder.
+  static constexpr const uint32_t HistogramBinSz = 4;
+  /// Enough bins for the largest border counter.
+  static constexpr const uint32_t HistogramBins = 1024 / HistogramBinSz;
+
+  /// The summary of the border PIO values of a single frame.
+  struct FrameStats {
+    /// The smallest and largest left border of the non-empty lines.
+    uint32_t MinX = 0;
+    uint32_t MaxX = 0;
+    /// The first and last non-empty line.
+    uint32_t FirstLine = 0;
+    uint32_t LastLine = 0;
+    uint32_t NonEmptyLines = 0;
+    /// Number of non-empty lines per left-border bin.
+    std::array<uint16_t, HistogramBins> XHistogram;
+    bool empty() const { return NonEmptyLines == 0; }
+  };
+
+private:
+  /// The border PIO pushes one value per line. These get streamed by DMA into
+  /// BorderLines[] while we are reading the frame and get processed once per
+  /// frame in frameTick(), so the capture loop doesn't touch the border SM.
+  /// NOTE: This and the histograms below are static because TTLReader lives in
+  /// core1's small stack.
+  static uint32_t BorderLines[MaxLines];
+  PIO BorderPio = nullptr;
+  uint BorderSM = 0;
+  int DMAChannel = -1;
+  bool DMAArmed = false;
+  /// The value the border PIO counts down from, which depends on the mode.
+  uint32_t BorderCounter = 0;
+  static FrameStats Stats;
+  /// Stops the DMA and fills in Stats. \Returns false if the DMA was not armed.
+  bool processFrame();
+
+  /// Continuous mode: Instead of a running minimum over a few frames, we
+  /// accumulate the per-frame stats of AUTO_ADJUST_CONT_WINDOW non-dark frames
+  /// and pick a percentile of the left border and the median of the top border.
+  /// The borders only change if the new values differ by more than the
+  /// hysteresis for AUTO_ADJUST_CONT_PERSIST_WINDOWS windows in a row.
+  bool Continuous = false;
+  /// Left border histogram of all lines of the window.
+  static std::array<uint32_t, HistogramBins> WindowXHistogram;
+  /// Histogram of the first non-empty line of each frame of the window.
+  static std::array<uint16_t, MaxLines> WindowYHistogram;
+  uint32_t WindowFrames = 0;
+  uint32_t WindowLines = 0;
+  /// The borders proposed by the last windows and for how many windows.
+  uint32_t ProposedXBorder = 0;
+  uint32_t ProposedYBorder = 0;
+  uint32_t ProposedCnt = 0;
+  /// Set when continuous mode has changed the borders but we have not saved
+  /// them to flash yet.
+  bool PendingSave = false;
+  /// Clears the window and the proposed borders.
+  void resetWindow();
+  /// Adds Stats to the window. \Returns true if the borders got updated.
+  bool continuousTick(const TTLDescr &TimingsTTL);
+  bool isXBorderAuto() const { return !ManualTTLEnabled || XBorderAUTO; }
+  bool isYBorderAuto() const { return !ManualTTLEnabled || YBorderAUTO; }
+
   enum class State {
     Off,
     SingleON,
@@ -95,14 +169,143 @@ public:
         TTLR(TTLR) {}
   void forceStart();
   void runAutoAdjust();
-  void collect(PIO Pio, uint32_t SM, uint32_t ModeBorderCounter, uint32_t Line,
-               TTL Mode);
-  /// Gets called on every frame. Returns if borders were applied.
+  /// Claims the DMA channel that collects the values of the border \p SM.
+  void init(PIO Pio, uint SM);
+  /// Releases the DMA channel, used before restarting the TTLReader.
+  void release();
+  /// Discards the values of the current frame, used when the capture of the
+  /// frame was aborted because we lost the signal.
+  void dropFrame();
+  /// Sets the value that the border PIO counts down from. This happens on a
+  /// mode switch so the continuous window is no longer valid.
+  void setBorderCounter(uint32_t Counter) {
+    BorderCounter = Counter;
+    resetWindow();
+  }
+  bool getContinuous() const { return Continuous; }
+  void setContinuous(bool Val) {
+    Continuous = Val;
+    resetWindow();
+  }
+  /// \Returns true once for each border update of the continuous mode, so that
+  /// the caller can save them to flash.
+  bool hasPendingSave() const { return PendingSave; }
+  void clearPendingSave() { PendingSave = false; }
+  /// Arms the DMA. Must be called right after VSync so that BorderLines[Line]
+  /// corresponds to the \p Line of the frame.
+  void frameStart();
+  const FrameStats &getFrameStats() const { return Stats; }
+  /// Gets called on every frame. Returns if borders were applied by the
+  /// single-shot auto-adjust. Updates by the continuous mode are reported by
+  /// hasPendingSave() instead, as these need to be rate-limited.
   bool frameTick(const TTLDescr &TimingsTTL);
   /// Used to set the borders when stored in flash.
   void setBorder(const BorderXY &XY);
 };
 
+/// Measures the active area of the TTL signal for ManualTTL's AUTO-SIZE.
+/// The border PIO only finds the first non-black pixel of each line, so the
+/// right edge is found by scanning a few rows of the frame buffer per frame
+/// from both ends, while the top and bottom lines come from the border stats.
+/// This expects the capture area to be widened to the maximum while measuring.
+class AutoSize {
+  DisplayBuffer &Buff;
+  bool Active = false;
+  uint32_t FrameCnt = 0;
+  uint32_t NextRow = 0;
+  /// Left-most and right-most non-black pixel in the frame buffer.
+  uint32_t MinX = 0;
+  uint32_t MaxX = 0;
+  uint32_t NonEmptyRows = 0;
+  /// First and last non-empty line as reported by the border PIO.
+  uint32_t MinFirstLine = 0;
+  uint32_t MaxLastLine = 0;
+  uint32_t NonEmptyFrames = 0;
+  /// Finds the first and last non-black pixel of frame buffer row \p Y.
+  /// \p HalfRate rows hold one byte per two pixels.
+  /// \Returns false if the row is black.
+  bool getRowExtent(uint32_t Y, bool IsMDA, bool HalfRate, uint32_t &Left,
+                    uint32_t &Right) const;
+
+public:
+  struct Result {
+    uint32_t H_Visible;
+    uint32_t V_Visible;
+  };
+  AutoSize(DisplayBuffer &Buff) : Buff(Buff) {}
+  void start();
+  bool isActive() const { return Active; }
+  /// Gets called once per frame after the border \p Stats have been collected.
+  /// \Returns true when the measurement is done.
+  bool frameTick(const TTLDescr &TimingsTTL, bool HalfRate,
+                 const AutoAdjustBorder::FrameStats &Stats);
+  /// \Returns the H/V visible values (including XB/YB) or std::nullopt if we
+  /// did not find any non-black pixels.
+  std::optional<Result> getResult() const;
+};
+
+/// Reads the edge timestamps of a SyncPeriod PIO state machine (see
+/// Pio/SyncPeriod.pio) and turns them into period/pulse measurements.
+class SyncPeriodCounter {
+  PIO Pio;
+  uint SM;
+  uint Offset;
+  /// The number of timestamps popped since arm(). Odd ones are falling edges.
+  uint32_t Pushes = 0;
+  uint32_t LastRise = 0;
+  uint32_t LastFall = 0;
+
+public:
+  struct Result {
+    /// System clock cycles between two rising edges.
+    uint32_t Period = 0;
+    /// System clock cycles of the sync pulse, i.e. the shorter phase.
+    uint32_t Pulse = 0;
+    Polarity Pol = Polarity::Pos;
+    /// \Returns true if \p Other has the same polarity and its period is
+    /// within SYNC_LOCK_PERMILLE.
+    bool matches(const Result &Other) const;
+  };
+  SyncPeriodCounter(PIO Pio, uint SM, uint Offset)
+      : Pio(Pio), SM(SM), Offset(Offset) {}
+  /// Restarts the measurement, dropping any timestamps in the FIFO.
+  void arm();
+  /// Non-blocking. \Returns the last full period found in the FIFO, if any.
+  /// This needs to be called at least once per period, otherwise the FIFO
+  /// fills up and we have to re-arm, which costs us an extra period.
+  std::optional<Result> poll();
+};
+
+/// Finds out which TTL pins are in use, which tells apart signals with the
+/// same timings. This uses the rising edge latches of the GPIO interrupt
+/// logic, which are set by the hardware even if the interrupts are disabled.
+/// So we clear them, let a few frames go by and check which pins went high,
+/// without spending any CPU time on the way.
+class PinActivitySampler {
+  enum class State {
+    Idle,
+    Sampling,
+    Done,
+  };
+  State St = State::Idle;
+  uint32_t Frames = 0;
+  /// The TTL pins that had a rising edge.
+  uint32_t Ones = 0;
+  void clearEdges();
+  uint32_t getEdges() const;
+
+public:
+  /// Non-blocking. Starts sampling if we are idle. \Returns the
+  /// TTLPinActivity bits once PIN_ACTIVITY_FRAMES frames have been captured.
+  std::optional<uint32_t> poll();
+  /// \Returns true if a result is being collected or has not been polled.
+  bool busy() const { return St != State::Idle; }
+  /// Drops the result, e.g., because the signal changed.
+  void reset() { St = State::Idle; }
+  /// Gets called after a frame was captured. \p Aborted frames don't count.
+  void frameEnd(bool Aborted);
+};
+
 class TTLReader {
   Pico &Pi;
   /// This unit reads the TTL video signal from the video card.
@@ -114,10 +317,6 @@ class TTLReader {
   PIO TTLBorderPio;
   uint TTLBorderSM;
   uint TTLBorderOffset;
-public:
-  static constexpr const uint32_t SyncPolarityCounterInit = 31;
-
-private:
   uint32_t FrameCnt = 0;
 
   TTLDescr TimingsTTL = PresetTimingsTTL[DisplayBufferDefaultTTL];
@@ -159,11 +358,24 @@ private:
     ManualTTL_V_BackPorchIdx,
     MaxFlashIdx,
   };
+  /// Per-profile entries added after the original layout. These are placed
+  /// after all the Profile entries so that we can still read the data written
+  /// by older firmware. Older firmware either wrote 0 or, for the entries past
+  /// the end of its data, nothing at all, which reads as 0xFFFFFFFF. So both
+  /// values must decode to the default.
+  enum class ProfileExt {
+    AutoAdjustContinuousIdx = 0,
+    LearnedSyncIdx,
+    LearnedSizeIdx,
+    Capture320Idx,
+    PaletteIdx,
+    MaxFlashIdx,
+  };
 
   // Check that the data fits in flash.
-  static_assert((NumProfiles * (int)Profile::MaxFlashIdx + 1) *
-                        sizeof(FlashStorage::DataTy::ValTy) <
-                    FlashStorage::DataTy::size_in_bytes(),
+  static_assert(1 + NumProfiles * (int)Profile::MaxFlashIdx +
+                        NumProfiles * (int)ProfileExt::MaxFlashIdx <=
+                    FlashStorage::DataTy::capacity(),
                 "Data won't fit in flash! Increase BytesToWrite!");
 
   uint32_t get(Profile Idx,
@@ -174,9 +386,22 @@ private:
                   Profile * (uint32_t)Profile::MaxFlashIdx;
     return RetIdx;
   }
+  uint32_t get(ProfileExt Idx,
+               std::optional<uint32_t> ForceProfile = std::nullopt) const {
+    assert(ProfileBankOpt && "Make sure we have read ProfileBank from flash!");
+    uint32_t Profile = ForceProfile ? *ForceProfile : *ProfileBankOpt;
+    // Unlike Profile, these are grouped by entry and not by profile, so that
+    // new entries don't move the existing ones.
+    auto RetIdx = /*ProfileIdx*/ 1 +
+                  NumProfiles * (uint32_t)Profile::MaxFlashIdx +
+                  (uint32_t)Idx * NumProfiles + Profile;
+    return RetIdx;
+  }
   uint32_t getNumFlashEntries() const {
     assert(ProfileBankOpt && "Make sure we have read ProfileBank from flash!");
-    return /*ProfileBankIdx*/ 1 + NumProfiles * (uint32_t)Profile::MaxFlashIdx;
+    return /*ProfileBankIdx*/ 1 +
+           NumProfiles * (uint32_t)Profile::MaxFlashIdx +
+           NumProfiles * (uint32_t)ProfileExt::MaxFlashIdx;
   }
   static constexpr const uint32_t InvalidBorder = 0xffffffff;
 
@@ -219,10 +444,14 @@ private:
   // auto-adjust, pxClock) to make sure we are not servicing more than one
   // action at once.
   UserAction UsrAction = UserAction::None;
+  /// The TTL info page fits in the overlay, so we keep capturing under it.
+  bool TTLInfoOnOverlay = false;
   bool AllowEnterMenu = false;
   std::optional<absolute_time_t> ManualTTLExitTime;
 
   AutoAdjustBorder AutoAdjust;
+  /// The last time we saved borders found by the continuous auto-adjust.
+  std::optional<absolute_time_t> LastContinuousSaveTime;
   std::optional<absolute_time_t> PxClkEndTime;
   bool ChangedPxClk = false;
 
@@ -232,13 +461,71 @@ private:
 
   std::optional<absolute_time_t> ChangeProfileEndTime;
 
+  AutoSize AutoSizer;
+#ifdef USB_STREAM
+  UsbStream Stream;
+#endif
+  LogicAnalyzer LA;
+#ifdef USB_COMMANDS
+  CmdLine Cmd;
+  /// Reads the requests that arrived over the USB serial without blocking,
+  /// and runs the complete ones.
+  void serviceCommands();
+  /// Runs the request in Cmd and prints the reply. The protocol is text based,
+  /// one request per line:
+  ///   PING
+  ///   VERSION
+  ///   STATS                Measurements, settings and counters
+  ///   SET PXCLK <Hz>       Pixel clock of the current mode
+  ///   SET OFFSET <N>       Sampling offset of the current mode
+  ///   SET XBORDER <N>      Borders of the current mode (XBORDER is a
+  ///   SET YBORDER <N>      multiple of 4)
+  ///   SET PROFILE <N>      Loads profile N from flash
+  ///   COMMIT               Saves the settings to flash
+  ///   TRACE                Prints the event trace, see Trace::dump()
+  /// and each reply is zero or more "+<KEY> <VALUE>" lines followed by "=OK"
+  /// or "=ERR <REASON>". Settings apply right away but are only saved by
+  /// COMMIT. Any other lines on the serial port, like debug messages, are not
+  /// part of the protocol. See firmware/tools/mcectl.py.
+  void runCommand();
+#endif
+  /// Counters reported by the STATS command.
+  uint32_t AbortedFrames = 0;
+  uint32_t SignalLosses = 0;
+  uint32_t ModeChanges = 0;
+  /// Stops the capture, runs the logic analyzer with \p Trig and sends the
+  /// samples over USB. The capture restarts when done.
+  void runLogicAnalyzer(LogicAnalyzer::Trigger Trig);
+  /// The ManualTTL size before AUTO-SIZE, restored if measuring fails.
+  TTLDescrReduced AutoSizeOrigTTL;
+  /// Widens ManualTTL to the maximum and starts measuring.
+  void startAutoSize();
+  /// Applies the measured size to ManualTTL.
+  void finishAutoSize();
+
   static constexpr const uint32_t TimingNOPsCGA = 7;
   static constexpr const uint32_t TimingNOPsMDA = 7;
 
   FlashStorage &Flash;
 
-  template <bool DiscardData> inline bool readLineCGA(uint32_t Line);
-  template <bool DiscardData> inline bool readLineMDA(uint32_t Line);
+  /// The capture loops are specialized for each preset in TimingsTTL.def so
+  /// that the visible width and the VSync polarity are compile-time constants.
+  /// GenericPreset uses the run-time values of TimingsTTL instead.
+  template <int Preset> inline bool readLineCGA(uint32_t Line);
+  template <int Preset> inline bool readLineMDA(uint32_t Line);
+  /// \Returns the timings the capture loop should use for \p Preset.
+  template <int Preset> inline const TTLDescr &getCaptureTimings() const {
+    if constexpr (Preset == GenericPreset)
+      return TimingsTTL;
+    else
+      return PresetTimingsTTL[Preset];
+  }
+  /// The preset that matches TimingsTTL, used for selecting the specialized
+  /// capture loop. This is GenericPreset for ManualTTL or non-preset timings.
+  int CapturePreset = GenericPreset;
+  /// Use the generic loop for the presets too, see setGenericCapture().
+  bool GenericCapture = false;
+  void updateCapturePreset();
   /// Updates the PIO's timing NOPs based on the current display mode.
   void setTimingNOPs() ;
 
@@ -247,16 +534,67 @@ private:
   bool haveBorderFromFlash() const;
 
   void switchPio();
+  /// Restarts the TTL and border SMs from the top of their already loaded
+  /// programs, dropping any stale data. Used when the signal comes back.
+  void restartCaptureSMs();
+  /// Like pio_sm_get_blocking() but gives up and \returns 0 if NoSignal.
+  inline uint32_t getTTLData() {
+    while (pio_sm_is_rx_fifo_empty(TTLPio, TTLSM))
+      if (NoSignal)
+        return 0;
+    return pio_sm_get(TTLPio, TTLSM);
+  }
 
   void getDividerAutomatically();
 
+  /// The user asked for 320-pixel capture in this profile.
+  bool Capture320 = false;
+  /// We are capturing 320 pixels per line at half the pixel clock. This is
+  /// set by switchPio() and read by core0 to pick the pixel-doubling PIO.
+  volatile bool HalfRate = false;
+  /// \Returns true if Capture320 applies to the current mode, which is only
+  /// the case for the low-res CGA capture.
+  bool isHalfRate() const {
+    return Capture320 && TimingsTTL.Mode != TTL::MDA && !isHighRes(TimingsTTL);
+  }
+
+  /// The palette of this profile.
+  Palette Pal = Palette::Standard;
+  /// The LUT of Pal, used by readLineCGA() for every captured pixel.
+  alignas(4) PaletteLUT PalLUT;
+  void setPalette(Palette NewPal) {
+    Pal = NewPal;
+    buildPaletteLUT(Pal, PalLUT);
+  }
+
   Polarity &VSyncPolarity = TimingsTTL.V_SyncPolarity;
   Polarity &HSyncPolarity = TimingsTTL.H_SyncPolarity;
 
-  PIO VSyncPolarityPio;
-  int VSyncPolaritySM;
-  PIO HSyncPolarityPio;
-  int HSyncPolaritySM;
+  SyncPeriodCounter VSyncCounter;
+  SyncPeriodCounter HSyncCounter;
+  std::optional<SyncPeriodCounter::Result> VSyncMeasOpt;
+  std::optional<SyncPeriodCounter::Result> HSyncMeasOpt;
+
+  enum class SyncLockState {
+    /// The sync timings changed (or we just started), wait until they are
+    /// stable for SYNC_LOCK_STABLE_CNT measurements.
+    Searching,
+    /// The mode has been selected for the sync timings in LockedV/LockedH.
+    Locked,
+  };
+  SyncLockState SyncLock = SyncLockState::Searching;
+  uint32_t SyncLockStableCnt = 0;
+  SyncPeriodCounter::Result LockedV;
+  SyncPeriodCounter::Result LockedH;
+  /// When we first saw the sync timings change, used for the lock time.
+  std::optional<absolute_time_t> SyncChangeTime;
+  uint32_t SyncChangeFrames = 0;
+  /// The time from a sync change until the new mode was in place.
+  std::optional<uint32_t> LastLockUs;
+  uint32_t LastLockFrames = 0;
+  /// Gets called once per frame. Locks to a new mode once the sync counters
+  /// are stable, or re-checks the mode every TTL_MOD frames while locked.
+  void syncLockTick(uint32_t Mod);
 
   /// Save settings to flash.
   void saveToFlash(bool OnlyProfileBank = false, bool AllProfiles = false);
@@ -270,7 +608,9 @@ private:
 
   /// This is used to avoid hanging while reading TTL when TTL is not connected.
   /// In this way we can still have functional menus while TTL is down.
-  bool NoSignal = true;
+  /// This is set by core0, so the capture loops also check it while waiting
+  /// for the signal and bail out of the frame if it gets set.
+  volatile bool NoSignal = true;
   bool LastNoSignal = false;
 
   Utils::FixedVector<std::pair<PIO, uint>, 8> UsedSMs;
@@ -282,6 +622,35 @@ private:
   float &VHz = TimingsTTL.V_Hz;
   /// The horizontal
   float &HHz = TimingsTTL.H_Hz;
+  /// The lines between two VSync pulses, from the sync counters.
+  uint32_t LinesPerFrame = 0;
+  /// Used when the timings alone are ambiguous.
+  PinActivitySampler PinActivity;
+  /// Cached result of PinActivity, valid for CachedPinActivityPreset.
+  uint32_t CachedPinActivity = 0;
+  int CachedPinActivityPreset = GenericPreset;
+  uint32_t PinActivityRetryCnt = 0;
+  /// The mode synthesized for an unknown signal, stored per profile.
+  std::optional<LearnedTTL> LearnedOpt;
+  uint32_t AdaptiveStableCnt = 0;
+  uint32_t AdaptiveLines = 0;
+  /// A newly learned mode is only kept in RAM at first. Its visible lines
+  /// grow to the extent of the content of the following frames, and it gets
+  /// saved once that has not changed for ADAPTIVE_MODE_SAVE_FRAMES frames.
+  bool LearnedUnsaved = false;
+  TTLFeatures LearnedFeatures;
+  uint32_t LearnedFirstLine = 0;
+  uint32_t LearnedLastLine = 0;
+  uint32_t LearnedSameFrames = 0;
+  /// \Returns the features of the signal from the last sync measurements.
+  TTLFeatures getFeatures() const;
+  /// Called when \p Features don't match any preset. \Returns the learned
+  /// mode if it matches, or synthesizes a new one once the measurements are
+  /// stable.
+  std::optional<TTLDescr> getAdaptiveMode(TTLFeatures &Features);
+  /// Refines the unsaved learned mode with the current frame and saves it
+  /// once it is stable. Called once per captured frame.
+  void learnedFrameTick();
   absolute_time_t FrameEnd;
   /// Limits the number of "UNKNOWN MODE" messages the user will see.
   int UnknownMsgMaxCnt = UNKNOWN_MODE_SHOW_MSG_MAX_COUNT;
@@ -292,18 +661,21 @@ private:
   void displayTTLInfo();
   void showProfile();
   void changeProfile(bool Next);
+  /// Switches to \p Profile, reading its settings from flash.
+  void selectProfile(uint32_t Profile);
   /// Take actions based on button state.
   void handleButtons();
-  /// Calculates the polarity for both V and H sync based on the PIO values and
-  /// updates VSyncPolarity and HSyncPolarity variables.
-  void updateSyncPolarityVariables();
+  /// Polls the V/H SyncPeriod PIOs and updates VHz, HHz, LinesPerFrame and
+  /// the VSyncPolarity and HSyncPolarity variables.
+  /// \Returns true if we got a new VSync measurement.
+  bool updateSyncVariables();
 
   bool ResetToDefaults;
 
   DisplayBuffer &Buff;
 
-  template <TTL M, bool DiscardLineData> bool readLinePerMode(uint32_t Line);
-  template <TTL M> void readFrame(uint32_t &Line);
+  template <TTL M, int Preset> bool readLinePerMode(uint32_t Line);
+  template <TTL M, int Preset> void readFrame(uint32_t &Line);
 
   void readConfigFromFlash();
 
@@ -316,13 +688,14 @@ public:
   static bool isHighRes(const TTLDescr &Descr);
 
   const TTLDescr &getMode() const { return TimingsTTL; }
+  /// \Returns true if the buffer lines hold 320 pixels that need doubling.
+  bool getHalfRate() const { return HalfRate; }
   void unclaimUsedSMs();
 
   std::optional<absolute_time_t> DisplayTxtEndTime;
-  /// NOTE: This won't write to the display directly. You need to call
-  /// displayTxtTick()!
+  /// Shows \p Txt in the overlay for \p Time ms.
   void displayTxt(const char *Txt, int Time = 0);
-  /// Copies the TxtBuffer to the visible Buffer.
+  /// Hides the text once its time is up.
   void displayTxtTick();
   int ManualTTLMenuIdx = 0;
   static constexpr const int ManualTTLMenu_Enabled_ItemIdx = 0;
@@ -333,21 +706,28 @@ public:
   static constexpr const int ManualTTLMenu_XBorder_ItemIdx = 5;
   static constexpr const int ManualTTLMenu_YBorderAUTO_ItemIdx = 6;
   static constexpr const int ManualTTLMenu_YBorder_ItemIdx = 7;
-  static constexpr const int ManualTTLMenu_NumMenuItems = 8;
+  static constexpr const int ManualTTLMenu_AutoSize_ItemIdx = 8;
+  static constexpr const int ManualTTLMenu_Palette_ItemIdx = 9;
+  static constexpr const int ManualTTLMenu_NumMenuItems = 10;
 
   HorizMenu<ManualTTLMenu_NumMenuItems> ManualTTLMenu;
 
   TTLReader(PioProgramLoader &PioLoader, Pico &Pi, FlashStorage &Flash,
-            DisplayBuffer &Buff, PIO VSyncPolarityPio, uint VSyncPolaritySM,
-            PIO HSyncPolarityPio, uint HSyncPolaritySM, bool ResetToDefaults);
+            DisplayBuffer &Buff, PIO SyncPeriodPio, uint VSyncPeriodSM,
+            uint HSyncPeriodSM, uint SyncPeriodOffset, bool ResetToDefaults);
   void setBorders();
   absolute_time_t FrameBegin;
-  void calculateVHSyncs(absolute_time_t LastFrameEnd, uint32_t VisibleLines);
   void runForEver();
   void setNoSignal(bool Val) {
     DBG_PRINT(std::cout << "TTLReader: setNoSignal=" << Val << "\n";)
     NoSignal = Val;
   }
+  /// Makes the capture use the generic loop for the presets too, so that the
+  /// host tests can compare the two, see tests/TTLReplay.cpp.
+  void setGenericCapture(bool Val) {
+    GenericCapture = Val;
+    updateCapturePreset();
+  }
 };
 
 #endif // __TTLREADER_H__
@@ -0,0 +1,81 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+
+#ifndef __TEMPORALFILTER_H__
+#define __TEMPORALFILTER_H__
+
+#include "Palette.h"
+#include <config.h>
+#include <cstdint>
+
+#if defined(TEMPORAL_DENOISE) && defined(TEMPORAL_DEFLICKER)
+#error "TEMPORAL_DENOISE and TEMPORAL_DEFLICKER can't be used together"
+#endif
+
+#if defined(TEMPORAL_DENOISE) || defined(TEMPORAL_DEFLICKER)
+#define TEMPORAL_FILTER
+#endif
+
+/// Per-pixel filters across frames, applied to a whole buffer word (4 CGA/EGA
+/// VHRRGGBB pixels) at a time, so there are no per-pixel branches. \p Raw is
+/// the FIFO word just captured and \p History is the word that the filter
+/// keeps for the same position across frames. They return the word to show.
+///
+/// The filters only run in 320-pixel capture, where the right half of each
+/// row is unused and holds one history word for each word shown. There is no
+/// RAM for a history at 640 pixels, as it would need a second frame buffer.
+namespace TemporalFilter {
+/// The RRGGBB bits of each pixel, the rest are the syncs.
+static constexpr const uint32_t RGBBits = 0x3f3f3f3f;
+/// Bit 6 of each byte of a denoise history word.
+static constexpr const uint32_t SameBits = 0x40404040;
+
+/// Majority of the current and the two previous raw frames per pixel, so a
+/// color that shows up for a single frame (like sparkles from a noisy TTL
+/// signal) never reaches the screen, at the cost of one frame of latency for
+/// real changes. If all three differ the current one wins. \p History holds
+/// the previous frame's RRGGBB bits and, in bit 6, whether it matched the
+/// frame before it, which is all the vote needs from the older frame.
+static inline uint32_t denoise(const uint8_t *LUT, uint32_t Raw,
+                               uint32_t &History) {
+  uint32_t Diff = (Raw ^ History) & RGBBits;
+  // Bit 6 is set for the pixels that differ from the previous frame. Each
+  // byte of Diff is at most 0x3f so there is no carry into the next byte.
+  uint32_t Changed = (Diff + RGBBits) & SameBits;
+  // Keep the previous pixel if it changed now but was the same in the two
+  // previous frames, i.e. expand bit 6 into 0x3f for these bytes.
+  uint32_t Keep = Changed & History;
+  uint32_t Vote = Raw ^ (Diff & (Keep - (Keep >> 6)));
+  History = (Raw & RGBBits) | (Changed ^ SameBits);
+  return applyPaletteLUT(LUT, Vote);
+}
+
+/// Per-channel average of the current and the previous frame, rounded down,
+/// which turns 2-frame flicker (like a sprite drawn every other frame) into a
+/// steady dimmer color. \p History holds the previous frame after the LUT.
+/// Each channel is 2 bits so the halves of the XOR are masked with the low
+/// bit of each channel: 0b00010101.
+static inline uint32_t deflicker(const uint8_t *LUT, uint32_t Raw,
+                                 uint32_t &History) {
+  uint32_t New = applyPaletteLUT(LUT, Raw);
+  uint32_t Prev = History;
+  History = New;
+  return (New & Prev) + (((New ^ Prev) >> 1) & 0x15151515);
+}
+
+#if defined(TEMPORAL_DENOISE)
+static inline uint32_t apply(const uint8_t *LUT, uint32_t Raw,
+                             uint32_t &History) {
+  return denoise(LUT, Raw, History);
+}
+#elif defined(TEMPORAL_DEFLICKER)
+static inline uint32_t apply(const uint8_t *LUT, uint32_t Raw,
+                             uint32_t &History) {
+  return deflicker(LUT, Raw, History);
+}
+#endif
+} // namespace TemporalFilter
+
+#endif // __TEMPORALFILTER_H__
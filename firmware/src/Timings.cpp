@@ -6,7 +6,7 @@
 #include "Timings.h"
 #include "Common.h"
 #include "Debug.h"
-#include <iostream>
+#include <limits>
 
 const char *modeToStr(VGAResolution R) {
   switch (R) {
@@ -65,18 +65,216 @@ const char polarityToChar(Polarity P) {
   return 'E';
 }
 
-/// The allowed error for matching the measured Hz compared to the presets.
+/// The features of each preset that we can measure, used by classifyMode().
+struct PresetFeatures {
+  float V_Hz;
+  float H_Hz;
+  /// Lines between two VSync pulses.
+  uint32_t Lines;
+  Polarity V_SyncPolarity;
+  Polarity H_SyncPolarity;
+  TTL Mode;
+};
 
-std::optional<TTLDescr> getModeForVPolarityAndHz(Polarity VSyncPolarity,
-                                                 uint32_t ReqHz) {
+static constexpr const PresetFeatures PresetFeaturesTTL[] = {
+// clang-format off
+#define DEF_TTL(NAME, H_FP, H_VIS, H_BP, H_RET, V_FP, V_VIS, V_BP, V_RET,      \
+                H_POL, V_POL, H_HZ, V_HZ, PX_CLK, MODE)                         \
+  {V_HZ, H_HZ, H_HZ / V_HZ - V_RET, V_POL, H_POL, MODE},
+#include "TimingsTTL.def"
+    // clang-format on
+};
+
+/// \Returns the penalty for \p Mode given the pins that toggled.
+static float getPinsPenalty(TTL Mode, uint32_t Activity) {
+  switch (Mode) {
+  case TTL::MDA:
+    return (Activity & PinActivityRGB) != 0 ? AUTO_DETECT_MODE_PINS_PENALTY
+                                            : 0.0f;
+  case TTL::CGA:
+    // CGA can't show the secondary red, and MDA is not RGB.
+    return (Activity & (PinActivitySecondaryRed | PinActivityMono)) != 0
+               ? AUTO_DETECT_MODE_PINS_PENALTY
+               : 0.0f;
+  case TTL::EGA:
+    // Prefer CGA for 16-color signals with the same timings.
+    if ((Activity & PinActivityMono) != 0)
+      return AUTO_DETECT_MODE_PINS_PENALTY;
+    return (Activity & PinActivityRGB) != 0 &&
+                   (Activity & PinActivitySecondaryRed) == 0
+               ? AUTO_DETECT_MODE_PINS_PENALTY / 2
+               : 0.0f;
+  }
+  return 0.0f;
+}
+
+std::optional<TTLMatch> classifyMode(const TTLFeatures &F) {
+  int BestIdx = GenericPreset;
+  float BestScore = std::numeric_limits<float>::max();
+  float SecondScore = std::numeric_limits<float>::max();
   for (int Idx = 0; Idx != PresetTimingsMAX; ++Idx) {
-    const auto &Mode = PresetTimingsTTL[Idx];
-    if (std::abs(Mode.V_Hz - ReqHz) <= AUTO_DETECT_MODE_V_HZ_ERROR) {
-      if (Mode.V_SyncPolarity == VSyncPolarity)
-        return Mode;
+    const auto &P = PresetFeaturesTTL[Idx];
+    // Each feature adds its error relative to its limit.
+    float VErr = std::abs(P.V_Hz - F.V_Hz) / AUTO_DETECT_MODE_V_HZ_ERROR;
+    if (VErr > 1.0f)
+      continue;
+    float Score = VErr;
+    if (F.H_Hz != 0) {
+      float HErr = std::abs(P.H_Hz - F.H_Hz) / AUTO_DETECT_MODE_H_HZ_ERROR;
+      if (HErr > 1.0f)
+        continue;
+      Score += HErr;
+    }
+    if (F.Lines != 0) {
+      float LinesErr = std::abs((float)P.Lines - (float)F.Lines) /
+                       AUTO_DETECT_MODE_LINES_ERROR;
+      if (LinesErr > 1.0f)
+        continue;
+      Score += LinesErr;
     }
+    if (P.V_SyncPolarity != F.V_SyncPolarity)
+      Score += AUTO_DETECT_MODE_POLARITY_PENALTY;
+    if (P.H_SyncPolarity != F.H_SyncPolarity)
+      Score += AUTO_DETECT_MODE_POLARITY_PENALTY;
+    if (F.PinActivity)
+      Score += getPinsPenalty(P.Mode, *F.PinActivity);
+    // On a tie the first one in TimingsTTL.def wins.
+    if (Score < BestScore) {
+      SecondScore = BestScore;
+      BestScore = Score;
+      BestIdx = Idx;
+    } else if (Score < SecondScore) {
+      SecondScore = Score;
+    }
+  }
+  if (BestIdx == GenericPreset)
+    return std::nullopt;
+  TTLMatch Match;
+  Match.Descr = PresetTimingsTTL[BestIdx];
+  // The capture loop follows the measured polarities.
+  Match.Descr.V_SyncPolarity = F.V_SyncPolarity;
+  Match.Descr.H_SyncPolarity = F.H_SyncPolarity;
+  Match.PresetIdx = BestIdx;
+  Match.Ambiguous =
+      !F.PinActivity &&
+      SecondScore - BestScore < AUTO_DETECT_MODE_AMBIGUOUS_SCORE;
+  return Match;
+}
+
+int getPresetIdx(const TTLDescr &Descr) {
+  for (int Idx = 0; Idx != PresetTimingsMAX; ++Idx) {
+    const auto &Preset = PresetTimingsTTL[Idx];
+    if (Preset == Descr && Preset.V_SyncPolarity == Descr.V_SyncPolarity)
+      return Idx;
   }
-  return std::nullopt;
+  return GenericPreset;
+}
+
+/// Synthesizes a \p Mode TTLDescr, see synthesizeMode().
+static TTLDescr synthesizeModeFor(TTL Mode, const TTLFeatures &F,
+                                  uint32_t FirstLine, uint32_t LastLine) {
+  // Start from the preset of the family.
+  int FamilyIdx = CGA_640x200_60Hz;
+  switch (Mode) {
+  case TTL::MDA:
+    FamilyIdx = MDA_720x350_50Hz;
+    break;
+  case TTL::CGA:
+    FamilyIdx = CGA_640x200_60Hz;
+    break;
+  case TTL::EGA:
+    FamilyIdx = EGA_640x350_60Hz;
+    break;
+  }
+  TTLDescr Descr = PresetTimingsTTL[FamilyIdx];
+  Descr.V_Hz = F.V_Hz;
+  Descr.H_Hz = F.H_Hz;
+  Descr.V_SyncPolarity = F.V_SyncPolarity;
+  Descr.H_SyncPolarity = F.H_SyncPolarity;
+  // The lines we don't see between two VSync pulses are the retrace.
+  uint32_t TotalLines = (uint32_t)(F.H_Hz / F.V_Hz + 0.5f);
+  Descr.V_Retrace = TotalLines > F.Lines ? TotalLines - F.Lines : 0;
+  if (LastLine >= FirstLine && LastLine < F.Lines) {
+    Descr.V_FrontPorch = FirstLine;
+    Descr.V_Visible = LastLine - FirstLine + 1 + YB;
+    Descr.V_BackPorch = F.Lines - LastLine - 1;
+  } else {
+    // Keep the preset's visible lines, but make sure they fit. Like in the
+    // presets, V_Visible includes the YB lines of the bottom border.
+    uint32_t Active = std::min(Descr.V_Visible - YB, F.Lines);
+    Descr.V_Visible = Active + YB;
+    Descr.V_FrontPorch = (F.Lines - Active) / 2;
+    Descr.V_BackPorch = F.Lines - Active - Descr.V_FrontPorch;
+  }
+  return Descr;
+}
+
+TTLDescr synthesizeMode(const TTLFeatures &F, uint32_t FirstLine,
+                        uint32_t LastLine) {
+  TTL Mode = TTL::CGA;
+  if (F.PinActivity && (*F.PinActivity & PinActivityMono) != 0)
+    Mode = TTL::MDA;
+  else if (F.H_Hz >= SYNTH_MODE_EGA_MIN_H_HZ)
+    Mode = TTL::EGA;
+  return synthesizeModeFor(Mode, F, FirstLine, LastLine);
+}
+
+LearnedTTL::LearnedTTL(const TTLFeatures &F, const TTLDescr &Descr)
+    : V_Hz(F.V_Hz), Lines(F.Lines), V_SyncPolarity(F.V_SyncPolarity),
+      H_SyncPolarity(F.H_SyncPolarity), Mode(Descr.Mode),
+      H_Visible(Descr.H_Visible), V_Visible(Descr.V_Visible),
+      V_FrontPorch(Descr.V_FrontPorch) {}
+
+bool LearnedTTL::matches(const TTLFeatures &F) const {
+  return std::abs(V_Hz - F.V_Hz) <= AUTO_DETECT_MODE_V_HZ_ERROR &&
+         std::abs((int)Lines - (int)F.Lines) <= AUTO_DETECT_MODE_LINES_ERROR &&
+         V_SyncPolarity == F.V_SyncPolarity &&
+         H_SyncPolarity == F.H_SyncPolarity;
+}
+
+TTLDescr LearnedTTL::getDescr(const TTLFeatures &F) const {
+  TTLDescr Descr =
+      synthesizeModeFor(Mode, F, /*FirstLine=*/1, /*LastLine=*/0);
+  Descr.H_Visible = H_Visible;
+  Descr.V_Visible = V_Visible;
+  Descr.V_FrontPorch = V_FrontPorch;
+  uint32_t Used = V_FrontPorch + V_Visible - YB;
+  Descr.V_BackPorch = F.Lines > Used ? F.Lines - Used : 0;
+  return Descr;
+}
+
+// Flash layout:
+// Sync: [31:29] 0, [28] valid, [27] HPolarity, [26] VPolarity, [25:24] Mode,
+//       [23:14] Lines, [13:0] V_Hz * 100
+// Size: [31:30] 0, [29:21] V_FrontPorch, [20:11] V_Visible, [10:0] H_Visible
+static constexpr const uint32_t LearnedValidBit = 1u << 28;
+
+std::pair<uint32_t, uint32_t> LearnedTTL::pack() const {
+  uint32_t Sync = ((uint32_t)(V_Hz * 100) & 0x3fff) | (Lines & 0x3ff) << 14 |
+                  (uint32_t)getTTLIdx(Mode) << 24 |
+                  (uint32_t)(V_SyncPolarity == Neg) << 26 |
+                  (uint32_t)(H_SyncPolarity == Neg) << 27 | LearnedValidBit;
+  uint32_t Size = (H_Visible & 0x7ff) | (V_Visible & 0x3ff) << 11 |
+                  (V_FrontPorch & 0x1ff) << 21;
+  return {Sync, Size};
+}
+
+std::optional<LearnedTTL> LearnedTTL::unpack(uint32_t Sync, uint32_t Size) {
+  if ((Sync & 0xf0000000) != LearnedValidBit || (Size & 0xc0000000) != 0)
+    return std::nullopt;
+  int ModeIdx = (Sync >> 24) & 0x3;
+  if (ModeIdx > MaxTTLIdx)
+    return std::nullopt;
+  LearnedTTL L;
+  L.V_Hz = (float)(Sync & 0x3fff) / 100;
+  L.Lines = (Sync >> 14) & 0x3ff;
+  L.Mode = getTTLAtIdx(ModeIdx);
+  L.V_SyncPolarity = ((Sync >> 26) & 0x1) ? Neg : Pos;
+  L.H_SyncPolarity = ((Sync >> 27) & 0x1) ? Neg : Pos;
+  L.H_Visible = Size & 0x7ff;
+  L.V_Visible = (Size >> 11) & 0x3ff;
+  L.V_FrontPorch = (Size >> 21) & 0x1ff;
+  return L;
 }
 
 TTLDescr &TTLDescr::operator=(const TTLDescrReduced &Other) {
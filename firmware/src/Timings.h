@@ -178,9 +178,85 @@ static constexpr const unsigned PresetTimingsMAX = 0
 #include "TimingsTTL.def"
     ;
 
-std::optional<TTLDescr> getModeForVPolarityAndHz(Polarity VSyncPolarity,
-                                                 uint32_t ReqHz);
+/// Bits of TTLFeatures::PinActivity.
+enum TTLPinActivity : uint32_t {
+  /// The primary R/G/B pins toggled.
+  PinActivityRGB = 1u << 0,
+  /// The secondary red pin toggled, which is only used by 64-color EGA.
+  PinActivitySecondaryRed = 1u << 1,
+  /// Only the MDA video/intensity pins toggled.
+  PinActivityMono = 1u << 2,
+};
+
+/// The measured features of the TTL signal used for detecting the mode.
+/// Zero values are treated as unknown.
+struct TTLFeatures {
+  float V_Hz = 0;
+  float H_Hz = 0;
+  /// Lines between two VSync pulses.
+  uint32_t Lines = 0;
+  Polarity V_SyncPolarity = Polarity::Pos;
+  Polarity H_SyncPolarity = Polarity::Pos;
+  /// The TTLPinActivity bits, if we have sampled the pins.
+  std::optional<uint32_t> PinActivity;
+};
+
+struct TTLMatch {
+  /// The best match with the sync polarities of the signal.
+  TTLDescr Descr;
+  /// The index of the preset in PresetTimingsTTL.
+  int PresetIdx;
+  /// True if the second best is too close, so we need the pin activity.
+  bool Ambiguous;
+};
+
+/// Scores all presets against \p Features and \returns the best match, or
+/// std::nullopt if none is within the AUTO_DETECT_MODE_*_ERROR limits.
+std::optional<TTLMatch> classifyMode(const TTLFeatures &Features);
+
+/// Builds a TTLDescr for a signal that does not match any preset. The mode
+/// family comes from the pin activity and the HSync frequency, the horizontal
+/// timings and pixel clock from the family's preset, and the vertical timings
+/// from the measured lines and the first/last non-empty lines.
+/// \p LastLine < \p FirstLine means we don't know the active area.
+TTLDescr synthesizeMode(const TTLFeatures &Features, uint32_t FirstLine,
+                        uint32_t LastLine);
+
+/// A synthesized mode along with the features it was synthesized from, so
+/// that we can find it again without measuring. This fits in two flash values.
+struct LearnedTTL {
+  float V_Hz = 0;
+  uint32_t Lines = 0;
+  Polarity V_SyncPolarity = Polarity::Pos;
+  Polarity H_SyncPolarity = Polarity::Pos;
+  TTL Mode = TTL::CGA;
+  uint32_t H_Visible = 0;
+  uint32_t V_Visible = 0;
+  uint32_t V_FrontPorch = 0;
+
+  LearnedTTL() = default;
+  LearnedTTL(const TTLFeatures &Features, const TTLDescr &Descr);
+  /// \Returns true if \p Features are close enough to the learned ones.
+  bool matches(const TTLFeatures &Features) const;
+  /// \Returns the descriptor using the live measurements of \p Features.
+  TTLDescr getDescr(const TTLFeatures &Features) const;
+  /// Packing for flash. Both erased (0xFFFFFFFF) and zeroed flash unpack to
+  /// std::nullopt.
+  std::pair<uint32_t, uint32_t> pack() const;
+  static std::optional<LearnedTTL> unpack(uint32_t Sync, uint32_t Size);
+};
+
+/// Used instead of a preset index when the timings don't match any preset,
+/// like for example with ManualTTL.
+static constexpr const int GenericPreset = -1;
+/// \Returns the index of the preset in PresetTimingsTTL that matches \p Descr
+/// (mode, visible area and VSync polarity), or GenericPreset.
+int getPresetIdx(const TTLDescr &Descr);
 
 static constexpr const int DisplayBufferDefaultTTL = 2; // EGA 640x200
 
+/// Synthesized modes with a higher HSync frequency are EGA, see
+/// synthesizeMode(). This is between the CGA and EGA 350-line frequencies.
+static constexpr const float SYNTH_MODE_EGA_MIN_H_HZ = 19000;
+
 #endif // __TIMINGS_H__
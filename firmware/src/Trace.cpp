@@ -0,0 +1,50 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+
+#include "Trace.h"
+#include "hardware/watchdog.h"
+#include <cstdio>
+#include <cstring>
+
+static TraceRing __uninitialized_ram(TraceRings)[Trace::NumRings];
+TraceRing *const Trace::Rings = TraceRings;
+
+void Trace::init() {
+  for (uint32_t Idx = 0; Idx != NumRings; ++Idx) {
+    TraceRing &Ring = Rings[Idx];
+    // After a power-on the RAM holds garbage.
+    if (Ring.Magic != Magic) {
+      memset(&Ring, 0, sizeof(Ring));
+      Ring.Magic = Magic;
+    }
+    ++Ring.Boots;
+  }
+  event(TraceEvent::Boot, Rings[0].Boots, watchdog_caused_reboot());
+}
+
+void Trace::dump() {
+  static TraceEntry Copy[TRACE_ENTRIES];
+  for (uint32_t Idx = 0; Idx != NumRings; ++Idx) {
+    const TraceRing &Ring = Rings[Idx];
+    uint32_t Head = Ring.Head;
+    __dmb();
+    memcpy(Copy, (const void *)Ring.Entries, sizeof(Copy));
+    printf("TRACE-BEGIN %lu %lu %lu %lu\n", (unsigned long)FormatVersion,
+           (unsigned long)Idx, (unsigned long)Ring.Boots, (unsigned long)Head);
+    uint32_t Num = Head < TRACE_ENTRIES ? Head : TRACE_ENTRIES;
+    for (uint32_t Cnt = Head - Num; Cnt != Head; ++Cnt) {
+      const TraceEntry &Entry = Copy[Cnt % TRACE_ENTRIES];
+      // The other core may have overwritten it since we read Head.
+      if (Entry.Seq != (uint16_t)Cnt)
+        continue;
+      printf("TR %lx %x %x %lx %lx %lx\n", (unsigned long)Entry.Time,
+             (unsigned)Entry.Event, (unsigned)Entry.Seq,
+             (unsigned long)Entry.Args[0], (unsigned long)Entry.Args[1],
+             (unsigned long)Entry.Args[2]);
+    }
+    printf("TRACE-END\n");
+  }
+  fflush(stdout);
+}
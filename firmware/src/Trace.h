@@ -0,0 +1,86 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include "Common.h"
+#include "hardware/sync.h"
+#include "pico/platform.h"
+#include "pico/time.h"
+#include <cstdint>
+
+enum class TraceEvent : uint16_t {
+// clang-format off
+#define DEF_TRACE(NAME, ...) \
+  NAME,
+#include "TraceEvents.def"
+  // clang-format on
+};
+
+struct TraceEntry {
+  /// time_us_32() of the event.
+  uint32_t Time;
+  TraceEvent Event;
+  /// The low bits of the ring's Head when written, which tell apart the new
+  /// entries from the old ones when dumping while the ring is being written.
+  uint16_t Seq;
+  uint32_t Args[3];
+};
+
+/// One ring per core, so that each one has a single writer and needs no lock.
+struct TraceRing {
+  uint32_t Magic;
+  /// The number of events ever written, the next one goes to Head % Entries.
+  volatile uint32_t Head;
+  /// The number of boots since the ring was last cleared.
+  uint32_t Boots;
+  TraceEntry Entries[TRACE_ENTRIES];
+};
+
+/// An always-on trace of the rare events that help with field debugging (mode
+/// switches, PIO reloads, flash writes, signal loss etc.), which unlike
+/// DBGPRINT doesn't change the timing. The rings are in uninitialized RAM so
+/// that they survive a watchdog or a soft reset, and after such a reboot the
+/// new events get added after the ones that led to it. They are printed by
+/// dump() and decoded by firmware/tools/tracedump.py.
+class Trace {
+public:
+  static constexpr const uint32_t Magic = 0x54524345; // "TRCE"
+  static constexpr const uint32_t NumRings = 2;
+  static constexpr const uint32_t FormatVersion = 1;
+  /// The rings, defined in Trace.cpp.
+  static TraceRing *const Rings;
+
+  /// Clears the rings unless they hold a trace from before the reboot, and
+  /// records the Boot event. Must be called once before starting core1.
+  static void init();
+  /// Records \p Event in the ring of the calling core. This is a few stores,
+  /// so it can be called from either core, and it gets inlined into the
+  /// functions that run from RAM.
+  static inline void event(TraceEvent Event, uint32_t Arg0 = 0,
+                           uint32_t Arg1 = 0, uint32_t Arg2 = 0) {
+    TraceRing &Ring = Rings[get_core_num()];
+    uint32_t Head = Ring.Head;
+    TraceEntry &Entry = Ring.Entries[Head % TRACE_ENTRIES];
+    Entry.Time = time_us_32();
+    Entry.Event = Event;
+    Entry.Seq = (uint16_t)Head;
+    Entry.Args[0] = Arg0;
+    Entry.Args[1] = Arg1;
+    Entry.Args[2] = Arg2;
+    // The entry must be complete before it shows up in dump().
+    __dmb();
+    Ring.Head = Head + 1;
+  }
+  /// Prints the rings to the USB serial port, oldest events first:
+  ///   TRACE-BEGIN <Version> <Ring> <Boots> <Head>
+  ///   TR <Time> <Event> <Seq> <Arg0> <Arg1> <Arg2>
+  ///   TRACE-END
+  /// with the TR values in hex.
+  static void dump();
+};
+
+#endif // __TRACE_H__
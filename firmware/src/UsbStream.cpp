@@ -0,0 +1,157 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+
+#include "UsbStream.h"
+
+#ifdef USB_STREAM
+
+#include "Common.h"
+#include "pico/stdio_usb.h"
+#include "tusb.h"
+#include <algorithm>
+#include <cstring>
+
+uint32_t __not_in_flash_func(UsbStream::hashLine)(const uint8_t *Row,
+                                                  uint32_t Bytes) {
+  // FNV-1a over words. The lines are word aligned and a whole number of words.
+  const auto *Words = (const uint32_t *)Row;
+  uint32_t Hash = 2166136261u;
+  for (uint32_t Idx = 0, E = Bytes / 4; Idx != E; ++Idx)
+    Hash = (Hash ^ Words[Idx]) * 16777619u;
+  return Hash;
+}
+
+uint32_t __not_in_flash_func(UsbStream::encodeLine)(const uint8_t *Src,
+                                                    uint32_t Sz, uint8_t *Dst) {
+  uint32_t Out = 0;
+  uint32_t Idx = 0;
+  while (Idx != Sz) {
+    uint8_t Val = Src[Idx];
+    uint32_t Run = 1;
+    while (Idx + Run != Sz && Run != MaxRun && Src[Idx + Run] == Val)
+      ++Run;
+    if (Run >= 2) {
+      Dst[Out++] = 0x80 | (Run - 2);
+      Dst[Out++] = Val;
+      Idx += Run;
+      continue;
+    }
+    // Literals until the next run of 3, since a run of 2 saves nothing.
+    uint32_t Start = Idx++;
+    while (Idx != Sz && Idx - Start != MaxLiteral &&
+           !(Idx + 2 < Sz && Src[Idx] == Src[Idx + 1] &&
+             Src[Idx] == Src[Idx + 2]))
+      ++Idx;
+    Dst[Out++] = Idx - Start - 1;
+    memcpy(&Dst[Out], &Src[Start], Idx - Start);
+    Out += Idx - Start;
+  }
+  return Out;
+}
+
+uint32_t UsbStream::writeAvailable() { return tud_cdc_write_available(); }
+
+void UsbStream::write(const uint8_t *Data, uint32_t Sz) {
+  stdio_usb.out_chars((const char *)Data, Sz);
+}
+
+static uint8_t *put16(uint8_t *Dst, uint32_t Val) {
+  Dst[0] = Val;
+  Dst[1] = Val >> 8;
+  return Dst + 2;
+}
+
+static uint8_t *put32(uint8_t *Dst, uint32_t Val) {
+  return put16(put16(Dst, Val), Val >> 16);
+}
+
+bool UsbStream::flushRecord() {
+  while (RecordOff != RecordSz) {
+    uint32_t Sz = std::min(RecordSz - RecordOff, writeAvailable());
+    if (Sz == 0)
+      return false;
+    write(&Record[RecordOff], Sz);
+    RecordOff += Sz;
+  }
+  return true;
+}
+
+bool UsbStream::startFrame(const TTLDescr &TimingsTTL, bool HalfRate) {
+  if (writeAvailable() < HeaderSz)
+    return false;
+  bool IsMDA = TimingsTTL.Mode == TTL::MDA;
+  bool TwoPixelsPerByte = IsMDA || HalfRate;
+  if (TimingsTTL != LastMode || HalfRate != LastHalfRate ||
+      StreamFrameCnt % KeyFrameInterval == 0)
+    KeyFrame = true;
+  LastMode = TimingsTTL;
+  LastHalfRate = HalfRate;
+  Lines = std::min(TimingsTTL.V_Visible, DisplayBuffer::BuffY);
+  BytesPerLine = std::min(TwoPixelsPerByte ? TimingsTTL.H_Visible / 2
+                                           : TimingsTTL.H_Visible,
+                          DisplayBuffer::BuffX) &
+                 ~3u;
+
+  uint8_t Header[HeaderSz];
+  memcpy(Header, "MCEF", 4);
+  Header[4] = FormatVersion;
+  Header[5] = (uint8_t)TimingsTTL.Mode;
+  Header[6] = (KeyFrame ? FlagKeyFrame : 0) |
+              (TwoPixelsPerByte ? FlagTwoPixelsPerByte : 0);
+  Header[7] = 0;
+  uint8_t *Ptr = put16(&Header[8], TimingsTTL.H_Visible);
+  Ptr = put16(Ptr, Lines);
+  Ptr = put16(Ptr, BytesPerLine);
+  Ptr = put16(Ptr, TimingsTTL.V_Hz * 100);
+  Ptr = put32(Ptr, TimingsTTL.H_Hz);
+  put32(Ptr, StreamFrameCnt);
+  write(Header, HeaderSz);
+  InFrame = true;
+  NextLine = 0;
+  return true;
+}
+
+void UsbStream::frameTick(const TTLDescr &TimingsTTL, bool HalfRate,
+                          bool InputActive, absolute_time_t Deadline) {
+  if (!stdio_usb_connected()) {
+    // Start with a key frame when the host connects.
+    InFrame = false;
+    KeyFrame = true;
+    RecordSz = RecordOff = 0;
+    return;
+  }
+  if (!flushRecord())
+    return;
+  if (!InFrame && !startFrame(TimingsTTL, HalfRate))
+    return;
+  bool RetraceVSync = TimingsTTL.V_SyncPolarity == Pos;
+  while (NextLine != Lines) {
+    if (time_reached(Deadline) ||
+        (InputActive && gpio_get(TTL_VSYNC_GPIO) != RetraceVSync))
+      return;
+    const uint8_t *Row = Buff.getScanoutRow(NextLine);
+    uint32_t Hash = hashLine(Row, BytesPerLine);
+    if (KeyFrame || Hash != LineHash[NextLine]) {
+      uint32_t Sz = encodeLine(Row, BytesPerLine, &Record[4]);
+      put16(put16(Record, NextLine), Sz);
+      RecordSz = 4 + Sz;
+      RecordOff = 0;
+      LineHash[NextLine] = Hash;
+    }
+    ++NextLine;
+    if (!flushRecord())
+      return;
+  }
+  if (writeAvailable() < 2)
+    return;
+  uint8_t End[2];
+  put16(End, EndOfFrame);
+  write(End, sizeof(End));
+  InFrame = false;
+  KeyFrame = false;
+  ++StreamFrameCnt;
+}
+
+#endif // USB_STREAM
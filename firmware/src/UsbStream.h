@@ -0,0 +1,132 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+
+#ifndef __USBSTREAM_H__
+#define __USBSTREAM_H__
+
+#include <config.h>
+
+#ifdef USB_STREAM
+
+// Both use the USB serial port.
+#if defined(DBGPRINT)
+#error "USB_STREAM and DBGPRINT can't be used together"
+#endif
+#if defined(USB_COMMANDS)
+#error "USB_STREAM and USB_COMMANDS can't be used together"
+#endif
+
+#include "DisplayBuffer.h"
+#include "Timings.h"
+#include <array>
+#include <cstdint>
+
+/// Sends what the scanout shows over the USB serial, so the screen can be
+/// recorded or monitored from a PC. The format is decoded by
+/// firmware/tools/usbstream.py. All values are little-endian.
+///
+/// Each frame starts with a header:
+///   "MCEF"           Magic
+///   u8  Version      FormatVersion
+///   u8  Mode         TTL: 0 MDA, 1 CGA, 2 EGA
+///   u8  Flags        FlagKeyFrame, FlagTwoPixelsPerByte
+///   u8  Reserved
+///   u16 Width        Pixels per line
+///   u16 Height       Lines per frame
+///   u16 BytesPerLine
+///   u16 VHz          Vertical frequency in 1/100 Hz
+///   u32 HHz          Horizontal frequency in Hz
+///   u32 FrameCnt
+/// followed by the lines that changed since they were last sent:
+///   u16 Line
+///   u16 Sz           Size of the compressed line
+///   u8  Data[Sz]     See encodeLine()
+/// and it ends with a u16 EndOfFrame.
+///
+/// Bytes are in the frame buffer format: VHRRGGBB for CGA/EGA with HV being
+/// 0, or two 00VI pixels for MDA (the first one in the low nibble). With
+/// FlagTwoPixelsPerByte set for CGA/EGA each byte is two identical pixels.
+///
+/// A line only gets sent when its hash changes, so a static screen costs
+/// little more than the headers. A key frame with all the lines is sent
+/// every KeyFrameInterval frames and after a mode change, so that a host that
+/// connects mid-stream gets a full picture. Frame buffer lines are read while
+/// the capture keeps writing them, so a frame that takes longer than one TTL
+/// frame to send may mix lines from consecutive frames.
+///
+/// With an input signal the lines are only sent during the VSync retrace, and
+/// only as much as fits in the TinyUSB buffer, since a write to a full buffer
+/// would block the capture. So the stream gets the buffer plus what USB sends
+/// during the retrace, a few hundred bytes per TTL frame, see
+/// tests/UsbStreamTest.cpp.
+class UsbStream {
+public:
+  static constexpr const uint8_t FormatVersion = 1;
+  static constexpr const uint8_t FlagKeyFrame = 0b01;
+  static constexpr const uint8_t FlagTwoPixelsPerByte = 0b10;
+  static constexpr const uint16_t EndOfFrame = 0xffff;
+  /// With an input signal a key frame of a text screen takes a few seconds, so
+  /// they are rare. The host connecting already gets one.
+  static constexpr const uint32_t KeyFrameInterval = 3600;
+  static constexpr const uint32_t HeaderSz = 24;
+  /// The longest run and the longest literal of encodeLine().
+  static constexpr const uint32_t MaxRun = 129;
+  static constexpr const uint32_t MaxLiteral = 128;
+  /// The worst case of a compressed line, when it has no runs at all.
+  static constexpr const uint32_t MaxLineSz =
+      DisplayBuffer::BuffX +
+      (DisplayBuffer::BuffX + MaxLiteral - 1) / MaxLiteral;
+
+private:
+  DisplayBuffer &Buff;
+  /// The hash of each line when it was last sent.
+  std::array<uint32_t, DisplayBuffer::BuffY> LineHash;
+  /// The frame currently being sent.
+  bool InFrame = false;
+  bool KeyFrame = true;
+  uint32_t NextLine = 0;
+  uint32_t Lines = 0;
+  uint32_t BytesPerLine = 0;
+  uint32_t StreamFrameCnt = 0;
+  /// The mode of the last frame, a change forces a key frame.
+  TTLDescr LastMode;
+  bool LastHalfRate = false;
+  /// A line record: Line, Sz and the compressed data.
+  uint8_t Record[4 + MaxLineSz];
+  /// The size of the record and how much of it was written.
+  uint32_t RecordSz = 0;
+  uint32_t RecordOff = 0;
+
+  static uint32_t hashLine(const uint8_t *Row, uint32_t Bytes);
+  /// \Returns the free space in the USB buffer. Writes block until the host
+  /// reads them, so we never write more than this, to keep a slow host from
+  /// stalling the capture.
+  static uint32_t writeAvailable();
+  static void write(const uint8_t *Data, uint32_t Sz);
+  /// Writes what fits of the rest of Record. \Returns true once all of it is
+  /// written.
+  bool flushRecord();
+  /// Writes the frame header. \Returns false if there is no room for it.
+  bool startFrame(const TTLDescr &TimingsTTL, bool HalfRate);
+
+public:
+  UsbStream(DisplayBuffer &Buff) : Buff(Buff) {}
+  /// Compresses \p Sz bytes from \p Src into \p Dst, which must have room for
+  /// MaxLineSz bytes. A control byte C < 128 is followed by C + 1 literal
+  /// bytes, while C >= 128 is followed by one byte repeated C - 126 times.
+  /// \Returns the compressed size.
+  static uint32_t encodeLine(const uint8_t *Src, uint32_t Sz, uint8_t *Dst);
+  /// Called by TTLReader on core1 once per frame, after the capture. Sends
+  /// lines until the USB buffer is full or \p Deadline is reached, and if
+  /// \p InputActive until the TTL VSync retrace ends, because the capture of
+  /// the next frame starts right after it. The next call continues from where
+  /// this one stopped.
+  void frameTick(const TTLDescr &TimingsTTL, bool HalfRate, bool InputActive,
+                 absolute_time_t Deadline);
+};
+
+#endif // USB_STREAM
+
+#endif // __USBSTREAM_H__
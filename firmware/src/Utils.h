@@ -11,18 +11,21 @@
 #include <cassert>
 #include <cstdint>
 #include <cstring>
-#include <iostream>
 #include <iterator>
+#include <type_traits>
+#include <utility>
 
 #define DUMP_METHOD __attribute__((noinline)) __attribute__((__used__))
 
 struct Utils {
+#ifdef DBGPRINT
   static void printBin(uint32_t Num, uint32_t Bits) {
     for (int Idx = Bits - 1; Idx >= 0; --Idx) {
       bool Bit = Num & (1u << Idx);
       std::cout << (int)Bit;
     }
   }
+#endif
 
   static void sleep_ns(uint32_t ns) {
     for (int i = 0, e = ns / 8; i != e; ++i)
@@ -159,6 +162,27 @@ struct Utils {
     iterator end() { return iterator(DataSz, *this); }
   };
 
+  template <typename Fn> class FunctionRef;
+  /// A non-owning reference to a callable, like llvm::function_ref. Unlike
+  /// std::function it never allocates, so the callable must outlive it, which
+  /// is the case when it is a function argument.
+  template <typename Ret, typename... Args> class FunctionRef<Ret(Args...)> {
+    void *Callable;
+    Ret (*Callback)(void *Callable, Args... As);
+
+  public:
+    template <typename Fn, typename = std::enable_if_t<!std::is_same_v<
+                               std::decay_t<Fn>, FunctionRef>>>
+    FunctionRef(Fn &&F)
+        : Callable((void *)&F), Callback([](void *Callable, Args... As) -> Ret {
+            return (*(std::remove_reference_t<Fn> *)Callable)(
+                std::forward<Args>(As)...);
+          }) {}
+    Ret operator()(Args... As) const {
+      return Callback(Callable, std::forward<Args>(As)...);
+    }
+  };
+
   template <int StaticSz> class StaticString {
     int Sz = 0;
     char Buff[StaticSz];
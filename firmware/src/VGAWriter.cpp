@@ -4,15 +4,19 @@
 //
 
 #include "VGAWriter.h"
-#include "HSyncPolarity.pio.h"
+#include "DebugLog.h"
+#include "LineMap.h"
 #include "NoInputSignal.pio.h"
+#include "SyncPeriod.pio.h"
 #include "TTLReader.h"
+#include "Trace.h"
 #include "VGAOut4x1Pixels.pio.h"
+#include "VGAOut4x1Pixels800.pio.h"
+#include "VGAOut4x2Pixels.pio.h"
 #include "VGAOut8x1MDA.pio.h"
-#include "VSyncPolarity.pio.h"
+#include <array>
 #include <config.h>
 #include <pico/multicore.h>
-#include <unordered_map>
 
 static bool ResetToDefaults = false;
 DisplayBuffer Buff;
@@ -21,13 +25,22 @@ extern PioProgramLoader *PPL;
 extern Pico *Pi;
 extern FlashStorage *Flash;
 
-static PIO VSyncPolarityPio_ = 0;
-static int VSyncPolaritySM_ = 0;
-static PIO HSyncPolarityPio_ = 0;
-static int HSyncPolaritySM_ = 0;
+/// Maps the visible VGA lines to buffer lines. This is not a member of
+/// VGAWriter because VGAWriter lives on core0's small stack.
+static LineMap VGALineMap;
+#ifdef VGA_VERTICAL_FILL
+static constexpr const LineMap::Scaling VGAScaling = LineMap::Scaling::Fill;
+#else
+static constexpr const LineMap::Scaling VGAScaling = LineMap::Scaling::Integer;
+#endif
+
+static PIO SyncPeriodPio_ = 0;
+static uint VSyncPeriodSM_ = 0;
+static uint HSyncPeriodSM_ = 0;
+static uint SyncPeriodOffset_ = 0;
 
+template <VGAResolution M>
 void __not_in_flash_func(VGAWriter::DrawBlackLineWithMask4x1)(bool InVertSync) {
-  static constexpr auto M = VGA_640x400_70Hz;
 
   static constexpr Polarity HPolarity = TimingsVGA[M].H_SyncPolarity;
   static constexpr Polarity VPolarity = TimingsVGA[M].V_SyncPolarity;
@@ -52,8 +65,8 @@ void __not_in_flash_func(VGAWriter::DrawBlackLineWithMask4x1)(bool InVertSync) {
     pio_sm_put_blocking(VGAPio, VGASM, Black4_InHSync);
 }
 
+template <VGAResolution M, bool PixelDoubling>
 void __not_in_flash_func(VGAWriter::DrawLineVSyncHigh4x1)(unsigned Line) {
-  static constexpr auto M = VGA_640x400_70Hz;
   // VSync is High throughout.
   // HSync is High for the boarders + visible parts.
 
@@ -70,13 +83,27 @@ void __not_in_flash_func(VGAWriter::DrawLineVSyncHigh4x1)(unsigned Line) {
     pio_sm_put_blocking(VGAPio, VGASM, Black4_Porch);
 
   // The visible part of the line.
-  for (unsigned i = 0; i < TimingsVGA[M].H_Visible; i += 4) {
-    uint32_t Pix4 = Buff.get32(Line, i);
-    if constexpr (HPolarity == Neg)
-      Pix4 |= HMask_4;
-    if constexpr (VPolarity == Neg)
-      Pix4 |= VMask_4;
-    pio_sm_put_blocking(VGAPio, VGASM, Pix4);
+  Buff.interpStartScanoutRow(Line);
+  uint32_t Mask4 = 0;
+  if constexpr (HPolarity == Neg)
+    Mask4 |= HMask_4;
+  if constexpr (VPolarity == Neg)
+    Mask4 |= VMask_4;
+  if constexpr (PixelDoubling) {
+    // Each buffer word is 4 pixels of the 320-pixel capture, which we show as
+    // 8 pixels. This is for FIXED_VGA_OUTPUT, otherwise we use the 4x2 PIO.
+    for (unsigned i = 0; i < TimingsVGA[M].H_Visible; i += 8) {
+      uint32_t Pix4 = *DisplayBuffer::interpNextWord32();
+      uint32_t Lo = (Pix4 & 0xff) * 0x0101 | ((Pix4 >> 8) & 0xff) * 0x01010000;
+      uint32_t Hi = ((Pix4 >> 16) & 0xff) * 0x0101 | (Pix4 >> 24) * 0x01010000;
+      pio_sm_put_blocking(VGAPio, VGASM, Lo | Mask4);
+      pio_sm_put_blocking(VGAPio, VGASM, Hi | Mask4);
+    }
+  } else {
+    for (unsigned i = 0; i < TimingsVGA[M].H_Visible; i += 4) {
+      uint32_t Pix4 = *DisplayBuffer::interpNextWord32();
+      pio_sm_put_blocking(VGAPio, VGASM, Pix4 | Mask4);
+    }
   }
 
   // Front Porch is black
@@ -94,6 +121,271 @@ void __not_in_flash_func(VGAWriter::DrawLineVSyncHigh4x1)(unsigned Line) {
     pio_sm_put_blocking(VGAPio, VGASM, Black4_Sync);
 }
 
+// The 4x2 PIO shows each pixel twice, so each FIFO entry is 8 VGA pixels.
+static constexpr const uint32_t Pixels4x2 = 8;
+
+template <VGAResolution M>
+void __not_in_flash_func(VGAWriter::DrawBlackLineWithMask4x2)(bool InVertSync) {
+  static constexpr const uint32_t MainWords =
+      (TimingsVGA[M].H_BackPorch + TimingsVGA[M].H_Visible +
+       TimingsVGA[M].H_FrontPorch) /
+      Pixels4x2;
+  static_assert(MainWords * Pixels4x2 ==
+                    TimingsVGA[M].H_BackPorch + TimingsVGA[M].H_Visible +
+                        TimingsVGA[M].H_FrontPorch &&
+                TimingsVGA[M].H_Retrace % Pixels4x2 == 0);
+
+  static constexpr Polarity HPolarity = TimingsVGA[M].H_SyncPolarity;
+  static constexpr Polarity VPolarity = TimingsVGA[M].V_SyncPolarity;
+  auto Black4_Main = Black_4;
+  if constexpr (HPolarity == Neg)
+    Black4_Main |= HMask_4;
+  if ((VPolarity == Neg && !InVertSync) || (VPolarity == Pos && InVertSync))
+    Black4_Main |= VMask_4;
+  for (unsigned i = 0; i != MainWords; ++i)
+    pio_sm_put_blocking(VGAPio, VGASM, Black4_Main);
+
+  auto Black4_InHSync = Black_4;
+  if constexpr (HPolarity == Pos)
+    Black4_InHSync |= HMask_4;
+  if ((VPolarity == Neg && !InVertSync) || (VPolarity == Pos && InVertSync))
+    Black4_InHSync |= VMask_4;
+  for (unsigned i = 0; i < TimingsVGA[M].H_Retrace; i += Pixels4x2)
+    pio_sm_put_blocking(VGAPio, VGASM, Black4_InHSync);
+}
+
+template <VGAResolution M>
+void __not_in_flash_func(VGAWriter::DrawLineVSyncHigh4x2)(unsigned Line) {
+  // Same as DrawLineVSyncHigh4x1() but in units of 8 VGA pixels. The back porch
+  // gets rounded down and the front porch makes up for it, which just moves
+  // the image by a few pixels.
+  static constexpr const uint32_t BackPorchWords =
+      TimingsVGA[M].H_BackPorch / Pixels4x2;
+  static constexpr const uint32_t VisibleWords =
+      TimingsVGA[M].H_Visible / Pixels4x2;
+  static constexpr const uint32_t FrontPorchWords =
+      (TimingsVGA[M].H_BackPorch + TimingsVGA[M].H_Visible +
+       TimingsVGA[M].H_FrontPorch) /
+          Pixels4x2 -
+      BackPorchWords - VisibleWords;
+
+  static constexpr Polarity HPolarity = TimingsVGA[M].H_SyncPolarity;
+  static constexpr Polarity VPolarity = TimingsVGA[M].V_SyncPolarity;
+  auto Black4_Porch = Black_4;
+  if constexpr (HPolarity == Polarity::Neg)
+    Black4_Porch |= HMask_4;
+  if constexpr (VPolarity == Polarity::Neg)
+    Black4_Porch |= VMask_4;
+  uint32_t Mask4 = 0;
+  if constexpr (HPolarity == Neg)
+    Mask4 |= HMask_4;
+  if constexpr (VPolarity == Neg)
+    Mask4 |= VMask_4;
+
+  // Back Porch is black.
+  for (unsigned i = 0; i != BackPorchWords; ++i)
+    pio_sm_put_blocking(VGAPio, VGASM, Black4_Porch);
+
+  // The visible part of the line, half the buffer words of 4x1.
+  Buff.interpStartScanoutRow(Line);
+  for (unsigned i = 0; i != VisibleWords; ++i) {
+    uint32_t Pix4 = *DisplayBuffer::interpNextWord32();
+    pio_sm_put_blocking(VGAPio, VGASM, Pix4 | Mask4);
+  }
+
+  // Front Porch is black
+  for (unsigned i = 0; i != FrontPorchWords; ++i)
+    pio_sm_put_blocking(VGAPio, VGASM, Black4_Porch);
+
+  // Sync.
+  auto Black4_Sync = Black_4;
+  if constexpr (HPolarity == Pos)
+    Black4_Sync |= HMask_4;
+  if constexpr (VPolarity == Neg)
+    Black4_Sync |= VMask_4;
+  for (unsigned i = 0; i < TimingsVGA[M].H_Retrace; i += Pixels4x2)
+    pio_sm_put_blocking(VGAPio, VGASM, Black4_Sync);
+}
+
+template <VGAResolution R>
+void __not_in_flash_func(VGAWriter::drawFrame4x2)() {
+  // Same as drawFrame4x1() with line-doubling.
+  for (uint32_t Line = 0; Line != TimingsVGA[R].V_BackPorch; ++Line)
+    DrawBlackLineWithMask4x2<R>(/*InVSync=*/false);
+
+  VGALineMap.update(R, std::min(TimingsTTL.V_Visible, DisplayBuffer::BuffY),
+                    /*Repeat=*/2, TimingsVGA[R].V_FrontPorch, VGAScaling);
+  static constexpr const uint32_t LineVGAE =
+      TimingsVGA[R].V_Visible + TimingsVGA[R].V_FrontPorch;
+  for (uint32_t Line = 0; Line != LineVGAE; ++Line) {
+    uint32_t BuffLine = VGALineMap[Line];
+    if (BuffLine == LineMap::Black)
+      DrawBlackLineWithMask4x2<R>(/*InVSync=*/false);
+    else
+      DrawLineVSyncHigh4x2<R>(BuffLine);
+  }
+
+  for (uint32_t Line = 0; Line != TimingsVGA[R].V_Retrace; ++Line)
+    DrawBlackLineWithMask4x2<R>(/*InVSync=*/true);
+}
+
+#if defined(CGA_800x600) && !defined(FIXED_VGA_OUTPUT)
+void __not_in_flash_func(VGAWriter::DrawLineVSyncHigh4x1DMA)(unsigned Line) {
+  static constexpr auto M = VGA_800x600_56Hz;
+  // With positive polarities the syncs are low in the visible part, which is
+  // what the frame buffer holds, so the DMA can copy it as is.
+  static_assert(TimingsVGA[M].H_SyncPolarity == Pos &&
+                TimingsVGA[M].V_SyncPolarity == Pos);
+  static constexpr const uint32_t Black4_Porch = Black_4;
+  static constexpr const uint32_t Black4_Sync = Black_4 | HMask_4;
+
+  // Center the buffer line in the 800 pixels.
+  const uint32_t BuffWords =
+      std::min(TimingsTTL.H_Visible, DisplayBuffer::BuffX) / 4;
+  const uint32_t PadLeftWords = (TimingsVGA[M].H_Visible / 4 - BuffWords) / 2;
+  const uint32_t PadRightWords =
+      TimingsVGA[M].H_Visible / 4 - BuffWords - PadLeftWords;
+
+  // Back Porch and left padding are black.
+  for (unsigned i = 0; i < TimingsVGA[M].H_BackPorch / 4 + PadLeftWords; ++i)
+    pio_sm_put_blocking(VGAPio, VGASM, Black4_Porch);
+
+  // The visible part of the line, paced by the PIO's TX DREQ.
+  dma_channel_set_read_addr(VGADMAChannel, Buff.getScanoutRow(Line), false);
+  dma_channel_set_trans_count(VGADMAChannel, BuffWords, true);
+  dma_channel_wait_for_finish_blocking(VGADMAChannel);
+
+  // Right padding and Front Porch are black.
+  for (unsigned i = 0; i < PadRightWords + TimingsVGA[M].H_FrontPorch / 4; ++i)
+    pio_sm_put_blocking(VGAPio, VGASM, Black4_Porch);
+
+  // Sync.
+  for (unsigned i = 0; i < TimingsVGA[M].H_Retrace; i += 4)
+    pio_sm_put_blocking(VGAPio, VGASM, Black4_Sync);
+}
+
+bool VGAWriter::use800x600(const TTLDescr &Descr) {
+  // Too tall for 640x480 with line-doubling, but not tall enough for
+  // isHighRes().
+  return Descr.Mode != TTL::MDA && !TTLReader::isHighRes(Descr) &&
+         Descr.V_Visible - YB > 240;
+}
+
+template <VGAResolution R, bool LineDoubling>
+void __not_in_flash_func(VGAWriter::drawFrame4x1DMA)() {
+  // 0. Non-visible Back porch
+  for (uint32_t Line = 0; Line != TimingsVGA[R].V_BackPorch; ++Line)
+    DrawBlackLineWithMask4x1<R>(/*InVSync=*/false);
+
+  // 1. Visible. 800x600 fits 300 line-doubled lines without the front porch.
+  VGALineMap.update(R, std::min(TimingsTTL.V_Visible, DisplayBuffer::BuffY),
+                    LineDoubling ? 2 : 1, /*ExtraLines=*/0, VGAScaling);
+  for (uint32_t Line = 0; Line != TimingsVGA[R].V_Visible; ++Line) {
+    uint32_t BuffLine = VGALineMap[Line];
+    if (BuffLine == LineMap::Black)
+      DrawBlackLineWithMask4x1<R>(/*InVSync=*/false);
+    else
+      DrawLineVSyncHigh4x1DMA(BuffLine);
+  }
+
+  // 2. Non-visible front porch
+  for (uint32_t Line = 0; Line != TimingsVGA[R].V_FrontPorch; ++Line)
+    DrawBlackLineWithMask4x1<R>(/*InVSync=*/false);
+  // 3. Retrace
+  for (uint32_t Line = 0; Line != TimingsVGA[R].V_Retrace; ++Line)
+    DrawBlackLineWithMask4x1<R>(/*InVSync=*/true);
+}
+#endif // CGA_800x600 && !FIXED_VGA_OUTPUT
+
+/// Converts one byte of the MDA buffer (2 pixels, 00VI each) to two VHRRGGBB
+/// pixels for the 4x1 PIO, by copying the VI bits to RR, GG and BB.
+static constexpr const auto MDATo4x1 = [] {
+  std::array<uint16_t, 256> Table{};
+  for (uint32_t Byte = 0; Byte != 256; ++Byte) {
+    auto Gray = [](uint32_t VI) { return VI | VI << 2 | VI << 4; };
+    Table[Byte] = Gray(Byte & 0b11) | Gray((Byte >> 4) & 0b11) << 8;
+  }
+  return Table;
+}();
+
+template <VGAResolution M, bool Resample>
+void __not_in_flash_func(VGAWriter::DrawLineVSyncHighMDA4x1)(
+    unsigned Line, unsigned SrcX, unsigned PadLeft) {
+  // Same as DrawLineVSyncHigh4x1() but the pixels come from the MDA buffer.
+  static constexpr Polarity HPolarity = TimingsVGA[M].H_SyncPolarity;
+  static constexpr Polarity VPolarity = TimingsVGA[M].V_SyncPolarity;
+  auto Black4_Porch = Black_4;
+  if constexpr (HPolarity == Polarity::Neg)
+    Black4_Porch |= HMask_4;
+  if constexpr (VPolarity == Polarity::Neg)
+    Black4_Porch |= VMask_4;
+
+  // Back Porch is black.
+  for (unsigned i = 0; i < TimingsVGA[M].H_BackPorch; i += 4)
+    pio_sm_put_blocking(VGAPio, VGASM, Black4_Porch);
+
+  if constexpr (Resample) {
+    // The visible part of the line, resampled from MDA pixel SrcX with
+    // interp1 and centered with black like the XB border.
+    static constexpr unsigned Pad =
+        (TimingsVGA[M].H_Visible - MDA_RESAMPLE_DST) / 2;
+    static_assert(Pad % 4 == 0, "Expected whole words of padding");
+    for (unsigned X = 0; X < Pad; X += 4)
+      pio_sm_put_blocking(VGAPio, VGASM, Black4_Porch);
+    Buff.resampleMDARow(Line, SrcX, [this, Black4_Porch](uint32_t MDA8) {
+      uint32_t Pix4Lo =
+          MDATo4x1[MDA8 & 0xff] | MDATo4x1[(MDA8 >> 8) & 0xff] << 16;
+      uint32_t Pix4Hi =
+          MDATo4x1[(MDA8 >> 16) & 0xff] | MDATo4x1[MDA8 >> 24] << 16;
+      pio_sm_put_blocking(VGAPio, VGASM, Pix4Lo | Black4_Porch);
+      pio_sm_put_blocking(VGAPio, VGASM, Pix4Hi | Black4_Porch);
+    });
+    for (unsigned X = 0; X < Pad; X += 4)
+      pio_sm_put_blocking(VGAPio, VGASM, Black4_Porch);
+  } else {
+    // Pad with black if the MDA line is narrower than VGA.
+    unsigned X = 0;
+    for (; X < PadLeft; X += 4)
+      pio_sm_put_blocking(VGAPio, VGASM, Black4_Porch);
+
+    // The visible part of the line, 8 MDA pixels per iteration.
+    const uint8_t *Row = Buff.getScanoutRow(Line);
+    for (; X < TimingsVGA[M].H_Visible; X += 8, SrcX += 8) {
+      uint32_t MDA8 = *(const uint32_t *)&Row[SrcX / 2];
+      uint32_t Pix4Lo =
+          MDATo4x1[MDA8 & 0xff] | MDATo4x1[(MDA8 >> 8) & 0xff] << 16;
+      uint32_t Pix4Hi =
+          MDATo4x1[(MDA8 >> 16) & 0xff] | MDATo4x1[MDA8 >> 24] << 16;
+      pio_sm_put_blocking(VGAPio, VGASM, Pix4Lo | Black4_Porch);
+      pio_sm_put_blocking(VGAPio, VGASM, Pix4Hi | Black4_Porch);
+    }
+  }
+
+  // Front Porch is black
+  for (unsigned i = 0; i < TimingsVGA[M].H_FrontPorch; i += 4)
+    pio_sm_put_blocking(VGAPio, VGASM, Black4_Porch);
+
+  // Sync.
+  auto Black4_Sync = Black_4;
+  if constexpr (HPolarity == Pos)
+    Black4_Sync |= HMask_4;
+  if constexpr (VPolarity == Neg)
+    Black4_Sync |= VMask_4;
+
+  for (unsigned i = 0; i != TimingsVGA[M].H_Retrace; i += 4)
+    pio_sm_put_blocking(VGAPio, VGASM, Black4_Sync);
+}
+
+bool VGAWriter::resampleMDA(const TTLDescr &Descr) {
+#ifdef MDA_RESAMPLE_640
+  // Real MDA that is too wide for 640 but fits in 400 lines.
+  return Descr.Mode == TTL::MDA && Descr.H_Visible - XB > 640 &&
+         Descr.V_Visible - YB <= 400;
+#else
+  return false;
+#endif
+}
+
 void __not_in_flash_func(VGAWriter::DrawBlackLineWithMaskMDA8x1)(uint32_t Mask_8) {
   static constexpr auto M = VGA_800x600_56Hz;
   const uint32_t BlackMDA_8_HM = BlackMDA_8 | HMaskMDA_8 | Mask_8;
@@ -123,9 +415,10 @@ void __not_in_flash_func(VGAWriter::DrawLineVSyncHighMDA8x1)(unsigned Line) {
   for (; X < Padding; X += 8)
     pio_sm_put_blocking(VGAPio, VGASM, BlackMDA_8_HV);
 
-  // The visible part of the line.
+  // The visible part of the line, 8 pixels (4 bytes) per word.
+  Buff.interpStartScanoutRow(Line);
   for (unsigned Idx = 0, E = TimingsTTL.H_Visible; Idx < E; Idx += 8) {
-    uint32_t Pixels8_HV = Buff.getMDA32(Line, Idx) | HVMaskMDA_8;
+    uint32_t Pixels8_HV = *DisplayBuffer::interpNextWord32() | HVMaskMDA_8;
     pio_sm_put_blocking(VGAPio, VGASM, Pixels8_HV);
   }
   X += TimingsTTL.H_Visible;
@@ -144,23 +437,60 @@ void __not_in_flash_func(VGAWriter::DrawLineVSyncHighMDA8x1)(unsigned Line) {
 
 void __not_in_flash_func(VGAWriter::tryChangePIOMode)() {
   TimingsTTL = TTLReaderPtr->getMode();
+  bool NewHalfRate = TTLReaderPtr->getHalfRate();
 
-  if (TimingsTTL == LastMode)
+  if (TimingsTTL == LastMode && NewHalfRate == HalfRate)
     return;
   LastMode = TimingsTTL;
+  HalfRate = NewHalfRate;
   Buff.setMode(TimingsTTL);
   DBG_PRINT(std::cout << "VGAWriter: Change PIO Mode: "
                       << modeToStr(TimingsTTL.Mode) << "\n";)
-  switch (TimingsTTL.Mode) {
+#ifdef FIXED_VGA_OUTPUT
+  // All modes use the 4x1 PIO, so load it only once and never retime the
+  // monitor. 320-pixel capture is doubled by the CPU, see
+  // DrawLineVSyncHigh4x1(), so this doesn't depend on HalfRate either.
+  if (VGAPioLoaded)
+    return;
+  VGAPioLoaded = true;
+  Trace::event(TraceEvent::VGAPioChange, (uint32_t)TimingsTTL.Mode, HalfRate,
+               (uint32_t)TTL::CGA);
+  VGAOffset = PioLoader.loadPIOProgram(
+      VGAPio, VGASM, &VGAOut4x1Pixels_program,
+      [](PIO Pio, uint SM, uint Offset) {
+        VGAOut4x1PixelsPioConfig(Pio, SM, Offset, VGA_RGB_GPIO);
+      });
+#else
+  // Resampled MDA uses the 4x1 PIO at 640x400.
+  TTL PioMode = resampleMDA(TimingsTTL) ? TTL::CGA : TimingsTTL.Mode;
+  Trace::event(TraceEvent::VGAPioChange, (uint32_t)TimingsTTL.Mode, HalfRate,
+               (uint32_t)PioMode);
+  switch (PioMode) {
   case TTL::CGA:
   case TTL::EGA:
+    if (HalfRate) {
+      VGAOffset = PioLoader.loadPIOProgram(
+          VGAPio, VGASM, &VGAOut4x2Pixels_program,
+          [](PIO Pio, uint SM, uint Offset) {
+            VGAOut4x2PixelsPioConfig(Pio, SM, Offset, VGA_RGB_GPIO);
+          });
+      break;
+    }
+#if defined(CGA_800x600) && !defined(FIXED_VGA_OUTPUT)
+    if (use800x600(TimingsTTL)) {
+      VGAOffset = PioLoader.loadPIOProgram(
+          VGAPio, VGASM, &VGAOut4x1Pixels800_program,
+          [](PIO Pio, uint SM, uint Offset) {
+            VGAOut4x1Pixels800PioConfig(Pio, SM, Offset, VGA_RGB_GPIO);
+          });
+      break;
+    }
+#endif
     VGAOffset = PioLoader.loadPIOProgram(
         VGAPio, VGASM, &VGAOut4x1Pixels_program,
         [](PIO Pio, uint SM, uint Offset) {
           VGAOut4x1PixelsPioConfig(Pio, SM, Offset, VGA_RGB_GPIO);
         });
-    pio_sm_put_blocking(VGAPio, VGASM, VGADarkYellow);
-    pio_sm_put_blocking(VGAPio, VGASM, VGABrown);
     break;
   case TTL::MDA:
     VGAOffset = PioLoader.loadPIOProgram(VGAPio, VGASM, &VGAOut8x1MDA_program,
@@ -173,6 +503,7 @@ void __not_in_flash_func(VGAWriter::tryChangePIOMode)() {
     DBG_PRINT(std::cout << "ERROR: no mode found!\n";)
     break;
   }
+#endif // FIXED_VGA_OUTPUT
   DBG_PRINT(std::cout << "VGAWriter:: done changing PIO\n";)
 }
 
@@ -183,8 +514,23 @@ VGAWriter::VGAWriter(Pico &Pico, PioProgramLoader &PioLoader)
 
   Buff.clear();
   Buff.setMode(TimingsTTL);
+  // The scanout on core0 loads the pixels with interp0 and resamples MDA with
+  // interp1.
+  DisplayBuffer::interpInit();
+  DisplayBuffer::resampleInterpInit();
 
   VGASM = pio_claim_unused_sm(VGAPio, true);
+#if defined(CGA_800x600) && !defined(FIXED_VGA_OUTPUT)
+  // Copies the visible part of the 800x600 lines to the VGA PIO.
+  VGADMAChannel = dma_claim_unused_channel(true);
+  dma_channel_config DMAConfig = dma_channel_get_default_config(VGADMAChannel);
+  channel_config_set_transfer_data_size(&DMAConfig, DMA_SIZE_32);
+  channel_config_set_read_increment(&DMAConfig, true);
+  channel_config_set_write_increment(&DMAConfig, false);
+  channel_config_set_dreq(&DMAConfig, pio_get_dreq(VGAPio, VGASM, true));
+  dma_channel_configure(VGADMAChannel, &DMAConfig, &VGAPio->txf[VGASM],
+                        nullptr, 0, /*trigger=*/false);
+#endif
 
   NoInputSignalSM = pio_claim_unused_sm(NoInputSignalPio, true);
   NoInputSignalOffset =
@@ -193,29 +539,21 @@ VGAWriter::VGAWriter(Pico &Pico, PioProgramLoader &PioLoader)
                          NoInputSignalOffset, TTL_HSYNC_GPIO);
   pio_sm_set_enabled(NoInputSignalPio, NoInputSignalSM, true);
 
-  // Start the VSyncPolarity PIO.
-  VSyncPolaritySM = pio_claim_unused_sm(VSyncPolarityPio, true);
-  VSyncPolarityOffset =
-      pio_add_program(VSyncPolarityPio, &VSyncPolarity_program);
-  VSyncPolarityPioConfig(VSyncPolarityPio, VSyncPolaritySM, VSyncPolarityOffset,
-                         TTL_VSYNC_GPIO);
-  pio_sm_set_enabled(VSyncPolarityPio, VSyncPolaritySM, true);
-  DBG_PRINT(std::cout << "Started VSyncPolarty Pio\n";)
-
-  // Start the HSyncPolarity PIO.
-  HSyncPolaritySM = pio_claim_unused_sm(HSyncPolarityPio, true);
-  HSyncPolarityOffset =
-      pio_add_program(HSyncPolarityPio, &HSyncPolarity_program);
-  HSyncPolarityPioConfig(HSyncPolarityPio, HSyncPolaritySM, HSyncPolarityOffset,
-                         TTL_HSYNC_GPIO);
-  pio_sm_set_enabled(HSyncPolarityPio, HSyncPolaritySM, true);
-  DBG_PRINT(std::cout << "Started HSyncPolarty Pio\n";)
+  // Start the V/H SyncPeriod PIOs. They share the same program.
+  SyncPeriodOffset = pio_add_program(SyncPeriodPio, &SyncPeriod_program);
+  VSyncPeriodSM = pio_claim_unused_sm(SyncPeriodPio, true);
+  SyncPeriodPioConfig(SyncPeriodPio, VSyncPeriodSM, SyncPeriodOffset,
+                      TTL_VSYNC_GPIO);
+  HSyncPeriodSM = pio_claim_unused_sm(SyncPeriodPio, true);
+  SyncPeriodPioConfig(SyncPeriodPio, HSyncPeriodSM, SyncPeriodOffset,
+                      TTL_HSYNC_GPIO);
+  DBG_PRINT(std::cout << "Started SyncPeriod Pios\n";)
 
   // Reset to defaults if the user is pressinx PxClkBtn during boot.
   ResetToDefaults = !gpio_get(PX_CLK_BTN_GPIO) && !gpio_get(AUTO_ADJUST_GPIO);
 
   // Start TTLReader. We don't know yet the state of NoSignal, but it's fine.
-  restartCore1TTLReader(NoSignal);
+  startCore1TTLReader(NoSignal);
 
   // Start VGA Pio
   tryChangePIOMode();
@@ -226,29 +564,24 @@ VGAWriter::VGAWriter(Pico &Pico, PioProgramLoader &PioLoader)
 }
 
 static void core1_main() {
-  TTLReader TTLR(*PPL, *Pi, *Flash, Buff, VSyncPolarityPio_, VSyncPolaritySM_,
-                 HSyncPolarityPio_, HSyncPolaritySM_, ResetToDefaults);
+  TTLReader TTLR(*PPL, *Pi, *Flash, Buff, SyncPeriodPio_, VSyncPeriodSM_,
+                 HSyncPeriodSM_, SyncPeriodOffset_, ResetToDefaults);
   ResetToDefaults = false;      // Only once
   TTLReaderPtr = &TTLR;
   DBG_PRINT(std::cout << "TTLR started\n";)
   TTLR.runForEver();
 }
 
-void VGAWriter::restartCore1TTLReader(bool NoSignal) {
-  // Restart core1 because it must have hanged waiting for TTL
-  DBG_PRINT(std::cout << "Starting or restarting Core1\n";)
-  if (TTLReaderPtr != nullptr) {
-    DBG_PRINT(std::cout << "RESET CORE 1\n";)
-    TTLReaderPtr->unclaimUsedSMs();
-    multicore_reset_core1();
-    // multicore_fifo_pop_blocking();
-    sleep_ms(10);
-  }
+void VGAWriter::startCore1TTLReader(bool NoSignal) {
+  DBG_PRINT(std::cout << "Starting Core1\n";)
+  Trace::event(TraceEvent::Core1Start, NoSignal);
+  // From now on core1 sends the messages.
+  DBG_PRINT(DebugLog::flush();)
   TTLReaderPtr = nullptr;
-  VSyncPolarityPio_ = VSyncPolarityPio;
-  VSyncPolaritySM_ = VSyncPolaritySM;
-  HSyncPolarityPio_ = HSyncPolarityPio;
-  HSyncPolaritySM_ = HSyncPolaritySM;
+  SyncPeriodPio_ = SyncPeriodPio;
+  VSyncPeriodSM_ = VSyncPeriodSM;
+  HSyncPeriodSM_ = HSyncPeriodSM;
+  SyncPeriodOffset_ = SyncPeriodOffset;
   multicore_launch_core1(core1_main);
 
   DBG_PRINT(std::cout << "VGAWriter Wait for TTLReader\n";)
@@ -266,7 +599,8 @@ void VGAWriter::restartCore1TTLReader(bool NoSignal) {
     if (!NoSignal) {
       DBG_PRINT(std::cout << "No Signal\n";)
       NoSignal = true;
-      restartCore1TTLReader(NoSignal);
+      // This makes core1 abort the frame it is capturing and wait.
+      TTLReaderPtr->setNoSignal(NoSignal);
       auto Now = get_absolute_time();
       VGAOffTime = delayed_by_ms(Now, VGA_OFF_TIMER_MS);
     } else {
@@ -288,7 +622,7 @@ void VGAWriter::restartCore1TTLReader(bool NoSignal) {
           NoSignal = false;
           DBG_PRINT(std::cout << "VGA Off Over, Enable VGAPio\n";)
           pio_sm_set_enabled(VGAPio, VGASM, true);
-          restartCore1TTLReader(NoSignal);
+          TTLReaderPtr->setNoSignal(NoSignal);
         }
       }
     }
@@ -298,50 +632,69 @@ void VGAWriter::restartCore1TTLReader(bool NoSignal) {
   if (NoSignal) {
     DBG_PRINT(std::cout << "\n\nEnd of No Signal\n";)
     NoSignal = false;
-    restartCore1TTLReader(NoSignal);
+    TTLReaderPtr->setNoSignal(NoSignal);
   }
-  // Pop from the nosignal queue.
-  pio_sm_get(NoInputSignalPio, NoInputSignalSM);
+  // Drain the nosignal queue, so that if we don't get a new HSync pulse by
+  // the next call we know right away.
+  while (!pio_sm_is_rx_fifo_empty(NoInputSignalPio, NoInputSignalSM))
+    pio_sm_get(NoInputSignalPio, NoInputSignalSM);
 }
 
-template <VGAResolution R, bool LineDoubling>
+template <VGAResolution R, bool LineDoubling, bool MDASource>
 void __not_in_flash_func(VGAWriter::drawFrame4x1)() {
   // Back porch is black.
   for (uint32_t Line = 0; Line != TimingsVGA[R].V_BackPorch; ++Line)
-    DrawBlackLineWithMask4x1(/*InVSync=*/false);
-
-  // 1. TTL Visible.
-  uint32_t Line = 0;
-  // If there is empty space below the screen (e.g. in TTL resolutions like
-  // 640x350 that are drawn in 640x400), then center the image vertically.
-  uint32_t TTLV = (LineDoubling ? 2 : 1) * TimingsTTL.V_Visible;
-  if (TimingsVGA[R].V_Visible > TTLV) {
-    // Vertical VGA-TTL visible gap, fill with black lines.
-    uint32_t VGA_TTL_VerticalGap = TimingsVGA[R].V_Visible - TTLV;
-    uint32_t CenteringLinesTop = VGA_TTL_VerticalGap / 2;
-    for (; Line < CenteringLinesTop; ++Line)
-      DrawBlackLineWithMask4x1(/*InVSync=*/false);
-  }
-  uint32_t Offset = Line;
-  // Note: We limit to min(TTL Visible, VGA V_Visble + V_FrontPorch) in case the
-  // TTL input signal is slightly taller than VGA visible. This is useful for
-  // some strange inputs that are 260 lines but we would still want to use VGA
-  // 640x480.
-  uint32_t DrawnLines =
-      std::min(std::min((LineDoubling ? 2 : 1) * TimingsTTL.V_Visible,
-                        TimingsVGA[R].V_Visible + TimingsVGA[R].V_FrontPorch),
-               (LineDoubling ? 2 : 1) * DisplayBuffer::BuffY);
-  uint32_t LineTTLE = Offset + DrawnLines;
-  for (; Line < LineTTLE; ++Line)
-    DrawLineVSyncHigh4x1((Line - Offset) / (LineDoubling ? 2 : 1));
-  // 2. The rest is black, including the front porch
+    DrawBlackLineWithMask4x1<R>(/*InVSync=*/false);
+
+  // 1. TTL Visible, including the front porch.
+  // Note: The line map may use the front porch in case the TTL input signal is
+  // slightly taller than VGA visible. This is useful for some strange inputs
+  // that are 260 lines but we would still want to use VGA 640x480.
+  VGALineMap.update(R, std::min(TimingsTTL.V_Visible, DisplayBuffer::BuffY),
+                    LineDoubling ? 2 : 1, TimingsVGA[R].V_FrontPorch,
+                    VGAScaling);
   static constexpr const uint32_t LineVGAE =
       TimingsVGA[R].V_Visible + TimingsVGA[R].V_FrontPorch;
-  for (; Line < LineVGAE; ++Line)
-    DrawBlackLineWithMask4x1(/*InVSync=*/false);
+  if constexpr (MDASource) {
+    static constexpr const uint32_t VGAH = TimingsVGA[R].H_Visible;
+    uint32_t TTLH = TimingsTTL.H_Visible;
+    if (resampleMDA(TimingsTTL)) {
+      // Scale MDA_RESAMPLE_SRC columns to MDA_RESAMPLE_DST.
+      uint32_t SrcX = DisplayBuffer::getResampleStart(TTLH);
+      for (uint32_t Line = 0; Line != LineVGAE; ++Line) {
+        uint32_t BuffLine = VGALineMap[Line];
+        if (BuffLine == LineMap::Black)
+          DrawBlackLineWithMask4x1<R>(/*InVSync=*/false);
+        else
+          DrawLineVSyncHighMDA4x1<R, /*Resample=*/true>(BuffLine, SrcX, 0);
+      }
+    } else {
+      // Center the MDA line horizontally, cropping it if wider than VGA.
+      uint32_t SrcX = TTLH > VGAH ? ((TTLH - VGAH) / 2) & ~7u : 0;
+      uint32_t PadLeft = TTLH < VGAH ? ((VGAH - TTLH) / 2) & ~7u : 0;
+      for (uint32_t Line = 0; Line != LineVGAE; ++Line) {
+        uint32_t BuffLine = VGALineMap[Line];
+        if (BuffLine == LineMap::Black)
+          DrawBlackLineWithMask4x1<R>(/*InVSync=*/false);
+        else
+          DrawLineVSyncHighMDA4x1<R, /*Resample=*/false>(BuffLine, SrcX,
+                                                      PadLeft);
+      }
+    }
+  } else {
+    for (uint32_t Line = 0; Line != LineVGAE; ++Line) {
+      uint32_t BuffLine = VGALineMap[Line];
+      if (BuffLine == LineMap::Black)
+        DrawBlackLineWithMask4x1<R>(/*InVSync=*/false);
+      else if (HalfRate)
+        DrawLineVSyncHigh4x1<R, /*PixelDoubling=*/true>(BuffLine);
+      else
+        DrawLineVSyncHigh4x1<R, /*PixelDoubling=*/false>(BuffLine);
+    }
+  }
 
   for (uint32_t Line = 0; Line != TimingsVGA[R].V_Retrace; ++Line)
-    DrawBlackLineWithMask4x1(/*InVSync=*/true);
+    DrawBlackLineWithMask4x1<R>(/*InVSync=*/true);
 }
 
 template <VGAResolution R, bool LineDoubling>
@@ -351,34 +704,21 @@ void __not_in_flash_func(VGAWriter::drawFrame8x1)() {
        ++InvisLine)
     DrawBlackLineWithMaskMDA8x1(VMaskMDA_8);
 
-  // Visible
-  // -------
-  // 1. Vertical VGA-TTL visible gap, fill with black lines.
-  uint32_t VGA_TTL_VerticalGap = TimingsVGA[R].V_Visible - TimingsTTL.V_Visible;
-  uint32_t CenteringLinesTop = VGA_TTL_VerticalGap / 2;
-  uint32_t TTLLine = 0;
-  for (; TTLLine < CenteringLinesTop; ++TTLLine)
-    DrawBlackLineWithMaskMDA8x1(VMaskMDA_8);
-
-  // 2. Non-black TTL Visible.
-  uint32_t LineTTLE =
-      std::min(std::min((LineDoubling ? 2 : 1) * TimingsTTL.V_Visible,
-                        TimingsVGA[R].V_Visible),
-               (LineDoubling ? 2 : 1) * DisplayBuffer::BuffY);
-  for (uint32_t BuffLine = 0; BuffLine < LineTTLE; ++BuffLine) {
-    DrawLineVSyncHighMDA8x1(BuffLine / (LineDoubling ? 2 : 1));
-    ++TTLLine;
+  // 1. Visible
+  VGALineMap.update(R, std::min(TimingsTTL.V_Visible, DisplayBuffer::BuffY),
+                    LineDoubling ? 2 : 1, /*ExtraLines=*/0, VGAScaling);
+  for (uint32_t Line = 0; Line != TimingsVGA[R].V_Visible; ++Line) {
+    uint32_t BuffLine = VGALineMap[Line];
+    if (BuffLine == LineMap::Black)
+      DrawBlackLineWithMaskMDA8x1(VMaskMDA_8);
+    else
+      DrawLineVSyncHighMDA8x1(BuffLine);
   }
-  // 3. Bottom part of visible to fill the gap with black and keep the image
-  // centered.
-  static constexpr const uint32_t LineVGAE = TimingsVGA[R].V_Visible;
-  for (; TTLLine < LineVGAE; ++TTLLine)
-    DrawBlackLineWithMaskMDA8x1(VMaskMDA_8);
 
-  // 4. Non-visible front porch
+  // 2. Non-visible front porch
   for (uint32_t Line = 0; Line != TimingsVGA[R].V_FrontPorch; ++Line)
     DrawBlackLineWithMaskMDA8x1(VMaskMDA_8);
-  // 5. Retrace
+  // 3. Retrace
   for (uint32_t Line = 0; Line != TimingsVGA[R].V_Retrace; ++Line)
     DrawBlackLineWithMaskMDA8x1(BlackMDA_8);
 }
@@ -386,11 +726,40 @@ void __not_in_flash_func(VGAWriter::drawFrame8x1)() {
 void __not_in_flash_func(VGAWriter::runForEver)() {
   uint32_t Cnt = 0;
   while (true) {
+#ifdef FIXED_VGA_OUTPUT
+    // Always use 640x480 so that input mode changes don't retime the
+    // monitor. Line-double if it fits, otherwise center.
+    bool LineDoubling = 2 * (TimingsTTL.V_Visible - YB) <= 480;
+    if (TimingsTTL.Mode == TTL::MDA) {
+      if (LineDoubling)
+        drawFrame4x1<VGA_640x480_60Hz, /*LineDoubling=*/true,
+                     /*MDASource=*/true>();
+      else
+        drawFrame4x1<VGA_640x480_60Hz, /*LineDoubling=*/false,
+                     /*MDASource=*/true>();
+    } else {
+      if (LineDoubling)
+        drawFrame4x1<VGA_640x480_60Hz, /*LineDoubling=*/true>();
+      else
+        drawFrame4x1<VGA_640x480_60Hz, /*LineDoubling=*/false>();
+    }
+#else
     switch (TimingsTTL.Mode) {
     case TTL::CGA:
     case TTL::EGA:
       if (TTLReader::isHighRes(TimingsTTL))
         drawFrame4x1<VGA_640x400_70Hz, /*LineDoubing=*/false>();
+      else if (HalfRate) {
+        // 320-pixel capture, doubled by the 4x2 PIO.
+        if (TimingsTTL.V_Visible - YB > 200)
+          drawFrame4x2<VGA_640x480_60Hz>();
+        else
+          drawFrame4x2<VGA_640x400_70Hz>();
+      }
+#if defined(CGA_800x600) && !defined(FIXED_VGA_OUTPUT)
+      else if (use800x600(TimingsTTL))
+        drawFrame4x1DMA<VGA_800x600_56Hz, /*LineDoubling=*/true>();
+#endif
       else {
         if (TimingsTTL.V_Visible - YB > 200)
           drawFrame4x1<VGA_640x480_60Hz, /*LineDoubing=*/true>();
@@ -399,6 +768,12 @@ void __not_in_flash_func(VGAWriter::runForEver)() {
       }
       break;
     case TTL::MDA:
+      // If we can resample the 720 columns to 640 use the cheaper 640x400.
+      if (resampleMDA(TimingsTTL)) {
+        drawFrame4x1<VGA_640x400_70Hz, /*LineDoubling=*/false,
+                     /*MDASource=*/true>();
+        break;
+      }
       // If this is real MDA with high horizontal resolution > 640 or vertical >
       // 240 use no line-doubling and 800x600.
       if (TimingsTTL.H_Visible - XB > 640 || TimingsTTL.V_Visible - YB > 240) {
@@ -419,12 +794,12 @@ void __not_in_flash_func(VGAWriter::runForEver)() {
                           << modeToStr(TimingsTTL.Mode);)
       break;
     }
+#endif // FIXED_VGA_OUTPUT
     ++Cnt;
     // Update PIO if needed.
     if (Cnt % 2 == 0) {
       tryChangePIOMode();
     }
-    if (Cnt % 2 == 1)
-      checkInputSignal();
+    checkInputSignal();
   }
 }
@@ -25,13 +25,11 @@ class VGAWriter {
   uint NoInputSignalSM = 0;
   uint NoInputSignalOffset = 0;
 
-  const PIO VSyncPolarityPio = pio0;
-  uint VSyncPolaritySM = 0;
-  uint VSyncPolarityOffset = 0;
-
-  const PIO HSyncPolarityPio = pio0;
-  uint HSyncPolaritySM = 0;
-  uint HSyncPolarityOffset = 0;
+  /// Measures the V/H sync periods for TTLReader.
+  const PIO SyncPeriodPio = pio0;
+  uint VSyncPeriodSM = 0;
+  uint HSyncPeriodSM = 0;
+  uint SyncPeriodOffset = 0;
 
   Polarity VSyncPolarity = Polarity::Pos;
   Polarity HSyncPolarity = Polarity::Pos;
@@ -49,22 +47,63 @@ class VGAWriter {
 
   void checkInputSignal();
 
-  void DrawBlackLineWithMask4x1(bool InVertSync);
+  /// The line routines take the sync polarities from the timings of \p M,
+  /// which must be the resolution of the frame that they are part of.
+  template <VGAResolution M> void DrawBlackLineWithMask4x1(bool InVertSync);
+  /// If \p PixelDoubling the buffer line holds 320 pixels that get doubled.
+  template <VGAResolution M, bool PixelDoubling>
   void DrawLineVSyncHigh4x1(unsigned Line);
 
+  /// The TTLReader captures 320 pixels per line.
+  bool HalfRate = false;
+  /// The 4x2 routines are for the pixel-doubling PIO.
+  template <VGAResolution M> void DrawBlackLineWithMask4x2(bool InVertSync);
+  template <VGAResolution M> void DrawLineVSyncHigh4x2(unsigned Line);
+  /// Print a single line-doubled frame of the 320-pixel capture.
+  template <VGAResolution R> void drawFrame4x2();
+
   void DrawBlackLineWithMaskMDA8x1(uint32_t Mask_4);
   void DrawLineVSyncHighMDA8x1(unsigned Line);
 
   /// Starts/changes PIO program based on the Buffer's mode.
   void tryChangePIOMode();
 
-  /// Print a single frame using the 4x1 routines.
-  template <VGAResolution R, bool LineDoubling> void drawFrame4x1();
+#ifdef FIXED_VGA_OUTPUT
+  /// The 4x1 PIO is loaded once and used for all modes.
+  bool VGAPioLoaded = false;
+#endif
+  /// Draws MDA buffer \p Line with the 4x1 routines, starting from MDA pixel
+  /// \p SrcX. If \p Resample the line is resampled with
+  /// DisplayBuffer::resampleMDARow(), otherwise it starts after \p PadLeft
+  /// black pixels.
+  template <VGAResolution M, bool Resample>
+  void DrawLineVSyncHighMDA4x1(unsigned Line, unsigned SrcX, unsigned PadLeft);
+  /// \Returns true if we should scale the MDA columns to fit in 640 with
+  /// MDA_RESAMPLE_640, instead of using 800x600.
+  static bool resampleMDA(const TTLDescr &Descr);
+
+  /// Print a single frame using the 4x1 routines. If \p MDASource the pixels
+  /// are read from the MDA buffer.
+  template <VGAResolution R, bool LineDoubling, bool MDASource = false>
+  void drawFrame4x1();
+
+#if defined(CGA_800x600) && !defined(FIXED_VGA_OUTPUT)
+  /// Feeds the visible part of the 800x600 lines to the VGA PIO.
+  int VGADMAChannel = -1;
+  /// Draws buffer \p Line in 800x600 with the visible part copied by DMA.
+  void DrawLineVSyncHigh4x1DMA(unsigned Line);
+  /// \Returns true if \p Descr is CGA/EGA that should be shown in 800x600.
+  static bool use800x600(const TTLDescr &Descr);
+  /// Print a single CGA/EGA frame in 800x600 using DMA for the visible part.
+  template <VGAResolution R, bool LineDoubling> void drawFrame4x1DMA();
+#endif
 
   /// Print a single frame using the 8x1 routines.
   template <VGAResolution R, bool LineDoubling> void drawFrame8x1();
 
-  void restartCore1TTLReader(bool NoSignal);
+  /// Starts the TTLReader on core1. This is done only once, signal loss and
+  /// recovery are handled by TTLReader::setNoSignal().
+  void startCore1TTLReader(bool NoSignal);
 
 public:
   VGAWriter(Pico &Pico, PioProgramLoader &PioLoader);
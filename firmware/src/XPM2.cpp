@@ -18,6 +18,9 @@ void XPM2::show(DisplayBuffer &DBuff, const TTLDescr &TimingsTTL, int OffsetX,
     // Special case due to 2-pixels per byte
     DisplayWidth /= 2;
     ZoomX >>= 1;
+  } else if (DBuff.HalfRate) {
+    // The 320-pixel capture, each byte gets doubled on output.
+    DisplayWidth /= 2;
   } else if ((DBuff.TimingsTTL->Mode == TTL::CGA ||
               DBuff.TimingsTTL->Mode == TTL::EGA) &&
              !TTLReader::isHighRes(*DBuff.TimingsTTL)) {
@@ -38,7 +41,7 @@ void XPM2::show(DisplayBuffer &DBuff, const TTLDescr &TimingsTTL, int OffsetX,
     for (int Col = 0, BuffCol = 0;
          Col < Width && X + BuffCol + XRepeatedPixels < DisplayWidth;
          ++Col, BuffCol += XRepeatedPixels) {
-      uint8_t Pixel = CharToColor.at(LineStr[Col]);
+      uint8_t Pixel = CharToColor[LineStr[Col] & 0x7f];
       // Stamp the pixel multiple times to make a big zoomed-in pixel.
       for (int SubX = 0; SubX != XRepeatedPixels; ++SubX)
         for (int SubY = 0; SubY != YRepeatedPixels; ++SubY) {
@@ -6,29 +6,52 @@
 #ifndef __XPM2_H__
 #define __XPM2_H__
 
-#include <unordered_map>
 #include <cstdint>
-#include <cstdio>
 
 class DisplayBuffer;
 class TTLDescr;
 
 class XPM2 {
-  int Width;
-  int Height;
-  int NumColors;
-  int CharsPerPixel;
+  int Width = 0;
+  int Height = 0;
+  int NumColors = 0;
+  int CharsPerPixel = 0;
   const char **XPMArray;
-  std::unordered_map<char, uint8_t> CharToColor;
+  /// Indexed by the pixel character. XPM2 uses printable characters only.
+  uint8_t CharToColor[128] = {};
+
+  /// Parses the number at \p Ptr in \p Base and moves \p Ptr past it and
+  /// any spaces that follow.
+  static uint32_t parseNum(const char *&Ptr, uint32_t Base) {
+    uint32_t Num = 0;
+    while (true) {
+      char C = *Ptr;
+      uint32_t Digit = C >= '0' && C <= '9'   ? C - '0'
+                       : C >= 'a' && C <= 'f' ? C - 'a' + 10
+                       : C >= 'A' && C <= 'F' ? C - 'A' + 10
+                                              : Base;
+      if (Digit >= Base)
+        break;
+      Num = Num * Base + Digit;
+      ++Ptr;
+    }
+    while (*Ptr == ' ')
+      ++Ptr;
+    return Num;
+  }
   void parseHeader() {
     // "Width Height NumColors CharsPerPixel"
-    sscanf(XPMArray[0], "%d %d %d %d", &Width, &Height, &NumColors,
-           &CharsPerPixel);
+    const char *Ptr = XPMArray[0];
+    Width = parseNum(Ptr, 10);
+    Height = parseNum(Ptr, 10);
+    NumColors = parseNum(Ptr, 10);
+    CharsPerPixel = parseNum(Ptr, 10);
     // "Char c #Color"
     for (int ColorIdx = 0; ColorIdx != NumColors; ++ColorIdx) {
-      char Char;
-      uint32_t Color;
-      sscanf(XPMArray[ColorIdx + 1], "%c c #%lx", &Char, &Color);
+      const char *Line = XPMArray[ColorIdx + 1];
+      uint8_t Char = Line[0] & 0x7f;
+      const char *Ptr = &Line[5];
+      uint32_t Color = parseNum(Ptr, 16);
       uint8_t R = (Color & 0xc00000) >> 18;
       uint8_t G = (Color & 0x00c000) >> 12;
       uint8_t B = (Color & 0x0000c0) >> 6;
@@ -5,9 +5,11 @@
 
 #include "Common.h"
 #include "Debug.h"
+#include "DebugLog.h"
 #include "Flash.h"
 #include "Pico.h"
 #include "TTLReader.h"
+#include "Trace.h"
 #include "VGAWriter.h"
 
 FlashStorage *Flash = nullptr;
@@ -23,7 +25,9 @@ int main() {
   (void)__dso_handle;
   Pico Pico;
   Pi = &Pico;
+  DBG_PRINT(DebugLog::install();)
   critical_section_init(&UnusedPIOLock);
+  Trace::init();
 
   DBG_PRINT(sleep_ms(1500);)
   DBG_PRINT(std::cout << PROJECT_NAME << " rev." << REVISION_MAJOR << "."
@@ -44,6 +48,7 @@ int main() {
                 Pico::Pull::Down, "VGA");
   Pico.initGPIO(PinRange(MDA_VI_GPIO, MDA_VI_GPIO + 2), GPIO_IN, Pico::Pull::Up,
                 "MDA");
+  DBG_PRINT(DebugLog::flush();)
 
   // Read Presets from flash.
   FlashStorage FlashMain;
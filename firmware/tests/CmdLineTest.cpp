@@ -0,0 +1,131 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+// Tests the USB_COMMANDS line parser.
+//
+
+#include "CmdLine.h"
+#include "Test.h"
+#include <cstring>
+#include <string>
+
+using Status = CmdLine::Status;
+
+/// Feeds all the characters of \p Str and \returns the last status.
+static Status feed(CmdLine &Cmd, const char *Str) {
+  Status S = Status::Incomplete;
+  for (; *Str != '\0'; ++Str)
+    S = Cmd.feed(*Str);
+  return S;
+}
+
+static void testWords() {
+  CmdLine Cmd;
+  CHECK(feed(Cmd, "set pxclk 14318181") == Status::Incomplete);
+  CHECK(Cmd.feed('\n') == Status::Ready);
+  CHECK(Cmd.size() == 3);
+  CHECK(strcmp(Cmd[0], "set") == 0);
+  CHECK(strcmp(Cmd[1], "pxclk") == 0);
+  CHECK(strcmp(Cmd[2], "14318181") == 0);
+  // Runs of spaces and tabs, leading and trailing ones too.
+  CHECK(feed(Cmd, " \t border  \t8 2 \t\n") == Status::Ready);
+  CHECK(Cmd.size() == 3);
+  CHECK(strcmp(Cmd[0], "border") == 0);
+  CHECK(strcmp(Cmd[2], "2") == 0);
+}
+
+static void testIs() {
+  CmdLine Cmd;
+  CHECK(feed(Cmd, "StAtS x\n") == Status::Ready);
+  CHECK(Cmd.is(0, "STATS"));
+  CHECK(!Cmd.is(0, "STAT"));
+  CHECK(!Cmd.is(0, "STATSX"));
+  CHECK(!Cmd.is(0, "X"));
+  CHECK(Cmd.is(1, "X"));
+  // Out of range words never match.
+  CHECK(!Cmd.is(2, "X"));
+  CHECK(!Cmd.is(CmdLine::MaxWords, ""));
+}
+
+static void testGetUInt() {
+  CmdLine Cmd;
+  CHECK(feed(Cmd, "0 4294967295 007\n") == Status::Ready);
+  uint32_t Val = 42;
+  CHECK(Cmd.getUInt(0, Val) && Val == 0);
+  CHECK(Cmd.getUInt(1, Val) && Val == 4294967295u);
+  CHECK(Cmd.getUInt(2, Val) && Val == 7);
+  // Failures leave Val alone.
+  CHECK(!Cmd.getUInt(3, Val) && Val == 7);
+  CHECK(feed(Cmd, "4294967296 12a -1 99999999999999999999999\n") ==
+        Status::Ready);
+  CHECK(!Cmd.getUInt(0, Val) && Val == 7);
+  CHECK(!Cmd.getUInt(1, Val) && Val == 7);
+  CHECK(!Cmd.getUInt(2, Val) && Val == 7);
+  // This one overflows 64 bits too.
+  CHECK(!Cmd.getUInt(3, Val) && Val == 7);
+}
+
+static void testEmptyLines() {
+  CmdLine Cmd;
+  CHECK(Cmd.feed('\n') == Status::Incomplete);
+  CHECK(Cmd.feed('\r') == Status::Incomplete);
+  CHECK(feed(Cmd, "  \t \n") == Status::Incomplete);
+  CHECK(Cmd.size() == 0);
+  CHECK(feed(Cmd, "\n\nstats\n") == Status::Ready);
+  CHECK(Cmd.size() == 1 && Cmd.is(0, "STATS"));
+}
+
+static void testCRLF() {
+  CmdLine Cmd;
+  // The CR ends the line and the LF is an empty line, so a CR/LF pair gives a
+  // single command.
+  CHECK(feed(Cmd, "stats\r") == Status::Ready);
+  CHECK(Cmd.size() == 1 && Cmd.is(0, "STATS"));
+  CHECK(Cmd.feed('\n') == Status::Incomplete);
+  CHECK(feed(Cmd, "commit\r\n") == Status::Incomplete);
+  CHECK(feed(Cmd, "set offset 3\r") == Status::Ready);
+  uint32_t Val = 0;
+  CHECK(Cmd.size() == 3 && Cmd.getUInt(2, Val) && Val == 3);
+  CHECK(Cmd.feed('\n') == Status::Incomplete);
+}
+
+static void testOverflow() {
+  CmdLine Cmd;
+  std::string Max(CmdLine::MaxLineSz, 'a');
+  CHECK(feed(Cmd, (Max + "\n").c_str()) == Status::Ready);
+  CHECK(Cmd.size() == 1 && strlen(Cmd[0]) == CmdLine::MaxLineSz);
+  // One character too many drops the whole line, even a very long one.
+  CHECK(feed(Cmd, (Max + "b\n").c_str()) == Status::Error);
+  CHECK(feed(Cmd, (Max + Max + Max + "\n").c_str()) == Status::Error);
+  // The next line is fine again.
+  CHECK(feed(Cmd, "stats\n") == Status::Ready);
+  CHECK(Cmd.size() == 1 && Cmd.is(0, "STATS"));
+  // The overflow is only reported at the end of the line.
+  CHECK(feed(Cmd, Max.c_str()) == Status::Incomplete);
+  CHECK(Cmd.feed('x') == Status::Incomplete);
+  CHECK(Cmd.feed('\r') == Status::Error);
+  CHECK(Cmd.feed('\n') == Status::Incomplete);
+}
+
+static void testTooManyWords() {
+  CmdLine Cmd;
+  CHECK(feed(Cmd, "a b c d\n") == Status::Ready);
+  CHECK(Cmd.size() == CmdLine::MaxWords);
+  CHECK(feed(Cmd, "a b c d  \t\n") == Status::Ready);
+  CHECK(Cmd.size() == CmdLine::MaxWords);
+  CHECK(feed(Cmd, "a b c d e\n") == Status::Error);
+  CHECK(feed(Cmd, "set border 8 2\n") == Status::Ready);
+  CHECK(Cmd.size() == 4 && Cmd.is(1, "BORDER"));
+}
+
+int main() {
+  testWords();
+  testIs();
+  testGetUInt();
+  testEmptyLines();
+  testCRLF();
+  testOverflow();
+  testTooManyWords();
+  return Test::result();
+}
@@ -0,0 +1,107 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+// Tests the vertical scaling of LineMap.cpp.
+//
+// $ LineMapTest
+//
+
+#include "LineMap.h"
+#include "Test.h"
+
+/// \Returns the number of visible VGA lines of \p R plus its front porch,
+/// which is how many lines of \p Map drawFrame4x1() reads.
+static uint32_t getLines(VGAResolution R) {
+  return TimingsVGA[R].V_Visible + TimingsVGA[R].V_FrontPorch;
+}
+
+/// Checks that the rest of \p Map from line \p From is black.
+static bool isBlackFrom(const LineMap &Map, uint32_t From) {
+  for (uint32_t Line = From; Line != LineMap::MaxLines; ++Line)
+    if (Map[Line] != LineMap::Black)
+      return false;
+  return true;
+}
+
+static void testIntegerCentered() {
+  // EGA 640x350 in 640x400.
+  LineMap Map;
+  Map.update(VGA_640x400_70Hz, 350, /*Repeat=*/1,
+             TimingsVGA[VGA_640x400_70Hz].V_FrontPorch,
+             LineMap::Scaling::Integer);
+  CHECK(Map[24] == LineMap::Black);
+  for (uint32_t Line = 25; Line != 25 + 350; ++Line)
+    CHECK(Map[Line] == Line - 25);
+  CHECK(isBlackFrom(Map, 25 + 350));
+}
+
+static void testIntegerFrontPorch() {
+  // A 260-line CGA mode doubled into 640x480 spills into the 10 lines of the
+  // front porch, but no further.
+  static constexpr auto R = VGA_640x480_60Hz;
+  LineMap Map;
+  Map.update(R, 260, /*Repeat=*/2, TimingsVGA[R].V_FrontPorch,
+             LineMap::Scaling::Integer);
+  CHECK(getLines(R) == 490);
+  for (uint32_t Line = 0; Line != getLines(R); ++Line)
+    CHECK(Map[Line] == Line / 2);
+  CHECK(isBlackFrom(Map, getLines(R)));
+}
+
+static void testFill200To480() {
+  static constexpr auto R = VGA_640x480_60Hz;
+  LineMap Map;
+  Map.update(R, 200, /*Repeat=*/2, TimingsVGA[R].V_FrontPorch,
+             LineMap::Scaling::Fill);
+  CHECK(Map[0] == 0);
+  CHECK(Map[479] == 199);
+  uint32_t Repeats = 1;
+  for (uint32_t Line = 1; Line != 480; ++Line) {
+    uint32_t Prev = Map[Line - 1];
+    // Monotonic, without skipping any source line.
+    CHECK(Map[Line] == Prev || Map[Line] == Prev + 1);
+    if (Map[Line] == Prev) {
+      ++Repeats;
+      continue;
+    }
+    CHECK(Repeats == 2 || Repeats == 3);
+    Repeats = 1;
+  }
+  CHECK(Repeats == 2 || Repeats == 3);
+  // Fill doesn't use the front porch.
+  CHECK(isBlackFrom(Map, 480));
+}
+
+static void testFill350To600() {
+  static constexpr auto R = VGA_800x600_56Hz;
+  LineMap Map;
+  Map.update(R, 350, /*Repeat=*/1, TimingsVGA[R].V_FrontPorch,
+             LineMap::Scaling::Fill);
+  for (uint32_t Line = 0; Line != 600; ++Line)
+    CHECK(Map[Line] < 350);
+  CHECK(Map[599] == 349);
+  CHECK(isBlackFrom(Map, 600));
+}
+
+static void testRebuild() {
+  // The map gets rebuilt when any of the parameters changes.
+  LineMap Map;
+  Map.update(VGA_640x400_70Hz, 350, 1, 0, LineMap::Scaling::Integer);
+  Map.update(VGA_640x400_70Hz, 200, 2, 0, LineMap::Scaling::Integer);
+  CHECK(Map[0] == 0 && Map[1] == 0 && Map[2] == 1 && Map[399] == 199);
+  Map.update(VGA_640x400_70Hz, 200, 2, 0, LineMap::Scaling::Fill);
+  CHECK(Map[0] == 0 && Map[399] == 199);
+  // Without source lines everything is black.
+  Map.update(VGA_640x400_70Hz, 0, 2, 0, LineMap::Scaling::Fill);
+  CHECK(isBlackFrom(Map, 0));
+}
+
+int main() {
+  testIntegerCentered();
+  testIntegerFrontPorch();
+  testFill200To480();
+  testFill350To600();
+  testRebuild();
+  return Test::result();
+}
@@ -0,0 +1,120 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+// Tests the MDA_RESAMPLE_640 resampler of DisplayBuffer on the simulated SDK,
+// which emulates interp1, against a per-pixel nearest-neighbour reference.
+//
+// $ ResampleTest
+//
+
+#include "Common.h"
+#include "DisplayBuffer.h"
+#include "HostSim.h"
+#include "Test.h"
+#include <memory>
+#include <random>
+#include <vector>
+
+/// \Returns the VI bits of MDA pixel \p X of \p Row.
+static uint32_t getPixel(const uint8_t *Row, uint32_t X) {
+  return (Row[X / 2] >> (4 * (X % 2))) & 0b11;
+}
+
+/// \Returns the MDA_RESAMPLE_DST pixels that resampleMDARow() gives for line
+/// \p Y, one per entry.
+static std::vector<uint32_t> resample(const DisplayBuffer &Buff, uint32_t Y,
+                                      uint32_t Start) {
+  std::vector<uint32_t> Pixels;
+  Buff.resampleMDARow(Y, Start, [&Pixels](uint32_t MDA8) {
+    for (uint32_t Px = 0; Px != 8; ++Px)
+      Pixels.push_back((MDA8 >> (4 * Px)) & 0b11);
+  });
+  return Pixels;
+}
+
+/// \Returns the MDA_RESAMPLE_DST pixels of line \p Y with nearest-neighbour.
+static std::vector<uint32_t> reference(const DisplayBuffer &Buff, uint32_t Y,
+                                       uint32_t Start) {
+  std::vector<uint32_t> Pixels;
+  for (uint32_t Col = 0; Col != MDA_RESAMPLE_DST; ++Col)
+    Pixels.push_back(
+        getPixel(Buff.getScanoutRow(Y),
+                 Start + Col * MDA_RESAMPLE_SRC / MDA_RESAMPLE_DST));
+  return Pixels;
+}
+
+/// Fills the MDA buffer with random pixels, including the unused high bits
+/// of each nibble, which the resampler must keep out of the VI bits.
+static void fillRandom(DisplayBuffer &Buff, std::mt19937 &Rand) {
+  for (uint32_t Y = 0; Y != DisplayBuffer::BuffY; ++Y)
+    for (uint32_t X = 0; X != 2 * DisplayBuffer::BuffX; ++X) {
+      Buff.setMDA(Y, X, Rand() & 0b11);
+      Buff.setBit(Y, X / 2, 4 * (X % 2) + 2 + Rand() % 2, Rand() % 2);
+    }
+}
+
+static void testStart() {
+  CHECK(DisplayBuffer::getResampleStart(MDA_RESAMPLE_SRC) == 0);
+  // Narrower lines start from the left edge.
+  CHECK(DisplayBuffer::getResampleStart(650) == 0);
+  // MDA after the auto-adjust of the borders.
+  CHECK(DisplayBuffer::getResampleStart(730) == 4);
+  // Always a whole byte.
+  CHECK(DisplayBuffer::getResampleStart(726) == 2);
+  for (uint32_t TTLH = 0; TTLH != 4 * DisplayBuffer::BuffX; ++TTLH) {
+    uint32_t Start = DisplayBuffer::getResampleStart(TTLH);
+    CHECK(Start % 2 == 0);
+    // The blocks read MDA_RESAMPLE_SRC / 2 bytes from Start / 2, plus one.
+    CHECK(Start / 2 + MDA_RESAMPLE_SRC / 2 <= DisplayBuffer::BuffX - 1);
+  }
+}
+
+static void testReference(DisplayBuffer &Buff) {
+  std::mt19937 Rand(36);
+  fillRandom(Buff, Rand);
+  for (uint32_t TTLH :
+       {650u, 720u, 724u, 730u, 737u, 2 * DisplayBuffer::BuffX})
+    for (uint32_t Y = 0; Y != DisplayBuffer::BuffY; ++Y) {
+      uint32_t Start = DisplayBuffer::getResampleStart(TTLH);
+      std::vector<uint32_t> Pixels = resample(Buff, Y, Start);
+      CHECK(Pixels.size() == MDA_RESAMPLE_DST);
+      CHECK(Pixels == reference(Buff, Y, Start));
+    }
+}
+
+static void testInterp0Untouched(DisplayBuffer &Buff) {
+  // The scanout streams the other lines with interp0.
+  DisplayBuffer::interpInit();
+  Buff.interpStartScanoutRow(1);
+  uint32_t *Word = DisplayBuffer::interpNextWord32();
+  resample(Buff, 2, 0);
+  CHECK(DisplayBuffer::interpNextWord32() == Word + 1);
+}
+
+static void testGolden(DisplayBuffer &Buff) {
+  // A fixed picture, so that any change to the resampled image is noticed.
+  Buff.clear();
+  for (uint32_t Y = 0; Y != DisplayBuffer::BuffY; ++Y)
+    for (uint32_t X = 0; X != 2 * DisplayBuffer::BuffX; ++X)
+      Buff.setMDA(Y, X, (X * 7 + Y * 3 + X / 9) & 0b11);
+  // FNV-1a of all the resampled lines.
+  uint32_t Hash = 2166136261u;
+  for (uint32_t Y = 0; Y != DisplayBuffer::BuffY; ++Y)
+    for (uint32_t VI :
+         resample(Buff, Y, DisplayBuffer::getResampleStart(730)))
+      Hash = (Hash ^ VI) * 16777619u;
+  printf("ResampleTest: golden hash 0x%08x\n", Hash);
+  CHECK(Hash == 0xba9dd9c5u);
+}
+
+int main() {
+  HostSim::reset();
+  auto Buff = std::make_unique<DisplayBuffer>();
+  DisplayBuffer::resampleInterpInit();
+  testStart();
+  testReference(*Buff);
+  testInterp0Untouched(*Buff);
+  testGolden(*Buff);
+  return Test::result();
+}
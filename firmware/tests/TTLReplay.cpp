@@ -0,0 +1,266 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+// Replays a GPIO trace into the capture code of the firmware, built for the
+// host on top of the simulated SDK of sdk/, and writes the frames that it
+// leaves in the DisplayBuffer. tools/replay.py converts the logic analyzer
+// recordings to traces and reads the frames back.
+//
+// $ TTLReplay [--time] [--generic-capture] <trace> <frames>
+//
+// --time prints the host time of the capture loops per FIFO read, without the
+// simulation, at the end. --generic-capture runs the presets through the
+// generic capture loop too, so the two tell how much the specialized loops
+// save. These are host numbers, the Pico's are different.
+//
+// Each frame is the DisplayBuffer at the end of a VSync retrace of the input,
+// when the capture of the previous frame is complete:
+//   "MCEF", uint64_t microseconds since the start of the trace,
+//   uint16_t width, uint16_t height, uint8_t name length, the mode name,
+//   uint8_t HalfRate, then width * height RGB pixels.
+// All little-endian.
+//
+
+#include "Common.h"
+#include "DisplayBuffer.h"
+#include "Flash.h"
+#include "HostSim.h"
+#include "NoInputSignal.pio.h"
+#include "Pico.h"
+#include "PioProgramLoader.h"
+#include "SyncPeriod.pio.h"
+#include "TTLReader.h"
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const char *PresetNames[] = {
+#define DEF_TTL(NAME, ...) #NAME,
+#include "TimingsTTL.def"
+};
+
+/// \Returns the cycles at which the VSync retraces of the trace end. The
+/// retrace is the shorter phase of VSync, which is per frame because the
+/// polarity changes with the mode.
+static std::vector<uint64_t> findRetraceEnds(uint64_t Cycle) {
+  std::vector<uint64_t> Edges = {Cycle};
+  bool Level = HostSim::findLevel(TTL_VSYNC_GPIO, true, Cycle) == Cycle;
+  while ((Cycle = HostSim::findLevel(TTL_VSYNC_GPIO, Level = !Level, Cycle)) !=
+         UINT64_MAX)
+    Edges.push_back(Cycle);
+  std::vector<uint64_t> Ends;
+  for (size_t Idx = 1; Idx < Edges.size(); ++Idx) {
+    uint64_t Phase = Edges[Idx] - Edges[Idx - 1];
+    bool ShorterThanPrev = Idx < 2 || Phase < Edges[Idx - 1] - Edges[Idx - 2];
+    bool ShorterThanNext =
+        Idx + 1 == Edges.size() || Phase < Edges[Idx + 1] - Edges[Idx];
+    if (ShorterThanPrev && ShorterThanNext)
+      Ends.push_back(Edges[Idx]);
+  }
+  return Ends;
+}
+
+/// \Returns the 2-bit color level \p Val as 8 bits.
+static uint8_t to8Bit(uint32_t Val) { return (Val & 0b11) * 0x55; }
+
+class FrameWriter {
+  FILE *File;
+  const DisplayBuffer &Buff;
+  const TTLReader *TTLR = nullptr;
+  uint64_t StartCycle;
+  uint32_t Frames = 0;
+
+  void put(uint64_t Val, int Bytes) {
+    for (int Idx = 0; Idx != Bytes; ++Idx)
+      fputc((Val >> (8 * Idx)) & 0xff, File);
+  }
+
+public:
+  FrameWriter(FILE *File, const DisplayBuffer &Buff)
+      : File(File), Buff(Buff), StartCycle(HostSim::now()) {}
+  void setReader(const TTLReader *R) { TTLR = R; }
+  uint32_t getFrames() const { return Frames; }
+
+  /// Writes the frame that is in the buffer now.
+  void write() {
+    if (TTLR == nullptr)
+      return;
+    const TTLDescr &Mode = TTLR->getMode();
+    bool HalfRate = TTLR->getHalfRate();
+    uint32_t W = Mode.H_Visible;
+    uint32_t H = std::min(Mode.V_Visible, DisplayBuffer::BuffY);
+    int Preset = getPresetIdx(Mode);
+    std::string Name = Preset != GenericPreset
+                           ? PresetNames[Preset]
+                           : std::string(modeToStr(Mode.Mode)) + "_" +
+                                 std::to_string(W) + "x" + std::to_string(H);
+    fwrite("MCEF", 1, 4, File);
+    put((HostSim::now() - StartCycle) * 1000000 / HostSim::getSysHz(), 8);
+    put(W, 2);
+    put(H, 2);
+    put(Name.size(), 1);
+    fwrite(Name.data(), 1, Name.size(), File);
+    put(HalfRate, 1);
+    std::vector<uint8_t> RGB;
+    RGB.reserve(W * H * 3);
+    for (uint32_t Y = 0; Y != H; ++Y) {
+      const uint8_t *Row = Buff.getScanoutRow(Y);
+      for (uint32_t X = 0; X != W; ++X) {
+        uint32_t Px;
+        if (Mode.Mode == TTL::MDA) {
+          // Two pixels per byte, 00VI each, copied to RR, GG and BB.
+          uint32_t Byte = Buff.getMDAXOffset() + X / 2;
+          uint32_t VI =
+              Byte < DisplayBuffer::BuffX ? (Row[Byte] >> (4 * (X % 2))) & 3 : 0;
+          Px = VI | VI << 2 | VI << 4;
+        } else {
+          uint32_t Byte = HalfRate ? X / 2 : X;
+          Px = Byte < DisplayBuffer::BuffX ? Row[Byte] : 0;
+        }
+        RGB.push_back(to8Bit(Px >> 4));
+        RGB.push_back(to8Bit(Px >> 2));
+        RGB.push_back(to8Bit(Px));
+      }
+    }
+    fwrite(RGB.data(), 1, RGB.size(), File);
+    ++Frames;
+  }
+};
+
+int main(int argc, char **argv) {
+  bool Time = false;
+  bool GenericCapture = false;
+  int Arg = 1;
+  for (; Arg < argc && argv[Arg][0] == '-'; ++Arg) {
+    if (strcmp(argv[Arg], "--time") == 0)
+      Time = true;
+    else if (strcmp(argv[Arg], "--generic-capture") == 0)
+      GenericCapture = true;
+    else
+      break;
+  }
+  if (argc - Arg != 2) {
+    fprintf(stderr,
+            "Usage: %s [--time] [--generic-capture] <trace> <frames>\n",
+            argv[0]);
+    return 1;
+  }
+  const char *TracePath = argv[Arg];
+  const char *FramesPath = argv[Arg + 1];
+  HostSim::reset();
+  if (Time)
+    HostSim::timeFifoGaps();
+  HostSim::Trace T;
+  std::string Err;
+  if (!HostSim::readTraceFile(TracePath, T, Err)) {
+    fprintf(stderr, "%s\n", Err.c_str());
+    return 1;
+  }
+  FILE *Out = fopen(FramesPath, "wb");
+  if (Out == nullptr) {
+    fprintf(stderr, "Can't write %s\n", FramesPath);
+    return 1;
+  }
+  auto WallStart = std::chrono::steady_clock::now();
+  uint64_t StartCycle = 0;
+
+  // Like main().
+  Pico Pi;
+  Pi.initGPIO(AUTO_ADJUST_GPIO, GPIO_IN, Pico::Pull::Up, "AutoAdjust");
+  Pi.initGPIO(PinRange(EGA_RGB_GPIO, EGA_RGB_GPIO + 6), GPIO_IN,
+              Pico::Pull::Up, "EGA");
+  Pi.initGPIO(PinRange(TTL_VSYNC_GPIO), GPIO_IN, Pico::Pull::Up, "TTL_VSync");
+  Pi.initGPIO(PinRange(TTL_HSYNC_GPIO), GPIO_IN, Pico::Pull::Up, "TTL_HSync");
+  Pi.initGPIO(PinRange(CGA_ACTUAL_RGB_GPIO, CGA_ACTUAL_RGB_GPIO + 6), GPIO_IN,
+              Pico::Pull::Up, "CGA");
+  Pi.initGPIO(PinRange(MDA_VI_GPIO, MDA_VI_GPIO + 2), GPIO_IN, Pico::Pull::Up,
+              "MDA");
+  FlashStorage Flash;
+  PioProgramLoader PioLoader;
+  // Too big for the stack.
+  auto Buff = std::make_unique<DisplayBuffer>();
+
+  // Like the VGAWriter constructor. TTLReader sets the mode of the buffer.
+  Buff->clear();
+  PIO NoInputSignalPio = pio1;
+  uint NoInputSignalSM = pio_claim_unused_sm(NoInputSignalPio, true);
+  uint NoInputSignalOffset =
+      pio_add_program(NoInputSignalPio, &NoInputSignal_program);
+  noInputSignalPioConfig(NoInputSignalPio, NoInputSignalSM,
+                         NoInputSignalOffset, TTL_HSYNC_GPIO);
+  pio_sm_set_enabled(NoInputSignalPio, NoInputSignalSM, true);
+  PIO SyncPeriodPio = pio0;
+  uint SyncPeriodOffset = pio_add_program(SyncPeriodPio, &SyncPeriod_program);
+  uint VSyncPeriodSM = pio_claim_unused_sm(SyncPeriodPio, true);
+  SyncPeriodPioConfig(SyncPeriodPio, VSyncPeriodSM, SyncPeriodOffset,
+                      TTL_VSYNC_GPIO);
+  uint HSyncPeriodSM = pio_claim_unused_sm(SyncPeriodPio, true);
+  SyncPeriodPioConfig(SyncPeriodPio, HSyncPeriodSM, SyncPeriodOffset,
+                      TTL_HSYNC_GPIO);
+
+  StartCycle = HostSim::now();
+  HostSim::loadTrace(T);
+  FrameWriter Frames(Out, *Buff);
+  for (uint64_t Cycle : findRetraceEnds(HostSim::now()))
+    HostSim::at(Cycle, [&Frames]() { Frames.write(); });
+
+  // Core0 checks for the input signal once per VGA frame, like
+  // VGAWriter::checkInputSignal().
+  TTLReader *TTLR = nullptr;
+  bool NoSignal = false;
+  const uint64_t VGAFrameCycles = HostSim::getSysHz() / 60;
+  std::function<void()> CheckInputSignal = [&]() {
+    if (TTLR != nullptr) {
+      if (pio_sm_is_rx_fifo_empty(NoInputSignalPio, NoInputSignalSM)) {
+        if (!NoSignal)
+          TTLR->setNoSignal(NoSignal = true);
+      } else {
+        if (NoSignal)
+          TTLR->setNoSignal(NoSignal = false);
+        while (!pio_sm_is_rx_fifo_empty(NoInputSignalPio, NoInputSignalSM))
+          pio_sm_get(NoInputSignalPio, NoInputSignalSM);
+      }
+    }
+    HostSim::at(HostSim::now() + VGAFrameCycles, CheckInputSignal);
+  };
+  HostSim::at(HostSim::now() + VGAFrameCycles, CheckInputSignal);
+
+  std::unique_ptr<TTLReader> Reader;
+  try {
+    Reader = std::make_unique<TTLReader>(PioLoader, Pi, Flash, *Buff,
+                                         SyncPeriodPio, VSyncPeriodSM,
+                                         HSyncPeriodSM, SyncPeriodOffset,
+                                         /*ResetToDefaults=*/false);
+    TTLR = Reader.get();
+    // Like VGAWriter::startCore1TTLReader().
+    TTLR->setNoSignal(NoSignal);
+    TTLR->setGenericCapture(GenericCapture);
+    Frames.setReader(TTLR);
+    TTLR->runForEver();
+  } catch (HostSim::EndOfTrace &) {
+  }
+  fclose(Out);
+
+  double WallSecs = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - WallStart)
+                        .count();
+  const HostSim::Stats &Stats = HostSim::getStats();
+  fprintf(stderr,
+          "TTLReplay: %u frames, %.3fs simulated in %.3fs, %llu PIO steps, "
+          "%llu skipped, %llu DMA words\n",
+          Frames.getFrames(),
+          (double)(HostSim::now() - StartCycle) / HostSim::getSysHz(), WallSecs,
+          (unsigned long long)Stats.PioSteps,
+          (unsigned long long)Stats.PioSkips,
+          (unsigned long long)Stats.DmaWords);
+  if (Time && HostSim::getFifoGaps() != 0)
+    fprintf(stderr,
+            "TTLReplay: %s capture loops: %.2fns per FIFO read on the "
+            "host, %llu reads\n",
+            GenericCapture ? "generic" : "specialized", HostSim::getFifoGapNs(),
+            (unsigned long long)HostSim::getFifoGaps());
+  return 0;
+}
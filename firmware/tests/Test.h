@@ -0,0 +1,37 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+
+#ifndef __TESTS_TEST_H__
+#define __TESTS_TEST_H__
+
+#include <cstdio>
+
+/// A minimal checker for the host tests. A failing CHECK() prints the
+/// condition and the test keeps going, so one run shows all the failures.
+namespace Test {
+inline int &failures() {
+  static int Cnt = 0;
+  return Cnt;
+}
+/// \Returns the exit code of the test.
+inline int result() {
+  if (failures() != 0) {
+    fprintf(stderr, "%d checks failed\n", failures());
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
+} // namespace Test
+
+#define CHECK(COND)                                                            \
+  do {                                                                         \
+    if (!(COND)) {                                                             \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #COND); \
+      ++Test::failures();                                                      \
+    }                                                                          \
+  } while (0)
+
+#endif // __TESTS_TEST_H__
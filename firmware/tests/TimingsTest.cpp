@@ -0,0 +1,276 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+// Tests the mode detection and the synthesized and learned modes of
+// Timings.cpp.
+//
+// $ TimingsTest
+//
+
+#include "Common.h"
+#include "Test.h"
+#include "Timings.h"
+#include <cmath>
+
+/// \Returns true if the vertical timings of \p Descr add up to \p Lines.
+static bool linesAddUp(const TTLDescr &Descr, uint32_t Lines) {
+  return Descr.V_FrontPorch + Descr.V_Visible - YB + Descr.V_BackPorch ==
+         Lines;
+}
+
+static TTLFeatures getFeatures(float V_Hz, float H_Hz, uint32_t Lines,
+                               Polarity VPol, Polarity HPol,
+                               std::optional<uint32_t> PinActivity) {
+  TTLFeatures F;
+  F.V_Hz = V_Hz;
+  F.H_Hz = H_Hz;
+  F.Lines = Lines;
+  F.V_SyncPolarity = VPol;
+  F.H_SyncPolarity = HPol;
+  F.PinActivity = PinActivity;
+  return F;
+}
+
+/// \Returns the nominal features of preset \p Idx.
+static TTLFeatures getPresetFeatures(int Idx,
+                                     std::optional<uint32_t> PinActivity) {
+  const TTLDescr &P = PresetTimingsTTL[Idx];
+  return getFeatures(P.V_Hz, P.H_Hz,
+                     (uint32_t)(P.H_Hz / P.V_Hz) - P.V_Retrace,
+                     P.V_SyncPolarity, P.H_SyncPolarity, PinActivity);
+}
+
+static constexpr const uint32_t RGB = PinActivityRGB;
+static constexpr const uint32_t RGBI2 =
+    PinActivityRGB | PinActivitySecondaryRed;
+static constexpr const uint32_t Mono = PinActivityMono;
+static constexpr const int NoMatch = GenericPreset;
+
+static void testClassifyMode() {
+  const TTLFeatures CGA = getPresetFeatures(CGA_640x200_60Hz, std::nullopt);
+  const TTLFeatures EGA350 = getPresetFeatures(EGA_640x350_60Hz, std::nullopt);
+  const TTLFeatures MDA = getPresetFeatures(MDA_720x350_50Hz, std::nullopt);
+  /// \Returns \p F with some of the features changed.
+  auto with = [](TTLFeatures F, auto Change) {
+    Change(F);
+    return F;
+  };
+  auto pins = [&with](const TTLFeatures &F, std::optional<uint32_t> Pins) {
+    return with(F, [Pins](TTLFeatures &F) { F.PinActivity = Pins; });
+  };
+  struct {
+    const char *Name;
+    TTLFeatures F;
+    int PresetIdx;
+    bool Ambiguous;
+  } Tests[] = {
+      // Each preset with its nominal features and pins.
+      {"MDA", pins(MDA, Mono), MDA_720x350_50Hz, false},
+      {"CGA", pins(CGA, RGB), CGA_640x200_60Hz, false},
+      {"EGA200", pins(CGA, RGBI2), EGA_640x200_60Hz, false},
+      {"EGA350", pins(EGA350, RGBI2), EGA_640x350_60Hz, false},
+      // Without the pins CGA and EGA200 tie and the first one wins, but we
+      // need to look at the pins.
+      {"CGA/EGA200 tie", CGA, CGA_640x200_60Hz, true},
+      {"MDA no pins", MDA, MDA_720x350_50Hz, false},
+      {"EGA350 no pins", EGA350, EGA_640x350_60Hz, false},
+      // Each pin activity class on the CGA/EGA200 timings. EGA200 is only
+      // preferred with the secondary red, blank or mono signals are CGA.
+      {"CGA blank", pins(CGA, 0u), CGA_640x200_60Hz, false},
+      {"CGA mono", pins(CGA, Mono), CGA_640x200_60Hz, false},
+      {"CGA RGB+mono", pins(CGA, RGB | Mono), CGA_640x200_60Hz, false},
+      // The pins don't override the timings of the other families.
+      {"MDA RGB", pins(MDA, RGB), MDA_720x350_50Hz, false},
+      {"EGA350 mono", pins(EGA350, Mono), EGA_640x350_60Hz, false},
+      // Off-nominal, within the limits.
+      {"CGA off-nominal",
+       with(pins(CGA, RGB),
+            [](TTLFeatures &F) {
+              F.V_Hz += 0.9f;
+              F.H_Hz -= 900;
+              F.Lines += 7;
+            }),
+       CGA_640x200_60Hz, false},
+      {"MDA off-nominal",
+       with(pins(MDA, Mono),
+            [](TTLFeatures &F) {
+              F.V_Hz -= 0.9f;
+              F.H_Hz += 900;
+              F.Lines -= 7;
+            }),
+       MDA_720x350_50Hz, false},
+      // Past the limits of each feature.
+      {"V_Hz too far", with(CGA, [](TTLFeatures &F) { F.V_Hz += 1.1f; }),
+       NoMatch, false},
+      {"H_Hz too far", with(CGA, [](TTLFeatures &F) { F.H_Hz += 1100; }),
+       NoMatch, false},
+      {"Lines too far", with(EGA350, [](TTLFeatures &F) { F.Lines -= 9; }),
+       NoMatch, false},
+      // Flipped polarities add a penalty but don't reject the only match.
+      {"EGA350 flipped",
+       with(EGA350,
+            [](TTLFeatures &F) {
+              F.V_SyncPolarity = Pos;
+              F.H_SyncPolarity = Neg;
+            }),
+       EGA_640x350_60Hz, false},
+      {"MDA flipped",
+       with(MDA,
+            [](TTLFeatures &F) {
+              F.V_SyncPolarity = Pos;
+              F.H_SyncPolarity = Neg;
+            }),
+       MDA_720x350_50Hz, false},
+      // With only V_Hz known the polarities pick between the 60Hz presets.
+      {"60Hz V+",
+       with(CGA,
+            [](TTLFeatures &F) {
+              F.H_Hz = 0;
+              F.Lines = 0;
+            }),
+       CGA_640x200_60Hz, true},
+      {"60Hz V-",
+       with(EGA350,
+            [](TTLFeatures &F) {
+              F.H_Hz = 0;
+              F.Lines = 0;
+            }),
+       EGA_640x350_60Hz, false},
+  };
+  for (const auto &T : Tests) {
+    std::optional<TTLMatch> Match = classifyMode(T.F);
+    int Idx = Match ? Match->PresetIdx : NoMatch;
+    if (Idx != T.PresetIdx || (Match && Match->Ambiguous != T.Ambiguous)) {
+      fprintf(stderr, "%s: got preset %d ambiguous %d\n", T.Name, Idx,
+              Match && Match->Ambiguous);
+      CHECK(false);
+      continue;
+    }
+    if (!Match)
+      continue;
+    // The capture follows the measured polarities.
+    CHECK(Match->Descr.V_SyncPolarity == T.F.V_SyncPolarity);
+    CHECK(Match->Descr.H_SyncPolarity == T.F.H_SyncPolarity);
+    CHECK(Match->Descr.Mode == PresetTimingsTTL[T.PresetIdx].Mode);
+  }
+}
+
+static void testSynthesizeMode() {
+  // Each family, from the pin activity and the HSync frequency.
+  struct {
+    TTLFeatures F;
+    TTL Mode;
+  } Tests[] = {
+      {getFeatures(50, 18430, 360, Neg, Pos, PinActivityMono), TTL::MDA},
+      {getFeatures(60, 15700, 250, Pos, Pos, PinActivityRGB), TTL::CGA},
+      {getFeatures(60, 15700, 250, Pos, Pos, std::nullopt), TTL::CGA},
+      {getFeatures(60, 21850, 360, Neg, Pos, PinActivityRGB), TTL::EGA},
+  };
+  for (const auto &T : Tests) {
+    // With the first/last non-empty lines.
+    TTLDescr Descr = synthesizeMode(T.F, 20, 219);
+    CHECK(Descr.Mode == T.Mode);
+    CHECK(Descr.V_FrontPorch == 20);
+    CHECK(Descr.V_Visible == 200 + YB);
+    CHECK(linesAddUp(Descr, T.F.Lines));
+    CHECK(Descr.V_SyncPolarity == T.F.V_SyncPolarity);
+    CHECK(Descr.H_SyncPolarity == T.F.H_SyncPolarity);
+    CHECK(Descr.V_Retrace ==
+          (uint32_t)std::lround(T.F.H_Hz / T.F.V_Hz) - T.F.Lines);
+
+    // Without them we fall back to the preset's visible lines.
+    for (uint32_t LastLine : {0u, T.F.Lines}) {
+      Descr = synthesizeMode(T.F, 1, LastLine);
+      CHECK(Descr.Mode == T.Mode);
+      CHECK(linesAddUp(Descr, T.F.Lines));
+    }
+  }
+  // Fewer lines than the preset's visible ones.
+  TTLFeatures F = getFeatures(60, 15700, 150, Pos, Pos, PinActivityRGB);
+  TTLDescr Descr = synthesizeMode(F, 1, 0);
+  CHECK(Descr.V_Visible == 150 + YB);
+  CHECK(linesAddUp(Descr, F.Lines));
+}
+
+static void testPackRoundTrip() {
+  for (TTL Mode : {TTL::MDA, TTL::CGA, TTL::EGA})
+    for (Polarity VPol : {Pos, Neg})
+      for (Polarity HPol : {Pos, Neg}) {
+        LearnedTTL L;
+        L.V_Hz = 59.92f;
+        L.Lines = 1023;
+        L.V_SyncPolarity = VPol;
+        L.H_SyncPolarity = HPol;
+        L.Mode = Mode;
+        L.H_Visible = 2047;
+        L.V_Visible = 1023;
+        L.V_FrontPorch = 511;
+        auto [Sync, Size] = L.pack();
+        std::optional<LearnedTTL> U = LearnedTTL::unpack(Sync, Size);
+        CHECK(U.has_value());
+        if (!U)
+          continue;
+        // V_Hz is stored in hundredths.
+        CHECK(std::abs(U->V_Hz - L.V_Hz) <= 0.01f);
+        CHECK(U->Lines == L.Lines);
+        CHECK(U->V_SyncPolarity == VPol);
+        CHECK(U->H_SyncPolarity == HPol);
+        CHECK(U->Mode == Mode);
+        CHECK(U->H_Visible == L.H_Visible);
+        CHECK(U->V_Visible == L.V_Visible);
+        CHECK(U->V_FrontPorch == L.V_FrontPorch);
+      }
+}
+
+static void testUnpackInvalid() {
+  // Erased and zeroed flash.
+  CHECK(!LearnedTTL::unpack(0xffffffff, 0xffffffff));
+  CHECK(!LearnedTTL::unpack(0, 0));
+  LearnedTTL L;
+  L.V_Hz = 60;
+  L.Lines = 250;
+  auto [Sync, Size] = L.pack();
+  CHECK(LearnedTTL::unpack(Sync, Size));
+  // Either word erased or zeroed.
+  CHECK(!LearnedTTL::unpack(Sync, 0xffffffff));
+  CHECK(!LearnedTTL::unpack(0xffffffff, Size));
+  CHECK(!LearnedTTL::unpack(0, Size));
+  // There is no fourth mode.
+  CHECK(!LearnedTTL::unpack(Sync | 0x3u << 24, Size));
+}
+
+static void testLearnedDescr() {
+  // A learned mode gives back the synthesized timings after a trip through
+  // flash.
+  TTLFeatures F = getFeatures(60, 21850, 360, Neg, Pos, PinActivityRGB);
+  TTLDescr Descr = synthesizeMode(F, 7, 356);
+  auto [Sync, Size] = LearnedTTL(F, Descr).pack();
+  std::optional<LearnedTTL> L = LearnedTTL::unpack(Sync, Size);
+  CHECK(L.has_value());
+  if (!L)
+    return;
+  CHECK(L->matches(F));
+  TTLDescr Learned = L->getDescr(F);
+  CHECK(Learned.Mode == Descr.Mode);
+  CHECK(Learned.H_Visible == Descr.H_Visible);
+  CHECK(Learned.V_FrontPorch == Descr.V_FrontPorch);
+  CHECK(Learned.V_Visible == Descr.V_Visible);
+  CHECK(Learned.V_BackPorch == Descr.V_BackPorch);
+  // Too far from the learned features.
+  TTLFeatures Other = F;
+  Other.Lines += AUTO_DETECT_MODE_LINES_ERROR + 1;
+  CHECK(!L->matches(Other));
+  Other = F;
+  Other.V_SyncPolarity = Pos;
+  CHECK(!L->matches(Other));
+}
+
+int main() {
+  testClassifyMode();
+  testSynthesizeMode();
+  testPackRoundTrip();
+  testUnpackInvalid();
+  testLearnedDescr();
+  return Test::result();
+}
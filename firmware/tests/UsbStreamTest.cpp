@@ -0,0 +1,371 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+// Tests the USB_STREAM encoder of UsbStream.cpp on the simulated SDK and
+// prints how many frames per second it streams.
+//
+// $ UsbStreamTest [<stream> <lines>]
+//
+// With the arguments it also saves a stream and the picture that decoding it
+// must give, one byte per pixel, so that tools/usbstream.py can be checked
+// against the encoder.
+//
+
+#include "Bitmaps.h"
+#include "Common.h"
+#include "DisplayBuffer.h"
+#include "HostSim.h"
+#include "Test.h"
+#include "UsbStream.h"
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+#ifndef USB_STREAM
+#error "UsbStreamTest needs the config.h of USB_STREAM"
+#endif
+
+/// What the tests assume that the host reads, about what full-speed USB CDC
+/// gets in practice.
+static constexpr const uint32_t UsbBytesPerSec = 1000000;
+
+static const TTLDescr &EGA350 = PresetTimingsTTL[EGA_640x350_60Hz];
+
+/// \Returns the line that decodes from the \p Sz bytes at \p Src, or an empty
+/// one if they are corrupt.
+static std::vector<uint8_t> decodeLine(const uint8_t *Src, uint32_t Sz) {
+  std::vector<uint8_t> Line;
+  for (uint32_t Idx = 0; Idx != Sz;) {
+    uint8_t Ctrl = Src[Idx++];
+    uint32_t Cnt = Ctrl < 0x80 ? Ctrl + 1 : 1;
+    if (Idx + Cnt > Sz)
+      return {};
+    if (Ctrl < 0x80)
+      Line.insert(Line.end(), &Src[Idx], &Src[Idx + Cnt]);
+    else
+      Line.insert(Line.end(), Ctrl - 126, Src[Idx]);
+    Idx += Cnt;
+  }
+  return Line;
+}
+
+static std::vector<uint8_t> encodeLine(const std::vector<uint8_t> &Line) {
+  std::vector<uint8_t> Out(UsbStream::MaxLineSz);
+  Out.resize(UsbStream::encodeLine(Line.data(), Line.size(), Out.data()));
+  return Out;
+}
+
+static void testEncodeLine() {
+  using Bytes = std::vector<uint8_t>;
+  // The format, byte by byte.
+  CHECK(encodeLine({}) == Bytes());
+  CHECK(encodeLine({7}) == Bytes({0x00, 7}));
+  CHECK(encodeLine({7, 7}) == Bytes({0x80, 7}));
+  CHECK(encodeLine({1, 2, 3}) == Bytes({0x02, 1, 2, 3}));
+  // Runs of 2 stay in the literal, runs of 3 end it.
+  CHECK(encodeLine({1, 2, 2, 3}) == Bytes({0x03, 1, 2, 2, 3}));
+  CHECK(encodeLine({1, 2, 2, 2, 3}) == Bytes({0x00, 1, 0x81, 2, 0x00, 3}));
+  CHECK(encodeLine(Bytes(UsbStream::MaxRun, 5)) == Bytes({0xff, 5}));
+  CHECK(encodeLine(Bytes(UsbStream::MaxRun + 1, 5)) ==
+        Bytes({0xff, 5, 0x00, 5}));
+  Bytes Literal;
+  for (uint32_t Idx = 0; Idx != UsbStream::MaxLiteral + 1; ++Idx)
+    Literal.push_back(Idx);
+  Bytes Want = {0x7f};
+  Want.insert(Want.end(), Literal.begin(), Literal.end() - 1);
+  Want.insert(Want.end(), {0x00, (uint8_t)UsbStream::MaxLiteral});
+  CHECK(encodeLine(Literal) == Want);
+
+  // Random lines of few colors, and the worst case.
+  std::mt19937 Rand(0);
+  for (uint32_t Cnt = 0; Cnt != 1000; ++Cnt) {
+    Bytes Line(Rand() % (DisplayBuffer::BuffX + 1));
+    uint32_t Colors = 1 + Rand() % 8;
+    for (uint8_t &Val : Line)
+      Val = Rand() % Colors;
+    Bytes Enc = encodeLine(Line);
+    CHECK(Enc.size() <= UsbStream::MaxLineSz);
+    CHECK(decodeLine(Enc.data(), Enc.size()) == Line);
+  }
+  Bytes Worst;
+  for (uint32_t Idx = 0; Idx != DisplayBuffer::BuffX; ++Idx)
+    Worst.push_back(Idx % 2 + (Idx / 256));
+  CHECK(encodeLine(Worst).size() == UsbStream::MaxLineSz);
+}
+
+/// The host end of the stream: collects the bytes and decodes the frames.
+struct Host {
+  std::vector<uint8_t> Bytes;
+  /// The time when Bytes reached each size, to tell when each frame arrived.
+  std::vector<std::pair<size_t, uint64_t>> Arrivals;
+
+  struct Frame {
+    uint8_t Mode, Flags;
+    uint16_t Width, Height, BytesPerLine;
+    uint32_t FrameCnt;
+    /// The picture after the frame, with the lines of earlier frames.
+    std::vector<std::vector<uint8_t>> Lines;
+    /// The bytes of the frame and when its last byte arrived.
+    size_t Sz;
+    uint64_t Cycle;
+  };
+
+  void connect() {
+    HostSim::connectUsb(UsbBytesPerSec, [this](const char *Buf, int Sz) {
+      Bytes.insert(Bytes.end(), Buf, Buf + Sz);
+      Arrivals.push_back({Bytes.size(), HostSim::now()});
+    });
+  }
+
+  static uint32_t get(const uint8_t *Ptr, int Sz) {
+    uint32_t Val = 0;
+    for (int Idx = Sz - 1; Idx >= 0; --Idx)
+      Val = Val << 8 | Ptr[Idx];
+    return Val;
+  }
+
+  /// Decodes the frames that arrived completely.
+  std::vector<Frame> decode() const {
+    std::vector<Frame> Frames;
+    std::vector<std::vector<uint8_t>> Lines;
+    size_t Pos = 0;
+    const uint8_t *B = Bytes.data();
+    while (Bytes.size() - Pos >= UsbStream::HeaderSz) {
+      size_t Start = Pos;
+      Frame F;
+      CHECK(memcmp(&B[Pos], "MCEF", 4) == 0);
+      CHECK(B[Pos + 4] == UsbStream::FormatVersion);
+      F.Mode = B[Pos + 5];
+      F.Flags = B[Pos + 6];
+      F.Width = get(&B[Pos + 8], 2);
+      F.Height = get(&B[Pos + 10], 2);
+      F.BytesPerLine = get(&B[Pos + 12], 2);
+      F.FrameCnt = get(&B[Pos + 20], 4);
+      Pos += UsbStream::HeaderSz;
+      if (Lines.size() != F.Height)
+        Lines.assign(F.Height, std::vector<uint8_t>(F.BytesPerLine));
+      while (true) {
+        if (Bytes.size() - Pos < 2)
+          return Frames;
+        uint32_t Line = get(&B[Pos], 2);
+        if (Line == UsbStream::EndOfFrame) {
+          Pos += 2;
+          break;
+        }
+        if (Bytes.size() - Pos < 4)
+          return Frames;
+        uint32_t Sz = get(&B[Pos + 2], 2);
+        if (Bytes.size() - Pos < 4 + Sz)
+          return Frames;
+        CHECK(Line < F.Height);
+        std::vector<uint8_t> Data = decodeLine(&B[Pos + 4], Sz);
+        CHECK(Data.size() == F.BytesPerLine);
+        if (Line < F.Height)
+          Lines[Line] = Data;
+        Pos += 4 + Sz;
+      }
+      F.Lines = Lines;
+      F.Sz = Pos - Start;
+      F.Cycle = std::lower_bound(Arrivals.begin(), Arrivals.end(),
+                                 std::make_pair(Pos, (uint64_t)0))
+                    ->second;
+      Frames.push_back(std::move(F));
+    }
+    return Frames;
+  }
+};
+
+/// Drives the stream like TTLReader::runForEver() with an EGA 640x350 input:
+/// the picture changes during the capture, and UsbStream::frameTick() runs
+/// in the VSync retrace that follows.
+class Capture {
+  /// The trace is only VSync, which is what frameTick() checks.
+  static constexpr const uint32_t RetraceLevel = 0;
+
+public:
+  std::unique_ptr<DisplayBuffer> Buff = std::make_unique<DisplayBuffer>();
+  UsbStream Stream{*Buff};
+  Host H;
+  /// How far frameTick() ran into the capture of the next frame.
+  uint64_t MaxOverrunCycles = 0;
+  uint32_t TTLFrames = 0;
+
+  Capture(uint32_t Secs) {
+    HostSim::reset();
+    Buff->setMode(EGA350);
+    Buff->clear();
+    HostSim::Trace T;
+    T.Driven = 1u << TTL_VSYNC_GPIO;
+    const uint64_t FramePs = 1000000000000ull / (uint64_t)EGA350.V_Hz;
+    const uint64_t RetracePs =
+        EGA350.V_Retrace * 1000000000000ull / (uint64_t)EGA350.H_Hz;
+    for (uint64_t Frame = 0; Frame != Secs * (uint64_t)EGA350.V_Hz; ++Frame) {
+      T.TimesPs.push_back(Frame * FramePs);
+      T.States.push_back(RetraceLevel << TTL_VSYNC_GPIO);
+      T.TimesPs.push_back(Frame * FramePs + RetracePs);
+      T.States.push_back(!RetraceLevel << TTL_VSYNC_GPIO);
+    }
+    HostSim::loadTrace(T);
+    H.connect();
+  }
+
+  uint8_t (*frameBuffer())[DisplayBuffer::BuffX] {
+    uint32_t Words;
+    return (uint8_t(*)[DisplayBuffer::BuffX])Buff->borrowRAM(Words);
+  }
+
+  /// Streams TTL frames until the end of the trace. \p Draw changes the
+  /// picture during the capture of each frame.
+  void run(const std::function<void(uint32_t)> &Draw) {
+    while (true) {
+      uint64_t CaptureStart =
+          HostSim::findLevel(TTL_VSYNC_GPIO, !RetraceLevel, HostSim::now());
+      if (CaptureStart == UINT64_MAX)
+        break;
+      uint64_t CaptureEnd =
+          HostSim::findLevel(TTL_VSYNC_GPIO, RetraceLevel, CaptureStart);
+      if (CaptureEnd == UINT64_MAX)
+        break;
+      HostSim::advance(CaptureEnd - HostSim::now());
+      Draw(TTLFrames++);
+      Stream.frameTick(EGA350, /*HalfRate=*/false, /*InputActive=*/true,
+                       make_timeout_time_us(USB_STREAM_MAX_TICK_US));
+      uint64_t NextCapture =
+          HostSim::findLevel(TTL_VSYNC_GPIO, !RetraceLevel, CaptureEnd);
+      if (HostSim::now() > NextCapture)
+        MaxOverrunCycles =
+            std::max(MaxOverrunCycles, HostSim::now() - NextCapture);
+    }
+  }
+
+  /// \Returns true if the host shows what the frame buffer holds.
+  bool hostIsCurrent() const {
+    std::vector<Host::Frame> Frames = H.decode();
+    if (Frames.empty())
+      return false;
+    const Host::Frame &Last = Frames.back();
+    for (uint32_t Y = 0; Y != Last.Height; ++Y)
+      if (memcmp(Last.Lines[Y].data(), Buff->getScanoutRow(Y),
+                 Last.BytesPerLine) != 0)
+        return false;
+    return true;
+  }
+};
+
+/// Draws an 80x25 text screen of 8x14 cells in the frame buffer.
+static void drawText(Capture &C, uint32_t Seed) {
+  std::mt19937 Rand(Seed);
+  for (uint32_t Row = 0; Row != 25; ++Row)
+    for (uint32_t Col = 0; Col != 80; ++Col)
+      C.Buff->displayChar(' ' + Rand() % 95, Col * BMapWidth, Row * 14,
+                          C.frameBuffer(), 0b101010, 0b000001);
+}
+
+/// Prints the frame rate of the stream between the first key frame and the
+/// end.
+static void report(const char *Name, const Capture &C) {
+  std::vector<Host::Frame> Frames = C.H.decode();
+  if (Frames.size() < 2) {
+    printf("%-24s key frame %5zu bytes, not sent\n", Name,
+           Frames.empty() ? (size_t)0 : Frames[0].Sz);
+    return;
+  }
+  double KeySecs = (double)Frames[0].Cycle / HostSim::getSysHz();
+  double Secs = (double)(Frames.back().Cycle - Frames[0].Cycle) /
+                HostSim::getSysHz();
+  size_t Bytes = 0, Deltas = 0;
+  for (size_t Idx = 1; Idx != Frames.size(); ++Idx) {
+    if (Frames[Idx].Flags & UsbStream::FlagKeyFrame)
+      continue;
+    Bytes += Frames[Idx].Sz;
+    ++Deltas;
+  }
+  printf("%-24s key frame %5zu bytes in %4.2fs, then %4.1f frames/s, "
+         "%5zu bytes per delta frame\n",
+         Name, Frames[0].Sz, KeySecs, (Frames.size() - 1) / Secs,
+         Deltas != 0 ? Bytes / Deltas : 0);
+}
+
+static void testStaticScreen() {
+  Capture C(/*Secs=*/10);
+  drawText(C, 0);
+  C.run([](uint32_t) {});
+  std::vector<Host::Frame> Frames = C.H.decode();
+  CHECK(Frames.size() > 2);
+  if (Frames.empty())
+    return;
+  CHECK(Frames[0].Mode == (uint8_t)TTL::EGA);
+  CHECK(Frames[0].Flags == UsbStream::FlagKeyFrame);
+  CHECK(Frames[0].Width == EGA350.H_Visible);
+  CHECK(Frames[0].Height == EGA350.V_Visible);
+  CHECK(Frames[0].BytesPerLine == (EGA350.H_Visible & ~3u));
+  for (size_t Idx = 0; Idx != Frames.size(); ++Idx)
+    CHECK(Frames[Idx].FrameCnt == Idx);
+  CHECK(C.hostIsCurrent());
+  // Once sent, a static screen costs just the header and the end marker.
+  CHECK(Frames.back().Sz == UsbStream::HeaderSz + 2);
+  // The stream never holds up the capture.
+  CHECK(C.MaxOverrunCycles < 100);
+  report("Static 80x25 text", C);
+}
+
+static void testTyping(const char *StreamPath, const char *LinesPath) {
+  Capture C(/*Secs=*/20);
+  drawText(C, 0);
+  // One character per TTL frame, and then nothing for the last seconds so
+  // that the host catches up.
+  const uint32_t TypingFrames = 15 * (uint32_t)EGA350.V_Hz;
+  C.run([&C, TypingFrames](uint32_t Frame) {
+    if (Frame >= TypingFrames)
+      return;
+    uint32_t Char = Frame % (80 * 25);
+    C.Buff->displayChar('A' + Frame % 26, Char % 80 * BMapWidth,
+                        Char / 80 * 14, C.frameBuffer(), 0b111111, 0b000001);
+  });
+  CHECK(C.hostIsCurrent());
+  CHECK(C.MaxOverrunCycles < 100);
+  report("Typing 1 char per frame", C);
+  if (StreamPath == nullptr)
+    return;
+  FILE *F = fopen(StreamPath, "wb");
+  CHECK(F != nullptr);
+  if (F != nullptr) {
+    fwrite(C.H.Bytes.data(), 1, C.H.Bytes.size(), F);
+    fclose(F);
+  }
+  F = fopen(LinesPath, "wb");
+  CHECK(F != nullptr);
+  if (F != nullptr) {
+    for (uint32_t Y = 0; Y != EGA350.V_Visible; ++Y)
+      fwrite(C.Buff->getScanoutRow(Y), 1, EGA350.H_Visible & ~3u, F);
+    fclose(F);
+  }
+}
+
+static void testScrolling() {
+  Capture C(/*Secs=*/20);
+  // A new text screen on each TTL frame: the stream falls behind and mixes
+  // lines of different frames, but it must keep going.
+  C.run([&C](uint32_t Frame) { drawText(C, Frame); });
+  CHECK(C.H.decode().size() > 2);
+  CHECK(C.MaxOverrunCycles < 100);
+  report("New screen every frame", C);
+}
+
+int main(int argc, char **argv) {
+  if (argc != 1 && argc != 3) {
+    fprintf(stderr, "Usage: %s [<stream> <lines>]\n", argv[0]);
+    return 1;
+  }
+  printf("EGA 640x350 60Hz input, the host reads %u bytes/s, %u bytes of USB "
+         "buffer:\n",
+         UsbBytesPerSec, HostSim::UsbTxBufferSz);
+  testEncodeLine();
+  testStaticScreen();
+  testTyping(argc == 3 ? argv[1] : nullptr, argc == 3 ? argv[2] : nullptr);
+  testScrolling();
+  return Test::result();
+}
@@ -0,0 +1,395 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2025 Scrap Computing
+#
+# A PIO assembler for the host tests, so that they don't need the Pico SDK's
+# pioasm. It covers the PIO syntax used by firmware/src/Pio/ and writes
+# headers in the same format as pioasm: the program, its
+# <name>_program_get_default_config() and the % c-sdk blocks.
+#
+# Usage:
+#   pioasm.py Foo.pio Foo.pio.h
+#   pioasm.py --out-dir gen/ Pio/*.pio     Writes gen/Foo.pio.h etc.
+#   pioasm.py --self-test
+#
+
+import argparse
+import os
+import re
+import sys
+
+JMP_CONDS = {"": 0, "!x": 1, "x--": 2, "!y": 3, "y--": 4, "x!=y": 5,
+             "pin": 6, "!osre": 7}
+IN_SRCS = {"pins": 0, "x": 1, "y": 2, "null": 3, "isr": 6, "osr": 7}
+OUT_DSTS = {"pins": 0, "x": 1, "y": 2, "null": 3, "pindirs": 4, "pc": 5,
+            "isr": 6, "exec": 7}
+MOV_DSTS = {"pins": 0, "x": 1, "y": 2, "pindirs": 3, "exec": 4, "pc": 5,
+            "isr": 6, "osr": 7}
+MOV_SRCS = {"pins": 0, "x": 1, "y": 2, "null": 3, "status": 5, "isr": 6,
+            "osr": 7}
+SET_DSTS = {"pins": 0, "x": 1, "y": 2, "pindirs": 4}
+WAIT_SRCS = {"gpio": 0, "pin": 1, "irq": 2, "jmppin": 3}
+
+
+class AsmError(Exception):
+    pass
+
+
+class Program:
+    def __init__(self, name):
+        self.name = name
+        self.defines = {}
+        self.public_defines = {}
+        self.labels = {}
+        self.public_labels = []
+        # (Line number, [Tokens], Delay expression, Side-set expression)
+        self.instrs = []
+        self.wrap_target = None
+        self.wrap = None
+        self.origin = -1
+        self.sideset_bits = 0
+        self.sideset_opt = False
+        self.sideset_pindirs = False
+        self.c_sdk = []
+
+
+def evaluate(expr, symbols):
+    """Evaluates an integer expression of numbers, symbols and + - * / ()."""
+    def sub(match):
+        word = match.group(0)
+        if re.match(r"0x[0-9a-fA-F]+$|0b[01]+$|\d+$", word):
+            return str(int(word, 0))
+        if word not in symbols:
+            raise AsmError("unknown symbol '%s'" % word)
+        return str(symbols[word])
+    expr = re.sub(r"\b\w+\b", sub, expr)
+    if not re.match(r"^[\d\s+\-*/()]*$", expr):
+        raise AsmError("bad expression '%s'" % expr)
+    return int(eval(expr.replace("/", "//"), {"__builtins__": {}}))
+
+
+def split_operands(text):
+    """Splits the operands of an instruction on commas and spaces, keeping
+    parenthesized expressions whole."""
+    words = []
+    depth = 0
+    cur = ""
+    for char in text:
+        if char == "(":
+            depth += 1
+        elif char == ")":
+            depth -= 1
+        if depth == 0 and (char == "," or char.isspace()):
+            if cur:
+                words.append(cur)
+            cur = ""
+        else:
+            cur += char
+    if cur:
+        words.append(cur)
+    return words
+
+
+def parse(text):
+    """Returns the list of Programs in the source text."""
+    programs = []
+    global_defines = {}
+    prog = None
+    in_c_sdk = False
+    for num, raw in enumerate(text.splitlines(), 1):
+        if in_c_sdk:
+            if raw.strip() == "%}":
+                in_c_sdk = False
+            else:
+                prog.c_sdk.append(raw)
+            continue
+        line = re.sub(r"(;|//).*", "", raw).strip()
+        if not line:
+            continue
+        try:
+            if re.match(r"%\s*c-sdk\s*{", line):
+                if prog is None:
+                    raise AsmError("% c-sdk outside of a program")
+                in_c_sdk = True
+                continue
+            if line.startswith("%"):
+                # Other languages, e.g. % python {
+                raise AsmError("unsupported block '%s'" % line)
+            match = re.match(r"\.program\s+(\w+)$", line)
+            if match:
+                prog = Program(match.group(1))
+                prog.defines = dict(global_defines)
+                programs.append(prog)
+                continue
+            match = re.match(r"\.define\s+(public\s+)?(\w+)\s+(.+)$", line)
+            if match:
+                defines = prog.defines if prog else global_defines
+                val = evaluate(match.group(3), defines)
+                defines[match.group(2)] = val
+                if match.group(1) and prog:
+                    prog.public_defines[match.group(2)] = val
+                continue
+            if prog is None:
+                raise AsmError("'%s' outside of a program" % line)
+            match = re.match(r"(public\s+)?(\w+):\s*(.*)$", line)
+            if match:
+                prog.labels[match.group(2)] = len(prog.instrs)
+                if match.group(1):
+                    prog.public_labels.append(match.group(2))
+                line = match.group(3)
+                if not line:
+                    continue
+            if line == ".wrap_target":
+                prog.wrap_target = len(prog.instrs)
+            elif line == ".wrap":
+                prog.wrap = len(prog.instrs) - 1
+            elif line.startswith(".origin"):
+                prog.origin = evaluate(line.split(None, 1)[1], prog.defines)
+            elif line.startswith(".side_set"):
+                words = line.split()
+                prog.sideset_bits = evaluate(words[1], prog.defines)
+                prog.sideset_opt = "opt" in words[2:]
+                prog.sideset_pindirs = "pindirs" in words[2:]
+            elif line.startswith("."):
+                raise AsmError("unsupported directive '%s'" % line)
+            else:
+                delay = None
+                match = re.match(r"(.*?)\[([^\]]*)\]\s*$", line)
+                if match:
+                    line, delay = match.group(1).strip(), match.group(2)
+                side = None
+                match = re.match(r"(.*?)\s+(?:side|sideset)\s+(.+)$", line)
+                if match:
+                    line, side = match.group(1), match.group(2)
+                # The delay may also come before the side-set.
+                match = re.match(r"(.*?)\[([^\]]*)\]\s*$", line)
+                if match and delay is None:
+                    line, delay = match.group(1).strip(), match.group(2)
+                prog.instrs.append((num, line, delay, side))
+        except AsmError as err:
+            raise AsmError("line %d: %s" % (num, err))
+    if in_c_sdk:
+        raise AsmError("unterminated % c-sdk block")
+    return programs
+
+
+def encode(prog, line, symbols):
+    words = line.split(None, 1)
+    op = words[0].lower()
+    args = split_operands(words[1]) if len(words) > 1 else []
+    low = [arg.lower() for arg in args]
+
+    def val(expr):
+        return evaluate(expr, symbols)
+
+    def count(expr):
+        bits = val(expr)
+        if not 1 <= bits <= 32:
+            raise AsmError("bit count %d out of range" % bits)
+        return bits & 31
+
+    if op == "nop":
+        return 0b101 << 13 | 2 << 5 | 2
+    if op == "jmp":
+        cond = low[0] if len(args) == 2 else ""
+        if cond not in JMP_CONDS:
+            raise AsmError("bad jmp condition '%s'" % args[0])
+        return JMP_CONDS[cond] << 5 | val(args[-1])
+    if op == "wait":
+        pol = val(args[0])
+        src = low[1]
+        if src not in WAIT_SRCS:
+            raise AsmError("bad wait source '%s'" % args[1])
+        idx = val(args[2]) if len(args) > 2 else 0
+        if src == "irq" and len(low) > 3 and low[3] == "rel":
+            idx |= 0x10
+        return 0b001 << 13 | pol << 7 | WAIT_SRCS[src] << 5 | idx
+    if op == "in":
+        return 0b010 << 13 | IN_SRCS[low[0]] << 5 | count(args[1])
+    if op == "out":
+        return 0b011 << 13 | OUT_DSTS[low[0]] << 5 | count(args[1])
+    if op in ("push", "pull"):
+        cond = "iffull" if op == "push" else "ifempty"
+        bits = 1 << 5  # block is the default
+        for arg in low:
+            if arg == cond:
+                bits |= 1 << 6
+            elif arg == "noblock":
+                bits &= ~(1 << 5)
+            elif arg != "block":
+                raise AsmError("bad %s option '%s'" % (op, arg))
+        return 0b100 << 13 | (op == "pull") << 7 | bits
+    if op == "mov":
+        dst, src = low
+        mov_op = 0
+        if src.startswith(("~", "!")):
+            mov_op, src = 1, src[1:].strip()
+        elif src.startswith("::"):
+            mov_op, src = 2, src[2:].strip()
+        if dst not in MOV_DSTS or src not in MOV_SRCS:
+            raise AsmError("bad mov operands '%s'" % ", ".join(args))
+        return 0b101 << 13 | MOV_DSTS[dst] << 5 | mov_op << 3 | MOV_SRCS[src]
+    if op == "irq":
+        clear = wait = False
+        rest = []
+        for arg in low:
+            if arg == "clear":
+                clear = True
+            elif arg == "wait":
+                wait = True
+            elif arg not in ("set", "nowait"):
+                rest.append(arg)
+        idx = val(rest[0])
+        if len(rest) > 1 and rest[1] == "rel":
+            idx |= 0x10
+        return 0b110 << 13 | clear << 6 | wait << 5 | idx
+    if op == "set":
+        return 0b111 << 13 | SET_DSTS[low[0]] << 5 | val(args[1])
+    raise AsmError("unknown instruction '%s'" % op)
+
+
+def assemble(prog):
+    """Returns the instruction words of prog."""
+    symbols = dict(prog.defines)
+    symbols.update(prog.labels)
+    delay_bits = 5 - prog.sideset_bits - prog.sideset_opt
+    out = []
+    for num, line, delay, side in prog.instrs:
+        try:
+            instr = encode(prog, line, symbols)
+            field = 0
+            if delay is not None:
+                dly = evaluate(delay, symbols)
+                if not 0 <= dly < 1 << delay_bits:
+                    raise AsmError("delay %d doesn't fit" % dly)
+                field |= dly
+            if side is not None:
+                if not prog.sideset_bits:
+                    raise AsmError("side-set without .side_set")
+                sval = evaluate(side, symbols)
+                field |= sval << delay_bits
+                if prog.sideset_opt:
+                    field |= 1 << 4
+            elif prog.sideset_bits and not prog.sideset_opt:
+                raise AsmError("missing side-set")
+            out.append(instr | field << 8)
+        except (AsmError, ValueError, KeyError, IndexError) as err:
+            raise AsmError("line %d: %s: %s" % (num, line, err))
+    return out
+
+
+def header(programs):
+    out = ["// -------------------------------------------------- //",
+           "// This file is autogenerated by pioasm.py; do not edit! //",
+           "// -------------------------------------------------- //",
+           "", "#pragma once", "", "#include \"hardware/pio.h\"", ""]
+    for prog in programs:
+        instrs = assemble(prog)
+        name = prog.name
+        wrap_target = prog.wrap_target or 0
+        wrap = prog.wrap if prog.wrap is not None else len(instrs) - 1
+        out += ["// %s" % name, "#define %s_wrap_target %d" % (name, wrap_target),
+                "#define %s_wrap %d" % (name, wrap),
+                "#define %s_pio_version 0" % name]
+        for label in prog.public_labels:
+            out.append("#define %s_offset_%s %du" %
+                       (name, label, prog.labels[label]))
+        for define, val in prog.public_defines.items():
+            out.append("#define %s_%s %d" % (name, define, val))
+        out.append("static const uint16_t %s_program_instructions[] = {" % name)
+        out += ["    0x%04x, // %2d" % (instr, idx)
+                for idx, instr in enumerate(instrs)]
+        out += ["};", "static const struct pio_program %s_program = {" % name,
+                "    .instructions = %s_program_instructions," % name,
+                "    .length = %d," % len(instrs),
+                "    .origin = %d," % prog.origin, "};",
+                "static inline pio_sm_config "
+                "%s_program_get_default_config(uint offset) {" % name,
+                "    pio_sm_config c = pio_get_default_sm_config();",
+                "    sm_config_set_wrap(&c, offset + %s_wrap_target, "
+                "offset + %s_wrap);" % (name, name)]
+        if prog.sideset_bits:
+            out.append("    sm_config_set_sideset(&c, %d, %s, %s);" %
+                       (prog.sideset_bits + prog.sideset_opt,
+                        str(prog.sideset_opt).lower(),
+                        str(prog.sideset_pindirs).lower()))
+        out += ["    return c;", "}"]
+        out += prog.c_sdk
+        out.append("")
+    return "\n".join(out) + "\n"
+
+
+def convert(src, dst):
+    with open(src) as f:
+        text = f.read()
+    try:
+        hdr = header(parse(text))
+    except AsmError as err:
+        sys.exit("%s: %s" % (src, err))
+    with open(dst, "w") as f:
+        f.write(hdr)
+
+
+def self_test():
+    src = """
+.program test
+.side_set 1 opt
+.define N 3
+entry:
+    pull block
+.wrap_target
+loop:
+    in pins, 8 [N]
+    jmp pin loop side 1
+    push noblock
+    mov x, ~null
+    wait 0 gpio (4+N)
+    set y 2
+    out null, 32
+    .wrap
+% c-sdk {
+// c code
+%}
+"""
+    progs = parse(src)
+    assert len(progs) == 1 and progs[0].c_sdk == ["// c code"], progs
+    instrs = assemble(progs[0])
+    # Checked against the instruction encoding tables of the RP2040 datasheet.
+    assert instrs == [0x80a0, 0x4308, 0x18c1, 0x8000, 0xa02b, 0x2007, 0xe042,
+                      0x6060], ["%04x" % i for i in instrs]
+    assert progs[0].wrap_target == 1 and progs[0].wrap == 7
+    hdr = header(progs)
+    assert "sm_config_set_sideset(&c, 2, true, false);" in hdr, hdr
+    assert "#define test_wrap 7" in hdr, hdr
+    for bad in (".program p\n jmp nowhere\n", ".program p\n in pins, 33\n",
+                ".program p\n in pins, 8 [32]\n"):
+        try:
+            assemble(parse(bad)[0])
+            assert False, bad
+        except AsmError:
+            pass
+    print("Self-test OK")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Assembles PIO programs.")
+    parser.add_argument("files", nargs="*")
+    parser.add_argument("--out-dir", help="Write <dir>/<file>.h for each file")
+    parser.add_argument("--self-test", action="store_true")
+    args = parser.parse_args()
+    if args.self_test:
+        self_test()
+        return
+    if args.out_dir:
+        os.makedirs(args.out_dir, exist_ok=True)
+        for src in args.files:
+            convert(src, os.path.join(args.out_dir,
+                                      os.path.basename(src) + ".h"))
+    elif len(args.files) == 2:
+        convert(*args.files)
+    else:
+        parser.error("expected <input.pio> <output.h> or --out-dir")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,407 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+// The subset of the Pico SDK that the capture code uses, for building it for
+// the host. The functions don't just compile, they model the hardware: the
+// PIOs run their programs against the GPIO trace of HostSim.h, the DMA moves
+// the PIO FIFO data and interp0 computes addresses like the real one. All the
+// pico/*.h, hardware/*.h and tusb.h headers of this directory include this.
+//
+
+#ifndef __TESTS_SDK_HOSTSDK_H__
+#define __TESTS_SDK_HOSTSDK_H__
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+typedef unsigned int uint;
+
+// pico/platform.h
+#define __not_in_flash(GROUP) __attribute__((section(".time_critical." GROUP)))
+#define __not_in_flash_func(FUNC) __not_in_flash(#FUNC) FUNC
+#define __time_critical_func(FUNC) __not_in_flash_func(FUNC)
+#define __scratch_x(GROUP)
+#define __scratch_y(GROUP)
+#define __uninitialized_ram(VAR) VAR
+inline void __compiler_memory_barrier() {
+  __asm__ volatile("" : : : "memory");
+}
+inline void __dmb() { __compiler_memory_barrier(); }
+/// Always core1, the capture core.
+uint get_core_num();
+
+// pico/time.h
+/// Microseconds since boot, like the SDK's non-debug builds.
+typedef uint64_t absolute_time_t;
+absolute_time_t get_absolute_time();
+uint32_t time_us_32();
+uint64_t time_us_64();
+inline uint32_t to_ms_since_boot(absolute_time_t T) { return T / 1000; }
+inline uint64_t to_us_since_boot(absolute_time_t T) { return T; }
+inline absolute_time_t delayed_by_us(absolute_time_t T, uint64_t Us) {
+  return T + Us;
+}
+inline absolute_time_t delayed_by_ms(absolute_time_t T, uint32_t Ms) {
+  return T + (uint64_t)Ms * 1000;
+}
+inline int64_t absolute_time_diff_us(absolute_time_t From,
+                                     absolute_time_t To) {
+  return (int64_t)(To - From);
+}
+inline absolute_time_t make_timeout_time_us(uint64_t Us) {
+  return delayed_by_us(get_absolute_time(), Us);
+}
+inline absolute_time_t make_timeout_time_ms(uint32_t Ms) {
+  return delayed_by_ms(get_absolute_time(), Ms);
+}
+bool time_reached(absolute_time_t T);
+void sleep_us(uint64_t Us);
+void sleep_ms(uint32_t Ms);
+void busy_wait_us(uint64_t Us);
+inline void tight_loop_contents() {}
+
+// pico/stdio.h, pico/stdio_usb.h and tusb.h
+#define PICO_ERROR_TIMEOUT -1
+bool stdio_init_all();
+int getchar_timeout_us(uint32_t Us);
+struct stdio_driver_t {
+  void (*out_chars)(const char *Buf, int Len);
+};
+extern stdio_driver_t stdio_usb;
+bool stdio_usb_connected();
+uint32_t tud_cdc_write_available();
+
+// pico/critical_section.h, pico/multicore.h, hardware/sync.h
+typedef struct critical_section {
+  int Unused;
+} critical_section_t;
+inline void critical_section_init(critical_section_t *) {}
+inline void critical_section_enter_blocking(critical_section_t *) {}
+inline void critical_section_exit(critical_section_t *) {}
+inline void multicore_lockout_victim_init() {}
+inline void multicore_lockout_start_blocking() {}
+inline void multicore_lockout_end_blocking() {}
+inline uint32_t save_and_disable_interrupts() { return 0; }
+inline void restore_interrupts(uint32_t) {}
+
+// hardware/clocks.h, hardware/vreg.h, hardware/pll.h, hardware/watchdog.h
+enum clock_index { clk_gpout0, clk_ref, clk_sys, clk_peri, clk_usb, clk_adc };
+#define CLOCKS_FC0_SRC_VALUE_CLK_SYS 1
+#define CLOCKS_FC0_SRC_VALUE_CLK_USB 2
+#define CLOCKS_FC0_SRC_VALUE_CLK_PERI 3
+#define CLOCKS_FC0_SRC_VALUE_CLK_REF 4
+#define CLOCKS_FC0_SRC_VALUE_CLK_ADC 5
+#define CLOCKS_FC0_SRC_VALUE_CLK_RTC 6
+uint32_t clock_get_hz(enum clock_index Clk);
+uint32_t frequency_count_khz(uint Src);
+bool set_sys_clock_khz(uint32_t KHz, bool Required);
+enum vreg_voltage {
+  VREG_VOLTAGE_0_85 = 6,
+  VREG_VOLTAGE_0_90,
+  VREG_VOLTAGE_0_95,
+  VREG_VOLTAGE_1_00,
+  VREG_VOLTAGE_1_05,
+  VREG_VOLTAGE_1_10,
+  VREG_VOLTAGE_1_15,
+  VREG_VOLTAGE_1_20,
+  VREG_VOLTAGE_1_25,
+  VREG_VOLTAGE_1_30,
+};
+inline void vreg_set_voltage(enum vreg_voltage) {}
+inline bool watchdog_caused_reboot() { return false; }
+
+// hardware/gpio.h
+#define GPIO_IN 0
+#define GPIO_OUT 1
+#define PICO_DEFAULT_LED_PIN 25
+enum gpio_irq_level {
+  GPIO_IRQ_LEVEL_LOW = 0x1u,
+  GPIO_IRQ_LEVEL_HIGH = 0x2u,
+  GPIO_IRQ_EDGE_FALL = 0x4u,
+  GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+void gpio_init(uint Pin);
+void gpio_set_dir(uint Pin, bool Out);
+void gpio_pull_up(uint Pin);
+void gpio_pull_down(uint Pin);
+void gpio_disable_pulls(uint Pin);
+bool gpio_get(uint Pin);
+uint32_t gpio_get_all();
+void gpio_put(uint Pin, bool Val);
+void gpio_put_masked(uint32_t Mask, uint32_t Val);
+inline void gpio_set_mask(uint32_t Mask) { gpio_put_masked(Mask, ~0u); }
+inline void gpio_clr_mask(uint32_t Mask) { gpio_put_masked(Mask, 0); }
+void gpio_set_dir_masked(uint32_t Mask, uint32_t Out);
+inline void gpio_set_dir_out_masked(uint32_t Mask) {
+  gpio_set_dir_masked(Mask, ~0u);
+}
+inline void gpio_set_dir_in_masked(uint32_t Mask) {
+  gpio_set_dir_masked(Mask, 0);
+}
+void gpio_acknowledge_irq(uint Pin, uint32_t Events);
+
+// hardware/structs/io_bank0.h
+/// The raw interrupt registers. The edge events are computed from the trace
+/// on every read, so they are a proxy instead of plain memory.
+struct io_bank0_intr_regs {
+  uint32_t operator[](uint Idx) const;
+};
+struct io_bank0_hw_t {
+  io_bank0_intr_regs intr;
+};
+extern io_bank0_hw_t *const io_bank0_hw;
+
+// hardware/flash.h
+#define FLASH_PAGE_SIZE (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+/// The 2MB of flash, erased at startup.
+extern uint8_t HostFlash[];
+#define XIP_BASE ((uintptr_t)HostFlash)
+void flash_range_erase(uint32_t Offs, size_t Count);
+void flash_range_program(uint32_t Offs, const uint8_t *Data, size_t Count);
+
+// hardware/pio.h
+/// Only the FIFO registers, whose addresses the DMA uses. The state of the
+/// state machines lives in HostSim.
+struct pio_hw_t {
+  volatile uint32_t txf[4];
+  volatile uint32_t rxf[4];
+};
+typedef pio_hw_t *PIO;
+extern pio_hw_t HostPioHw[];
+#define pio0 (&HostPioHw[0])
+#define pio1 (&HostPioHw[1])
+#define pio2 (&HostPioHw[2])
+#define NUM_PIOS 3
+#define NUM_PIO_STATE_MACHINES 4
+
+typedef struct pio_program {
+  const uint16_t *instructions;
+  uint8_t length;
+  int8_t origin;
+  uint8_t pio_version;
+} pio_program_t;
+
+enum pio_fifo_join {
+  PIO_FIFO_JOIN_NONE = 0,
+  PIO_FIFO_JOIN_TX = 1,
+  PIO_FIFO_JOIN_RX = 2,
+};
+
+typedef struct {
+  /// The clock divider in 1/256ths.
+  uint32_t clkdiv;
+  uint wrap_target;
+  uint wrap;
+  uint jmp_pin;
+  uint in_base;
+  uint out_base;
+  uint out_count;
+  uint set_base;
+  uint set_count;
+  uint sideset_bits;
+  bool sideset_opt;
+  bool in_shift_right;
+  bool autopush;
+  uint push_threshold;
+  bool out_shift_right;
+  bool autopull;
+  uint pull_threshold;
+  enum pio_fifo_join join;
+} pio_sm_config;
+
+pio_sm_config pio_get_default_sm_config();
+inline void sm_config_set_wrap(pio_sm_config *C, uint Target, uint Wrap) {
+  C->wrap_target = Target;
+  C->wrap = Wrap;
+}
+inline void sm_config_set_sideset(pio_sm_config *C, uint Bits, bool Optional,
+                                  bool) {
+  C->sideset_bits = Bits;
+  C->sideset_opt = Optional;
+}
+inline void sm_config_set_sideset_pins(pio_sm_config *, uint) {}
+inline void sm_config_set_in_pins(pio_sm_config *C, uint Base) {
+  C->in_base = Base;
+}
+inline void sm_config_set_out_pins(pio_sm_config *C, uint Base, uint Count) {
+  C->out_base = Base;
+  C->out_count = Count;
+}
+inline void sm_config_set_set_pins(pio_sm_config *C, uint Base, uint Count) {
+  C->set_base = Base;
+  C->set_count = Count;
+}
+inline void sm_config_set_jmp_pin(pio_sm_config *C, uint Pin) {
+  C->jmp_pin = Pin;
+}
+inline void sm_config_set_in_shift(pio_sm_config *C, bool ShiftRight,
+                                   bool AutoPush, uint Threshold) {
+  C->in_shift_right = ShiftRight;
+  C->autopush = AutoPush;
+  C->push_threshold = Threshold;
+}
+inline void sm_config_set_out_shift(pio_sm_config *C, bool ShiftRight,
+                                    bool AutoPull, uint Threshold) {
+  C->out_shift_right = ShiftRight;
+  C->autopull = AutoPull;
+  C->pull_threshold = Threshold;
+}
+inline void sm_config_set_fifo_join(pio_sm_config *C, enum pio_fifo_join J) {
+  C->join = J;
+}
+inline void sm_config_set_clkdiv_int_frac(pio_sm_config *C, uint16_t Int,
+                                          uint8_t Frac) {
+  C->clkdiv = (uint32_t)Int << 8 | Frac;
+}
+inline void sm_config_set_clkdiv(pio_sm_config *C, float Div) {
+  // Like the SDK: the integer part and the fraction in 1/256ths, truncated.
+  uint16_t Int = (uint16_t)Div;
+  sm_config_set_clkdiv_int_frac(C, Int, Int == 0 ? 0 : (uint8_t)((Div - Int) * 256));
+}
+
+uint pio_add_program(PIO Pio, const pio_program_t *Program);
+void pio_remove_program(PIO Pio, const pio_program_t *Program, uint Offset);
+int pio_claim_unused_sm(PIO Pio, bool Required);
+void pio_sm_claim(PIO Pio, uint SM);
+void pio_sm_unclaim(PIO Pio, uint SM);
+inline uint pio_get_index(PIO Pio) { return Pio - pio0; }
+inline uint pio_get_dreq(PIO Pio, uint SM, bool IsTx) {
+  return pio_get_index(Pio) * 8 + (IsTx ? 0 : 4) + SM;
+}
+inline void pio_gpio_init(PIO, uint) {}
+void pio_sm_init(PIO Pio, uint SM, uint InitialPC, const pio_sm_config *C);
+void pio_sm_set_enabled(PIO Pio, uint SM, bool Enabled);
+void pio_sm_restart(PIO Pio, uint SM);
+void pio_sm_clear_fifos(PIO Pio, uint SM);
+void pio_sm_exec(PIO Pio, uint SM, uint Instr);
+void pio_sm_set_consecutive_pindirs(PIO Pio, uint SM, uint Base, uint Count,
+                                    bool IsOut);
+void pio_sm_set_clkdiv_int_frac(PIO Pio, uint SM, uint16_t Int, uint8_t Frac);
+inline void pio_sm_set_clkdiv(PIO Pio, uint SM, float Div) {
+  pio_sm_config C;
+  sm_config_set_clkdiv(&C, Div);
+  pio_sm_set_clkdiv_int_frac(Pio, SM, C.clkdiv >> 8, C.clkdiv & 0xff);
+}
+uint pio_sm_get_rx_fifo_level(PIO Pio, uint SM);
+uint pio_sm_get_tx_fifo_level(PIO Pio, uint SM);
+bool pio_sm_is_rx_fifo_empty(PIO Pio, uint SM);
+bool pio_sm_is_rx_fifo_full(PIO Pio, uint SM);
+bool pio_sm_is_tx_fifo_full(PIO Pio, uint SM);
+uint32_t pio_sm_get(PIO Pio, uint SM);
+uint32_t pio_sm_get_blocking(PIO Pio, uint SM);
+void pio_sm_put(PIO Pio, uint SM, uint32_t Data);
+void pio_sm_put_blocking(PIO Pio, uint SM, uint32_t Data);
+
+enum pio_src_dest {
+  pio_pins = 0,
+  pio_x = 1,
+  pio_y = 2,
+  pio_null = 3,
+  pio_pindirs = 4,
+  pio_exec_mov = 4,
+  pio_status = 5,
+  pio_pc = 5,
+  pio_isr = 6,
+  pio_osr = 7,
+};
+inline uint pio_encode_jmp(uint Addr) { return Addr; }
+inline uint pio_encode_mov(enum pio_src_dest Dst, enum pio_src_dest Src) {
+  return 0b101u << 13 | (uint)Dst << 5 | (uint)Src;
+}
+inline uint pio_encode_mov_not(enum pio_src_dest Dst, enum pio_src_dest Src) {
+  return pio_encode_mov(Dst, Src) | 1u << 3;
+}
+
+// hardware/dma.h
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+#define DREQ_FORCE 0x3f
+typedef struct {
+  enum dma_channel_transfer_size size;
+  bool read_increment;
+  bool write_increment;
+  uint dreq;
+  uint chain_to;
+} dma_channel_config;
+/// The registers that the firmware reads. transfer_count is kept up to date
+/// as the DMA moves data.
+struct dma_channel_hw_t {
+  volatile uint32_t read_addr;
+  volatile uint32_t write_addr;
+  volatile uint32_t transfer_count;
+  volatile uint32_t ctrl_trig;
+};
+int dma_claim_unused_channel(bool Required);
+void dma_channel_unclaim(uint Ch);
+dma_channel_config dma_channel_get_default_config(uint Ch);
+inline void channel_config_set_transfer_data_size(
+    dma_channel_config *C, enum dma_channel_transfer_size Size) {
+  C->size = Size;
+}
+inline void channel_config_set_read_increment(dma_channel_config *C, bool I) {
+  C->read_increment = I;
+}
+inline void channel_config_set_write_increment(dma_channel_config *C, bool I) {
+  C->write_increment = I;
+}
+inline void channel_config_set_dreq(dma_channel_config *C, uint DReq) {
+  C->dreq = DReq;
+}
+inline void channel_config_set_chain_to(dma_channel_config *C, uint Ch) {
+  C->chain_to = Ch;
+}
+void dma_channel_configure(uint Ch, const dma_channel_config *C,
+                           volatile void *Dst, const volatile void *Src,
+                           uint Count, bool Trigger);
+void dma_channel_abort(uint Ch);
+bool dma_channel_is_busy(uint Ch);
+dma_channel_hw_t *dma_channel_hw_addr(uint Ch);
+
+// hardware/interp.h
+/// One interpolator: the lanes work like in section 2.3.1 of the RP2040
+/// datasheet. The firmware keeps pointers in BASE2, so unlike the hardware the
+/// registers and the full result are pointer-sized.
+typedef uintptr_t interp_reg_t;
+struct interp_hw_t {
+  interp_reg_t accum[2];
+  interp_reg_t base[3];
+  uint32_t ctrl[2];
+};
+extern interp_hw_t *const interp0;
+extern interp_hw_t *const interp1;
+typedef struct {
+  uint32_t ctrl;
+} interp_config;
+interp_config interp_default_config();
+inline void interp_config_set_shift(interp_config *C, uint Shift) {
+  C->ctrl = (C->ctrl & ~0x1fu) | Shift;
+}
+inline void interp_config_set_mask(interp_config *C, uint Lsb, uint Msb) {
+  C->ctrl = (C->ctrl & ~(0x3ffu << 5)) | Lsb << 5 | Msb << 10;
+}
+inline void interp_config_set_signed(interp_config *C, bool Signed) {
+  C->ctrl = (C->ctrl & ~(1u << 15)) | (uint32_t)Signed << 15;
+}
+inline void interp_config_set_cross_input(interp_config *C, bool Cross) {
+  C->ctrl = (C->ctrl & ~(1u << 16)) | (uint32_t)Cross << 16;
+}
+inline void interp_config_set_cross_result(interp_config *C, bool Cross) {
+  C->ctrl = (C->ctrl & ~(1u << 17)) | (uint32_t)Cross << 17;
+}
+inline void interp_config_set_add_raw(interp_config *C, bool AddRaw) {
+  C->ctrl = (C->ctrl & ~(1u << 18)) | (uint32_t)AddRaw << 18;
+}
+/// Only interp1 lane 0 has the clamp mode.
+inline void interp_config_set_clamp(interp_config *C, bool Clamp) {
+  C->ctrl = (C->ctrl & ~(1u << 22)) | (uint32_t)Clamp << 22;
+}
+void interp_set_config(interp_hw_t *Interp, uint Lane, interp_config *C);
+uint32_t interp_peek_lane_result(interp_hw_t *Interp, uint Lane);
+uint32_t interp_pop_lane_result(interp_hw_t *Interp, uint Lane);
+interp_reg_t interp_peek_full_result(interp_hw_t *Interp);
+interp_reg_t interp_pop_full_result(interp_hw_t *Interp);
+
+#endif // __TESTS_SDK_HOSTSDK_H__
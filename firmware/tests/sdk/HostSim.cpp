@@ -0,0 +1,1415 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+
+#include "HostSim.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+constexpr uint64_t Never = UINT64_MAX;
+constexpr uint32_t DefaultSysHz = 125000000;
+constexpr uint32_t FlashSz = 2u << 20;
+constexpr uint32_t NumDMAChannels = 16;
+// Typical W25Q times.
+constexpr uint32_t FlashEraseUs = 45000;
+constexpr uint32_t FlashProgramPageUs = 400;
+
+[[noreturn]] void panic(const char *Msg) {
+  fprintf(stderr, "HostSim: %s\n", Msg);
+  abort();
+}
+
+struct Fifo {
+  uint32_t Data[8];
+  uint32_t Head = 0;
+  uint32_t Cnt = 0;
+  uint32_t Cap = 4;
+  bool empty() const { return Cnt == 0; }
+  bool full() const { return Cnt == Cap; }
+  void push(uint32_t Val) { Data[(Head + Cnt++) % 8] = Val; }
+  uint32_t pop() {
+    uint32_t Val = Data[Head];
+    Head = (Head + 1) % 8;
+    --Cnt;
+    return Val;
+  }
+  void clear() { Head = Cnt = 0; }
+};
+
+struct Channel;
+
+struct StateMachine {
+  bool Claimed = false;
+  bool Enabled = false;
+  pio_sm_config Cfg;
+  uint32_t PC = 0;
+  uint32_t X = 0;
+  uint32_t Y = 0;
+  uint32_t ISR = 0;
+  uint32_t OSR = 0;
+  uint32_t ISRCnt = 0;
+  uint32_t OSRCnt = 32;
+  Fifo Rx;
+  Fifo Tx;
+  /// The time of the next instruction, in 1/256 cycles.
+  uint64_t Time = 0;
+  /// The DMA channel that drains Rx.
+  Channel *RxDMA = nullptr;
+  /// Where the SM is in the trace, see pinsAt().
+  size_t Cursor = 0;
+};
+
+struct PioBlock {
+  uint16_t Mem[32] = {};
+  uint32_t Used = 0;
+  StateMachine SMs[4];
+};
+
+struct Channel {
+  bool Claimed = false;
+  bool Busy = false;
+  dma_channel_config Cfg;
+  volatile uint8_t *Write = nullptr;
+  const volatile uint8_t *Read = nullptr;
+  StateMachine *SM = nullptr;
+  dma_channel_hw_t Hw = {};
+};
+
+struct GpioState {
+  bool Out = false;
+  bool OutVal = false;
+  bool PullUp = false;
+  bool PullDown = true;
+};
+
+struct Sim {
+  uint64_t Now = 0;
+  uint32_t SysHz = DefaultSysHz;
+  bool InCallback = false;
+  std::multimap<uint64_t, std::function<void()>> Timers;
+  uint64_t NextTimer = Never;
+  uint64_t TraceEnd = Never;
+
+  // The trace, in cycles.
+  std::vector<uint64_t> Times;
+  std::vector<uint32_t> States;
+  uint32_t Driven = 0;
+  /// The cycles when each GPIO of the trace toggles.
+  std::array<std::vector<uint64_t>, 32> Edges;
+  size_t CPUCursor = 0;
+  std::array<uint64_t, 32> AckRise = {};
+  std::array<uint64_t, 32> AckFall = {};
+
+  std::array<GpioState, 32> Gpio;
+  /// The levels of the GPIOs that are not in the trace.
+  uint32_t Static = 0;
+
+  PioBlock Pios[NUM_PIOS];
+  Channel Channels[NumDMAChannels];
+  interp_hw_t Interps[2] = {};
+
+  bool UsbConnected = false;
+  uint32_t UsbBytesPerSec = 0;
+  std::function<void(const char *, int)> UsbSink;
+  /// Bytes in the CDC buffer as of UsbTime.
+  double UsbFill = 0;
+  uint64_t UsbTime = 0;
+  std::deque<char> StdIn;
+
+  HostSim::Stats Stats;
+  /// See HostSim::timeFifoGaps(): the gaps by length in host ticks.
+  std::vector<uint64_t> FifoGapHist;
+  bool InFifoGap = false;
+  uint64_t FifoGapStart = 0;
+  /// The time of reading the clock, which each gap includes.
+  double ClockTicks = 0;
+  uint64_t TimeStartTicks = 0;
+  std::chrono::steady_clock::time_point TimeStart;
+};
+
+Sim S;
+
+/// The fastest clock of the host. Reading steady_clock takes longer than most
+/// gaps in a VM.
+uint64_t hostTicks() {
+#if defined(__x86_64__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+/// \Returns the mean of histogram \p Hist without the slowest 1%, which the
+/// host spent elsewhere.
+double getTrimmedMean(const std::vector<uint64_t> &Hist) {
+  uint64_t Total = 0;
+  for (uint64_t Cnt : Hist)
+    Total += Cnt;
+  uint64_t Left = Total - Total / 100;
+  double Sum = 0;
+  for (uint32_t Idx = 0; Idx != Hist.size() && Left != 0; ++Idx) {
+    uint64_t Cnt = std::min(Hist[Idx], Left);
+    Sum += (double)Idx * Cnt;
+    Left -= Cnt;
+  }
+  return Total != 0 ? Sum / (Total - Total / 100) : 0;
+}
+
+void sdkCall() {
+  if (S.InFifoGap) {
+    uint64_t Ticks = hostTicks() - S.FifoGapStart;
+    ++S.FifoGapHist[std::min<uint64_t>(Ticks, S.FifoGapHist.size() - 1)];
+    S.InFifoGap = false;
+  }
+  HostSim::advance(HostSim::SdkCallCycles);
+}
+
+void updateStatic() {
+  S.Static = 0;
+  for (uint32_t Pin = 0; Pin != 32; ++Pin) {
+    const GpioState &G = S.Gpio[Pin];
+    if (G.Out ? G.OutVal : G.PullUp)
+      S.Static |= 1u << Pin;
+  }
+}
+
+uint32_t traceStateAt(uint64_t Cycle, size_t &Cursor) {
+  if (S.Times.empty())
+    return 0;
+  size_t Last = S.Times.size() - 1;
+  while (Cursor != Last && S.Times[Cursor + 1] <= Cycle)
+    ++Cursor;
+  while (Cursor != 0 && S.Times[Cursor] > Cycle)
+    --Cursor;
+  return S.States[Cursor];
+}
+
+/// \Returns all the GPIO levels at \p Cycle.
+uint32_t pinsAt(uint64_t Cycle, size_t &Cursor) {
+  return (traceStateAt(Cycle, Cursor) & S.Driven) | (S.Static & ~S.Driven);
+}
+
+uint32_t rotr(uint32_t Val, uint32_t N) {
+  N &= 31;
+  return N == 0 ? Val : Val >> N | Val << (32 - N);
+}
+
+uint32_t reverseBits(uint32_t Val) {
+  uint32_t Res = 0;
+  for (int Bit = 0; Bit != 32; ++Bit, Val >>= 1)
+    Res = Res << 1 | (Val & 1);
+  return Res;
+}
+
+StateMachine &getSM(PIO Pio, uint SM) {
+  uint Idx = pio_get_index(Pio);
+  if (Idx >= NUM_PIOS || SM >= NUM_PIO_STATE_MACHINES)
+    panic("bad PIO state machine");
+  return S.Pios[Idx].SMs[SM];
+}
+
+PioBlock &getPio(PIO Pio) { return S.Pios[pio_get_index(Pio)]; }
+
+void finishDMA(Channel &Ch) {
+  Ch.Busy = false;
+  if (Ch.SM != nullptr)
+    Ch.SM->RxDMA = nullptr;
+  Ch.SM = nullptr;
+}
+
+void dmaWrite(Channel &Ch, uint32_t Val) {
+  uint32_t Sz = 1u << Ch.Cfg.size;
+  memcpy((void *)Ch.Write, &Val, Sz);
+  if (Ch.Cfg.write_increment)
+    Ch.Write += Sz;
+  ++S.Stats.DmaWords;
+  if (--Ch.Hw.transfer_count == 0)
+    finishDMA(Ch);
+}
+
+void pushRx(StateMachine &SM, uint32_t Val) {
+  if (SM.RxDMA != nullptr)
+    dmaWrite(*SM.RxDMA, Val);
+  else
+    SM.Rx.push(Val);
+}
+
+bool rxFull(const StateMachine &SM) {
+  return SM.RxDMA == nullptr && SM.Rx.full();
+}
+
+uint64_t getPeriod(const StateMachine &SM) {
+  // An integer divider of 0 means 65536.
+  return SM.Cfg.clkdiv < 256 ? 65536 * 256 : SM.Cfg.clkdiv;
+}
+
+uint32_t getThreshold(uint32_t Thr) { return Thr == 0 ? 32 : Thr; }
+
+uint32_t nextPC(const StateMachine &SM, uint32_t PC) {
+  return PC == SM.Cfg.wrap ? SM.Cfg.wrap_target : (PC + 1) % 32;
+}
+
+/// The result of executing an instruction.
+enum class Exec {
+  /// Done, PC is the next instruction.
+  Done,
+  /// Stalled on a FIFO, so waiting for the CPU.
+  StallFifo,
+  /// Stalled on a WAIT for GPIO WaitPin to be at WaitLevel.
+  StallWait,
+};
+
+struct ExecResult {
+  Exec E;
+  uint32_t PC = 0;
+  uint32_t WaitPin = 0;
+  bool WaitLevel = false;
+};
+
+/// Executes \p Instr on \p SM at the time of the SM.
+ExecResult execute(StateMachine &SM, uint16_t Instr, uint32_t PC) {
+  const uint32_t Arg = Instr & 0xff;
+  const uint32_t Next = nextPC(SM, PC);
+  const uint64_t Cycle = SM.Time >> 8;
+  auto Count = [Arg]() { return (Arg & 31) == 0 ? 32u : Arg & 31; };
+  switch (Instr >> 13) {
+  case 0: { // JMP
+    bool Take = false;
+    switch (Arg >> 5) {
+    case 0:
+      Take = true;
+      break;
+    case 1:
+      Take = SM.X == 0;
+      break;
+    case 2:
+      Take = SM.X-- != 0;
+      break;
+    case 3:
+      Take = SM.Y == 0;
+      break;
+    case 4:
+      Take = SM.Y-- != 0;
+      break;
+    case 5:
+      Take = SM.X != SM.Y;
+      break;
+    case 6:
+      Take = HostSim::getLevelAt(SM.Cfg.jmp_pin, Cycle);
+      break;
+    case 7:
+      Take = SM.OSRCnt < getThreshold(SM.Cfg.pull_threshold);
+      break;
+    }
+    return {Exec::Done, Take ? Arg & 31 : Next};
+  }
+  case 1: { // WAIT
+    bool Level = Arg >> 7;
+    uint32_t Pin = Arg & 31;
+    switch ((Arg >> 5) & 3) {
+    case 0:
+      break;
+    case 1:
+      Pin = (SM.Cfg.in_base + Pin) % 32;
+      break;
+    default:
+      panic("WAIT IRQ is not supported");
+    }
+    if (HostSim::getLevelAt(Pin, Cycle) == Level)
+      return {Exec::Done, Next};
+    return {Exec::StallWait, PC, Pin, Level};
+  }
+  case 2: { // IN
+    uint32_t N = Count();
+    uint32_t Data = 0;
+    switch (Arg >> 5) {
+    case 0:
+      Data = rotr(pinsAt(Cycle, SM.Cursor), SM.Cfg.in_base);
+      break;
+    case 1:
+      Data = SM.X;
+      break;
+    case 2:
+      Data = SM.Y;
+      break;
+    case 3:
+      break;
+    case 6:
+      Data = SM.ISR;
+      break;
+    case 7:
+      Data = SM.OSR;
+      break;
+    default:
+      panic("bad IN source");
+    }
+    bool Push = SM.Cfg.autopush &&
+                SM.ISRCnt + N >= getThreshold(SM.Cfg.push_threshold);
+    if (Push && rxFull(SM))
+      return {Exec::StallFifo, PC};
+    if (N == 32)
+      SM.ISR = Data;
+    else if (SM.Cfg.in_shift_right)
+      SM.ISR = SM.ISR >> N | Data << (32 - N);
+    else
+      SM.ISR = SM.ISR << N | (Data & ((1u << N) - 1));
+    SM.ISRCnt = std::min(32u, SM.ISRCnt + N);
+    if (Push) {
+      pushRx(SM, SM.ISR);
+      SM.ISR = 0;
+      SM.ISRCnt = 0;
+    }
+    return {Exec::Done, Next};
+  }
+  case 3: { // OUT
+    uint32_t N = Count();
+    if (SM.Cfg.autopull &&
+        SM.OSRCnt >= getThreshold(SM.Cfg.pull_threshold)) {
+      if (SM.Tx.empty())
+        return {Exec::StallFifo, PC};
+      SM.OSR = SM.Tx.pop();
+      SM.OSRCnt = 0;
+    }
+    uint32_t Data;
+    if (N == 32) {
+      Data = SM.OSR;
+      SM.OSR = 0;
+    } else if (SM.Cfg.out_shift_right) {
+      Data = SM.OSR & ((1u << N) - 1);
+      SM.OSR >>= N;
+    } else {
+      Data = SM.OSR >> (32 - N);
+      SM.OSR <<= N;
+    }
+    SM.OSRCnt = std::min(32u, SM.OSRCnt + N);
+    switch (Arg >> 5) {
+    case 0: // PINS
+    case 3: // NULL
+    case 4: // PINDIRS
+      break;
+    case 1:
+      SM.X = Data;
+      break;
+    case 2:
+      SM.Y = Data;
+      break;
+    case 5:
+      return {Exec::Done, Data & 31};
+    case 6:
+      SM.ISR = Data;
+      SM.ISRCnt = N;
+      break;
+    default:
+      panic("OUT EXEC is not supported");
+    }
+    return {Exec::Done, Next};
+  }
+  case 4: { // PUSH/PULL
+    bool IfFlag = Arg & 0x40;
+    bool Block = Arg & 0x20;
+    if ((Arg & 0x80) == 0) {
+      if (IfFlag && SM.ISRCnt < getThreshold(SM.Cfg.push_threshold))
+        return {Exec::Done, Next};
+      if (rxFull(SM)) {
+        if (Block)
+          return {Exec::StallFifo, PC};
+        // A non-blocking push to a full FIFO drops the data.
+      } else {
+        pushRx(SM, SM.ISR);
+      }
+      SM.ISR = 0;
+      SM.ISRCnt = 0;
+    } else {
+      if (IfFlag && SM.OSRCnt < getThreshold(SM.Cfg.pull_threshold))
+        return {Exec::Done, Next};
+      if (SM.Tx.empty()) {
+        if (Block)
+          return {Exec::StallFifo, PC};
+        SM.OSR = SM.X;
+      } else {
+        SM.OSR = SM.Tx.pop();
+      }
+      SM.OSRCnt = 0;
+    }
+    return {Exec::Done, Next};
+  }
+  case 5: { // MOV
+    uint32_t Data = 0;
+    switch (Arg & 7) {
+    case 0:
+      Data = rotr(pinsAt(Cycle, SM.Cursor), SM.Cfg.in_base);
+      break;
+    case 1:
+      Data = SM.X;
+      break;
+    case 2:
+      Data = SM.Y;
+      break;
+    case 3:
+      break;
+    case 6:
+      Data = SM.ISR;
+      break;
+    case 7:
+      Data = SM.OSR;
+      break;
+    default:
+      panic("bad MOV source");
+    }
+    switch ((Arg >> 3) & 3) {
+    case 1:
+      Data = ~Data;
+      break;
+    case 2:
+      Data = reverseBits(Data);
+      break;
+    }
+    switch (Arg >> 5) {
+    case 0: // PINS
+    case 3: // PINDIRS
+      break;
+    case 1:
+      SM.X = Data;
+      break;
+    case 2:
+      SM.Y = Data;
+      break;
+    case 5:
+      return {Exec::Done, Data & 31};
+    case 6:
+      SM.ISR = Data;
+      SM.ISRCnt = 0;
+      break;
+    case 7:
+      SM.OSR = Data;
+      SM.OSRCnt = 0;
+      break;
+    default:
+      panic("MOV EXEC is not supported");
+    }
+    return {Exec::Done, Next};
+  }
+  case 6:
+    panic("IRQ is not supported");
+  default: // SET
+    switch (Arg >> 5) {
+    case 1:
+      SM.X = Arg & 31;
+      break;
+    case 2:
+      SM.Y = Arg & 31;
+      break;
+    }
+    return {Exec::Done, Next};
+  }
+}
+
+/// \Returns the first tick of \p SM at or after \p Cycle.
+uint64_t tickAt(const StateMachine &SM, uint64_t Cycle) {
+  if (Cycle == Never)
+    return Never;
+  uint64_t Period = getPeriod(SM);
+  uint64_t Time = Cycle << 8;
+  if (Time <= SM.Time)
+    return SM.Time;
+  return SM.Time + (Time - SM.Time + Period - 1) / Period * Period;
+}
+
+/// Skips the iterations of the 2-instruction loops that wait for an edge
+/// while counting with X, like the ones of SyncPeriod. \Returns true if it
+/// skipped any.
+bool skipCountingLoop(PioBlock &P, StateMachine &SM, uint64_t Limit) {
+  uint16_t I0 = P.Mem[SM.PC];
+  uint32_t PC1 = nextPC(SM, SM.PC);
+  uint16_t I1 = P.Mem[PC1];
+  // Both are JMPs without delay or side-set.
+  if (((I0 | I1) & 0xff00) != 0)
+    return false;
+  uint32_t Cond0 = I0 >> 5, Cond1 = I1 >> 5;
+  uint64_t Period = getPeriod(SM);
+  uint64_t First;
+  bool ExitLevel;
+  uint64_t MaxIters = Never;
+  if (Cond0 == 2 && (I0 & 31) == PC1 && Cond1 == 6 && (I1 & 31) == SM.PC) {
+    // jmp x-- next; jmp pin first: X counts down while the pin is high, the
+    // pin is sampled by the second instruction.
+    First = SM.Time + Period;
+    ExitLevel = false;
+  } else if (Cond0 == 6 && (I0 & 31) != PC1 && Cond1 == 2 &&
+             (I1 & 31) == SM.PC) {
+    // jmp pin out; jmp x-- first: X counts down while the pin is low.
+    First = SM.Time;
+    ExitLevel = true;
+    MaxIters = SM.X;
+  } else {
+    return false;
+  }
+  uint64_t Exit = tickAt(SM, HostSim::findLevel(SM.Cfg.jmp_pin, ExitLevel,
+                                                SM.Time >> 8));
+  uint64_t Last = std::min(Exit == Never ? Never : Exit - 1, Limit);
+  if (Last < First)
+    return false;
+  uint64_t Iters = std::min((Last - First) / (2 * Period) + 1, MaxIters);
+  if (Iters < 2)
+    return false;
+  SM.X -= Iters;
+  SM.Time += Iters * 2 * Period;
+  S.Stats.PioSkips += Iters;
+  return true;
+}
+
+/// Runs \p SM up to now.
+void catchUp(PioBlock &P, StateMachine &SM) {
+  const uint64_t Limit = S.Now << 8;
+  if (!SM.Enabled)
+    return;
+  while (SM.Time <= Limit) {
+    if ((P.Mem[SM.PC] >> 13) == 0 && skipCountingLoop(P, SM, Limit))
+      continue;
+    uint16_t Instr = P.Mem[SM.PC];
+    ExecResult R = execute(SM, Instr, SM.PC);
+    ++S.Stats.PioSteps;
+    uint64_t Period = getPeriod(SM);
+    switch (R.E) {
+    case Exec::Done: {
+      uint32_t DelayBits = 5 - SM.Cfg.sideset_bits;
+      uint32_t Delay = (Instr >> 8) & ((1u << DelayBits) - 1);
+      SM.PC = R.PC;
+      SM.Time += Period * (1 + Delay);
+      break;
+    }
+    case Exec::StallFifo:
+      // Try again once the CPU had a chance to serve the FIFO.
+      SM.Time += ((Limit - SM.Time) / Period + 1) * Period;
+      break;
+    case Exec::StallWait: {
+      uint64_t When = HostSim::findLevel(R.WaitPin, R.WaitLevel,
+                                         (SM.Time >> 8) + 1);
+      SM.Time = std::max(SM.Time + Period, tickAt(SM, When));
+      ++S.Stats.PioSkips;
+      break;
+    }
+    }
+  }
+}
+
+void catchUpAll() {
+  for (PioBlock &P : S.Pios)
+    for (StateMachine &SM : P.SMs)
+      catchUp(P, SM);
+}
+
+/// The SM lost track of time, e.g. because it jumped elsewhere.
+void rephase(StateMachine &SM) { SM.Time = S.Now << 8; }
+
+void restartSM(StateMachine &SM) {
+  SM.ISR = 0;
+  SM.ISRCnt = 0;
+  SM.OSRCnt = 32;
+  rephase(SM);
+}
+
+void runTimers() {
+  while (!S.Timers.empty() && S.Timers.begin()->first <= S.Now) {
+    auto Fn = std::move(S.Timers.begin()->second);
+    S.Timers.erase(S.Timers.begin());
+    S.InCallback = true;
+    try {
+      Fn();
+    } catch (...) {
+      S.InCallback = false;
+      throw;
+    }
+    S.InCallback = false;
+  }
+  S.NextTimer = S.Timers.empty() ? Never : S.Timers.begin()->first;
+}
+
+uint64_t usToCycles(uint64_t Us) { return Us * S.SysHz / 1000000; }
+
+void usbDrain() {
+  if (S.UsbBytesPerSec == 0)
+    return;
+  double Drained =
+      (double)(S.Now - S.UsbTime) * S.UsbBytesPerSec / S.SysHz;
+  S.UsbFill = std::max(0.0, S.UsbFill - Drained);
+  S.UsbTime = S.Now;
+}
+
+void usbOutChars(const char *Buf, int Len) {
+  if (!S.UsbConnected)
+    return;
+  while (Len > 0) {
+    sdkCall();
+    usbDrain();
+    int Space = HostSim::UsbTxBufferSz - (int)S.UsbFill;
+    if (Space <= 0) {
+      // Wait until a byte goes out.
+      HostSim::advance(S.SysHz / S.UsbBytesPerSec + 1);
+      continue;
+    }
+    int Sz = std::min(Space, Len);
+    if (S.UsbSink)
+      S.UsbSink(Buf, Sz);
+    S.UsbFill += Sz;
+    Buf += Sz;
+    Len -= Sz;
+  }
+}
+
+uint32_t interpLaneValue(interp_hw_t *Interp, uint Lane) {
+  uint32_t Ctrl = Interp->ctrl[Lane];
+  bool Cross = Ctrl & (1u << 16);
+  uint32_t In = Interp->accum[Cross ? 1 - Lane : Lane];
+  uint32_t Shift = Ctrl & 31, Lsb = (Ctrl >> 5) & 31, Msb = (Ctrl >> 10) & 31;
+  uint32_t Mask =
+      (Msb == 31 ? ~0u : (1u << (Msb + 1)) - 1) & ~((1u << Lsb) - 1);
+  uint32_t Val = (In >> Shift) & Mask;
+  bool Signed = Ctrl & (1u << 15);
+  if (Signed && Msb != 31 && (Val >> Msb) & 1)
+    Val |= ~0u << (Msb + 1);
+  return Val;
+}
+
+uint32_t interpLaneResult(interp_hw_t *Interp, uint Lane) {
+  uint32_t Ctrl = Interp->ctrl[Lane];
+  uint32_t Val = interpLaneValue(Interp, Lane);
+  bool Clamp = Interp == interp1 && Lane == 0 && (Ctrl & (1u << 22));
+  uint32_t Base0 = Interp->base[0], Base1 = Interp->base[1];
+  if (Clamp) {
+    if (Ctrl & (1u << 15))
+      return (uint32_t)std::clamp((int32_t)Val, (int32_t)Base0,
+                                  (int32_t)Base1);
+    return std::clamp(Val, Base0, Base1);
+  }
+  bool AddRaw = Ctrl & (1u << 18);
+  bool Cross = Ctrl & (1u << 16);
+  uint32_t Raw = Interp->accum[Cross ? 1 - Lane : Lane];
+  return (uint32_t)Interp->base[Lane] + (AddRaw ? Raw : Val);
+}
+
+interp_reg_t interpFullResult(interp_hw_t *Interp) {
+  return Interp->base[2] + interpLaneValue(Interp, 0) +
+         interpLaneValue(Interp, 1);
+}
+
+void interpPop(interp_hw_t *Interp) {
+  uint32_t R0 = interpLaneResult(Interp, 0);
+  uint32_t R1 = interpLaneResult(Interp, 1);
+  Interp->accum[(Interp->ctrl[0] >> 17) & 1] = R0;
+  Interp->accum[1 - ((Interp->ctrl[1] >> 17) & 1)] = R1;
+}
+} // namespace
+
+// HostSim
+
+void HostSim::reset() {
+  S.~Sim();
+  new (&S) Sim();
+  memset(HostFlash, 0xff, FlashSz);
+  updateStatic();
+}
+
+uint64_t HostSim::now() { return S.Now; }
+uint32_t HostSim::getSysHz() { return S.SysHz; }
+
+void HostSim::advance(uint64_t Cycles) {
+  if (S.InCallback)
+    return;
+  S.Now += Cycles;
+  if (S.Now >= S.NextTimer)
+    runTimers();
+  if (S.Now > S.TraceEnd)
+    throw EndOfTrace();
+}
+
+void HostSim::loadTrace(const Trace &T) {
+  S.Times.clear();
+  S.States.clear();
+  for (auto &E : S.Edges)
+    E.clear();
+  S.Driven = T.Driven;
+  for (size_t Idx = 0; Idx != T.TimesPs.size(); ++Idx) {
+    uint64_t Cycle =
+        S.Now + (uint64_t)((unsigned __int128)T.TimesPs[Idx] * S.SysHz /
+                           1000000000000ull);
+    uint32_t State = T.States[Idx] & T.Driven;
+    if (!S.States.empty()) {
+      if (State == S.States.back())
+        continue;
+      if (Cycle == S.Times.back()) {
+        S.States.back() = State;
+        continue;
+      }
+    }
+    S.Times.push_back(Cycle);
+    S.States.push_back(State);
+  }
+  for (size_t Idx = 1; Idx < S.States.size(); ++Idx) {
+    uint32_t Diff = S.States[Idx] ^ S.States[Idx - 1];
+    for (uint32_t Pin = 0; Pin != 32; ++Pin)
+      if ((Diff >> Pin) & 1)
+        S.Edges[Pin].push_back(S.Times[Idx]);
+  }
+  // Duplicate states were merged, so the edges may have paired up again.
+  for (auto &E : S.Edges) {
+    std::vector<uint64_t> Clean;
+    for (uint64_t Cycle : E) {
+      if (!Clean.empty() && Clean.back() == Cycle)
+        Clean.pop_back();
+      else
+        Clean.push_back(Cycle);
+    }
+    E = std::move(Clean);
+  }
+  S.TraceEnd = S.Times.empty() ? S.Now : S.Times.back();
+  S.CPUCursor = 0;
+  for (PioBlock &P : S.Pios)
+    for (StateMachine &SM : P.SMs)
+      SM.Cursor = 0;
+  S.AckRise.fill(S.Now);
+  S.AckFall.fill(S.Now);
+}
+
+bool HostSim::readTraceFile(const char *Path, Trace &T, std::string &Err) {
+  std::ifstream File(Path, std::ios::binary);
+  if (!File) {
+    Err = std::string("can't open ") + Path;
+    return false;
+  }
+  char Magic[8];
+  uint8_t Driven[4];
+  if (!File.read(Magic, 8) || memcmp(Magic, "MCEEDGE1", 8) != 0 ||
+      !File.read((char *)Driven, 4)) {
+    Err = std::string(Path) + " is not a trace";
+    return false;
+  }
+  T.Driven = Driven[0] | Driven[1] << 8 | Driven[2] << 16 |
+             (uint32_t)Driven[3] << 24;
+  uint8_t Rec[12];
+  while (File.read((char *)Rec, sizeof(Rec))) {
+    uint64_t Time = 0;
+    for (int Idx = 7; Idx >= 0; --Idx)
+      Time = Time << 8 | Rec[Idx];
+    if (!T.TimesPs.empty() && Time < T.TimesPs.back()) {
+      Err = std::string(Path) + ": the times go backwards";
+      return false;
+    }
+    T.TimesPs.push_back(Time);
+    T.States.push_back(Rec[8] | Rec[9] << 8 | Rec[10] << 16 |
+                       (uint32_t)Rec[11] << 24);
+  }
+  if (File.gcount() != 0) {
+    Err = std::string(Path) + " is truncated";
+    return false;
+  }
+  return true;
+}
+
+uint64_t HostSim::getTraceEnd() { return S.TraceEnd; }
+
+bool HostSim::getLevelAt(uint32_t Pin, uint64_t Cycle) {
+  if (((S.Driven >> Pin) & 1) == 0 || S.States.empty())
+    return (S.Static >> Pin) & 1;
+  const auto &E = S.Edges[Pin];
+  size_t Idx = std::upper_bound(E.begin(), E.end(), Cycle) - E.begin();
+  return ((S.States[0] >> Pin) & 1) ^ (Idx & 1);
+}
+
+uint64_t HostSim::findLevel(uint32_t Pin, bool Level, uint64_t Cycle) {
+  if (getLevelAt(Pin, Cycle) == Level)
+    return Cycle;
+  if (((S.Driven >> Pin) & 1) == 0 || S.States.empty())
+    return Never;
+  const auto &E = S.Edges[Pin];
+  auto It = std::upper_bound(E.begin(), E.end(), Cycle);
+  return It == E.end() ? Never : *It;
+}
+
+void HostSim::at(uint64_t Cycle, std::function<void()> Fn) {
+  S.Timers.emplace(Cycle, std::move(Fn));
+  S.NextTimer = S.Timers.begin()->first;
+}
+
+void HostSim::connectUsb(uint32_t BytesPerSec,
+                         std::function<void(const char *, int)> Sink) {
+  S.UsbConnected = true;
+  S.UsbBytesPerSec = BytesPerSec;
+  S.UsbSink = std::move(Sink);
+  S.UsbFill = 0;
+  S.UsbTime = S.Now;
+}
+
+void HostSim::sendChars(const std::string &Str) {
+  S.StdIn.insert(S.StdIn.end(), Str.begin(), Str.end());
+}
+
+const HostSim::Stats &HostSim::getStats() { return S.Stats; }
+
+void HostSim::timeFifoGaps() {
+  constexpr uint32_t MaxTicks = 4096;
+  std::vector<uint64_t> ClockHist(MaxTicks);
+  for (uint32_t Cnt = 0; Cnt != 1000000; ++Cnt) {
+    uint64_t Start = hostTicks();
+    ++ClockHist[std::min<uint64_t>(hostTicks() - Start, MaxTicks - 1)];
+  }
+  S.ClockTicks = getTrimmedMean(ClockHist);
+  S.FifoGapHist.assign(MaxTicks, 0);
+  S.TimeStartTicks = hostTicks();
+  S.TimeStart = std::chrono::steady_clock::now();
+}
+
+double HostSim::getFifoGapNs() {
+  if (S.FifoGapHist.empty())
+    return 0;
+  double Ns = std::chrono::duration<double, std::nano>(
+                  std::chrono::steady_clock::now() - S.TimeStart)
+                  .count();
+  double NsPerTick = Ns / (hostTicks() - S.TimeStartTicks);
+  return (getTrimmedMean(S.FifoGapHist) - S.ClockTicks) * NsPerTick;
+}
+
+uint64_t HostSim::getFifoGaps() {
+  uint64_t Total = 0;
+  for (uint64_t Cnt : S.FifoGapHist)
+    Total += Cnt;
+  return Total;
+}
+
+// pico/platform.h, pico/time.h
+
+uint get_core_num() { return 1; }
+
+absolute_time_t get_absolute_time() {
+  sdkCall();
+  return S.Now * 1000000 / S.SysHz;
+}
+uint32_t time_us_32() { return (uint32_t)get_absolute_time(); }
+uint64_t time_us_64() { return get_absolute_time(); }
+bool time_reached(absolute_time_t T) { return get_absolute_time() >= T; }
+void sleep_us(uint64_t Us) { HostSim::advance(usToCycles(Us)); }
+void sleep_ms(uint32_t Ms) { sleep_us((uint64_t)Ms * 1000); }
+void busy_wait_us(uint64_t Us) { sleep_us(Us); }
+
+// pico/stdio.h, pico/stdio_usb.h, tusb.h
+
+bool stdio_init_all() { return true; }
+
+int getchar_timeout_us(uint32_t Us) {
+  sdkCall();
+  if (S.StdIn.empty()) {
+    sleep_us(Us);
+    return PICO_ERROR_TIMEOUT;
+  }
+  char C = S.StdIn.front();
+  S.StdIn.pop_front();
+  return (unsigned char)C;
+}
+
+stdio_driver_t stdio_usb = {usbOutChars};
+
+bool stdio_usb_connected() {
+  sdkCall();
+  return S.UsbConnected;
+}
+
+uint32_t tud_cdc_write_available() {
+  sdkCall();
+  if (!S.UsbConnected)
+    return 0;
+  usbDrain();
+  return HostSim::UsbTxBufferSz - (uint32_t)S.UsbFill;
+}
+
+// hardware/clocks.h
+
+uint32_t clock_get_hz(enum clock_index Clk) {
+  switch (Clk) {
+  case clk_sys:
+  case clk_peri:
+    return S.SysHz;
+  case clk_usb:
+  case clk_adc:
+    return 48000000;
+  default:
+    return 12000000;
+  }
+}
+
+uint32_t frequency_count_khz(uint Src) {
+  switch (Src) {
+  case CLOCKS_FC0_SRC_VALUE_CLK_SYS:
+  case CLOCKS_FC0_SRC_VALUE_CLK_PERI:
+    return S.SysHz / 1000;
+  case CLOCKS_FC0_SRC_VALUE_CLK_USB:
+  case CLOCKS_FC0_SRC_VALUE_CLK_ADC:
+    return 48000;
+  default:
+    return 12000;
+  }
+}
+
+bool set_sys_clock_khz(uint32_t KHz, bool) {
+  S.SysHz = KHz * 1000;
+  return true;
+}
+
+// hardware/gpio.h, hardware/structs/io_bank0.h
+
+void gpio_init(uint Pin) {
+  S.Gpio[Pin].Out = false;
+  S.Gpio[Pin].OutVal = false;
+  updateStatic();
+}
+void gpio_set_dir(uint Pin, bool Out) {
+  S.Gpio[Pin].Out = Out;
+  updateStatic();
+}
+void gpio_pull_up(uint Pin) {
+  S.Gpio[Pin].PullUp = true;
+  S.Gpio[Pin].PullDown = false;
+  updateStatic();
+}
+void gpio_pull_down(uint Pin) {
+  S.Gpio[Pin].PullUp = false;
+  S.Gpio[Pin].PullDown = true;
+  updateStatic();
+}
+void gpio_disable_pulls(uint Pin) {
+  S.Gpio[Pin].PullUp = false;
+  S.Gpio[Pin].PullDown = false;
+  updateStatic();
+}
+void gpio_put(uint Pin, bool Val) {
+  sdkCall();
+  S.Gpio[Pin].OutVal = Val;
+  updateStatic();
+}
+void gpio_put_masked(uint32_t Mask, uint32_t Val) {
+  sdkCall();
+  for (uint32_t Pin = 0; Pin != 32; ++Pin)
+    if ((Mask >> Pin) & 1)
+      S.Gpio[Pin].OutVal = (Val >> Pin) & 1;
+  updateStatic();
+}
+void gpio_set_dir_masked(uint32_t Mask, uint32_t Out) {
+  for (uint32_t Pin = 0; Pin != 32; ++Pin)
+    if ((Mask >> Pin) & 1)
+      S.Gpio[Pin].Out = (Out >> Pin) & 1;
+  updateStatic();
+}
+bool gpio_get(uint Pin) {
+  sdkCall();
+  return HostSim::getLevelAt(Pin, S.Now);
+}
+uint32_t gpio_get_all() {
+  sdkCall();
+  return pinsAt(S.Now, S.CPUCursor);
+}
+
+void gpio_acknowledge_irq(uint Pin, uint32_t Events) {
+  sdkCall();
+  if (Events & GPIO_IRQ_EDGE_RISE)
+    S.AckRise[Pin] = S.Now;
+  if (Events & GPIO_IRQ_EDGE_FALL)
+    S.AckFall[Pin] = S.Now;
+}
+
+uint32_t io_bank0_intr_regs::operator[](uint Idx) const {
+  sdkCall();
+  uint32_t Val = 0;
+  for (uint32_t Pin = Idx * 8, E = Pin + 8; Pin != E && Pin < 32; ++Pin) {
+    bool Level = HostSim::getLevelAt(Pin, S.Now);
+    uint32_t Events = Level ? GPIO_IRQ_LEVEL_HIGH : GPIO_IRQ_LEVEL_LOW;
+    if ((S.Driven >> Pin) & 1) {
+      // The edges since the last acknowledge. They alternate, so we only
+      // need to look at the first one to tell their direction.
+      const auto &Edges = S.Edges[Pin];
+      bool Init = (S.States[0] >> Pin) & 1;
+      auto Count = [&](uint64_t From, bool Rise) {
+        size_t Lo = std::upper_bound(Edges.begin(), Edges.end(), From) -
+                    Edges.begin();
+        size_t Hi = std::upper_bound(Edges.begin(), Edges.end(), S.Now) -
+                    Edges.begin();
+        if (Hi - Lo >= 2)
+          return true;
+        // Edge Lo goes to level Init ^ !(Lo & 1).
+        return Hi - Lo == 1 && (Init ^ !(Lo & 1)) == Rise;
+      };
+      if (Count(S.AckRise[Pin], true))
+        Events |= GPIO_IRQ_EDGE_RISE;
+      if (Count(S.AckFall[Pin], false))
+        Events |= GPIO_IRQ_EDGE_FALL;
+    }
+    Val |= Events << (4 * (Pin % 8));
+  }
+  return Val;
+}
+
+static io_bank0_hw_t IoBank0;
+io_bank0_hw_t *const io_bank0_hw = &IoBank0;
+
+// hardware/flash.h
+
+uint8_t HostFlash[FlashSz];
+
+void flash_range_erase(uint32_t Offs, size_t Count) {
+  if (Offs % FLASH_SECTOR_SIZE != 0 || Count % FLASH_SECTOR_SIZE != 0 ||
+      Offs + Count > FlashSz)
+    panic("bad flash erase");
+  memset(&HostFlash[Offs], 0xff, Count);
+  sleep_us((uint64_t)FlashEraseUs * (Count / FLASH_SECTOR_SIZE));
+}
+
+void flash_range_program(uint32_t Offs, const uint8_t *Data, size_t Count) {
+  if (Offs % FLASH_PAGE_SIZE != 0 || Count % FLASH_PAGE_SIZE != 0 ||
+      Offs + Count > FlashSz)
+    panic("bad flash program");
+  // Programming can only clear bits.
+  for (size_t Idx = 0; Idx != Count; ++Idx)
+    HostFlash[Offs + Idx] &= Data[Idx];
+  sleep_us((uint64_t)FlashProgramPageUs * (Count / FLASH_PAGE_SIZE));
+}
+
+// hardware/pio.h
+
+pio_hw_t HostPioHw[NUM_PIOS];
+
+pio_sm_config pio_get_default_sm_config() {
+  pio_sm_config C = {};
+  C.clkdiv = 1 << 8;
+  C.wrap = 31;
+  C.in_shift_right = true;
+  C.out_shift_right = true;
+  C.push_threshold = 32;
+  C.pull_threshold = 32;
+  C.join = PIO_FIFO_JOIN_NONE;
+  return C;
+}
+
+uint pio_add_program(PIO Pio, const pio_program_t *Program) {
+  PioBlock &P = getPio(Pio);
+  uint32_t Mask = (1u << Program->length) - 1;
+  if (Program->length == 32)
+    Mask = ~0u;
+  int Offset = -1;
+  if (Program->origin >= 0) {
+    if ((P.Used & Mask << Program->origin) == 0)
+      Offset = Program->origin;
+  } else {
+    // Like the SDK, from the top.
+    for (int Idx = 32 - Program->length; Idx >= 0 && Offset < 0; --Idx)
+      if ((P.Used & Mask << Idx) == 0)
+        Offset = Idx;
+  }
+  if (Offset < 0)
+    panic("no program space");
+  for (uint Idx = 0; Idx != Program->length; ++Idx) {
+    uint16_t Instr = Program->instructions[Idx];
+    // JMP targets are relative to the program.
+    if ((Instr >> 13) == 0)
+      Instr += Offset;
+    P.Mem[Offset + Idx] = Instr;
+  }
+  P.Used |= Mask << Offset;
+  return Offset;
+}
+
+void pio_remove_program(PIO Pio, const pio_program_t *Program, uint Offset) {
+  uint32_t Mask =
+      Program->length == 32 ? ~0u : (1u << Program->length) - 1;
+  getPio(Pio).Used &= ~(Mask << Offset);
+}
+
+int pio_claim_unused_sm(PIO Pio, bool Required) {
+  for (uint SM = 0; SM != NUM_PIO_STATE_MACHINES; ++SM) {
+    if (!getSM(Pio, SM).Claimed) {
+      getSM(Pio, SM).Claimed = true;
+      return SM;
+    }
+  }
+  if (Required)
+    panic("no free state machine");
+  return -1;
+}
+
+void pio_sm_claim(PIO Pio, uint SM) {
+  if (getSM(Pio, SM).Claimed)
+    panic("state machine already claimed");
+  getSM(Pio, SM).Claimed = true;
+}
+
+void pio_sm_unclaim(PIO Pio, uint SM) { getSM(Pio, SM).Claimed = false; }
+
+void pio_sm_init(PIO Pio, uint SMIdx, uint InitialPC,
+                 const pio_sm_config *C) {
+  sdkCall();
+  StateMachine &SM = getSM(Pio, SMIdx);
+  catchUp(getPio(Pio), SM);
+  SM.Enabled = false;
+  SM.Cfg = C != nullptr ? *C : pio_get_default_sm_config();
+  SM.Rx.Cap = SM.Cfg.join == PIO_FIFO_JOIN_RX   ? 8
+              : SM.Cfg.join == PIO_FIFO_JOIN_TX ? 0
+                                                : 4;
+  SM.Tx.Cap = SM.Cfg.join == PIO_FIFO_JOIN_TX   ? 8
+              : SM.Cfg.join == PIO_FIFO_JOIN_RX ? 0
+                                                : 4;
+  SM.Rx.clear();
+  SM.Tx.clear();
+  restartSM(SM);
+  SM.PC = InitialPC;
+}
+
+void pio_sm_set_enabled(PIO Pio, uint SMIdx, bool Enabled) {
+  sdkCall();
+  StateMachine &SM = getSM(Pio, SMIdx);
+  catchUp(getPio(Pio), SM);
+  if (Enabled && !SM.Enabled)
+    rephase(SM);
+  SM.Enabled = Enabled;
+}
+
+void pio_sm_restart(PIO Pio, uint SMIdx) {
+  sdkCall();
+  StateMachine &SM = getSM(Pio, SMIdx);
+  catchUp(getPio(Pio), SM);
+  restartSM(SM);
+}
+
+void pio_sm_clear_fifos(PIO Pio, uint SMIdx) {
+  sdkCall();
+  StateMachine &SM = getSM(Pio, SMIdx);
+  catchUp(getPio(Pio), SM);
+  SM.Rx.clear();
+  SM.Tx.clear();
+}
+
+void pio_sm_exec(PIO Pio, uint SMIdx, uint Instr) {
+  sdkCall();
+  StateMachine &SM = getSM(Pio, SMIdx);
+  catchUp(getPio(Pio), SM);
+  ExecResult R = execute(SM, Instr, SM.PC);
+  if (R.E != Exec::Done)
+    panic("pio_sm_exec() of a stalling instruction is not supported");
+  // A JMP changes the PC, anything else leaves it alone.
+  if ((Instr >> 13) == 0 || R.PC != nextPC(SM, SM.PC))
+    SM.PC = R.PC;
+  rephase(SM);
+}
+
+void pio_sm_set_consecutive_pindirs(PIO, uint, uint Base, uint Count,
+                                    bool IsOut) {
+  for (uint Pin = Base; Pin != Base + Count; ++Pin)
+    S.Gpio[Pin % 32].Out = IsOut;
+  updateStatic();
+}
+
+void pio_sm_set_clkdiv_int_frac(PIO Pio, uint SMIdx, uint16_t Int,
+                                uint8_t Frac) {
+  sdkCall();
+  StateMachine &SM = getSM(Pio, SMIdx);
+  catchUp(getPio(Pio), SM);
+  SM.Cfg.clkdiv = (uint32_t)Int << 8 | Frac;
+}
+
+uint pio_sm_get_rx_fifo_level(PIO Pio, uint SMIdx) {
+  sdkCall();
+  StateMachine &SM = getSM(Pio, SMIdx);
+  catchUp(getPio(Pio), SM);
+  return SM.Rx.Cnt;
+}
+
+uint pio_sm_get_tx_fifo_level(PIO Pio, uint SMIdx) {
+  sdkCall();
+  StateMachine &SM = getSM(Pio, SMIdx);
+  catchUp(getPio(Pio), SM);
+  return SM.Tx.Cnt;
+}
+
+bool pio_sm_is_rx_fifo_empty(PIO Pio, uint SM) {
+  return pio_sm_get_rx_fifo_level(Pio, SM) == 0;
+}
+
+bool pio_sm_is_rx_fifo_full(PIO Pio, uint SMIdx) {
+  sdkCall();
+  StateMachine &SM = getSM(Pio, SMIdx);
+  catchUp(getPio(Pio), SM);
+  return SM.Rx.full();
+}
+
+bool pio_sm_is_tx_fifo_full(PIO Pio, uint SMIdx) {
+  sdkCall();
+  StateMachine &SM = getSM(Pio, SMIdx);
+  catchUp(getPio(Pio), SM);
+  return SM.Tx.full();
+}
+
+uint32_t pio_sm_get(PIO Pio, uint SMIdx) {
+  sdkCall();
+  StateMachine &SM = getSM(Pio, SMIdx);
+  catchUp(getPio(Pio), SM);
+  // Reading an empty FIFO returns garbage on the hardware.
+  uint32_t Val = SM.Rx.empty() ? 0 : SM.Rx.pop();
+  if (!S.FifoGapHist.empty()) {
+    S.InFifoGap = true;
+    S.FifoGapStart = hostTicks();
+  }
+  return Val;
+}
+
+uint32_t pio_sm_get_blocking(PIO Pio, uint SM) {
+  while (pio_sm_is_rx_fifo_empty(Pio, SM))
+    ;
+  return pio_sm_get(Pio, SM);
+}
+
+void pio_sm_put(PIO Pio, uint SMIdx, uint32_t Data) {
+  sdkCall();
+  StateMachine &SM = getSM(Pio, SMIdx);
+  catchUp(getPio(Pio), SM);
+  if (!SM.Tx.full())
+    SM.Tx.push(Data);
+}
+
+void pio_sm_put_blocking(PIO Pio, uint SM, uint32_t Data) {
+  while (pio_sm_is_tx_fifo_full(Pio, SM))
+    ;
+  pio_sm_put(Pio, SM, Data);
+}
+
+// hardware/dma.h
+
+int dma_claim_unused_channel(bool Required) {
+  for (uint Ch = 0; Ch != NumDMAChannels; ++Ch) {
+    if (!S.Channels[Ch].Claimed) {
+      S.Channels[Ch].Claimed = true;
+      return Ch;
+    }
+  }
+  if (Required)
+    panic("no free DMA channel");
+  return -1;
+}
+
+void dma_channel_unclaim(uint Ch) {
+  finishDMA(S.Channels[Ch]);
+  S.Channels[Ch].Claimed = false;
+}
+
+dma_channel_config dma_channel_get_default_config(uint Ch) {
+  dma_channel_config C = {};
+  C.size = DMA_SIZE_32;
+  C.read_increment = true;
+  C.write_increment = false;
+  C.dreq = DREQ_FORCE;
+  C.chain_to = Ch;
+  return C;
+}
+
+void dma_channel_configure(uint ChIdx, const dma_channel_config *C,
+                           volatile void *Dst, const volatile void *Src,
+                           uint Count, bool Trigger) {
+  sdkCall();
+  catchUpAll();
+  Channel &Ch = S.Channels[ChIdx];
+  finishDMA(Ch);
+  Ch.Cfg = *C;
+  Ch.Write = (volatile uint8_t *)Dst;
+  Ch.Read = (const volatile uint8_t *)Src;
+  Ch.Hw.transfer_count = Count;
+  if (!Trigger || Count == 0)
+    return;
+  Ch.Busy = true;
+  if (C->dreq == DREQ_FORCE) {
+    // Memory to memory, we can do it all right away.
+    uint32_t Sz = 1u << C->size;
+    while (Ch.Busy) {
+      uint32_t Val = 0;
+      memcpy(&Val, (const void *)Ch.Read, Sz);
+      if (C->read_increment)
+        Ch.Read += Sz;
+      dmaWrite(Ch, Val);
+    }
+    return;
+  }
+  uint PioIdx = C->dreq / 8;
+  if (PioIdx >= NUM_PIOS || (C->dreq & 4) == 0 ||
+      Src != &HostPioHw[PioIdx].rxf[C->dreq % 4])
+    panic("only PIO RX FIFO DMA is supported");
+  StateMachine &SM = S.Pios[PioIdx].SMs[C->dreq % 4];
+  Ch.SM = &SM;
+  SM.RxDMA = &Ch;
+  // Whatever is already in the FIFO goes first.
+  while (!SM.Rx.empty() && Ch.Busy)
+    dmaWrite(Ch, SM.Rx.pop());
+}
+
+void dma_channel_abort(uint Ch) {
+  sdkCall();
+  catchUpAll();
+  finishDMA(S.Channels[Ch]);
+}
+
+bool dma_channel_is_busy(uint Ch) {
+  sdkCall();
+  catchUpAll();
+  return S.Channels[Ch].Busy;
+}
+
+dma_channel_hw_t *dma_channel_hw_addr(uint Ch) {
+  sdkCall();
+  catchUpAll();
+  return &S.Channels[Ch].Hw;
+}
+
+// hardware/interp.h
+
+interp_hw_t *const interp0 = &S.Interps[0];
+interp_hw_t *const interp1 = &S.Interps[1];
+
+interp_config interp_default_config() {
+  interp_config C = {0};
+  interp_config_set_mask(&C, 0, 31);
+  return C;
+}
+
+void interp_set_config(interp_hw_t *Interp, uint Lane, interp_config *C) {
+  Interp->ctrl[Lane] = C->ctrl;
+}
+
+uint32_t interp_peek_lane_result(interp_hw_t *Interp, uint Lane) {
+  sdkCall();
+  return interpLaneResult(Interp, Lane);
+}
+
+uint32_t interp_pop_lane_result(interp_hw_t *Interp, uint Lane) {
+  sdkCall();
+  uint32_t Res = interpLaneResult(Interp, Lane);
+  interpPop(Interp);
+  return Res;
+}
+
+interp_reg_t interp_peek_full_result(interp_hw_t *Interp) {
+  sdkCall();
+  return interpFullResult(Interp);
+}
+
+interp_reg_t interp_pop_full_result(interp_hw_t *Interp) {
+  sdkCall();
+  interp_reg_t Res = interpFullResult(Interp);
+  interpPop(Interp);
+  return Res;
+}
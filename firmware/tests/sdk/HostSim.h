@@ -0,0 +1,96 @@
+//-*- C++ -*-
+//
+// Copyright (C) 2025 Scrap Computing
+//
+// The simulated hardware behind HostSdk.h. The capture core is the only CPU:
+// it spends SdkCallCycles in each call that touches the hardware and no time
+// anywhere else, so the simulation finds functional bugs but it is not a
+// cycle-accurate model of the firmware. Everything else runs on the same
+// system clock: the PIOs execute their programs one instruction per divided
+// clock against a recorded GPIO trace, and the callbacks of at() stand in for
+// core0.
+//
+
+#ifndef __TESTS_SDK_HOSTSIM_H__
+#define __TESTS_SDK_HOSTSIM_H__
+
+#include "HostSdk.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace HostSim {
+/// What each SDK call that touches the hardware costs the capture core.
+static constexpr const uint32_t SdkCallCycles = 4;
+/// The TinyUSB CDC transmit buffer.
+static constexpr const uint32_t UsbTxBufferSz = 256;
+
+/// Thrown from the SDK calls once the simulation runs past the end of the
+/// GPIO trace. This is how the tests get out of runForEver().
+struct EndOfTrace {};
+
+/// Restores the power-on state: no trace, no timers, erased flash, default
+/// system clock, nothing claimed.
+void reset();
+
+/// \Returns the system clock cycles since boot.
+uint64_t now();
+/// \Returns the system clock frequency in Hz.
+uint32_t getSysHz();
+/// Lets \p Cycles of the system clock go by on the capture core.
+void advance(uint64_t Cycles);
+
+/// The GPIO inputs of a recording: from TimesPs[Idx] (picoseconds since the
+/// start of the recording) the GPIOs in \p Driven are at the levels of
+/// States[Idx]. The recording starts now(), the times are converted to
+/// cycles of the current system clock, so set it first.
+struct Trace {
+  std::vector<uint64_t> TimesPs;
+  std::vector<uint32_t> States;
+  uint32_t Driven = 0;
+};
+void loadTrace(const Trace &T);
+/// Reads a trace written by tools/replay.py: the magic "MCEEDGE1", the
+/// little-endian uint32_t Driven mask and then (uint64_t TimePs,
+/// uint32_t State) records. \Returns false and sets \p Err on error.
+bool readTraceFile(const char *Path, Trace &T, std::string &Err);
+/// \Returns the cycle of the last change of the trace.
+uint64_t getTraceEnd();
+/// \Returns the level of \p Pin at cycle \p Cycle.
+bool getLevelAt(uint32_t Pin, uint64_t Cycle);
+/// \Returns the first cycle from \p Cycle when \p Pin is at \p Level, or
+/// UINT64_MAX if it never is.
+uint64_t findLevel(uint32_t Pin, bool Level, uint64_t Cycle);
+
+/// Calls \p Fn once now() reaches \p Cycle. The callbacks run on "core0": the
+/// SDK calls they make take no time.
+void at(uint64_t Cycle, std::function<void()> Fn);
+
+/// Connects a USB host that reads \p BytesPerSec. Everything written to
+/// stdio_usb goes to \p Sink.
+void connectUsb(uint32_t BytesPerSec,
+                std::function<void(const char *, int)> Sink);
+/// Queues \p Str for getchar_timeout_us().
+void sendChars(const std::string &Str);
+
+struct Stats {
+  /// PIO instructions executed, and the waits and loops skipped over.
+  uint64_t PioSteps = 0;
+  uint64_t PioSkips = 0;
+  /// Words that the DMA moved.
+  uint64_t DmaWords = 0;
+};
+const Stats &getStats();
+/// Starts timing the firmware code from each pio_sm_get() to the next SDK
+/// call, which is one iteration of a capture loop. This is how the host build
+/// compares two versions of a capture loop, in host time: the Pico's timing
+/// is different.
+void timeFifoGaps();
+/// \Returns the mean of the gaps timed since timeFifoGaps() in host ns,
+/// without the time of reading the clock and the slowest 1%.
+double getFifoGapNs();
+/// \Returns the number of gaps timed since timeFifoGaps().
+uint64_t getFifoGaps();
+} // namespace HostSim
+
+#endif // __TESTS_SDK_HOSTSIM_H__
@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2025 Scrap Computing
+#
+# Fails if the heap allocator can be reached from the functions that run from
+# RAM, i.e. the ones marked with __not_in_flash_func(), which are the capture
+# and scanout loops. It builds the call graph from the disassembly of the ELF
+# file, so it only follows direct calls and tail calls (including the long
+# call veneers from RAM to flash), not calls through function pointers or
+# virtual functions.
+#
+# The build runs it with -DHEAP_CHECK=on. It can also be run by hand:
+#   heapcheck.py build/MCEBlaster.elf
+#   heapcheck.py --root 'TTLReader.*runForEver' build/MCEBlaster.elf
+#   heapcheck.py --self-test
+#
+
+import argparse
+import re
+import shutil
+import subprocess
+import sys
+
+# The allocation functions, including the ones wrapped by pico_malloc and
+# operator new/new[].
+FORBIDDEN = re.compile(r"^(__wrap_)?_?(malloc|calloc|realloc|memalign)(_r)?$|"
+                       r"^_Zn[wa][jm]")
+RAM_START = 0x20000000
+RAM_END = 0x30000000
+
+# The host build of the tests keeps the functions in their .time_critical
+# sections, like the SDK before linking.
+RAM_SECTION = ".time_critical."
+
+SECTION_RE = re.compile(r"^Disassembly of section (.+):$")
+FUNC_RE = re.compile(r"^([0-9a-f]+) <(.+)>:$")
+# e.g. "10000256:	f000 f8a2 	bl	1000039e <foo+0x4>"
+# or on the host "26640:	e8 ab 02 00 00	call   268f0 <foo@plt>"
+BRANCH_RE = re.compile(r"^\s*[0-9a-f]+:\s.*\s(b|bl|blx|b\.n|b\.w|b[a-z]{2}"
+                       r"(\.n|\.w)?|call|jmp|j[a-z]{1,3})\s+[0-9a-f]+ "
+                       r"<([^>+]+)(\+0x[0-9a-f]+)?>$")
+VENEER_RE = re.compile(r"^__(.+)_veneer$")
+PLT_RE = re.compile(r"@plt$")
+
+
+def parse(lines):
+    """Returns ({Function: Address}, {Function: set(Callee)},
+    {Function: Section})."""
+    addrs = {}
+    calls = {}
+    sections = {}
+    section = ""
+    func = None
+    for line in lines:
+        line = line.rstrip()
+        match = SECTION_RE.match(line)
+        if match:
+            section = match.group(1)
+            continue
+        match = FUNC_RE.match(line)
+        if match:
+            func = PLT_RE.sub("", match.group(2))
+            addrs[func] = int(match.group(1), 16)
+            sections[func] = section
+            calls.setdefault(func, set())
+            veneer = VENEER_RE.match(func)
+            if veneer:
+                calls[func].add(veneer.group(1))
+            continue
+        match = BRANCH_RE.match(line)
+        if match and func is not None:
+            callee = PLT_RE.sub("", match.group(3))
+            if callee != func:
+                calls[func].add(callee)
+    return addrs, calls, sections
+
+
+def find_paths(addrs, calls, roots):
+    """Returns a list of call chains from roots to FORBIDDEN functions, the
+    shortest one for each root."""
+    paths = []
+    for root in sorted(roots):
+        parent = {root: None}
+        queue = [root]
+        while queue:
+            func = queue.pop(0)
+            if FORBIDDEN.search(func):
+                path = []
+                while func is not None:
+                    path.append(func)
+                    func = parent[func]
+                paths.append(path[::-1])
+                break
+            for callee in sorted(calls.get(func, ())):
+                if callee not in parent:
+                    parent[callee] = func
+                    queue.append(callee)
+    return paths
+
+
+def find_roots(addrs, sections, patterns):
+    roots = {func for func, addr in addrs.items()
+             if (RAM_START <= addr < RAM_END or
+                 sections.get(func, "").startswith(RAM_SECTION)) and
+             not VENEER_RE.match(func)}
+    if patterns:
+        funcs = list(addrs)
+        names = dict(zip(funcs, demangle(funcs)))
+        for pattern in patterns:
+            regex = re.compile(pattern)
+            roots |= {func for func in funcs
+                      if regex.search(func) or regex.search(names[func])}
+    return roots
+
+
+def demangle(names):
+    if not shutil.which("c++filt"):
+        return names
+    res = subprocess.run(["c++filt"], input="\n".join(names), text=True,
+                         capture_output=True)
+    return res.stdout.splitlines() if res.returncode == 0 else names
+
+
+def self_test():
+    disasm = """
+10000100 <malloc>:
+10000100:	b510      	push	{r4, lr}
+
+10000200 <_Z4workv>:
+10000200:	f7ff ff7e 	bl	10000100 <malloc>
+10000204:	e7fc      	b.n	10000200 <_Z4workv>
+
+10000300 <__wrap_puts>:
+10000300:	4770      	bx	lr
+
+20000100 <_Z4scanv>:
+20000100:	f000 f80a 	bl	20000118 <___Z4workv_veneer>
+20000104:	d1fc      	bne.n	20000100 <_Z4scanv>
+
+20000118 <___Z4workv_veneer>:
+20000118:	f85f f000 	ldr.w	pc, [pc]
+
+20000200 <_Z4fastv>:
+20000200:	f000 f87e 	bl	10000300 <__wrap_puts>
+20000204:	f7ff bffc 	b.w	20000200 <_Z4fastv+0x0>
+""".splitlines()
+    addrs, calls, sections = parse(disasm)
+    assert calls["_Z4workv"] == {"malloc"}, calls
+    assert calls["___Z4workv_veneer"] == {"_Z4workv"}, calls
+    roots = find_roots(addrs, sections, [])
+    assert roots == {"_Z4scanv", "_Z4fastv"}, roots
+    paths = find_paths(addrs, calls, roots)
+    assert paths == [["_Z4scanv", "___Z4workv_veneer", "_Z4workv",
+                      "malloc"]], paths
+    assert find_paths(addrs, calls, {"_Z4fastv"}) == []
+    assert find_roots(addrs, sections, ["^_Z4workv$"]) >= {"_Z4workv"}
+    # The host build of the tests, on x86-64.
+    host = """
+Disassembly of section .plt:
+
+0000000000004030 <malloc@plt>:
+    4030:	ff 25 e2 6f 00 00    	jmp    *0x6fe2(%rip)
+
+Disassembly of section .text:
+
+0000000000005000 <_Z4workv>:
+    5000:	e8 2b f0 ff ff       	call   4030 <malloc@plt>
+    5005:	c3                   	ret
+
+0000000000005010 <_Z4idlev>:
+    5010:	c3                   	ret
+
+Disassembly of section .time_critical.scan:
+
+0000000000006000 <_Z4scanv>:
+    6000:	74 0e                	je     6010 <_Z4scanv+0x10>
+    6002:	e9 f9 ef ff ff       	jmp    5000 <_Z4workv>
+
+Disassembly of section .time_critical.fast:
+
+0000000000006100 <_Z4fastv>:
+    6100:	e8 0b ef ff ff       	call   5010 <_Z4idlev>
+""".splitlines()
+    addrs, calls, sections = parse(host)
+    assert calls["_Z4workv"] == {"malloc"}, calls
+    roots = find_roots(addrs, sections, [])
+    assert roots == {"_Z4scanv", "_Z4fastv"}, roots
+    paths = find_paths(addrs, calls, roots)
+    assert paths == [["_Z4scanv", "_Z4workv", "malloc"]], paths
+    for name in ("_Znwj", "_Znaj", "__wrap_malloc", "_malloc_r", "realloc"):
+        assert FORBIDDEN.search(name), name
+    assert not FORBIDDEN.search("malloc_stats")
+    print("Self-test OK")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Checks that the functions in RAM can't reach malloc.")
+    parser.add_argument("elf", nargs="?", help="The firmware ELF file")
+    parser.add_argument("--objdump", default="arm-none-eabi-objdump")
+    parser.add_argument("--root", action="append", default=[],
+                        help="Also check the functions matching this regex")
+    parser.add_argument("--self-test", action="store_true")
+    args = parser.parse_args()
+    if args.self_test:
+        self_test()
+        return
+    if args.elf is None:
+        parser.error("the ELF file is required")
+    res = subprocess.run([args.objdump, "-d", args.elf], text=True,
+                         capture_output=True)
+    if res.returncode != 0:
+        sys.exit("heapcheck: %s failed: %s" % (args.objdump, res.stderr))
+    addrs, calls, sections = parse(res.stdout.splitlines())
+    roots = find_roots(addrs, sections, args.root)
+    paths = find_paths(addrs, calls, roots)
+    for path in paths:
+        print("heapcheck: " + " -> ".join(demangle(path)), file=sys.stderr)
+    if paths:
+        sys.exit("heapcheck: %d of %d functions can allocate" %
+                 (len(paths), len(roots)))
+    print("heapcheck: %d functions checked" % len(roots))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
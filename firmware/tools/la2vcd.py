@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2025 Scrap Computing
+#
+# Converts the logic analyzer captures that the firmware prints to the USB
+# serial port into VCD files, which can be viewed with e.g. GTKWave or
+# PulseView. The format is described in firmware/src/LogicAnalyzer.h.
+#
+# Usage:
+#   Save the serial output to a file, e.g. with minicom's capture or with:
+#     cat /dev/ttyACM0 > log.txt
+#   then run a capture (medium press in the TTL info page) and:
+#     la2vcd.py log.txt -o capture.vcd
+#   Any other output in the log is skipped. If the log has several captures
+#   they are saved as capture_1.vcd, capture_2.vcd etc.
+#
+
+import argparse
+import os
+import sys
+
+FORMAT_VERSION = 1
+
+# The bit of each GPIO in a sample, see LogicAnalyzer.pio.
+SIGNALS = [(gpio + 2, "gpio%d" % gpio) for gpio in range(14)]
+SIGNALS += [(0, "gpio26"), (1, "gpio27")]
+NAMES = {
+    "gpio6": "gpio6_vsync",
+    "gpio7": "gpio7_hsync",
+    "gpio26": "gpio26_mda_intensity",
+    "gpio27": "gpio27_mda_video",
+}
+
+
+class Capture:
+    def __init__(self, rate, num_samples, trigger):
+        self.rate = rate
+        self.num_samples = num_samples
+        self.trigger = trigger
+        # (Sample, Count) runs.
+        self.runs = []
+
+
+def parse(lines):
+    """Returns the captures found in lines."""
+    captures = []
+    cap = None
+    for line in lines:
+        words = line.split()
+        if not words:
+            continue
+        if words[0] == "LA-BEGIN" and len(words) == 5:
+            if int(words[1]) != FORMAT_VERSION:
+                sys.exit("Unsupported format version %s" % words[1])
+            cap = Capture(int(words[2]), int(words[3]), words[4])
+        elif words[0] == "LA" and cap is not None:
+            for run in words[1:]:
+                sample, cnt = run.split(":")
+                cap.runs.append((int(sample, 16), int(cnt, 16)))
+        elif words[0] == "LA-END" and cap is not None:
+            total = sum(cnt for _, cnt in cap.runs)
+            if total != cap.num_samples:
+                print("Warning: got %d of %d samples" %
+                      (total, cap.num_samples), file=sys.stderr)
+            captures.append(cap)
+            cap = None
+    return captures
+
+
+def write_vcd(cap, path):
+    ids = [chr(ord("!") + idx) for idx in range(len(SIGNALS))]
+    with open(path, "w") as f:
+        f.write("$comment MCEBlaster logic analyzer, %d Hz, trigger %s "
+                "$end\n" % (cap.rate, cap.trigger))
+        f.write("$timescale 1ns $end\n")
+        f.write("$scope module mceblaster $end\n")
+        for (_, name), ident in zip(SIGNALS, ids):
+            f.write("$var wire 1 %s %s $end\n" % (ident, NAMES.get(name, name)))
+        f.write("$upscope $end\n$enddefinitions $end\n")
+        idx = 0
+        last = None
+        for sample, cnt in cap.runs:
+            changes = []
+            for (bit, _), ident in zip(SIGNALS, ids):
+                val = (sample >> bit) & 1
+                if last is None or val != (last >> bit) & 1:
+                    changes.append("%d%s" % (val, ident))
+            if changes:
+                f.write("#%d\n%s\n" % (idx * 10**9 // cap.rate,
+                                       "\n".join(changes)))
+            last = sample
+            idx += cnt
+        f.write("#%d\n" % (idx * 10**9 // cap.rate))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Converts MCEBlaster logic analyzer captures to VCD.")
+    parser.add_argument("log", help="The saved serial output")
+    parser.add_argument("-o", "--out", default="capture.vcd",
+                        help="The VCD file to write")
+    args = parser.parse_args()
+    with open(args.log, errors="replace") as f:
+        captures = parse(f)
+    if not captures:
+        sys.exit("No captures found in %s" % args.log)
+    for num, cap in enumerate(captures, 1):
+        path = args.out
+        if len(captures) > 1:
+            base, ext = os.path.splitext(args.out)
+            path = "%s_%d%s" % (base, num, ext)
+        write_vcd(cap, path)
+        print("%s: %d samples at %d Hz, trigger %s" %
+              (path, cap.num_samples, cap.rate, cap.trigger))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
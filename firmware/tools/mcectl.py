@@ -0,0 +1,256 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2025 Scrap Computing
+#
+# Client for the command protocol of firmware built with -DUSB_COMMANDS=on.
+# The protocol is described in TTLReader::runCommand() in
+# firmware/src/TTLReader.h. It can be used as a library:
+#
+#   with Client("/dev/ttyACM0") as mce:
+#       print(mce.stats()["VHZ"])
+#       mce.set("PXCLK", 14318181)
+#       mce.commit()
+#
+# or from the command line:
+#   mcectl.py /dev/ttyACM0 stats
+#   mcectl.py /dev/ttyACM0 watch            Print the stats every second
+#   mcectl.py /dev/ttyACM0 set offset 3
+#   mcectl.py /dev/ttyACM0 commit
+#   mcectl.py /dev/ttyACM0 trace            Print the event trace, see
+#                                           tracedump.py to decode it
+#   mcectl.py --self-test                   Test the client with a fake device
+#
+
+import argparse
+import os
+import select
+import sys
+import time
+
+PROTOCOL_VERSION = 1
+SETTINGS = ("PXCLK", "OFFSET", "XBORDER", "YBORDER", "PROFILE")
+
+
+class CommandError(Exception):
+    """The device replied with =ERR."""
+
+
+class Client:
+    """Sends one request at a time and collects the reply. Lines that are not
+    part of the protocol, like debug messages, are skipped."""
+
+    def __init__(self, path=None, fd=None, timeout=2.0):
+        if fd is None:
+            fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+            if os.isatty(fd):
+                import tty
+                tty.setraw(fd)
+        self.fd = fd
+        self.timeout = timeout
+        self.buf = b""
+
+    def close(self):
+        os.close(self.fd)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def _readline(self, deadline):
+        while b"\n" not in self.buf:
+            left = deadline - time.monotonic()
+            if left <= 0 or not select.select([self.fd], [], [], left)[0]:
+                raise TimeoutError("no reply from the device")
+            data = os.read(self.fd, 4096)
+            if not data:
+                raise EOFError("the device closed the connection")
+            self.buf += data
+        line, self.buf = self.buf.split(b"\n", 1)
+        return line.decode(errors="replace").strip()
+
+    def command(self, *words, other=None):
+        """Sends a request and returns the reply values as a dict. Raises
+        CommandError if the device replies with an error. The lines that are
+        not part of the protocol are appended to the list other, if given."""
+        os.write(self.fd, (" ".join(str(word) for word in words) +
+                           "\n").encode())
+        deadline = time.monotonic() + self.timeout
+        values = {}
+        while True:
+            line = self._readline(deadline)
+            if line.startswith("+"):
+                key, _, val = line[1:].partition(" ")
+                values[key] = val
+            elif line == "=OK":
+                return values
+            elif line.startswith("=ERR"):
+                raise CommandError(line[5:] or "UNKNOWN")
+            elif other is not None:
+                other.append(line)
+
+    def ping(self):
+        self.command("PING")
+
+    def version(self):
+        return self.command("VERSION")
+
+    def stats(self):
+        """Returns the STATS values, converted to int or float if they are
+        numbers."""
+        res = {}
+        for key, val in self.command("STATS").items():
+            for conv in (int, float):
+                try:
+                    val = conv(val)
+                    break
+                except ValueError:
+                    pass
+            res[key] = val
+        return res
+
+    def set(self, setting, value):
+        """Changes a setting, it is only saved to flash by commit()."""
+        if setting.upper() not in SETTINGS:
+            raise ValueError("unknown setting %s" % setting)
+        self.command("SET", setting.upper(), int(value))
+
+    def commit(self):
+        self.command("COMMIT")
+
+    def trace(self):
+        """Returns the lines of the event trace, see tracedump.py."""
+        lines = []
+        self.command("TRACE", other=lines)
+        return lines
+
+
+class FakeDevice:
+    """Replies like the firmware, for testing the client."""
+
+    def __init__(self, fd):
+        self.fd = fd
+        self.buf = b""
+        self.settings = {"PXCLK": 14318181, "OFFSET": 0, "XBORDER": 160,
+                         "YBORDER": 30, "PROFILE": 0}
+        self.saved = dict(self.settings)
+
+    def serve(self):
+        """Answers the requests that arrived."""
+        while select.select([self.fd], [], [], 0)[0]:
+            self.buf += os.read(self.fd, 4096)
+        while b"\n" in self.buf:
+            line, self.buf = self.buf.split(b"\n", 1)
+            words = line.decode().upper().split()
+            out = ["TTLReader: debug noise"]
+            if words == ["PING"]:
+                out.append("=OK")
+            elif words == ["VERSION"]:
+                out += ["+PROTOCOL %d" % PROTOCOL_VERSION,
+                        "+FIRMWARE MCEBlaster_test", "=OK"]
+            elif words == ["STATS"]:
+                out += ["+VHZ 59.92", "+VPOL P", "+MODE CGA"]
+                out += ["+%s %d" % item for item in self.settings.items()]
+                out.append("=OK")
+            elif len(words) == 3 and words[0] == "SET":
+                if words[1] not in self.settings:
+                    out.append("=ERR UNKNOWN_SETTING")
+                elif words[1] == "XBORDER" and int(words[2]) % 4:
+                    out.append("=ERR OUT_OF_RANGE")
+                else:
+                    self.settings[words[1]] = int(words[2])
+                    out.append("=OK")
+            elif words == ["COMMIT"]:
+                self.saved = dict(self.settings)
+                out.append("=OK")
+            elif words == ["TRACE"]:
+                out += ["TRACE-BEGIN 1 0 1 1", "TR 10 0 0 1 0 0",
+                        "TRACE-END", "=OK"]
+            else:
+                out.append("=ERR UNKNOWN_COMMAND")
+            os.write(self.fd, ("\r\n".join(out) + "\r\n").encode())
+
+
+def self_test():
+    import socket
+    import threading
+    host, dev = socket.socketpair()
+    fake = FakeDevice(dev.fileno())
+    stop = threading.Event()
+
+    def run():
+        while not stop.is_set():
+            select.select([dev.fileno()], [], [], 0.05)
+            fake.serve()
+
+    thread = threading.Thread(target=run)
+    thread.start()
+    try:
+        mce = Client(fd=host.fileno())
+        mce.ping()
+        assert mce.version()["PROTOCOL"] == str(PROTOCOL_VERSION)
+        stats = mce.stats()
+        assert stats["VHZ"] == 59.92 and stats["MODE"] == "CGA", stats
+        assert stats["PXCLK"] == 14318181, stats
+        mce.set("offset", 3)
+        assert mce.stats()["OFFSET"] == 3
+        assert fake.saved["OFFSET"] == 0
+        mce.commit()
+        assert fake.saved["OFFSET"] == 3
+        assert mce.trace() == ["TTLReader: debug noise", "TRACE-BEGIN 1 0 1 1",
+                               "TR 10 0 0 1 0 0", "TRACE-END"]
+        for bad in (("XBORDER", 3), ("PXCLK", "x")):
+            try:
+                mce.set(*bad)
+                assert False, bad
+            except (CommandError, ValueError):
+                pass
+        try:
+            mce.command("BOGUS")
+            assert False
+        except CommandError as err:
+            assert str(err) == "UNKNOWN_COMMAND", err
+    finally:
+        stop.set()
+        thread.join()
+        host.close()
+        dev.close()
+    print("Self-test OK")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Reads and changes the settings of an MCEBlaster built "
+        "with -DUSB_COMMANDS=on.")
+    parser.add_argument("port", nargs="?", help="The serial device")
+    parser.add_argument("command", nargs="*",
+                        help="stats, watch, version, set <setting> <value>, "
+                        "commit, trace, or any raw request")
+    parser.add_argument("--self-test", action="store_true")
+    args = parser.parse_args()
+    if args.self_test:
+        self_test()
+        return
+    if args.port is None or not args.command:
+        parser.error("port and command are required")
+    cmd = [word.upper() for word in args.command]
+    with Client(args.port) as mce:
+        try:
+            if cmd == ["WATCH"]:
+                while True:
+                    stats = mce.stats()
+                    print(" ".join("%s=%s" % item for item in stats.items()))
+                    time.sleep(1)
+            if cmd == ["TRACE"]:
+                print("\n".join(mce.trace()))
+                return
+            values = mce.command(*cmd)
+        except CommandError as err:
+            sys.exit("Error: %s" % err)
+        for key, val in values.items():
+            print("%s %s" % (key, val))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
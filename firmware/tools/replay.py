@@ -0,0 +1,612 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2025 Scrap Computing
+#
+# Replays logic analyzer recordings of a video card's TTL output through the
+# firmware's capture code and saves the frames it captured. This lets us keep a
+# corpus of recordings of problem cards and check every firmware change
+# against them without any hardware.
+#
+# The capture runs in TTLReplay, a host build of TTLReader and the rest of the
+# capture code on top of a simulation of the Pico SDK (firmware/tests/sdk/):
+# the PIO programs run instruction by instruction against the recorded GPIOs,
+# the DMA and the interpolators move the data like on the Pico, and core0
+# checks for the input signal once per VGA frame. So the mode detection, the
+# sampling, the auto-adjust and the palettes are the firmware's own. The
+# simulation is functional, not cycle-accurate: the CPU only spends time in
+# the SDK calls, so it does not find bugs that depend on how fast core1 is.
+#
+# This script converts the recording to the trace of TTLReplay (the color pins
+# go to both the EGA and the CGA GPIOs, like on the board), runs it, and reads
+# back the frame buffer at the end of each VSync retrace.
+#
+# Build TTLReplay with the host tests:
+#   cmake -B build_tests firmware/tests/ && cmake --build build_tests
+#
+# Supported recordings:
+#  - VCD files, e.g. exported by PulseView or from la2vcd.py. Each 1-bit wire
+#    is mapped to a GPIO by its name, see --pin.
+#  - sigrok session files (.sr) from sigrok-cli or PulseView.
+#
+# Usage:
+#   replay.py card.sr -o frames/                 Save each frame as PPM
+#   replay.py card.sr --pin D3=7 --pin D2=6      Map probes D3/D2 to HSync/VSync
+#   replay.py card.vcd --save-hashes card.sha    Record the expected frames
+#   replay.py card.vcd --check card.sha          Exits with 1 if they changed
+#   replay.py card.vcd --bench 10                Time the capture loops
+#   replay.py --lock-times 40                    Time the mode switches
+#   replay.py --self-test                        Replay a synthetic CGA signal
+# TTLReplay is looked up in build_tests/, or use --replay-bin.
+#
+
+import argparse
+import collections
+import configparser
+import hashlib
+import io
+import itertools
+import os
+import random
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+import zipfile
+
+SRC_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..",
+                       "src")
+REPO_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..",
+                        "..")
+
+# Signal names that map to a GPIO. Names of the form gpioN map to N.
+PIN_NAMES = {
+    "vsync": "TTL_VSYNC_GPIO", "vs": "TTL_VSYNC_GPIO", "v": "TTL_VSYNC_GPIO",
+    "hsync": "TTL_HSYNC_GPIO", "hs": "TTL_HSYNC_GPIO", "h": "TTL_HSYNC_GPIO",
+    # EGA names, CGA uses the secondary green for intensity.
+    "sb": 0, "b": 1, "pb": 1, "sg": 2, "i": 2, "g": 3, "pg": 3, "sr": 4,
+    "r": 5, "pr": 5,
+    "mda_intensity": "MDA_VI_GPIO", "intensity": "MDA_VI_GPIO",
+    "mda_video": "MDA_VI_GPIO+1", "video": "MDA_VI_GPIO+1",
+}
+
+
+def read_constants():
+    """Returns the integer and float constants of Common.h and Timings.h."""
+    consts = {}
+    for name in ("Common.h", "Timings.h"):
+        with open(os.path.join(SRC_DIR, name)) as f:
+            src = re.sub(r"//[^\n]*", "", f.read())
+        for match in re.finditer(r"static constexpr (?:const )?\w+ (\w+) =\s*"
+                                 r"([^;{]+);", src):
+            expr = re.sub(r"\b(\d+)u\b", r"\1", match.group(2))
+            expr = re.sub(r"\b(\d+\.\d*)f\b", r"\1", expr)
+            try:
+                consts.setdefault(match.group(1),
+                                  eval(expr, {"__builtins__": {}}, consts))
+            except Exception:
+                pass
+    return consts
+
+
+class Trace:
+    """The GPIO values of a recording: vals[i] holds from times[i] (in ns)
+    until times[i + 1]."""
+
+    def __init__(self):
+        self.times = []
+        self.vals = []
+        self.end = 0
+
+    def add(self, time, val):
+        if self.times and self.times[-1] == time:
+            self.vals[-1] = val
+        elif not self.vals or self.vals[-1] != val:
+            self.times.append(time)
+            self.vals.append(val)
+        self.end = time
+
+
+def map_pin(name, pins, consts):
+    """Returns the GPIO of signal name, or None if unknown."""
+    if name in pins:
+        return pins[name]
+    low = name.lower()
+    match = re.match(r".*?gpio(\d+)", low)
+    if match:
+        return int(match.group(1))
+    gpio = PIN_NAMES.get(low)
+    if isinstance(gpio, str):
+        gpio = eval(gpio, {"__builtins__": {}}, consts)
+    return gpio
+
+
+def load_vcd(path, pins, consts):
+    with open(path, errors="replace") as f:
+        tokens = f.read().split()
+    scale = 1.0
+    ids = {}
+    trace = Trace()
+    val = 0
+    time = None
+    idx = 0
+    while idx < len(tokens):
+        tok = tokens[idx]
+        idx += 1
+        if tok == "$timescale":
+            end = tokens.index("$end", idx)
+            match = re.match(r"(\d+)\s*([munpf]?s)", "".join(tokens[idx:end]))
+            scale = int(match.group(1)) * {"s": 1e9, "ms": 1e6, "us": 1e3,
+                                           "ns": 1.0, "ps": 1e-3,
+                                           "fs": 1e-6}[match.group(2)]
+            idx = end + 1
+        elif tok == "$var":
+            end = tokens.index("$end", idx)
+            size, ident, name = tokens[idx + 1:idx + 4]
+            gpio = map_pin(name, pins, consts)
+            if size == "1" and gpio is not None:
+                ids[ident] = gpio
+            idx = end + 1
+        elif tok in ("$comment", "$date", "$version", "$scope", "$upscope"):
+            idx = tokens.index("$end", idx) + 1
+        elif tok.startswith("$"):
+            continue
+        elif tok.startswith("#"):
+            if time is not None:
+                trace.add(time, val)
+            time = int(tok[1:]) * scale
+        else:
+            if tok[0] in "bBrR":
+                bit, ident = tok[-1:], tokens[idx]
+                idx += 1
+            else:
+                bit, ident = tok[0], tok[1:]
+            gpio = ids.get(ident)
+            if gpio is not None:
+                if bit == "1":
+                    val |= 1 << gpio
+                else:
+                    val &= ~(1 << gpio)
+    if time is not None:
+        trace.add(time, val)
+    return trace, sorted(set(ids.values()))
+
+
+def parse_rate(rate):
+    match = re.match(r"([\d.]+)\s*([kMG]?)Hz", rate)
+    return float(match.group(1)) * {"": 1, "k": 1e3, "M": 1e6,
+                                    "G": 1e9}[match.group(2)]
+
+
+def load_sigrok(path, pins, consts):
+    with zipfile.ZipFile(path) as zf:
+        meta = configparser.ConfigParser()
+        meta.read_string(zf.read("metadata").decode())
+        dev = meta["device 1"]
+        rate = parse_rate(dev["samplerate"])
+        unitsize = int(dev.get("unitsize", "1"))
+        # Bit of each probe -> GPIO.
+        bits = {}
+        for key, name in dev.items():
+            match = re.match(r"probe(\d+)$", key)
+            gpio = map_pin(name, pins, consts) if match else None
+            if gpio is not None:
+                bits[int(match.group(1)) - 1] = gpio
+        prefix = dev.get("capturefile", "logic-1")
+        chunks = sorted((name for name in zf.namelist()
+                         if name == prefix or name.startswith(prefix + "-")),
+                        key=lambda name: int(name.split("-")[-1])
+                        if name != prefix else 0)
+        data = b"".join(zf.read(name) for name in chunks)
+    fmt = {1: "B", 2: "H", 4: "I"}[unitsize]
+    samples = memoryview(data).cast(fmt)
+    trace = Trace()
+    # The signals only change every few samples, so map the runs.
+    idx = 0
+    for raw, run in itertools.groupby(samples):
+        val = 0
+        for bit, gpio in bits.items():
+            if raw >> bit & 1:
+                val |= 1 << gpio
+        trace.add(idx * 1e9 / rate, val)
+        idx += sum(1 for _ in run)
+    trace.add(idx * 1e9 / rate, trace.vals[-1] if trace.vals else 0)
+    return trace, sorted(set(bits.values()))
+
+
+def load(path, pins, consts):
+    if zipfile.is_zipfile(path):
+        return load_sigrok(path, pins, consts)
+    return load_vcd(path, pins, consts)
+
+
+def write_edges(path, trace, pins_found, consts):
+    """Writes trace in the format of HostSim::readTraceFile()."""
+    rgb = consts["EGA_RGB_GPIO"]
+    cga = consts["CGA_ACTUAL_RGB_GPIO"]
+    rgb_mask = 0b111111 << rgb
+    driven = 0
+    for gpio in pins_found:
+        driven |= 1 << gpio
+    if driven & rgb_mask:
+        driven |= (driven & rgb_mask) >> rgb << cga
+    with open(path, "wb") as f:
+        f.write(b"MCEEDGE1" + struct.pack("<I", driven))
+        for time, val in zip(trace.times, trace.vals):
+            val |= (val & rgb_mask) >> rgb << cga
+            f.write(struct.pack("<QI", round(time * 1000), val))
+
+
+class Frame:
+    def __init__(self, time_us, width, height, mode, half_rate, rgb):
+        self.time_us = time_us
+        self.width = width
+        self.height = height
+        self.mode = mode
+        self.half_rate = half_rate
+        self.rgb = rgb
+
+    def hash(self):
+        return hashlib.sha256(self.rgb).hexdigest()
+
+    def ppm(self):
+        return b"P6\n%d %d\n255\n" % (self.width, self.height) + self.rgb
+
+
+def read_frames(path):
+    """Reads the frames written by TTLReplay."""
+    frames = []
+    with open(path, "rb") as f:
+        data = f.read()
+    pos = 0
+    while pos < len(data):
+        magic, time_us, width, height, name_len = struct.unpack_from(
+            "<4sQHHB", data, pos)
+        assert magic == b"MCEF", "bad frame at %d" % pos
+        pos += struct.calcsize("<4sQHHB")
+        mode = data[pos:pos + name_len].decode()
+        half_rate = bool(data[pos + name_len])
+        pos += name_len + 1
+        size = width * height * 3
+        frames.append(Frame(time_us, width, height, mode, half_rate,
+                            data[pos:pos + size]))
+        pos += size
+    return frames
+
+
+def find_replay_bin():
+    for build in ("build_tests", "build"):
+        path = os.path.join(REPO_DIR, build, "TTLReplay")
+        if os.access(path, os.X_OK):
+            return path
+    sys.exit("Can't find TTLReplay, build firmware/tests/ or use "
+             "--replay-bin")
+
+
+def replay(replay_bin, trace, pins_found, consts, out=sys.stdout, opts=()):
+    """Runs the trace through TTLReplay with options opts and returns the
+    frames."""
+    with tempfile.TemporaryDirectory() as tmp:
+        edges = os.path.join(tmp, "trace.edges")
+        frames_path = os.path.join(tmp, "frames")
+        write_edges(edges, trace, pins_found, consts)
+        proc = subprocess.run([replay_bin] + list(opts) +
+                              [edges, frames_path],
+                              stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                              universal_newlines=True)
+        if proc.returncode != 0:
+            sys.exit("TTLReplay failed:\n%s%s" % (proc.stdout, proc.stderr))
+        frames = read_frames(frames_path)
+    print("Pins: %s  %s" % (",".join(str(pin) for pin in pins_found),
+                            proc.stderr.strip()), file=out)
+    return frames
+
+
+# The signals of the synthetic recordings: the mode name the firmware should
+# find, the pixel clock, the line and the frame in pixels and lines, each
+# starting with the sync pulse, the active level of VSync, and the colors.
+# There is no black, so that the auto-adjust finds the exact borders. The MDA
+# colors are (video, intensity).
+SYNTH_MODES = {
+    # CGA has no secondary red or blue.
+    "CGA": dict(name="CGA_640x200_60Hz", px_hz=14318181, h_total=912,
+                h_sync=64, left=140, width=640, v_total=262, v_sync=3,
+                top=30, height=200, v_active=1,
+                colors=[c for c in range(1, 64) if not c & 0b010001]),
+    "EGA350": dict(name="EGA_640x350_60Hz", px_hz=16257000, h_total=744,
+                   h_sync=56, left=84, width=640, v_total=364, v_sync=3,
+                   top=8, height=350, v_active=0, colors=list(range(1, 64))),
+    "MDA": dict(name="MDA_720x350_50Hz", px_hz=16257000, h_total=882,
+                h_sync=112, left=140, width=720, v_total=370, v_sync=16,
+                top=20, height=350, v_active=0, colors=[0b10, 0b11]),
+}
+
+
+def synthesize(segments, rng, consts):
+    """Returns the trace of the (mode, frames) of segments one after the
+    other, see SYNTH_MODES, the GPIOs it drives, and the start time in us and
+    the visible pixels of each segment."""
+    vsync, hsync, mda = (consts[name] for name in (
+        "TTL_VSYNC_GPIO", "TTL_HSYNC_GPIO", "MDA_VI_GPIO"))
+    trace = Trace()
+    segment_starts = []
+    time_ps = 0.0
+    for mode, num_frames in segments:
+        m = SYNTH_MODES[mode]
+        px_ps = 1e12 / m["px_hz"]
+        width, height, left, top = m["width"], m["height"], m["left"], m["top"]
+        image = [[0] * width for _ in range(height)]
+        for y in range(height):
+            for x0 in range(0, width, 8):
+                image[y][x0:x0 + 8] = [rng.choice(m["colors"])] * 8
+        segment_starts.append((time_ps / 1e6, image))
+        color_shift = mda if mode == "MDA" else consts["EGA_RGB_GPIO"]
+        for line in range(num_frames * m["v_total"]):
+            line %= m["v_total"]
+            vs = m["v_active"] ^ (line >= m["v_sync"])
+            row = image[line - top] if top <= line < top + height else None
+            # The pixels only change every 8, and at the HSync and the
+            # borders.
+            xs = [0, m["h_sync"]]
+            if row:
+                xs += range(left, left + width + 1, 8)
+            for x in xs:
+                hs = 1 if x < m["h_sync"] else 0
+                color = row[x - left] if row and left <= x < left + width \
+                    else 0
+                trace.add((time_ps + x * px_ps) / 1000,
+                          color << color_shift | vs << vsync | hs << hsync)
+            time_ps += m["h_total"] * px_ps
+    trace.add(time_ps / 1000, trace.vals[-1])
+    pins_found = list(range(consts["EGA_RGB_GPIO"],
+                            consts["EGA_RGB_GPIO"] + 6)) + \
+        [vsync, hsync, mda, mda + 1]
+    return trace, pins_found, segment_starts
+
+
+def write_vcd(path, trace, pins_found, consts):
+    """Writes trace as a VCD, with the signal names of PIN_NAMES where there
+    is one."""
+    names = {map_pin(name, {}, consts): name for name in
+             ("vsync", "hsync", "intensity", "video")}
+    with open(path, "w") as out:
+        out.write("$timescale 1ps $end\n$scope module synth $end\n")
+        for idx, gpio in enumerate(pins_found):
+            out.write("$var wire 1 %s %s $end\n" %
+                      (chr(33 + idx), names.get(gpio, "gpio%d" % gpio)))
+        out.write("$upscope $end\n$enddefinitions $end\n")
+        last = None
+        for time, val in zip(trace.times, trace.vals):
+            out.write("#%d\n" % round(time * 1000))
+            for idx, gpio in enumerate(pins_found):
+                if last is None or (val ^ last) >> gpio & 1:
+                    out.write("%d%s\n" % (val >> gpio & 1, chr(33 + idx)))
+            last = val
+
+
+def self_test(replay_bin, consts):
+    rng = random.Random(0)
+    trace, pins_found, segment_starts = synthesize([("CGA", 60)], rng, consts)
+    image = segment_starts[0][1]
+    # Through a VCD, to test the loader too.
+    with tempfile.TemporaryDirectory() as tmp:
+        path = os.path.join(tmp, "cga.vcd")
+        write_vcd(path, trace, pins_found, consts)
+        trace, pins_found = load_vcd(path, {}, consts)
+    log = io.StringIO()
+    frames = replay(replay_bin, trace, pins_found, consts, log)
+    msg = log.getvalue().strip()
+    assert frames, msg
+    last = frames[-1]
+    assert last.mode == "CGA_640x200_60Hz" and not last.half_rate, \
+        "%s: %s" % (last.mode, msg)
+    # Each line may start a pixel early or late, or slip by a pixel, depending
+    # on where the PIO clock falls against the pixels, or start a FIFO entry
+    # (4 pixels) late when core1 drains the FIFO before the last "push noblock"
+    # of the HSync retrace. The simulation doesn't know how long core1 takes,
+    # so accept both and report them.
+    width = last.width
+    mapping = {}
+    shifts = collections.Counter()
+    for y in range(200):
+        got = [bytes(last.rgb[(y * width + x) * 3:(y * width + x) * 3 + 3])
+               for x in range(width)]
+        want = image[y]
+
+        def edges(shift):
+            return sum((got[x + shift] != got[x + shift - 1]) ==
+                       (want[x] != want[x - 1]) for x in range(9, 631))
+
+        # The blocks repeat every 8 pixels, so prefer the smaller shift.
+        shift = max(range(-8, 9),
+                    key=lambda shift: (edges(shift), -abs(shift)))
+        shifts[shift] += 1
+        # The synthetic colors change every 8 pixels, so the middle of each
+        # block must match even if the sampling slips by a pixel.
+        for x in (x for x in range(8, 632) if 3 <= x % 8 <= 4):
+            assert mapping.setdefault(want[x], got[x + shift]) == \
+                got[x + shift], "pixel %d,%d: %s" % (x, y, msg)
+    # The standard palette shows dark yellow as brown.
+    for color, rgb in mapping.items():
+        color = 0b100100 if color == 0b101000 else color
+        assert rgb == bytes((color >> bit & 3) * 0x55
+                            for bit in (4, 2, 0)), \
+            "color %s: %s: %s" % (bin(color), rgb.hex(), msg)
+    assert max(shifts) - min(shifts) <= 4 + 1, "%s: %s" % (shifts, msg)
+    msg += "\nLine shifts (pixels: lines): %s" % ", ".join(
+        "%+d: %d" % item for item in sorted(shifts.items()))
+    print("Self-test OK: %d frames, %s" % (len(frames), msg))
+
+
+def bench(replay_bin, trace, pins_found, consts, runs):
+    """Times the specialized capture loops of the presets against the generic
+    one, alternating between them. These are host numbers: the loops and the
+    compiler are the same as on the Pico but the CPU is not."""
+    variants = (("specialized", ["--time"]),
+                ("generic", ["--time", "--generic-capture"]))
+    times = collections.defaultdict(list)
+    hashes = {}
+    for _ in range(runs):
+        for name, opts in variants:
+            log = io.StringIO()
+            frames = replay(replay_bin, trace, pins_found, consts, log, opts)
+            match = re.search(r"capture loops: ([-0-9.]+)ns", log.getvalue())
+            if match is None:
+                sys.exit("No timing from TTLReplay:\n%s" % log.getvalue())
+            times[name].append(float(match.group(1)))
+            hashes[name] = [frame.hash() for frame in frames]
+    if hashes["specialized"] != hashes["generic"]:
+        sys.exit("FAIL: the generic capture loop captured different frames")
+    for name, _ in variants:
+        vals = times[name]
+        print("%-11s %.2fns per FIFO read on the host (min %.2f, max %.2f, "
+              "%d runs)" % (name, sum(vals) / len(vals), min(vals), max(vals),
+                            len(vals)))
+
+
+# Every transition between the sync timings of MDA, CGA and EGA 640x350.
+LOCK_SEGMENTS = ["CGA", "EGA350", "MDA", "CGA", "MDA", "EGA350", "CGA"]
+
+
+def image_box(frame):
+    """Returns the left, right, top and bottom of the non-black pixels of
+    frame, or None if it is black."""
+    row_len = frame.width * 3
+    box = None
+    for y in range(frame.height):
+        row = frame.rgb[y * row_len:(y + 1) * row_len]
+        left = row_len - len(row.lstrip(b"\0"))
+        if left == row_len:
+            continue
+        right = len(row.rstrip(b"\0")) - 1
+        box = (min(box[0], left // 3), max(box[1], right // 3), box[2], y) \
+            if box else (left // 3, right // 3, y, y)
+    return box
+
+
+def lock_times(replay_bin, consts, frames_per_mode):
+    """Replays synthetic switches between the modes and prints how long the
+    firmware takes to show the new mode and a stable image. These are the
+    simulation's numbers, see the header."""
+    rng = random.Random(0)
+    segments = [(mode, frames_per_mode) for mode in LOCK_SEGMENTS]
+    trace, pins_found, segment_starts = synthesize(segments, rng, consts)
+    frames = replay(replay_bin, trace, pins_found, consts, io.StringIO())
+    prev = "start"
+    for num, (mode, _) in enumerate(segments):
+        start_us = segment_starts[num][0]
+        end_us = segment_starts[num + 1][0] if num + 1 < len(segments) \
+            else float("inf")
+        seg_frames = [frame for frame in frames
+                      if start_us <= frame.time_us < end_us]
+        m = SYNTH_MODES[mode]
+        want = m["name"]
+        if not seg_frames or seg_frames[-1].mode != want:
+            sys.exit("FAIL: %s -> %s: not locked after %d frames" %
+                     (prev, mode, frames_per_mode))
+        # The image is stable once its mode and its position don't change
+        # any more, give or take a FIFO entry of the CGA line shifts (see
+        # self_test()).
+        final = image_box(seg_frames[-1])
+
+        def stable(frame):
+            box = image_box(frame)
+            return frame.mode == want and box is not None and \
+                all(abs(a - b) <= 4 for a, b in zip(box[:2], final[:2])) and \
+                box[2:] == final[2:]
+
+        def settled_us(good):
+            idx = len(seg_frames)
+            while idx > 0 and good(seg_frames[idx - 1]):
+                idx -= 1
+            return seg_frames[idx].time_us - start_us
+
+        frame_us = 1e6 * m["h_total"] * m["v_total"] / m["px_hz"]
+        mode_us = settled_us(lambda frame: frame.mode == want)
+        stable_us = settled_us(stable)
+        print("%-6s -> %-6s  mode after %5.1fms (%4.1f frames), stable image "
+              "after %5.1fms (%4.1f frames)" %
+              (prev, mode, mode_us / 1000, mode_us / frame_us,
+               stable_us / 1000, stable_us / frame_us))
+        prev = mode
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Replays TTL recordings through a host build of the "
+        "MCEBlaster capture.")
+    parser.add_argument("recording", nargs="?",
+                        help="A VCD or a sigrok (.sr) recording")
+    parser.add_argument("-o", "--out-dir", help="Save frames as PPM here")
+    parser.add_argument("--pin", action="append", default=[],
+                        metavar="NAME=GPIO",
+                        help="Map the signal NAME of the recording to GPIO, "
+                        "e.g. D7=7 for HSync. Names like gpio7, hsync, vsync, "
+                        "r, g, b, i etc. are mapped automatically")
+    parser.add_argument("--replay-bin", help="The TTLReplay binary of the "
+                        "host tests")
+    parser.add_argument("--save-hashes", metavar="FILE",
+                        help="Save the hashes of the frames")
+    parser.add_argument("--check", metavar="FILE",
+                        help="Compare the frames against the saved hashes")
+    parser.add_argument("--bench", metavar="RUNS", type=int,
+                        help="Time the specialized capture loops against the "
+                        "generic one, RUNS times each")
+    parser.add_argument("--lock-times", metavar="FRAMES", type=int,
+                        help="Print how long it takes to lock to each mode "
+                        "transition, switching modes every FRAMES frames")
+    parser.add_argument("--self-test", action="store_true")
+    args = parser.parse_args()
+    consts = read_constants()
+    replay_bin = args.replay_bin or find_replay_bin()
+    if args.self_test:
+        self_test(replay_bin, consts)
+        return
+    if args.lock_times:
+        lock_times(replay_bin, consts, args.lock_times)
+        return
+    if args.recording is None:
+        parser.error("recording is required")
+    pins = {}
+    for spec in args.pin:
+        name, _, gpio = spec.partition("=")
+        if not gpio.isdigit():
+            parser.error("bad --pin %s" % spec)
+        pins[name] = int(gpio)
+    trace, pins_found = load(args.recording, pins, consts)
+    if not trace.vals:
+        sys.exit("No known signals in %s, see --pin" % args.recording)
+    if args.bench:
+        bench(replay_bin, trace, pins_found, consts, args.bench)
+        return
+    frames = replay(replay_bin, trace, pins_found, consts)
+    modes = [(mode, len(list(group))) for mode, group in
+             itertools.groupby(frame.mode + (" 320-pixel" if frame.half_rate
+                                             else "") for frame in frames)]
+    print("Frames: %d  Modes: %s" % (len(frames), ", ".join(
+        "%s x%d" % mode for mode in modes)))
+    if args.out_dir:
+        os.makedirs(args.out_dir, exist_ok=True)
+        for num, frame in enumerate(frames):
+            with open(os.path.join(args.out_dir, "frame%04d.ppm" % num),
+                      "wb") as f:
+                f.write(frame.ppm())
+    hashes = ["%s %s" % (frame.mode, frame.hash()) for frame in frames]
+    if args.save_hashes:
+        with open(args.save_hashes, "w") as f:
+            f.write("\n".join(hashes) + "\n")
+    if args.check:
+        with open(args.check) as f:
+            expected = f.read().split("\n")[:-1]
+        bad = [num for num, (got, want) in
+               enumerate(itertools.zip_longest(hashes, expected))
+               if got != want]
+        if bad:
+            print("FAIL: %d of %d frames differ, first: %d" %
+                  (len(bad), max(len(hashes), len(expected)), bad[0]))
+            return 1
+        print("OK: %d frames match" % len(hashes))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2025 Scrap Computing
+#
+# Decodes the event trace of the firmware, see firmware/src/Trace.h. The event
+# names and their arguments are read from firmware/src/TraceEvents.def, so
+# this doesn't need updating when events are added.
+#
+# Usage:
+#   tracedump.py --port /dev/ttyACM0    Read the trace from a device built with
+#                                       -DUSB_COMMANDS=on
+#   tracedump.py log.txt                Decode the output of "mcectl.py trace"
+#   tracedump.py --self-test
+#
+
+import argparse
+import os
+import re
+import sys
+
+FORMAT_VERSION = 1
+SRC_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "src")
+# The order of the TTL enum in Timings.h.
+MODES = ("MDA", "CGA", "EGA")
+
+
+def read_events(path):
+    """Returns a list of (Name, [ArgName]) in the order of the IDs."""
+    events = []
+    regex = re.compile(r"^DEF_TRACE\(\s*(\w+)\s*,([^)]*)\)")
+    with open(path) as f:
+        for line in f:
+            match = regex.match(line)
+            if match:
+                args = [arg.strip() for arg in match.group(2).split(",")]
+                events.append((match.group(1), args))
+    return events
+
+
+class Ring:
+    def __init__(self, core, boots, head):
+        self.core = core
+        self.boots = boots
+        self.head = head
+        # (Time, Event, Seq, [Args])
+        self.entries = []
+
+
+def parse(lines):
+    """Returns the rings found in lines, skipping anything else."""
+    rings = []
+    ring = None
+    for line in lines:
+        words = line.split()
+        if not words:
+            continue
+        if words[0] == "TRACE-BEGIN" and len(words) == 5:
+            if int(words[1]) != FORMAT_VERSION:
+                sys.exit("Unsupported format version %s" % words[1])
+            ring = Ring(*(int(word) for word in words[2:]))
+        elif words[0] == "TR" and len(words) == 7 and ring is not None:
+            vals = [int(word, 16) for word in words[1:]]
+            ring.entries.append((vals[0], vals[1], vals[2], vals[3:]))
+        elif words[0] == "TRACE-END" and ring is not None:
+            rings.append(ring)
+            ring = None
+    return rings
+
+
+def format_arg(name, val):
+    if name == "Mode" or name == "PioMode":
+        return "%s=%s" % (name, MODES[val] if val < len(MODES) else val)
+    return "%s=%d" % (name, val)
+
+
+def decode(rings, events):
+    """Returns the trace as text lines. The time is in seconds since the
+    boot that recorded the event, and it wraps after about 71 minutes."""
+    out = []
+    for ring in rings:
+        dropped = ring.head - len(ring.entries)
+        out.append("Core %d: %d boots, %d events (%d overwritten)" %
+                   (ring.core, ring.boots, ring.head, dropped))
+        last = None
+        for time, event, seq, args in ring.entries:
+            if event < len(events):
+                name, arg_names = events[event]
+            else:
+                name, arg_names = "Unknown%d" % event, ["Arg"] * 3
+            if name == "Boot":
+                last = None
+            delta = "" if last is None else "+%.6f" % ((time - last) % 2**32 /
+                                                       1e6)
+            last = time
+            text = " ".join(format_arg(arg, val)
+                            for arg, val in zip(arg_names, args) if arg != "-")
+            out.append("  %11.6f %12s  %-14s %s" %
+                       (time / 1e6, delta, name, text))
+    return out
+
+
+def self_test():
+    events = read_events(os.path.join(SRC_DIR, "TraceEvents.def"))
+    ids = {name: idx for idx, (name, _) in enumerate(events)}
+    assert ids["Boot"] == 0, "Boot must stay the first event"
+    log = ["noise", "TRACE-BEGIN 1 0 2 2",
+           "TR 100 %x 0 2 1 0" % ids["Boot"],
+           "TR f4240 %x 1 1 280 c8" % ids["ModeChange"],
+           "TRACE-END", "TRACE-BEGIN 1 1 2 0", "TRACE-END"]
+    rings = parse(log)
+    assert len(rings) == 2 and rings[0].boots == 2, rings
+    out = decode(rings, events)
+    assert "Boots=2 Watchdog=1" in out[1], out
+    assert "+0.999744" in out[2], out
+    assert "Mode=CGA H_Visible=640 V_Visible=200" in out[2], out
+    assert out[3].startswith("Core 1: 2 boots, 0 events"), out
+    print("Self-test OK")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Decodes the MCEBlaster event trace.")
+    parser.add_argument("log", nargs="?", help="The saved trace output")
+    parser.add_argument("--port", help="Read the trace from this serial device")
+    parser.add_argument("--def", dest="defs",
+                        default=os.path.join(SRC_DIR, "TraceEvents.def"),
+                        help="The TraceEvents.def of the firmware")
+    parser.add_argument("--self-test", action="store_true")
+    args = parser.parse_args()
+    if args.self_test:
+        self_test()
+        return
+    if args.port:
+        from mcectl import Client
+        with Client(args.port) as mce:
+            lines = mce.trace()
+    elif args.log:
+        with open(args.log, errors="replace") as f:
+            lines = f.readlines()
+    else:
+        parser.error("either a log or --port is required")
+    rings = parse(lines)
+    if not rings:
+        sys.exit("No trace found")
+    print("\n".join(decode(rings, read_events(args.defs))))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
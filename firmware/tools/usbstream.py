@@ -0,0 +1,321 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2025 Scrap Computing
+#
+# Decoder for the picture that the firmware sends over the USB serial port
+# when built with -DUSB_STREAM=on. The format is described in
+# firmware/src/UsbStream.h.
+#
+# Usage:
+#   usbstream.py /dev/ttyACM0 -o frames/    Save each frame as a PPM image
+#   usbstream.py dump.bin -o frames/        Same but from a saved stream
+#   usbstream.py --self-test                Round-trip synthetic frames
+#   usbstream.py --self-test --golden stream.bin lines.bin
+#                                           Also decode a stream of the
+#                                           firmware, see tests/UsbStreamTest
+#
+
+import argparse
+import os
+import random
+import struct
+import sys
+
+MAGIC = b"MCEF"
+FORMAT_VERSION = 1
+FLAG_KEY_FRAME = 0b01
+FLAG_TWO_PIXELS_PER_BYTE = 0b10
+END_OF_FRAME = 0xFFFF
+HEADER = struct.Struct("<4sBBBBHHHHII")
+RECORD = struct.Struct("<HH")
+MAX_RUN = 129
+MAX_LITERAL = 128
+MODES = {0: "MDA", 1: "CGA", 2: "EGA"}
+
+
+def rle_encode(data):
+    """Same as UsbStream::encodeLine()."""
+    out = bytearray()
+    idx = 0
+    size = len(data)
+    while idx != size:
+        val = data[idx]
+        run = 1
+        while idx + run != size and run != MAX_RUN and data[idx + run] == val:
+            run += 1
+        if run >= 2:
+            out += bytes((0x80 | (run - 2), val))
+            idx += run
+            continue
+        start = idx
+        idx += 1
+        while (idx != size and idx - start != MAX_LITERAL and
+               not (idx + 2 < size and data[idx] == data[idx + 1] and
+                    data[idx] == data[idx + 2])):
+            idx += 1
+        out.append(idx - start - 1)
+        out += data[start:idx]
+    return bytes(out)
+
+
+def rle_decode(data, size):
+    """Decodes one line of size bytes. Raises ValueError if corrupt."""
+    out = bytearray()
+    idx = 0
+    while idx < len(data):
+        ctrl = data[idx]
+        idx += 1
+        if ctrl < 0x80:
+            cnt = ctrl + 1
+            if idx + cnt > len(data):
+                raise ValueError("literal past the end of the line")
+            out += data[idx:idx + cnt]
+            idx += cnt
+        else:
+            if idx >= len(data):
+                raise ValueError("run past the end of the line")
+            out += bytes((data[idx],)) * (ctrl - 126)
+            idx += 1
+    if len(out) != size:
+        raise ValueError("line is %d bytes, expected %d" % (len(out), size))
+    return bytes(out)
+
+
+class Frame:
+    def __init__(self, header, lines):
+        (_, self.version, self.mode, self.flags, _, self.width, self.height,
+         self.bytes_per_line, v_hz, self.h_hz, self.frame_cnt) = header
+        self.v_hz = v_hz / 100
+        self.key_frame = bool(self.flags & FLAG_KEY_FRAME)
+        self.two_pixels_per_byte = bool(self.flags & FLAG_TWO_PIXELS_PER_BYTE)
+        self.lines = lines
+
+    def mode_str(self):
+        return MODES.get(self.mode, "?")
+
+    def to_rgb(self):
+        """Returns (width, height, RGB bytes) of the frame."""
+        rgb = bytearray()
+        for line in self.lines:
+            for byte in line:
+                if self.mode == 0:
+                    # Two 00VI pixels, the first one in the low nibble.
+                    for vi in (byte & 0b11, (byte >> 4) & 0b11):
+                        rgb += bytes((vi * 85,)) * 3
+                    continue
+                pixel = bytes((((byte >> 4) & 0b11) * 85,
+                               ((byte >> 2) & 0b11) * 85, (byte & 0b11) * 85))
+                rgb += pixel * (2 if self.two_pixels_per_byte else 1)
+        width = self.bytes_per_line * (2 if self.two_pixels_per_byte else 1)
+        return width, len(self.lines), bytes(rgb)
+
+    def write_ppm(self, path):
+        width, height, rgb = self.to_rgb()
+        with open(path, "wb") as f:
+            f.write(b"P6\n%d %d\n255\n" % (width, height))
+            f.write(rgb)
+
+
+class Decoder:
+    """Feed it bytes as they arrive, it returns the frames that completed.
+    The lines that a frame did not send are kept from the previous frames,
+    so frames are only returned after the first key frame. After corrupt or
+    missing data it skips to the next header and waits for a key frame."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.lines = None
+        self.layout = None
+        self.header = None
+        self.synced = False
+
+    def _resync(self, skip):
+        idx = self.buf.find(MAGIC, skip)
+        del self.buf[:idx if idx >= 0 else max(0, len(self.buf) - 3)]
+        self.header = None
+        self.synced = False
+
+    def feed(self, data):
+        self.buf += data
+        frames = []
+        while True:
+            if self.header is None:
+                if not self.buf.startswith(MAGIC):
+                    self._resync(0)
+                if len(self.buf) < HEADER.size:
+                    return frames
+                header = HEADER.unpack_from(self.buf)
+                if header[1] != FORMAT_VERSION:
+                    self._resync(1)
+                    continue
+                del self.buf[:HEADER.size]
+                layout = (header[2], header[6], header[7], header[3] &
+                          FLAG_TWO_PIXELS_PER_BYTE)
+                if header[3] & FLAG_KEY_FRAME:
+                    self.synced = True
+                if layout != self.layout:
+                    self.layout = layout
+                    self.lines = [bytes(header[7])] * header[6]
+                    self.synced = bool(header[3] & FLAG_KEY_FRAME)
+                self.header = header
+                continue
+            if len(self.buf) < 2:
+                return frames
+            (line,) = struct.unpack_from("<H", self.buf)
+            if line == END_OF_FRAME:
+                del self.buf[:2]
+                if self.synced:
+                    frames.append(Frame(self.header, list(self.lines)))
+                self.header = None
+                continue
+            if len(self.buf) < RECORD.size:
+                return frames
+            line, size = RECORD.unpack_from(self.buf)
+            if len(self.buf) < RECORD.size + size:
+                return frames
+            data = bytes(self.buf[RECORD.size:RECORD.size + size])
+            try:
+                if line >= len(self.lines):
+                    raise ValueError("line %d out of range" % line)
+                self.lines[line] = rle_decode(data, self.header[7])
+            except ValueError:
+                self._resync(0)
+                continue
+            del self.buf[:RECORD.size + size]
+
+
+class Encoder:
+    """Same as UsbStream but a whole frame at a time, for testing."""
+
+    def __init__(self, key_frame_interval=3600):
+        self.key_frame_interval = key_frame_interval
+        self.sent = None
+        self.frame_cnt = 0
+
+    def encode(self, lines, mode=1, two_pixels_per_byte=False, v_hz=60.0,
+               h_hz=15700):
+        key_frame = (self.sent is None or len(self.sent) != len(lines) or
+                     self.frame_cnt % self.key_frame_interval == 0)
+        flags = ((FLAG_KEY_FRAME if key_frame else 0) |
+                 (FLAG_TWO_PIXELS_PER_BYTE if two_pixels_per_byte else 0))
+        bytes_per_line = len(lines[0])
+        width = bytes_per_line * (2 if two_pixels_per_byte else 1)
+        out = bytearray(HEADER.pack(MAGIC, FORMAT_VERSION, mode, flags, 0,
+                                    width, len(lines), bytes_per_line,
+                                    int(v_hz * 100), h_hz, self.frame_cnt))
+        for idx, line in enumerate(lines):
+            if key_frame or self.sent[idx] != line:
+                data = rle_encode(line)
+                out += RECORD.pack(idx, len(data)) + data
+        out += struct.pack("<H", END_OF_FRAME)
+        self.sent = list(lines)
+        self.frame_cnt += 1
+        return bytes(out)
+
+
+def check_golden(stream_path, lines_path):
+    """Decodes a stream of the firmware's encoder, saved by the host test
+    UsbStreamTest, and compares the last frame with the picture it sent."""
+    with open(stream_path, "rb") as f:
+        frames = Decoder().feed(f.read())
+    with open(lines_path, "rb") as f:
+        picture = f.read()
+    assert frames, "no frames in %s" % stream_path
+    last = frames[-1]
+    size = last.bytes_per_line
+    assert len(picture) == size * last.height, (len(picture), size)
+    for idx, line in enumerate(last.lines):
+        assert line == picture[idx * size:(idx + 1) * size], "line %d" % idx
+    print("%s: %d frames match" % (os.path.basename(stream_path),
+                                   len(frames)))
+
+
+def self_test():
+    rng = random.Random(0)
+    # Edge cases of the line compression.
+    for line in (b"", b"\x01", b"\x01\x01", b"\x01\x02", bytes(656),
+                 bytes(range(256)) * 2, b"\x01\x01\x02" * 100,
+                 bytes(rng.randrange(4) for _ in range(656))):
+        assert rle_decode(rle_encode(line), len(line)) == line, line
+    # A text-like screen with a few lines changing per frame.
+    bytes_per_line, height = 640, 200
+    lines = [bytes(rng.choice((0, 0, 0, 0x3F)) for _ in range(bytes_per_line))
+             for _ in range(height)]
+    enc = Encoder(key_frame_interval=8)
+    dec = Decoder()
+    expected = []
+    # Start with garbage to check that the decoder finds the first header.
+    stream = bytearray(b"garbage" + MAGIC[:3])
+    for _ in range(20):
+        for _ in range(rng.randrange(10)):
+            idx = rng.randrange(height)
+            line = bytearray(lines[idx])
+            for _ in range(rng.randrange(1, 40)):
+                line[rng.randrange(bytes_per_line)] = rng.randrange(64)
+            lines[idx] = bytes(line)
+        stream += enc.encode(lines)
+        expected.append(list(lines))
+    frames = []
+    # Feed it in odd sizes to check the partial reads.
+    for idx in range(0, len(stream), 777):
+        frames += dec.feed(stream[idx:idx + 777])
+    assert len(frames) == len(expected), (len(frames), len(expected))
+    for frame, lines in zip(frames, expected):
+        assert frame.lines == lines, frame.frame_cnt
+    assert frames[0].width == bytes_per_line and frames[0].height == height
+    print("Self-test OK: %d frames, %d bytes, %.1f%% of the raw size" %
+          (len(frames), len(stream),
+           100 * len(stream) / (len(frames) * bytes_per_line * height)))
+
+
+def open_source(path):
+    f = open(path, "rb", buffering=0)
+    if os.isatty(f.fileno()):
+        import tty
+        tty.setraw(f.fileno())
+    return f
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Decodes the USB_STREAM picture of the MCEBlaster.")
+    parser.add_argument("source", nargs="?",
+                        help="The serial device or a saved stream")
+    parser.add_argument("-o", "--out-dir", help="Save frames as PPM here")
+    parser.add_argument("--every", type=int, default=1,
+                        help="Only save every Nth frame")
+    parser.add_argument("--self-test", action="store_true")
+    parser.add_argument("--golden", nargs=2, metavar=("STREAM", "LINES"),
+                        help="With --self-test, check the decoder against a "
+                        "stream and the picture it holds")
+    args = parser.parse_args()
+    if args.self_test:
+        self_test()
+        if args.golden:
+            check_golden(*args.golden)
+        return
+    if args.source is None:
+        parser.error("source is required")
+    if args.out_dir:
+        os.makedirs(args.out_dir, exist_ok=True)
+    dec = Decoder()
+    cnt = 0
+    with open_source(args.source) as f:
+        while True:
+            data = f.read(4096)
+            if not data:
+                break
+            for frame in dec.feed(data):
+                if cnt % args.every == 0:
+                    print("Frame %d: %s %dx%d %.2fHz %dHz%s" %
+                          (frame.frame_cnt, frame.mode_str(), frame.width,
+                           frame.height, frame.v_hz, frame.h_hz,
+                           " key" if frame.key_frame else ""))
+                    if args.out_dir:
+                        frame.write_ppm(os.path.join(
+                            args.out_dir, "frame%06d.ppm" % frame.frame_cnt))
+                cnt += 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())